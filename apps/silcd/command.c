@@ -398,19 +398,32 @@ SilcBool silc_server_command_pending_timed(SilcServer server,
 				       void *context,
 				       SilcUInt16 timeout)
 {
-  SilcServerCommandPending *reply;
+  SilcServerCommandPending *reply, *r = NULL, *prev = NULL;
 
   /* Check whether identical pending already exists for same command,
      ident, callback and callback context. If it does then it would be
      error to register it again. */
-  silc_dlist_start(server->pending_commands);
-  while ((reply = silc_dlist_get(server->pending_commands)) != SILC_LIST_END) {
-    if (reply->reply_cmd == reply_cmd && reply->ident == ident &&
-	reply->callback == callback && reply->context == context)
+  silc_hash_table_find(server->pending_commands, SILC_32_TO_PTR(ident),
+		       NULL, (void *)&r);
+  for (; r; r = r->next) {
+    if (r->reply_cmd == reply_cmd && r->callback == callback &&
+	r->context == context)
+      return FALSE;
+    prev = r;
+  }
+
+  /* Take context from the pool */
+  reply = server->pending_pool;
+  if (reply) {
+    server->pending_pool = reply->next;
+    server->pending_pool_count--;
+    memset(reply, 0, sizeof(*reply));
+  } else {
+    reply = silc_calloc(1, sizeof(*reply));
+    if (!reply)
       return FALSE;
   }
 
-  reply = silc_calloc(1, sizeof(*reply));
   reply->reply_cmd = reply_cmd;
   reply->ident = ident;
   reply->context = context;
@@ -419,7 +432,13 @@ SilcBool silc_server_command_pending_timed(SilcServer server,
     silc_schedule_task_add_timeout(server->schedule,
 				   silc_server_command_pending_timeout, reply,
 				   timeout ? timeout : 12, 0);
-  silc_dlist_add(server->pending_commands, reply);
+
+  /* Add to the end of the list of pending commands with same ident */
+  if (prev)
+    prev->next = reply;
+  else
+    silc_hash_table_add(server->pending_commands, SILC_32_TO_PTR(ident),
+			reply);
 
   return TRUE;
 }
@@ -430,19 +449,43 @@ void silc_server_command_pending_del(SilcServer server,
 				     SilcCommand reply_cmd,
 				     SilcUInt16 ident)
 {
-  SilcServerCommandPending *r;
-
-  silc_dlist_start(server->pending_commands);
-  while ((r = silc_dlist_get(server->pending_commands)) != SILC_LIST_END) {
-    if ((r->reply_cmd == reply_cmd || (r->reply_cmd == SILC_COMMAND_NONE &&
-                                       r->reply_check))
-        && r->ident == ident) {
-      silc_dlist_del(server->pending_commands, r);
-      if (r->timeout)
-	silc_schedule_task_del(server->schedule, r->timeout);
+  SilcServerCommandPending *r, *head = NULL, *prev = NULL, *next;
+
+  if (!silc_hash_table_find(server->pending_commands, SILC_32_TO_PTR(ident),
+			    NULL, (void *)&head))
+    return;
+
+  for (r = head; r; r = next) {
+    next = r->next;
+    if (r->reply_cmd != reply_cmd && (r->reply_cmd != SILC_COMMAND_NONE ||
+				      !r->reply_check)) {
+      prev = r;
+      continue;
+    }
+
+    if (prev)
+      prev->next = next;
+    else
+      head = next;
+
+    if (r->timeout)
+      silc_schedule_task_del(server->schedule, r->timeout);
+
+    /* Put context back to the pool */
+    if (server->pending_pool_count < SILC_SERVER_PENDING_POOL) {
+      r->next = server->pending_pool;
+      server->pending_pool = r;
+      server->pending_pool_count++;
+    } else {
       silc_free(r);
     }
   }
+
+  if (head)
+    silc_hash_table_replace(server->pending_commands, SILC_32_TO_PTR(ident),
+			    head);
+  else
+    silc_hash_table_del(server->pending_commands, SILC_32_TO_PTR(ident));
 }
 
 /* Checks for pending commands and marks callbacks to be called from
@@ -454,15 +497,28 @@ silc_server_command_pending_check(SilcServer server,
 				  SilcUInt16 ident,
 				  SilcUInt32 *callbacks_count)
 {
-  SilcServerCommandPending *r;
+  SilcServerCommandPending *r, *head = NULL;
   SilcServerCommandPendingCallbacks callbacks = NULL;
   int i = 0;
 
-  silc_dlist_start(server->pending_commands);
-  while ((r = silc_dlist_get(server->pending_commands)) != SILC_LIST_END) {
-    if ((r->reply_cmd == command || r->reply_cmd == SILC_COMMAND_NONE)
-	&& r->ident == ident) {
-      callbacks = silc_realloc(callbacks, sizeof(*callbacks) * (i + 1));
+  *callbacks_count = 0;
+  if (!silc_hash_table_find(server->pending_commands, SILC_32_TO_PTR(ident),
+			    NULL, (void *)&head))
+    return NULL;
+
+  for (r = head; r; r = r->next)
+    if (r->reply_cmd == command || r->reply_cmd == SILC_COMMAND_NONE)
+      i++;
+  if (!i)
+    return NULL;
+
+  callbacks = silc_calloc(i, sizeof(*callbacks));
+  if (!callbacks)
+    return NULL;
+
+  i = 0;
+  for (r = head; r; r = r->next) {
+    if (r->reply_cmd == command || r->reply_cmd == SILC_COMMAND_NONE) {
       callbacks[i].context = r->context;
       callbacks[i].callback = r->callback;
       r->reply_check = TRUE;
@@ -474,6 +530,53 @@ silc_server_command_pending_check(SilcServer server,
   return callbacks;
 }
 
+/* Frees all pending commands and the pending command pool.  Called when
+   the server is freed. */
+
+void silc_server_command_pending_free(SilcServer server)
+{
+  SilcServerCommandPending *r, *next;
+  SilcHashTableList htl;
+
+  silc_hash_table_list(server->pending_commands, &htl);
+  while (silc_hash_table_get(&htl, NULL, (void *)&r)) {
+    for (; r; r = next) {
+      next = r->next;
+      silc_free(r);
+    }
+  }
+  silc_hash_table_list_reset(&htl);
+  silc_hash_table_free(server->pending_commands);
+  server->pending_commands = NULL;
+
+  for (r = server->pending_pool; r; r = next) {
+    next = r->next;
+    silc_free(r);
+  }
+  server->pending_pool = NULL;
+  server->pending_pool_count = 0;
+}
+
+/* Returns new command identifier for a command that is sent.  Zero is
+   never returned, and identifiers that still have pending commands are
+   skipped so that after the identifier wraps around a reply to the new
+   command cannot execute callbacks pending for an old command. */
+
+SilcUInt16 silc_server_command_ident(SilcServer server)
+{
+  SilcUInt32 i;
+
+  for (i = 0; i < 0xffff; i++) {
+    if (!++server->cmd_ident)
+      server->cmd_ident++;
+    if (!silc_hash_table_find(server->pending_commands,
+			      SILC_32_TO_PTR(server->cmd_ident), NULL, NULL))
+      break;
+  }
+
+  return server->cmd_ident;
+}
+
 /* Sends simple status message as command reply packet */
 
 static void
@@ -735,113 +838,124 @@ SILC_SERVER_CMD_FUNC(nick)
   silc_server_command_free(cmd);
 }
 
-/* Sends the LIST command reply */
+/* Returns the cached channel list for LIST command, rebuilding it if
+   channels have been added or deleted since it was built.  Returns FALSE
+   if the cached list was up to date. */
+
+static SilcBool silc_server_command_list_cache(SilcServer server)
+{
+  SilcServerListCache *cache = &server->list_cache;
+  SilcList llist, glist;
+  SilcIDCacheEntry id_cache;
+  SilcUInt32 count;
+
+  if (cache->local_gen == server->local_list->channels_gen &&
+      cache->global_gen == server->global_list->channels_gen)
+    return FALSE;
+
+  SILC_LOG_DEBUG(("Rebuilding LIST cache"));
+
+  silc_list_init(llist, struct SilcIDCacheEntryStruct, next);
+  silc_list_init(glist, struct SilcIDCacheEntryStruct, next);
+  silc_idcache_get_all(server->local_list->channels, &llist);
+  silc_idcache_get_all(server->global_list->channels, &glist);
+
+  count = silc_list_count(llist) + silc_list_count(glist);
+  silc_free(cache->channels);
+  cache->channels = NULL;
+  cache->local_count = cache->count = 0;
+  if (count) {
+    cache->channels = silc_calloc(count, sizeof(*cache->channels));
+    if (!cache->channels)
+      return TRUE;
+
+    silc_list_start(llist);
+    while ((id_cache = silc_list_get(llist)))
+      cache->channels[cache->count++] = id_cache->context;
+    cache->local_count = cache->count;
+    silc_list_start(glist);
+    while ((id_cache = silc_list_get(glist)))
+      cache->channels[cache->count++] = id_cache->context;
+  }
+
+  cache->local_gen = server->local_list->channels_gen;
+  cache->global_gen = server->global_list->channels_gen;
+
+  return TRUE;
+}
+
+/* Sends the LIST command reply.  The `channels' has `local_count' channels
+   from local list followed by channels from global list.  Secret channels
+   are not listed. */
 
 static void
 silc_server_command_list_send_reply(SilcServerCommandContext cmd,
-				    SilcChannelEntry *lch,
-				    SilcUInt32 lch_count,
-				    SilcChannelEntry *gch,
-				    SilcUInt32 gch_count)
+				    SilcChannelEntry *channels,
+				    SilcUInt32 local_count,
+				    SilcUInt32 count)
 {
   int i, k;
-  SilcBuffer idp;
+  unsigned char idp[64];
+  SilcUInt32 idp_len;
   SilcChannelEntry entry;
   SilcStatus status;
   SilcUInt16 ident = silc_command_get_ident(cmd->payload);
   char *topic;
   unsigned char usercount[4];
   SilcUInt32 users;
-  int valid_lcount = 0, valid_rcount = 0;
+  int valid_count = 0;
 
-  for (i = 0; i < lch_count; i++) {
-    if (lch[i]->mode & SILC_CHANNEL_MODE_SECRET)
-      lch[i] = NULL;
-    else
-      valid_lcount++;
-  }
-  for (i = 0; i < gch_count; i++) {
-    if (gch[i]->mode & SILC_CHANNEL_MODE_SECRET)
-      gch[i] = NULL;
-    else
-      valid_rcount++;
-  }
+  for (i = 0; i < count; i++)
+    if (!(channels[i]->mode & SILC_CHANNEL_MODE_SECRET))
+      valid_count++;
 
-  if (!lch_count && !gch_count) {
+  if (!valid_count) {
     silc_server_command_send_status_reply(cmd, SILC_COMMAND_LIST,
 					  SILC_STATUS_OK, 0);
     return;
   }
 
   status = SILC_STATUS_OK;
-  if ((lch_count + gch_count) > 1)
+  if (valid_count > 1)
     status = SILC_STATUS_LIST_START;
 
-  /* Local list */
-  for (i = 0, k = 0; i < lch_count; i++) {
-    entry = lch[i];
-    if (!entry)
+  for (i = 0, k = 0; i < count; i++) {
+    entry = channels[i];
+    if (entry->mode & SILC_CHANNEL_MODE_SECRET)
       continue;
 
     if (k >= 1)
       status = SILC_STATUS_LIST_ITEM;
-    if (valid_lcount > 1 && k == valid_lcount - 1 && !valid_rcount)
+    if (valid_count > 1 && k == valid_count - 1)
       status = SILC_STATUS_LIST_END;
 
-    idp = silc_id_payload_encode(entry->id, SILC_ID_CHANNEL);
-
-    if (entry->mode & SILC_CHANNEL_MODE_PRIVATE) {
-      topic = "*private*";
-      memset(usercount, 0, sizeof(usercount));
-    } else {
-      topic = entry->topic;
-      users = silc_hash_table_count(entry->user_list);
-      SILC_PUT32_MSB(users, usercount);
-    }
-
-    /* Send the reply */
-    silc_server_send_command_reply(cmd->server, cmd->sock, SILC_COMMAND_LIST,
-				   status, 0, ident, 4,
-				   2, idp->data, silc_buffer_len(idp),
-				   3, entry->channel_name,
-				   strlen(entry->channel_name),
-				   4, topic, topic ? strlen(topic) : 0,
-				   5, usercount, 4);
-    silc_buffer_free(idp);
-    k++;
-  }
-
-  /* Global list */
-  for (i = 0, k = 0; i < gch_count; i++) {
-    entry = gch[i];
-    if (!entry)
+    SILC_PUT16_MSB(SILC_ID_CHANNEL, idp);
+    if (!silc_id_id2str(entry->id, SILC_ID_CHANNEL, idp + 4, sizeof(idp) - 4,
+			&idp_len))
       continue;
-
-    if (k >= 1)
-      status = SILC_STATUS_LIST_ITEM;
-    if (valid_rcount > 1 && k == valid_rcount - 1)
-      status = SILC_STATUS_LIST_END;
-
-    idp = silc_id_payload_encode(entry->id, SILC_ID_CHANNEL);
+    SILC_PUT16_MSB(idp_len, idp + 2);
+    idp_len += 4;
 
     if (entry->mode & SILC_CHANNEL_MODE_PRIVATE) {
       topic = "*private*";
       memset(usercount, 0, sizeof(usercount));
     } else {
       topic = entry->topic;
-      users = entry->user_count;
+      if (i < local_count)
+	users = silc_hash_table_count(entry->user_list);
+      else
+	users = entry->user_count;
       SILC_PUT32_MSB(users, usercount);
     }
 
     /* Send the reply */
     silc_server_send_command_reply(cmd->server, cmd->sock, SILC_COMMAND_LIST,
 				   status, 0, ident, 4,
-				   2, idp->data, silc_buffer_len(idp),
+				   2, idp, idp_len,
 				   3, entry->channel_name,
 				   strlen(entry->channel_name),
 				   4, topic, topic ? strlen(topic) : 0,
 				   5, usercount, 4);
-    silc_buffer_free(idp);
     k++;
   }
 }
@@ -852,26 +966,64 @@ silc_server_command_list_send_reply(SilcServerCommandContext cmd,
 SILC_SERVER_CMD_FUNC(list)
 {
   SilcServerCommandContext cmd = (SilcServerCommandContext)context;
+  SilcServerCommandReplyContext cmdr = context2;
   SilcServer server = cmd->server;
+  SilcServerListCache *cache = &server->list_cache;
   SilcID id;
   SilcChannelID *channel_id = NULL;
-  SilcChannelEntry *lchannels = NULL, *gchannels = NULL;
+  SilcChannelEntry *lchannels = NULL, *gchannels = NULL, *channels;
   SilcUInt32 lch_count = 0, gch_count = 0;
 
+  /* Reply to the LIST of all channels from router received.  This is
+     checked before the command check, as it returns on error reply. */
+  if (cmd->pending && cmdr && cmdr->ident == cache->ident) {
+    cache->ident = 0;
+    if (silc_command_get_status(cmdr->payload, NULL, NULL))
+      cache->updated = time(NULL);
+  }
+
   SILC_SERVER_COMMAND_CHECK(SILC_COMMAND_LIST, cmd, 0, 1);
 
+  /* Get Channel ID */
+  if (silc_argument_get_decoded(cmd->args, 1, SILC_ARGUMENT_ID, &id, NULL))
+    channel_id = SILC_ID_GET_ID(id);
+
   /* If we are normal server, send the command to router, since we
-     want to know all channels in the network. */
+     want to know all channels in the network.  The list of all channels
+     received from router is used for `list_cache_ttl' seconds, and all
+     clients listing channels while the list is being received wait for
+     the same reply. */
   if (!cmd->pending && server->server_type != SILC_ROUTER &&
       !server->standalone) {
     SilcBuffer tmpbuf;
     SilcUInt16 old_ident;
 
+    if (!channel_id) {
+      if (cache->updated &&
+	  cache->updated + server->config->list_cache_ttl > time(NULL)) {
+	server->stat.list_cache_hits++;
+	silc_server_command_list_cache(server);
+	silc_server_command_list_send_reply(cmd, cache->channels,
+					    cache->local_count, cache->count);
+	goto out;
+      }
+
+      if (cache->ident) {
+	server->stat.list_cache_hits++;
+	silc_server_command_pending(server, SILC_COMMAND_LIST, cache->ident,
+				    silc_server_command_list,
+				    silc_server_command_dup(cmd));
+	cmd->pending = TRUE;
+	goto out;
+      }
+      server->stat.list_cache_misses++;
+    }
+
     /* Statistics */
     cmd->server->stat.commands_sent++;
 
     old_ident = silc_command_get_ident(cmd->payload);
-    silc_command_set_ident(cmd->payload, ++server->cmd_ident);
+    silc_command_set_ident(cmd->payload, silc_server_command_ident(server));
     tmpbuf = silc_command_payload_encode_payload(cmd->payload);
     silc_server_packet_send(server, SILC_PRIMARY_ROUTE(server),
 			    SILC_PACKET_COMMAND, cmd->packet->flags,
@@ -883,14 +1035,26 @@ SILC_SERVER_CMD_FUNC(list)
 				silc_server_command_list,
 				silc_server_command_dup(cmd));
     cmd->pending = TRUE;
+    if (!channel_id)
+      cache->ident = silc_command_get_ident(cmd->payload);
     silc_command_set_ident(cmd->payload, old_ident);
     silc_buffer_free(tmpbuf);
     goto out;
   }
 
-  /* Get Channel ID */
-  if (silc_argument_get_decoded(cmd->args, 1, SILC_ARGUMENT_ID, &id, NULL))
-    channel_id = SILC_ID_GET_ID(id);
+  if (!channel_id) {
+    /* List all channels from the cached channel list.  On normal server
+       the statistics were updated already before sending to router. */
+    if (silc_server_command_list_cache(server)) {
+      if (!cmd->pending)
+	server->stat.list_cache_misses++;
+    } else if (!cmd->pending) {
+      server->stat.list_cache_hits++;
+    }
+    silc_server_command_list_send_reply(cmd, cache->channels,
+					cache->local_count, cache->count);
+    goto out;
+  }
 
   /* Get the channels from local list */
   lchannels = silc_idlist_get_channels(server->local_list, channel_id,
@@ -901,8 +1065,16 @@ SILC_SERVER_CMD_FUNC(list)
 				       &gch_count);
 
   /* Send the reply */
-  silc_server_command_list_send_reply(cmd, lchannels, lch_count,
-				      gchannels, gch_count);
+  channels = silc_calloc(lch_count + gch_count + 1, sizeof(*channels));
+  if (channels) {
+    if (lch_count)
+      memcpy(channels, lchannels, lch_count * sizeof(*channels));
+    if (gch_count)
+      memcpy(channels + lch_count, gchannels, gch_count * sizeof(*channels));
+    silc_server_command_list_send_reply(cmd, channels, lch_count,
+					lch_count + gch_count);
+    silc_free(channels);
+  }
 
   silc_free(lchannels);
   silc_free(gchannels);
@@ -1199,7 +1371,7 @@ SILC_SERVER_CMD_FUNC(invite)
   if (tmp && len2 > 2) {
     /* Parse the arguments to see they are constructed correctly */
     SILC_GET16_MSB(argc, tmp);
-    args = silc_argument_payload_parse(tmp + 2, len2 - 2, argc);
+    args = silc_argument_payload_parse(tmp + 2, len2 - 2, argc, NULL);
     if (!args) {
       silc_server_command_send_status_reply(cmd, SILC_COMMAND_INVITE,
 					    SILC_STATUS_ERR_NOT_ENOUGH_PARAMS,
@@ -1594,7 +1766,7 @@ SILC_SERVER_CMD_FUNC(info)
       cmd->server->stat.commands_sent++;
 
       old_ident = silc_command_get_ident(cmd->payload);
-      silc_command_set_ident(cmd->payload, ++server->cmd_ident);
+      silc_command_set_ident(cmd->payload, silc_server_command_ident(server));
       tmpbuf = silc_command_payload_encode_payload(cmd->payload);
 
       silc_server_packet_send(server, entry->connection,
@@ -1621,7 +1793,7 @@ SILC_SERVER_CMD_FUNC(info)
       cmd->server->stat.commands_sent++;
 
       old_ident = silc_command_get_ident(cmd->payload);
-      silc_command_set_ident(cmd->payload, ++server->cmd_ident);
+      silc_command_set_ident(cmd->payload, silc_server_command_ident(server));
       tmpbuf = silc_command_payload_encode_payload(cmd->payload);
 
       silc_server_packet_send(server, SILC_PRIMARY_ROUTE(server),
@@ -1758,8 +1930,8 @@ SILC_SERVER_CMD_FUNC(stats)
     idp = silc_id_payload_encode(server->router->id,
 				 SILC_ID_SERVER);
     packet = silc_command_payload_encode_va(SILC_COMMAND_STATS,
-					    ++server->cmd_ident, 1,
-					    1, idp->data,
+					    silc_server_command_ident(server),
+					    1, 1, idp->data,
 					    silc_buffer_len(idp));
     silc_server_packet_send(server, SILC_PRIMARY_ROUTE(server),
 			    SILC_PACKET_COMMAND, 0, packet->data,
@@ -1888,7 +2060,8 @@ static void silc_server_command_join_channel(SilcServer server,
 	 GETKEY command. Reprocess this packet after receiving the key */
       clidp = silc_id_payload_encode(client_id, SILC_ID_CLIENT);
       silc_server_send_command(server, cmd->sock,
-			       SILC_COMMAND_GETKEY, ++server->cmd_ident,
+			       SILC_COMMAND_GETKEY,
+			       silc_server_command_ident(server),
 			       1, 1, clidp->data, silc_buffer_len(clidp));
       silc_buffer_free(clidp);
       silc_server_command_pending(server, SILC_COMMAND_GETKEY,
@@ -2104,13 +2277,14 @@ static void silc_server_command_join_channel(SilcServer server,
   /* Join the client to the channel by adding it to channel's user list.
      Add also the channel to client entry's channels list for fast cross-
      referencing. */
-  chl = silc_calloc(1, sizeof(*chl));
+  chl = silc_idlist_add_chl(server->local_list);
   chl->mode = umode;
   chl->client = client;
   chl->channel = channel;
   silc_hash_table_add(channel->user_list, client, chl);
   silc_hash_table_add(client->channels, channel, chl);
   channel->user_count++;
+  SILC_CHANNEL_DELIVERY_RESET(channel);
   channel->disabled = FALSE;
 
   /* Get users on the channel */
@@ -2517,7 +2691,8 @@ SILC_SERVER_CMD_FUNC(join)
 	  cmd->server->stat.commands_sent++;
 
 	  old_ident = silc_command_get_ident(cmd->payload);
-	  silc_command_set_ident(cmd->payload, ++server->cmd_ident);
+	  silc_command_set_ident(cmd->payload,
+				 silc_server_command_ident(server));
 	  tmpbuf = silc_command_payload_encode_payload(cmd->payload);
 
 	  /* Send JOIN command to our router */
@@ -2744,7 +2919,7 @@ SILC_SERVER_CMD_FUNC(motd)
       cmd->server->stat.commands_sent++;
 
       old_ident = silc_command_get_ident(cmd->payload);
-      silc_command_set_ident(cmd->payload, ++server->cmd_ident);
+      silc_command_set_ident(cmd->payload, silc_server_command_ident(server));
       tmpbuf = silc_command_payload_encode_payload(cmd->payload);
 
       silc_server_packet_send(server, entry->connection,
@@ -2774,7 +2949,7 @@ SILC_SERVER_CMD_FUNC(motd)
       cmd->server->stat.commands_sent++;
 
       old_ident = silc_command_get_ident(cmd->payload);
-      silc_command_set_ident(cmd->payload, ++server->cmd_ident);
+      silc_command_set_ident(cmd->payload, silc_server_command_ident(server));
       tmpbuf = silc_command_payload_encode_payload(cmd->payload);
 
       silc_server_packet_send(server, SILC_PRIMARY_ROUTE(server),
@@ -3648,6 +3823,9 @@ SILC_SERVER_CMD_FUNC(cumode)
     }
   }
 
+  /* Delivery list carries the message blocking modes */
+  SILC_CHANNEL_DELIVERY_RESET(channel);
+
   if (target_mask & SILC_CHANNEL_UMODE_BLOCK_MESSAGES) {
     if (target_client != client) {
       silc_server_command_send_status_reply(cmd, SILC_COMMAND_CUMODE,
@@ -3907,7 +4085,7 @@ SILC_SERVER_CMD_FUNC(kick)
     SilcBuffer ab =
       silc_argument_payload_encode_one(NULL, target_idp, target_idp_len, 3);
     SilcArgumentPayload args =
-      silc_argument_payload_parse(ab->data, silc_buffer_len(ab), 1);
+      silc_argument_payload_parse(ab->data, silc_buffer_len(ab), 1, NULL);
 
     silc_server_inviteban_process(server, channel->invite_list, 1, args);
     silc_buffer_free(ab);
@@ -4090,8 +4268,9 @@ SILC_TASK_CALLBACK(silc_server_command_detach_cb)
 				sock);
 
   /* Close the connection on our side */
-  client->router = NULL;
+  silc_idlist_client_set_router(client, NULL);
   client->connection = NULL;
+  silc_server_client_delivery_reset(client);
   silc_server_close_connection(server, sock);
 
   /* Mark the client as locally detached. */
@@ -4222,7 +4401,7 @@ SILC_SERVER_CMD_FUNC(watch)
       cmd->server->stat.commands_sent++;
 
       old_ident = silc_command_get_ident(cmd->payload);
-      silc_command_set_ident(cmd->payload, ++server->cmd_ident);
+      silc_command_set_ident(cmd->payload, silc_server_command_ident(server));
       tmpbuf = silc_command_payload_encode_payload(cmd->payload);
 
       silc_server_packet_send(server, SILC_PRIMARY_ROUTE(server),
@@ -4395,7 +4574,7 @@ SILC_SERVER_CMD_FUNC(watch)
 
     /* Get the argument from the Argument List Payload */
     SILC_GET16_MSB(pkargc, pk);
-    pkargs = silc_argument_payload_parse(pk + 2, pk_len - 2, pkargc);
+    pkargs = silc_argument_payload_parse(pk + 2, pk_len - 2, pkargc, NULL);
     if (!pkargs) {
       silc_server_command_send_status_reply(cmd, SILC_COMMAND_WATCH,
 					    SILC_STATUS_ERR_NOT_ENOUGH_PARAMS,
@@ -4479,7 +4658,7 @@ SILC_SERVER_CMD_FUNC(watch)
     cmd->server->stat.commands_sent++;
 
     old_ident = silc_command_get_ident(cmd->payload);
-    silc_command_set_ident(cmd->payload, ++server->cmd_ident);
+    silc_command_set_ident(cmd->payload, silc_server_command_ident(server));
     tmpbuf = silc_command_payload_encode_payload(cmd->payload);
     silc_server_backup_send(server, silc_packet_get_context(cmd->sock),
 			    SILC_PACKET_COMMAND,
@@ -4691,7 +4870,7 @@ SILC_SERVER_CMD_FUNC(ban)
   if (tmp && len2 > 2) {
     /* Parse the arguments to see they are constructed correctly */
     SILC_GET16_MSB(argc, tmp);
-    args = silc_argument_payload_parse(tmp + 2, len2 - 2, argc);
+    args = silc_argument_payload_parse(tmp + 2, len2 - 2, argc, NULL);
     if (!args) {
       silc_server_command_send_status_reply(cmd, SILC_COMMAND_BAN,
 					    SILC_STATUS_ERR_NOT_ENOUGH_PARAMS,
@@ -4937,7 +5116,7 @@ SILC_SERVER_CMD_FUNC(users)
       /* Statistics */
       cmd->server->stat.commands_sent++;
 
-      silc_command_set_ident(cmd->payload, ++server->cmd_ident);
+      silc_command_set_ident(cmd->payload, silc_server_command_ident(server));
       tmpbuf = silc_command_payload_encode_payload(cmd->payload);
 
       /* Send USERS command */
@@ -5092,7 +5271,7 @@ SILC_SERVER_CMD_FUNC(getkey)
       cmd->server->stat.commands_sent++;
 
       old_ident = silc_command_get_ident(cmd->payload);
-      silc_command_set_ident(cmd->payload, ++server->cmd_ident);
+      silc_command_set_ident(cmd->payload, silc_server_command_ident(server));
       tmpbuf = silc_command_payload_encode_payload(cmd->payload);
 
       silc_server_packet_send(server, dest_sock,
@@ -5147,7 +5326,7 @@ SILC_SERVER_CMD_FUNC(getkey)
       cmd->server->stat.commands_sent++;
 
       old_ident = silc_command_get_ident(cmd->payload);
-      silc_command_set_ident(cmd->payload, ++server->cmd_ident);
+      silc_command_set_ident(cmd->payload, silc_server_command_ident(server));
       tmpbuf = silc_command_payload_encode_payload(cmd->payload);
 
       silc_server_packet_send(server, SILC_PRIMARY_ROUTE(server),
@@ -59,7 +59,10 @@ typedef struct {
 } *SilcServerCommandContext;
 
 /* Structure holding pending commands. If command is pending it will be
-   executed after command reply has been received and executed. */
+   executed after command reply has been received and executed.  Pending
+   commands are hashed by the command identifier and pending commands
+   with same identifier are in the `next' list in the order they were
+   added. */
 typedef struct SilcServerCommandPendingStruct {
   SilcCommand reply_cmd;
   SilcUInt16 ident;
@@ -70,6 +73,9 @@ typedef struct SilcServerCommandPendingStruct {
   struct SilcServerCommandPendingStruct *next;
 } SilcServerCommandPending;
 
+/* Maximum number of unused pending command contexts kept for reuse */
+#define SILC_SERVER_PENDING_POOL 256
+
 #include "command_reply.h"
 
 /* Macros */
@@ -125,6 +131,8 @@ silc_server_command_pending_check(SilcServer server,
 				  SilcCommand command,
 				  SilcUInt16 ident,
 				  SilcUInt32 *callbacks_count);
+void silc_server_command_pending_free(SilcServer server);
+SilcUInt16 silc_server_command_ident(SilcServer server);
 SILC_SERVER_CMD_FUNC(whois);
 SILC_SERVER_CMD_FUNC(whowas);
 SILC_SERVER_CMD_FUNC(identify);
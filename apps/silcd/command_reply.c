@@ -927,7 +927,8 @@ SILC_SERVER_CMD_REPLY_FUNC(motd)
          the client that there is no such server */
       tmp = silc_argument_get_arg_type(cmd->args, 2, &tmp_len);
       buffer = silc_command_payload_encode_va(SILC_COMMAND_IDENTIFY,
-	  				      ++server->cmd_ident, 5,
+					      silc_server_command_ident(server),
+					      5,
 					      1, NULL, 0, 2, NULL, 0,
 					      3, NULL, 0, 4, NULL, 0,
 					      5, tmp, tmp_len);
@@ -1120,7 +1121,7 @@ SILC_SERVER_CMD_REPLY_FUNC(join)
     SilcArgumentPayload iargs;
     SilcUInt16 iargc;
     SILC_GET16_MSB(iargc, tmp);
-    iargs = silc_argument_payload_parse(tmp + 2, len - 2, iargc);
+    iargs = silc_argument_payload_parse(tmp + 2, len - 2, iargc, NULL);
     if (iargs) {
       /* Delete old ban list */
       if (entry->ban_list)
@@ -1142,7 +1143,7 @@ SILC_SERVER_CMD_REPLY_FUNC(join)
     SilcArgumentPayload iargs;
     SilcUInt16 iargc;
     SILC_GET16_MSB(iargc, tmp);
-    iargs = silc_argument_payload_parse(tmp + 2, len - 2, iargc);
+    iargs = silc_argument_payload_parse(tmp + 2, len - 2, iargc, NULL);
     if (iargs) {
       /* Delete old invite list */
       if (entry->invite_list)
@@ -1292,7 +1293,8 @@ SILC_SERVER_CMD_REPLY_FUNC(users)
 
       idp = silc_id_payload_encode(SILC_ID_GET_ID(id), SILC_ID_CHANNEL);
       silc_server_send_command(server, SILC_PRIMARY_ROUTE(server),
-			       SILC_COMMAND_IDENTIFY, ++server->cmd_ident,
+			       SILC_COMMAND_IDENTIFY,
+			       silc_server_command_ident(server),
 			       1, 5, idp->data, silc_buffer_len(idp));
       silc_buffer_free(idp);
 
@@ -93,7 +93,11 @@ silc_idlist_add_server(SilcIDList id_list,
       return NULL;
   }
 
-  server = silc_calloc(1, sizeof(*server));
+  server = silc_slab_get(id_list->slabs->servers);
+  if (!server) {
+    silc_free(server_namec);
+    return NULL;
+  }
   server->server_name = server_name;
   server->server_type = server_type;
   server->id = id;
@@ -102,11 +106,13 @@ silc_idlist_add_server(SilcIDList id_list,
 
   if (!silc_idcache_add(id_list->servers, server_namec,
 			(void *)server->id, (void *)server)) {
-    silc_free(server);
+    silc_slab_put(id_list->slabs->servers, server);
     silc_free(server_namec);
     return NULL;
   }
 
+  silc_server_route_add(id_list, server);
+
   return server;
 }
 
@@ -242,15 +248,38 @@ silc_idlist_replace_server_id(SilcIDList id_list, SilcServerID *old_id,
 
   /* Remove the old entry and add a new one */
 
+  silc_server_route_del(id_list, server);
   silc_idcache_del_by_id(id_list->servers, (void *)server->id, NULL);
   *server->id = *new_id;
   silc_idcache_add(id_list->servers, name, server->id, server);
+  silc_server_route_add(id_list, server);
 
   SILC_LOG_DEBUG(("Found"));
 
   return server;
 }
 
+/* Empties the client and channel lists of server entry.  The entries
+   are not deleted and their `router' is left as is. */
+
+static void silc_idlist_server_detach(SilcServerEntry entry)
+{
+  SilcClientEntry client;
+  SilcChannelEntry channel;
+
+  while ((client = entry->clients)) {
+    entry->clients = client->router_next;
+    client->router_list = NULL;
+    client->router_next = client->router_prev = NULL;
+  }
+  while ((channel = entry->channels)) {
+    entry->channels = channel->router_next;
+    channel->router_list = NULL;
+    channel->router_next = channel->router_prev = NULL;
+  }
+  entry->num_clients = 0;
+}
+
 /* Removes and free's server entry from ID list */
 
 int silc_idlist_del_server(SilcIDList id_list, SilcServerEntry entry)
@@ -261,19 +290,23 @@ int silc_idlist_del_server(SilcIDList id_list, SilcServerEntry entry)
       SILC_LOG_DEBUG(("Unknown server, did not delete"));
       return FALSE;
     }
+    silc_server_route_del(id_list, entry);
 
     SILC_LOG_DEBUG(("Deleting server %s id %s", entry->server_name ?
 		    entry->server_name : "",
 		    entry->id ?
 		    silc_id_render(entry->id, SILC_ID_SERVER) : ""));
 
+    /* Detach the clients and channels still originated from this server */
+    silc_idlist_server_detach(entry);
+
     /* Free data */
     silc_free(entry->server_name);
     silc_free(entry->id);
     silc_free(entry->server_info);
 
     memset(entry, 'F', sizeof(*entry));
-    silc_free(entry);
+    silc_slab_put(id_list->slabs->servers, entry);
     return TRUE;
   }
 
@@ -338,26 +371,33 @@ silc_idlist_add_client(SilcIDList id_list, char *nickname, char *username,
       return NULL;
   }
 
-  client = silc_calloc(1, sizeof(*client));
+  client = silc_slab_get(id_list->slabs->clients);
   if (!client)
     return NULL;
   client->nickname = nickname;
   client->username = username ? strdup(username) : NULL;
   client->userinfo = userinfo;
   client->id = id;
-  client->router = router;
   client->connection = connection;
   client->channels = silc_hash_table_alloc(3, silc_hash_ptr, NULL,
 					   NULL, NULL, NULL, NULL, TRUE);
+  if (!client->channels) {
+    silc_slab_put(id_list->slabs->clients, client);
+    silc_free(nicknamec);
+    return NULL;
+  }
+  silc_hash_table_set_slab(client->channels, id_list->slabs->hash);
 
   if (!silc_idcache_add(id_list->clients, nicknamec, (void *)client->id,
 			(void *)client)) {
     silc_hash_table_free(client->channels);
-    silc_free(client);
+    silc_slab_put(id_list->slabs->clients, client);
     silc_free(nicknamec);
     return NULL;
   }
 
+  silc_idlist_client_set_router(client, router);
+
   return client;
 }
 
@@ -380,6 +420,40 @@ int silc_idlist_del_client(SilcIDList id_list, SilcClientEntry entry)
   return FALSE;
 }
 
+/* Sets the router of the client and moves the client from the client list
+   of the old router to the list of the new router. */
+
+void silc_idlist_client_set_router(SilcClientEntry client,
+				   SilcServerEntry router)
+{
+  SilcServerEntry old = client->router_list;
+
+  client->router = router;
+  if (old == router)
+    return;
+
+  if (old) {
+    if (client->router_prev)
+      client->router_prev->router_next = client->router_next;
+    else
+      old->clients = client->router_next;
+    if (client->router_next)
+      client->router_next->router_prev = client->router_prev;
+    old->num_clients--;
+  }
+
+  client->router_prev = NULL;
+  client->router_next = NULL;
+  if (router) {
+    client->router_next = router->clients;
+    if (router->clients)
+      router->clients->router_prev = client;
+    router->clients = client;
+    router->num_clients++;
+  }
+  client->router_list = router;
+}
+
 /* ID Cache destructor */
 
 void silc_idlist_client_destructor(SilcIDCache cache,
@@ -398,6 +472,7 @@ void silc_idlist_client_destructor(SilcIDCache cache,
 			      client);
 
     assert(!silc_hash_table_count(client->channels));
+    silc_idlist_client_set_router(client, NULL);
     silc_free(entry->name);
     silc_free(client->nickname);
     silc_free(client->servername);
@@ -408,7 +483,7 @@ void silc_idlist_client_destructor(SilcIDCache cache,
     silc_hash_table_free(client->channels);
 
     memset(client, 'A', sizeof(*client));
-    silc_free(client);
+    silc_slab_put(server->local_list->slabs->clients, client);
   }
 }
 
@@ -532,6 +607,36 @@ silc_idlist_find_client_by_id(SilcIDList id_list, SilcClientID *id,
   return client;
 }
 
+/* Finds client by encoded Client ID, as it is in packet, without decoding
+   it.  The client is found from both local and global list with one
+   lookup from the Client ID directory they share.  If `ret_local' is
+   provided it is set to TRUE if the client is in `id_list' and FALSE if
+   it is in the other list. */
+
+SilcClientEntry
+silc_idlist_find_client_by_id_str(SilcIDList id_list, const unsigned char *id,
+				  SilcUInt32 id_len, SilcBool registered,
+				  SilcBool *ret_local)
+{
+  SilcIDCacheEntry id_cache;
+  SilcClientEntry client;
+
+  id_cache = silc_idcache_directory_find(id_list->client_dir, id, id_len);
+  if (!id_cache)
+    return NULL;
+
+  client = (SilcClientEntry)id_cache->context;
+
+  if (client && registered &&
+      !(client->data.status & SILC_IDLIST_STATUS_REGISTERED))
+    return NULL;
+
+  if (ret_local)
+    *ret_local = id_cache->cache == id_list->clients;
+
+  return client;
+}
+
 /* Replaces old Client ID with new one */
 
 SilcClientEntry
@@ -614,33 +719,47 @@ silc_idlist_add_channel(SilcIDList id_list, char *channel_name, int mode,
       return NULL;
   }
 
-  channel = silc_calloc(1, sizeof(*channel));
+  channel = silc_slab_get(id_list->slabs->channels);
+  if (!channel) {
+    silc_free(channel_namec);
+    return NULL;
+  }
   channel->channel_name = channel_name;
   channel->mode = mode;
   channel->id = id;
-  channel->router = router;
   channel->send_key = send_key;
   channel->receive_key = receive_key;
   channel->hmac = hmac;
   channel->created = channel->updated = time(0);
   if (!channel->hmac)
     if (!silc_hmac_alloc(SILC_DEFAULT_HMAC, NULL, &channel->hmac)) {
-      silc_free(channel);
+      silc_slab_put(id_list->slabs->channels, channel);
+      silc_free(channel_namec);
       return NULL;
     }
 
   channel->user_list = silc_hash_table_alloc(3, silc_hash_ptr, NULL, NULL,
 					     NULL, NULL, NULL, TRUE);
+  if (!channel->user_list) {
+    silc_hmac_free(channel->hmac);
+    silc_slab_put(id_list->slabs->channels, channel);
+    silc_free(channel_namec);
+    return NULL;
+  }
+  silc_hash_table_set_slab(channel->user_list, id_list->slabs->hash);
 
   if (!silc_idcache_add(id_list->channels, channel_namec,
 			(void *)channel->id, (void *)channel)) {
     silc_hmac_free(channel->hmac);
     silc_hash_table_free(channel->user_list);
-    silc_free(channel);
+    silc_slab_put(id_list->slabs->channels, channel);
     silc_free(channel_namec);
     return NULL;
   }
 
+  id_list->channels_gen++;
+  silc_idlist_channel_set_router(channel, router);
+
   return channel;
 }
 
@@ -661,6 +780,7 @@ static void silc_idlist_del_channel_foreach(void *key, void *context,
 					    void *user_context)
 {
   SilcChannelClientEntry chl = (SilcChannelClientEntry)context;
+  SilcIDList id_list = user_context;
 
   SILC_LOG_DEBUG(("Removing client %s from channel %s",
 		  chl->client->nickname ? chl->client->nickname :
@@ -669,7 +789,7 @@ static void silc_idlist_del_channel_foreach(void *key, void *context,
   /* Remove the context from the client's channel hash table as that
      table and channel's user_list hash table share this same context. */
   silc_hash_table_del(chl->client->channels, chl->channel);
-  silc_free(chl);
+  silc_idlist_del_chl(id_list, chl);
 }
 
 /* Free channel entry.  This free's everything. */
@@ -682,6 +802,8 @@ int silc_idlist_del_channel(SilcIDList id_list, SilcChannelEntry entry)
       SILC_LOG_DEBUG(("Unknown channel, did not delete"));
       return FALSE;
     }
+    id_list->channels_gen++;
+    silc_idlist_channel_set_router(entry, NULL);
 
     SILC_LOG_DEBUG(("Deleting channel %s", entry->channel_name));
 
@@ -689,7 +811,7 @@ int silc_idlist_del_channel(SilcIDList id_list, SilcChannelEntry entry)
        will free all the entries so they are not freed at the foreach
        callback. */
     silc_hash_table_foreach(entry->user_list, silc_idlist_del_channel_foreach,
-			    NULL);
+			    id_list);
     silc_hash_table_free(entry->user_list);
 
     /* Free data */
@@ -719,15 +841,48 @@ int silc_idlist_del_channel(SilcIDList id_list, SilcChannelEntry entry)
       silc_pkcs_public_key_free(entry->founder_key);
     if (entry->channel_pubkeys)
       silc_hash_table_free(entry->channel_pubkeys);
+    silc_free(entry->delivery);
 
     memset(entry, 'F', sizeof(*entry));
-    silc_free(entry);
+    silc_slab_put(id_list->slabs->channels, entry);
     return TRUE;
   }
 
   return FALSE;
 }
 
+/* Sets the router of the channel and moves the channel from the channel
+   list of the old router to the list of the new router. */
+
+void silc_idlist_channel_set_router(SilcChannelEntry channel,
+				    SilcServerEntry router)
+{
+  SilcServerEntry old = channel->router_list;
+
+  channel->router = router;
+  if (old == router)
+    return;
+
+  if (old) {
+    if (channel->router_prev)
+      channel->router_prev->router_next = channel->router_next;
+    else
+      old->channels = channel->router_next;
+    if (channel->router_next)
+      channel->router_next->router_prev = channel->router_prev;
+  }
+
+  channel->router_prev = NULL;
+  channel->router_next = NULL;
+  if (router) {
+    channel->router_next = router->channels;
+    if (router->channels)
+      router->channels->router_prev = channel;
+    router->channels = channel;
+  }
+  channel->router_list = router;
+}
+
 /* Finds channel by channel name. Channel names are unique and they
    are not case-sensitive.  The 'name' must be normalized already. */
 
@@ -784,6 +939,32 @@ silc_idlist_find_channel_by_id(SilcIDList id_list, SilcChannelID *id,
   return channel;
 }
 
+/* Finds channel by encoded Channel ID from both local and global list.
+   See silc_idlist_find_client_by_id_str. */
+
+SilcChannelEntry
+silc_idlist_find_channel_by_id_str(SilcIDList id_list,
+				   const unsigned char *id, SilcUInt32 id_len,
+				   SilcBool *ret_local)
+{
+  SilcIDCacheEntry id_cache;
+  SilcChannelEntry channel;
+
+  id_cache = silc_idcache_directory_find(id_list->channel_dir, id, id_len);
+  if (!id_cache)
+    return NULL;
+
+  channel = (SilcChannelEntry)id_cache->context;
+
+  if (ret_local)
+    *ret_local = id_cache->cache == id_list->channels;
+
+  /* Touch channel */
+  channel->updated = time(NULL);
+
+  return channel;
+}
+
 /* Replaces old Channel ID with new one. This is done when router forces
    normal server to change Channel ID. */
 
@@ -859,3 +1040,60 @@ silc_idlist_get_channels(SilcIDList id_list, SilcChannelID *channel_id,
 
   return channels;
 }
+
+/* Allocates the slabs for ID list entries.  The same slabs are set to
+   both local and global list. */
+
+SilcIDListSlabs silc_idlist_slabs_alloc(void)
+{
+  SilcIDListSlabs slabs;
+
+  slabs = silc_calloc(1, sizeof(*slabs));
+  if (!slabs)
+    return NULL;
+
+  slabs->servers = silc_slab_alloc(sizeof(struct SilcServerEntryStruct), 32);
+  slabs->clients = silc_slab_alloc(sizeof(struct SilcClientEntryStruct), 0);
+  slabs->channels = silc_slab_alloc(sizeof(struct SilcChannelEntryStruct), 0);
+  slabs->chl = silc_slab_alloc(sizeof(struct SilcChannelClientEntryStruct),
+			       1024);
+  slabs->hash = silc_hash_table_slab_alloc(1024);
+  if (!slabs->servers || !slabs->clients || !slabs->channels ||
+      !slabs->chl || !slabs->hash) {
+    silc_idlist_slabs_free(slabs);
+    return NULL;
+  }
+
+  return slabs;
+}
+
+/* Frees the slabs.  All entries must have been freed before this. */
+
+void silc_idlist_slabs_free(SilcIDListSlabs slabs)
+{
+  if (!slabs)
+    return;
+
+  silc_slab_free(slabs->servers);
+  silc_slab_free(slabs->clients);
+  silc_slab_free(slabs->channels);
+  silc_slab_free(slabs->chl);
+  silc_slab_free(slabs->hash);
+  silc_free(slabs);
+}
+
+/* Allocates new channel client entry.  Caller adds it to the channel's
+   user list and to the client's channel list. */
+
+SilcChannelClientEntry silc_idlist_add_chl(SilcIDList id_list)
+{
+  return silc_slab_get(id_list->slabs->chl);
+}
+
+/* Frees channel client entry.  Caller must have removed it from the
+   channel's user list and from the client's channel list. */
+
+void silc_idlist_del_chl(SilcIDList id_list, SilcChannelClientEntry chl)
+{
+  silc_slab_put(id_list->slabs->chl, chl);
+}
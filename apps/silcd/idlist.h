@@ -78,6 +78,9 @@ struct SilcIDListDataObject {
   long last_receive;		/* Time last received data */
   long last_sent;		/* Time last sent data */
 
+  SilcUInt32 transit_packets;	/* Transit packets forwarded to link */
+  SilcUInt64 transit_bytes;	/* Transit payload bytes forwarded to link */
+
   unsigned long created;	/* Time when entry was created */
 
   SilcIDListStatus status;	/* Status mask of the entry */
@@ -146,6 +149,26 @@ struct SilcIDListDataObject {
        but as just said, this is usually pointer to the socket connection
        list.
 
+   SilcClientEntry clients
+   SilcChannelEntry channels
+   SilcUInt32 num_clients
+
+       Clients and channels whose `router' this server is, linked through
+       their `router_next' and `router_prev' pointers, and the number of
+       the clients.  These let netsplit and backup router handling find
+       the entries of one server without going through the whole ID lists.
+       The lists are maintained by silc_idlist_client_set_router and
+       silc_idlist_channel_set_router.
+
+   SilcUInt32 delivery_build
+   SilcUInt32 delivery_index
+
+       Set when channel delivery list is built and this server is the
+       route of some client on the channel.  The `delivery_build' is the
+       number of the build and `delivery_index' is the index of this
+       server in the list.  These let the build add each route only once
+       without searching the list.
+
 */
 struct SilcServerEntryStruct {
   /* Generic data structure. DO NOT add anything before this! */
@@ -163,6 +186,15 @@ struct SilcServerEntryStruct {
   /* Connection data */
   void *connection;
 
+  /* Clients and channels originated from this server */
+  SilcClientEntry clients;
+  SilcChannelEntry channels;
+  SilcUInt32 num_clients;
+
+  /* Channel delivery list build marker */
+  SilcUInt32 delivery_build;
+  SilcUInt32 delivery_index;
+
   void *backup_proto;
   unsigned int backup  : 1;	/* Set when executing backup protocol */
 };
@@ -287,7 +319,9 @@ typedef struct SilcChannelClientEntryStruct {
 
        This is a pointer to the server list. This is the router server whose
        cell this client is coming from. This is used to route messages to
-       this client.
+       this client.  This must be changed only with the function
+       silc_idlist_client_set_router, which also keeps the client in the
+       router's client list.
 
    SilcHashTable channels;
 
@@ -339,6 +373,11 @@ struct SilcClientEntryStruct {
   /* Pointer to the router */
   SilcServerEntry router;
 
+  /* Links in the client list of `router_list', the router */
+  SilcServerEntry router_list;
+  SilcClientEntry router_next;
+  SilcClientEntry router_prev;
+
   /* All channels this client has joined */
   SilcHashTable channels;
 
@@ -361,6 +400,27 @@ struct SilcClientEntryStruct {
   unsigned local_detached : 1;
 };
 
+/*
+   Channel delivery list entry.
+
+   The `entry' is a locally connected client (SilcClientEntry) or a next-hop
+   server (SilcServerEntry) through which remote clients on the channel are
+   reached.  The `deliver' is a mask of SILC_CHANNEL_DELIVER_* sender
+   classes whose channel messages are delivered to this entry.  For server
+   entry it is the combined mask of all clients behind that server.
+
+*/
+typedef struct {
+  void *entry;
+  SilcUInt32 deliver;
+} *SilcChannelDelivery, SilcChannelDeliveryStruct;
+
+/* Channel message sender classes for SilcChannelDelivery deliver mask */
+#define SILC_CHANNEL_DELIVER_USER        0x01  /* Normal user */
+#define SILC_CHANNEL_DELIVER_OP          0x02  /* Channel operator/founder */
+#define SILC_CHANNEL_DELIVER_ROBOT       0x04  /* Robot */
+#define SILC_CHANNEL_DELIVER_OP_ROBOT    0x08  /* Robot channel operator */
+
 /*
    SILC Channel entry object.
 
@@ -436,7 +496,8 @@ struct SilcClientEntryStruct {
 
        This is a pointer to the server list. This is the router server
        whose cell this channel belongs to. This is used to route messages
-       to this channel.
+       to this channel.  This must be changed only with the function
+       silc_idlist_channel_set_router.
 
    SilcCipher send_key
    SilcCipher receive_key
@@ -461,6 +522,16 @@ struct SilcClientEntryStruct {
 
        Channel key re-key context.
 
+   SilcChannelDelivery delivery
+
+       Precomputed delivery list of the channel.  It holds first the
+       locally connected clients and then the unique next-hop servers
+       of the remote clients on the channel.  It is built from `user_list'
+       when packet is sent to the channel and `delivery_gen' does not match
+       the server's delivery generation.  It is invalidated when users join
+       or leave the channel, their message blocking modes change or when
+       the routes of the clients change.
+
 */
 struct SilcChannelEntryStruct {
   char *channel_name;
@@ -484,6 +555,11 @@ struct SilcChannelEntryStruct {
   /* Pointer to the router */
   SilcServerEntry router;
 
+  /* Links in the channel list of `router_list', the router */
+  SilcServerEntry router_list;
+  SilcChannelEntry router_next;
+  SilcChannelEntry router_prev;
+
   /* Channel keys */
   SilcCipher send_key;
   SilcCipher receive_key;
@@ -495,6 +571,12 @@ struct SilcChannelEntryStruct {
   unsigned long created;
   unsigned long updated;
 
+  /* Precomputed delivery list */
+  SilcChannelDelivery delivery;
+  SilcUInt32 delivery_local;
+  SilcUInt32 delivery_count;
+  SilcUInt32 delivery_gen;
+
   /* Flags */
   unsigned int global_users : 1;
   unsigned int disabled : 1;
@@ -536,11 +618,28 @@ struct SilcChannelEntryStruct {
    has a specific context pointer to allocated entry (server, client or
    channel entry).
 
+   The entries are allocated from the slabs.  Local and global list share
+   the same slabs since entries may move from one list to the other.
+
 */
+typedef struct SilcIDListSlabsStruct {
+  SilcSlab servers;		/* Server entries */
+  SilcSlab clients;		/* Client entries */
+  SilcSlab channels;		/* Channel entries */
+  SilcSlab chl;			/* Channel client entries */
+  SilcSlab hash;		/* User list and channel list entries */
+} *SilcIDListSlabs;
+
 struct SilcIDListStruct {
   SilcIDCache servers;
   SilcIDCache clients;
   SilcIDCache channels;
+  SilcIDListSlabs slabs;
+  SilcHashTable routes;		/* Routing table, shared like slabs */
+  SilcIDDirectory client_dir;	/* Client ID directory, shared */
+  SilcIDDirectory channel_dir;	/* Channel ID directory, shared */
+  SilcUInt32 channels_gen;	/* Incremented when channel is added or
+				   deleted */
 };
 
 /*
@@ -600,6 +699,8 @@ silc_idlist_add_client(SilcIDList id_list, char *nickname, char *username,
 		       char *userinfo, SilcClientID *id,
 		       SilcServerEntry router, void *connection);
 int silc_idlist_del_client(SilcIDList id_list, SilcClientEntry entry);
+void silc_idlist_client_set_router(SilcClientEntry client,
+				   SilcServerEntry router);
 int silc_idlist_get_clients_by_nickname(SilcIDList id_list, char *nickname,
 					char *server,
 					SilcClientEntry **clients,
@@ -613,6 +714,10 @@ SilcClientEntry
 silc_idlist_find_client_by_id(SilcIDList id_list, SilcClientID *id,
 			      SilcBool registered, SilcIDCacheEntry *ret_entry);
 SilcClientEntry
+silc_idlist_find_client_by_id_str(SilcIDList id_list, const unsigned char *id,
+				  SilcUInt32 id_len, SilcBool registered,
+				  SilcBool *ret_local);
+SilcClientEntry
 silc_idlist_replace_client_id(SilcServer server,
 			      SilcIDList id_list, SilcClientID *old_id,
 			      SilcClientID *new_id, const char *nickname);
@@ -630,6 +735,8 @@ void silc_idlist_channel_destructor(SilcIDCache cache,
 				    void *dest_context,
 				    void *app_context);
 int silc_idlist_del_channel(SilcIDList id_list, SilcChannelEntry entry);
+void silc_idlist_channel_set_router(SilcChannelEntry channel,
+				    SilcServerEntry router);
 SilcChannelEntry
 silc_idlist_find_channel_by_name(SilcIDList id_list, char *name,
 				 SilcIDCacheEntry *ret_entry);
@@ -637,10 +744,18 @@ SilcChannelEntry
 silc_idlist_find_channel_by_id(SilcIDList id_list, SilcChannelID *id,
 			       SilcIDCacheEntry *ret_entry);
 SilcChannelEntry
+silc_idlist_find_channel_by_id_str(SilcIDList id_list,
+				   const unsigned char *id, SilcUInt32 id_len,
+				   SilcBool *ret_local);
+SilcChannelEntry
 silc_idlist_replace_channel_id(SilcIDList id_list, SilcChannelID *old_id,
 			       SilcChannelID *new_id);
 SilcChannelEntry *
 silc_idlist_get_channels(SilcIDList id_list, SilcChannelID *channel_id,
 			 SilcUInt32 *channels_count);
+SilcIDListSlabs silc_idlist_slabs_alloc(void);
+void silc_idlist_slabs_free(SilcIDListSlabs slabs);
+SilcChannelClientEntry silc_idlist_add_chl(SilcIDList id_list);
+void silc_idlist_del_chl(SilcIDList id_list, SilcChannelClientEntry chl);
 
 #endif
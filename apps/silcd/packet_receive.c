@@ -77,7 +77,8 @@ static void silc_server_notify_process(SilcServer server,
   }
 
   /* Parse the Notify Payload */
-  payload = silc_notify_payload_parse(buffer->data, silc_buffer_len(buffer));
+  payload = silc_notify_payload_parse(buffer->data, silc_buffer_len(buffer),
+				      server->stack);
   if (!payload) {
     SILC_LOG_DEBUG(("Marlformed notify payload"));
     return;
@@ -220,7 +221,7 @@ static void silc_server_notify_process(SilcServer server,
 
     /* JOIN the global client to the channel (local clients (if router
        created the channel) is joined in the pending JOIN command). */
-    chl = silc_calloc(1, sizeof(*chl));
+    chl = silc_idlist_add_chl(server->local_list);
     if (!chl)
       goto out;
     chl->client = client;
@@ -244,6 +245,7 @@ static void silc_server_notify_process(SilcServer server,
     silc_hash_table_add(channel->user_list, client, chl);
     silc_hash_table_add(client->channels, channel, chl);
     channel->user_count++;
+    SILC_CHANNEL_DELIVERY_RESET(channel);
     channel->disabled = FALSE;
 
     /* Update statistics */
@@ -377,8 +379,9 @@ static void silc_server_notify_process(SilcServer server,
 
     client->data.status &= ~SILC_IDLIST_STATUS_REGISTERED;
     client->mode = 0;
-    client->router = NULL;
+    silc_idlist_client_set_router(client, NULL);
     client->connection = NULL;
+    silc_server_client_delivery_reset(client);
     client->data.created = silc_time();
     silc_dlist_del(server->expired_clients, client);
     silc_dlist_add(server->expired_clients, client);
@@ -923,6 +926,9 @@ static void silc_server_notify_process(SilcServer server,
       if (!silc_server_client_on_channel(client2, channel, &chl))
 	goto out;
 
+      /* Delivery list carries the message blocking modes */
+      SILC_CHANNEL_DELIVERY_RESET(channel);
+
       if (server->server_type == SILC_SERVER && chl->mode == mode) {
 	SILC_LOG_DEBUG(("Mode is changed already"));
 	break;
@@ -1075,7 +1081,8 @@ static void silc_server_notify_process(SilcServer server,
 
       /* Parse the arguments to see they are constructed correctly */
       SILC_GET16_MSB(iargc, tmp);
-      iargs = silc_argument_payload_parse(tmp + 2, tmp_len - 2, iargc);
+      iargs = silc_argument_payload_parse(tmp + 2, tmp_len - 2, iargc,
+					  server->stack);
       if (!iargs)
 	goto out;
 
@@ -1168,30 +1175,12 @@ static void silc_server_notify_process(SilcServer server,
       /* Re-announce our clients on the channel as the ID has changed now */
       silc_server_announce_get_channel_users(server, channel, &modes, &users,
 					     &users_modes);
-      if (users) {
-	silc_buffer_push(users, users->data - users->head);
-	silc_server_packet_send(server, sock,
-				SILC_PACKET_NOTIFY, SILC_PACKET_FLAG_LIST,
-				users->data, silc_buffer_len(users));
-	silc_buffer_free(users);
-      }
-      if (modes) {
-	silc_buffer_push(modes, modes->data - modes->head);
-	silc_server_packet_send_dest(server, sock,
-				     SILC_PACKET_NOTIFY, SILC_PACKET_FLAG_LIST,
-				     channel->id, SILC_ID_CHANNEL,
-				     modes->data, silc_buffer_len(modes));
-	silc_buffer_free(modes);
-      }
-      if (users_modes) {
-	silc_buffer_push(users_modes, users_modes->data - users_modes->head);
-	silc_server_packet_send_dest(server, sock,
-				     SILC_PACKET_NOTIFY, SILC_PACKET_FLAG_LIST,
-				     channel->id, SILC_ID_CHANNEL,
-				     users_modes->data,
-				     silc_buffer_len(users_modes));
-	silc_buffer_free(users_modes);
-      }
+      silc_server_announce_send(server, sock, SILC_PACKET_NOTIFY, NULL,
+				users);
+      silc_server_announce_send(server, sock, SILC_PACKET_NOTIFY,
+				channel->id, modes);
+      silc_server_announce_send(server, sock, SILC_PACKET_NOTIFY,
+				channel->id, users_modes);
 
       /* Re-announce channel's topic */
       if (channel->topic) {
@@ -1415,7 +1404,8 @@ static void silc_server_notify_process(SilcServer server,
       SilcArgumentPayload iargs;
       tmp = silc_argument_get_arg_type(args, 1, &tmp_len);
       ab = silc_argument_payload_encode_one(NULL, tmp, tmp_len, 3);
-      iargs = silc_argument_payload_parse(ab->data, silc_buffer_len(ab), 1);
+      iargs = silc_argument_payload_parse(ab->data, silc_buffer_len(ab), 1,
+					  server->stack);
       silc_server_inviteban_process(server, channel->invite_list, 1, iargs);
       silc_buffer_free(ab);
       silc_argument_payload_free(iargs);
@@ -1535,8 +1525,9 @@ static void silc_server_notify_process(SilcServer server,
 
       client->data.status &= ~SILC_IDLIST_STATUS_REGISTERED;
       client->mode = 0;
-      client->router = NULL;
+      silc_idlist_client_set_router(client, NULL);
       client->connection = NULL;
+      silc_server_client_delivery_reset(client);
       client->data.created = silc_time();
       silc_dlist_del(server->expired_clients, client);
       silc_dlist_add(server->expired_clients, client);
@@ -1642,7 +1633,8 @@ static void silc_server_notify_process(SilcServer server,
 
       /* Parse the arguments to see they are constructed correctly */
       SILC_GET16_MSB(iargc, tmp);
-      iargs = silc_argument_payload_parse(tmp + 2, tmp_len - 2, iargc);
+      iargs = silc_argument_payload_parse(tmp + 2, tmp_len - 2, iargc,
+					  server->stack);
       if (!iargs)
 	goto out;
 
@@ -1759,8 +1751,11 @@ void silc_server_notify_list(SilcServer server,
     silc_buffer_pull_tail(buffer, len);
     silc_buffer_put(buffer, packet->buffer.data, len);
 
-    /* Process the Notify */
+    /* Process the Notify.  Each notify in the list is processed in its
+       own stack frame so that long lists do not grow the stack. */
+    silc_stack_push(server->stack, NULL);
     silc_server_notify_process(server, sock, packet, buffer);
+    silc_stack_pop(server->stack);
 
     silc_buffer_push_tail(buffer, len);
     silc_buffer_pull(&packet->buffer, len);
@@ -1943,7 +1938,6 @@ void silc_server_channel_message(SilcServer server,
 				 SilcPacket packet)
 {
   SilcChannelEntry channel = NULL;
-  SilcChannelID id;
   SilcClientID cid;
   SilcID sid;
   SilcClientEntry sender_entry = NULL;
@@ -1954,48 +1948,44 @@ void silc_server_channel_message(SilcServer server,
   SILC_LOG_DEBUG(("Processing channel message"));
 
   /* Sanity checks */
-  if (packet->dst_id_type != SILC_ID_CHANNEL) {
+  if (packet->dst_id_type != SILC_ID_CHANNEL || !packet->dst_id) {
     SILC_LOG_DEBUG(("Received bad message for channel, dropped"));
     goto out;
   }
 
-  /* Find channel entry */
-  if (!silc_id_str2id(packet->dst_id, packet->dst_id_len, SILC_ID_CHANNEL,
-		      &id, sizeof(id)))
-    goto out;
-  channel = silc_idlist_find_channel_by_id(server->local_list, &id, NULL);
+  /* Find channel entry from local and global list */
+  channel = silc_idlist_find_channel_by_id_str(server->local_list,
+					       packet->dst_id,
+					       packet->dst_id_len, NULL);
   if (!channel) {
-    channel = silc_idlist_find_channel_by_id(server->global_list, &id, NULL);
-    if (!channel) {
-      SilcBuffer idp;
-      unsigned char error;
-
-      /* Send SILC_NOTIFY_TYPE_ERROR to indicate that such destination ID
-	 does not exist or is invalid. */
-      idp = silc_id_payload_encode_data(packet->dst_id,
-					packet->dst_id_len,
-					packet->dst_id_type);
-      if (!idp)
-	goto out;
-
-      error = SILC_STATUS_ERR_NO_SUCH_CHANNEL_ID;
-      if (packet->src_id_type == SILC_ID_CLIENT) {
-	silc_id_str2id(packet->src_id, packet->src_id_len,
-		       packet->src_id_type, &cid, sizeof(cid));
-	silc_server_send_notify_dest(server, sock, FALSE,
-				     &cid, SILC_ID_CLIENT,
-				     SILC_NOTIFY_TYPE_ERROR, 2,
-				     &error, 1, idp->data,
-				     silc_buffer_len(idp));
-      } else {
-	silc_server_send_notify(server, sock, FALSE,
-				SILC_NOTIFY_TYPE_ERROR, 2,
-				&error, 1, idp->data, silc_buffer_len(idp));
-      }
+    SilcBuffer idp;
+    unsigned char error;
 
-      silc_buffer_free(idp);
+    /* Send SILC_NOTIFY_TYPE_ERROR to indicate that such destination ID
+       does not exist or is invalid. */
+    idp = silc_id_payload_encode_data(packet->dst_id,
+				      packet->dst_id_len,
+				      packet->dst_id_type);
+    if (!idp)
       goto out;
+
+    error = SILC_STATUS_ERR_NO_SUCH_CHANNEL_ID;
+    if (packet->src_id_type == SILC_ID_CLIENT) {
+      silc_id_str2id(packet->src_id, packet->src_id_len,
+		     packet->src_id_type, &cid, sizeof(cid));
+      silc_server_send_notify_dest(server, sock, FALSE,
+				   &cid, SILC_ID_CLIENT,
+				   SILC_NOTIFY_TYPE_ERROR, 2,
+				   &error, 1, idp->data,
+				   silc_buffer_len(idp));
+    } else {
+      silc_server_send_notify(server, sock, FALSE,
+			      SILC_NOTIFY_TYPE_ERROR, 2,
+			      &error, 1, idp->data, silc_buffer_len(idp));
     }
+
+    silc_buffer_free(idp);
+    goto out;
   }
 
   /* See that this client is on the channel. If the original sender is
@@ -2004,15 +1994,10 @@ void silc_server_channel_message(SilcServer server,
 		       packet->src_id_type, &sid))
     goto out;
   if (sid.type == SILC_ID_CLIENT) {
-    sender_entry = silc_idlist_find_client_by_id(server->local_list,
-						 SILC_ID_GET_ID(sid),
-						 TRUE, NULL);
-    if (!sender_entry) {
-      local = FALSE;
-      sender_entry = silc_idlist_find_client_by_id(server->global_list,
-						   SILC_ID_GET_ID(sid),
-						   TRUE, NULL);
-    }
+    sender_entry = silc_idlist_find_client_by_id_str(server->local_list,
+						     packet->src_id,
+						     packet->src_id_len,
+						     TRUE, &local);
     if (!sender_entry || !silc_server_client_on_channel(sender_entry,
 							channel, &chl)) {
       SILC_LOG_DEBUG(("Client not on channel"));
@@ -2380,6 +2365,7 @@ SilcServerEntry silc_server_new_server(SilcServer server,
     server->stat.cell_servers++;
 
   /* Remove the old cache entry */
+  silc_server_route_del(server->local_list, new_server);
   if (!silc_idcache_del_by_context(server->local_list->servers, new_server,
 				   NULL)) {
     if (!silc_idcache_del_by_context(server->global_list->servers,
@@ -2472,6 +2458,7 @@ SilcServerEntry silc_server_new_server(SilcServer server,
       silc_server_free_sock_user_data(server, sock, NULL);
       return NULL;
     } else {
+      silc_server_route_del(server->local_list, server_entry);
       silc_idcache_del_by_context(server->local_list->servers, server_entry,
 				  NULL);
     }
@@ -2488,6 +2475,7 @@ SilcServerEntry silc_server_new_server(SilcServer server,
 	silc_server_free_sock_user_data(server, sock, NULL);
 	return NULL;
       } else {
+	silc_server_route_del(server->global_list, server_entry);
 	silc_idcache_del_by_context(server->global_list->servers,
 				    server_entry, NULL);
       }
@@ -2519,6 +2507,7 @@ SilcServerEntry silc_server_new_server(SilcServer server,
   silc_idcache_add(local ? server->local_list->servers :
 		   server->global_list->servers, server_namec,
 		   new_server->id, new_server);
+  silc_server_route_add(server->local_list, new_server);
 
   /* Distribute the information about new server in the SILC network
      to our router. If we are normal server we won't send anything
@@ -2731,7 +2720,8 @@ static void silc_server_new_id_real(SilcServer server,
 					   entry, NULL);
 	} else {
 	  silc_server_send_command(server, router_sock,
-				   SILC_COMMAND_GETKEY, ++server->cmd_ident,
+				   SILC_COMMAND_GETKEY,
+				   silc_server_command_ident(server),
 				   1, 1, buffer->data,
 				   silc_buffer_len(buffer));
 	}
@@ -3126,30 +3116,12 @@ static void silc_server_new_channel_process(SilcServer server,
 	 users on the channel "joining" the channel. */
       silc_server_announce_get_channel_users(server, channel, &modes, &users,
 					     &users_modes);
-      if (users) {
-	silc_buffer_push(users, users->data - users->head);
-	silc_server_packet_send(server, sock,
-				SILC_PACKET_NOTIFY, SILC_PACKET_FLAG_LIST,
-				users->data, silc_buffer_len(users));
-	silc_buffer_free(users);
-      }
-      if (modes) {
-	silc_buffer_push(modes, modes->data - modes->head);
-	silc_server_packet_send_dest(server, sock,
-				     SILC_PACKET_NOTIFY, SILC_PACKET_FLAG_LIST,
-				     channel->id, SILC_ID_CHANNEL,
-				     modes->data, silc_buffer_len(modes));
-	silc_buffer_free(modes);
-      }
-      if (users_modes) {
-	silc_buffer_push(users_modes, users_modes->data - users_modes->head);
-	silc_server_packet_send_dest(server, sock,
-				     SILC_PACKET_NOTIFY, SILC_PACKET_FLAG_LIST,
-				     channel->id, SILC_ID_CHANNEL,
-				     users_modes->data,
-				     silc_buffer_len(users_modes));
-	silc_buffer_free(users_modes);
-      }
+      silc_server_announce_send(server, sock, SILC_PACKET_NOTIFY, NULL,
+				users);
+      silc_server_announce_send(server, sock, SILC_PACKET_NOTIFY,
+				channel->id, modes);
+      silc_server_announce_send(server, sock, SILC_PACKET_NOTIFY,
+				channel->id, users_modes);
       if (channel->topic) {
 	silc_server_send_notify_topic_set(server, sock,
 					  server->server_type == SILC_ROUTER ?
@@ -3634,7 +3606,8 @@ void silc_server_resume_client(SilcServer server,
 
 	silc_server_send_command(server, dest_sock ? dest_sock :
 				 SILC_PRIMARY_ROUTE(server),
-				 SILC_COMMAND_GETKEY, ++server->cmd_ident,
+				 SILC_COMMAND_GETKEY,
+				 silc_server_command_ident(server),
 				 1, 1, idp->data, silc_buffer_len(idp));
 
 	r = silc_calloc(1, sizeof(*r));
@@ -3716,6 +3689,7 @@ void silc_server_resume_client(SilcServer server,
     silc_schedule_task_del_by_context(server->schedule, detached_client);
     silc_packet_set_context(sock, detached_client);
     detached_client->connection = sock;
+    silc_server_client_delivery_reset(detached_client);
 
     if (detached_client->data.public_key) {
       /* Delete the detached client's public key from repository */
@@ -3810,7 +3784,8 @@ void silc_server_resume_client(SilcServer server,
 			      SILC_PACKET_RESUME_CLIENT, 0,
 			      buf->data, silc_buffer_len(buf));
     silc_buffer_free(buf);
-    client->router = NULL;
+    silc_idlist_client_set_router(client, NULL);
+    silc_server_client_delivery_reset(client);
 
     if (nick_change) {
       /* Notify about Client ID change, nickname doesn't actually change. */
@@ -3830,7 +3805,8 @@ void silc_server_resume_client(SilcServer server,
 			channel->channel_name));
 	if (channel->disabled || !channel->users_resolved) {
 	  silc_server_send_command(server, SILC_PRIMARY_ROUTE(server),
-				   SILC_COMMAND_USERS, ++server->cmd_ident,
+				   SILC_COMMAND_USERS,
+				   silc_server_command_ident(server),
 				   1, 2, channel->channel_name,
 				   strlen(channel->channel_name));
 	}
@@ -4064,7 +4040,8 @@ void silc_server_resume_client(SilcServer server,
      * a detached client.*/
     detached_client->local_detached = FALSE;
     /* Change the owner of the client */
-    detached_client->router = server_entry;
+    silc_idlist_client_set_router(detached_client, server_entry);
+    silc_server_client_delivery_reset(detached_client);
 
     /* Update channel information regarding global clients on channel. */
     if (server->server_type != SILC_ROUTER) {
@@ -120,6 +120,75 @@ SilcBool silc_server_packet_send_srcdest(SilcServer server,
 			      NULL, NULL);
 }
 
+/* Returns TRUE if `id_len' is valid length for encoded ID of `id_type'.
+   The ID may have IPv4 or IPv6 address. */
+
+static inline SilcBool silc_server_id_str_valid(SilcIdType id_type,
+						SilcUInt32 id_len)
+{
+  switch (id_type) {
+  case SILC_ID_SERVER:
+    return id_len == SILC_ID_SERVER_LEN || id_len == SILC_ID_SERVER_LEN + 12;
+  case SILC_ID_CLIENT:
+    return id_len == SILC_ID_CLIENT_LEN || id_len == SILC_ID_CLIENT_LEN + 12;
+  case SILC_ID_CHANNEL:
+    return id_len == SILC_ID_CHANNEL_LEN || id_len == SILC_ID_CHANNEL_LEN + 12;
+  }
+  return FALSE;
+}
+
+/* Forwards received transit packet to `sock'.  The source and destination
+   IDs and the payload are sent as they are in the received packet,
+   without decoding and encoding the IDs again.  The packet is counted as
+   transit traffic of the link it is sent to. */
+
+static SilcBool silc_server_packet_forward(SilcServer server,
+					   SilcPacketStream sock,
+					   SilcPacket packet)
+{
+  SilcIDListData idata;
+  SilcUInt32 data_len = silc_buffer_len(&packet->buffer);
+
+  if (!sock)
+    return FALSE;
+
+  if (silc_unlikely(!packet->src_id || !packet->dst_id ||
+		    !silc_server_id_str_valid(packet->src_id_type,
+					      packet->src_id_len) ||
+		    !silc_server_id_str_valid(packet->dst_id_type,
+					      packet->dst_id_len)))
+    return FALSE;
+
+  idata = silc_packet_get_context(sock);
+
+  /* If entry is disabled do not sent anything.  Allow hearbeat though */
+  if ((idata && idata->status & SILC_IDLIST_STATUS_DISABLED &&
+       packet->type != SILC_PACKET_HEARTBEAT) ||
+      ((SilcServerEntry)idata == server->id_entry)) {
+    SILC_LOG_DEBUG(("Connection is disabled"));
+    return FALSE;
+  }
+
+  SILC_LOG_DEBUG(("Forwarding %s packet",
+		  silc_get_packet_name(packet->type)));
+
+  if (!silc_packet_send_ext_str(sock, packet->type, packet->flags,
+				packet->src_id_type, packet->src_id,
+				packet->src_id_len, packet->dst_id_type,
+				packet->dst_id, packet->dst_id_len,
+				packet->buffer.data, data_len, NULL, NULL))
+    return FALSE;
+
+  server->stat.transit_packets++;
+  server->stat.transit_bytes += data_len;
+  if (idata) {
+    idata->transit_packets++;
+    idata->transit_bytes += data_len;
+  }
+
+  return TRUE;
+}
+
 /* Broadcast received packet to our primary route. This function is used
    by router to further route received broadcast packet. It is expected
    that the broadcast flag from the packet is checked before calling this
@@ -129,35 +198,28 @@ SilcBool silc_server_packet_broadcast(SilcServer server,
 				      SilcPacketStream primary_route,
 				      SilcPacket packet)
 {
-  SilcServerID src_id, dst_id;
+  unsigned char router_id[32];
+  SilcUInt32 router_id_len;
 
   if (!primary_route)
     return FALSE;
 
   SILC_LOG_DEBUG(("Broadcasting received broadcast packet"));
 
-  if (!silc_id_str2id(packet->src_id, packet->src_id_len, packet->src_id_type,
-		      &src_id, sizeof(src_id)))
-    return FALSE;
-  if (!silc_id_str2id(packet->dst_id, packet->dst_id_len, packet->dst_id_type,
-		      &dst_id, sizeof(dst_id)))
-    return FALSE;
-
   /* If the packet is originated from our primary route we are not allowed
      to send the packet. */
-  if (SILC_ID_SERVER_COMPARE(&src_id, server->router->id)) {
+  if (packet->src_id_type == SILC_ID_SERVER &&
+      silc_id_id2str(server->router->id, SILC_ID_SERVER, router_id,
+		     sizeof(router_id), &router_id_len) &&
+      packet->src_id_len == router_id_len &&
+      !memcmp(packet->src_id, router_id, router_id_len)) {
     SILC_LOG_DEBUG(("Will not broadcast to primary route since it is the "
 		    "original sender of this packet"));
     return FALSE;
   }
 
   /* Send the packet */
-  return silc_server_packet_send_srcdest(server, primary_route, packet->type,
-					 packet->flags, &src_id,
-					 SILC_ID_SERVER, &dst_id,
-					 SILC_ID_SERVER,
-					 packet->buffer.data,
-					 silc_buffer_len(&packet->buffer));
+  return silc_server_packet_forward(server, primary_route, packet);
 }
 
 /* Routes received packet to `sock'. This is used to route the packets that
@@ -167,23 +229,7 @@ SilcBool silc_server_packet_route(SilcServer server,
 				  SilcPacketStream sock,
 				  SilcPacket packet)
 {
-  SilcID src_id, dst_id;
-
-  if (!silc_id_str2id2(packet->src_id, packet->src_id_len, packet->src_id_type,
-		       &src_id))
-    return FALSE;
-  if (!silc_id_str2id2(packet->dst_id, packet->dst_id_len, packet->dst_id_type,
-		       &dst_id))
-    return FALSE;
-
-  return silc_server_packet_send_srcdest(server, sock, packet->type,
-					 packet->flags,
-					 SILC_ID_GET_ID(src_id),
-					 src_id.type,
-					 SILC_ID_GET_ID(dst_id),
-					 dst_id.type,
-					 packet->buffer.data,
-					 silc_buffer_len(&packet->buffer));
+  return silc_server_packet_forward(server, sock, packet);
 }
 
 /* This routine can be used to send a packet to table of clients provided
@@ -265,6 +311,117 @@ void silc_server_packet_send_clients(SilcServer server,
   silc_free(routed);
 }
 
+/* Returns the SILC_CHANNEL_DELIVER_* sender classes whose channel messages
+   are delivered to a channel user with channel user mode `mode'. */
+
+static inline SilcUInt32 silc_server_channel_deliver_mask(SilcUInt32 mode)
+{
+  SilcUInt32 mask = SILC_CHANNEL_DELIVER_OP | SILC_CHANNEL_DELIVER_OP_ROBOT;
+
+  if (mode & SILC_CHANNEL_UMODE_BLOCK_MESSAGES)
+    return 0;
+  if (!(mode & SILC_CHANNEL_UMODE_BLOCK_MESSAGES_USERS))
+    mask |= SILC_CHANNEL_DELIVER_USER | SILC_CHANNEL_DELIVER_ROBOT;
+  if (mode & SILC_CHANNEL_UMODE_BLOCK_MESSAGES_ROBOTS)
+    mask &= ~(SILC_CHANNEL_DELIVER_ROBOT | SILC_CHANNEL_DELIVER_OP_ROBOT);
+
+  return mask;
+}
+
+/* Returns the SILC_CHANNEL_DELIVER_* sender class of the channel message
+   sender `client' whose channel user entry is `chl'. */
+
+static inline SilcUInt32
+silc_server_channel_deliver_sender(SilcChannelClientEntry chl,
+				   SilcClientEntry client)
+{
+  SilcBool op = (chl->mode & (SILC_CHANNEL_UMODE_CHANOP |
+			      SILC_CHANNEL_UMODE_CHANFO)) != 0;
+
+  if (client->mode & SILC_UMODE_ROBOT)
+    return op ? SILC_CHANNEL_DELIVER_OP_ROBOT : SILC_CHANNEL_DELIVER_ROBOT;
+  return op ? SILC_CHANNEL_DELIVER_OP : SILC_CHANNEL_DELIVER_USER;
+}
+
+/* Builds the delivery list of the `channel' unless it is valid already.
+   Locally connected clients are put first in the list, and they are
+   followed by the unique next-hop servers of the remote clients.  The
+   deliver mask of a server entry is the combined mask of all clients
+   behind that server.  Returns FALSE on error. */
+
+static SilcBool silc_server_channel_delivery(SilcServer server,
+					     SilcChannelEntry channel)
+{
+  SilcChannelClientEntry chl;
+  SilcClientEntry client;
+  SilcServerEntry router;
+  SilcChannelDelivery d;
+  SilcHashTableList htl;
+  SilcUInt32 count, mask, build, l = 0, r, i;
+
+  if (channel->delivery_gen == server->delivery_gen)
+    return TRUE;
+
+  SILC_LOG_DEBUG(("Building delivery list for channel %s",
+		  channel->channel_name));
+
+  count = silc_hash_table_count(channel->user_list);
+  d = silc_realloc(channel->delivery, sizeof(*d) * (count + 1));
+  if (!d)
+    return FALSE;
+  channel->delivery = d;
+  r = count;
+
+  /* Routes already in the list are marked with this build */
+  build = ++server->delivery_build;
+  if (!build)
+    build = ++server->delivery_build;
+
+  /* Local clients grow from the start, routes from the end of the list */
+  silc_hash_table_list(channel->user_list, &htl);
+  while (silc_hash_table_get(&htl, NULL, (void *)&chl)) {
+    client = chl->client;
+    if (!client)
+      continue;
+
+    mask = silc_server_channel_deliver_mask(chl->mode);
+
+    if (!client->router) {
+      d[l].entry = client;
+      d[l].deliver = mask;
+      l++;
+      continue;
+    }
+
+    /* Add the route only once.  The entry is checked too, as the mark
+       may be stale after the build counter wraps. */
+    router = client->router;
+    i = router->delivery_index;
+    if (router->delivery_build == build && i >= r && i < count &&
+	d[i].entry == router) {
+      d[i].deliver |= mask;
+      continue;
+    }
+
+    r--;
+    d[r].entry = router;
+    d[r].deliver = mask;
+    router->delivery_build = build;
+    router->delivery_index = r;
+  }
+  silc_hash_table_list_reset(&htl);
+
+  /* Make the routes follow the local clients */
+  if (r > l)
+    memmove(d + l, d + r, sizeof(*d) * (count - r));
+
+  channel->delivery_local = l;
+  channel->delivery_count = l + (count - r);
+  channel->delivery_gen = server->delivery_gen;
+
+  return TRUE;
+}
+
 /* This routine is used by the server to send packets to channel. The
    packet sent with this function is distributed to all clients on
    the channel. Usually this is used to send notify messages to the
@@ -286,13 +443,10 @@ void silc_server_packet_send_to_channel(SilcServer server,
 {
   SilcPacketStream sock = NULL;
   SilcClientEntry client = NULL;
-  SilcServerEntry *routed = NULL;
-  SilcChannelClientEntry chl;
-  SilcHashTableList htl;
+  SilcServerEntry router;
   SilcIDListData idata;
-  SilcUInt32 routed_count = 0;
   SilcBool gone = FALSE;
-  int k;
+  SilcUInt32 i;
 
   /* This doesn't send channel message packets */
   SILC_ASSERT(type != SILC_PACKET_CHANNEL_MESSAGE);
@@ -311,85 +465,73 @@ void silc_server_packet_send_to_channel(SilcServer server,
 
   if (!silc_hash_table_count(channel->user_list)) {
     SILC_LOG_DEBUG(("Channel %s is empty", channel->channel_name));
-    goto out;
+    return;
   }
 
   SILC_LOG_DEBUG(("Sending %s to channel %s",
 		  silc_get_packet_name(type), channel->channel_name));
 
-  routed = silc_calloc(silc_hash_table_count(channel->user_list),
-		       sizeof(*routed));
-
-  /* Send the message to clients on the channel's client list. */
-  silc_hash_table_list(channel->user_list, &htl);
-  while (silc_hash_table_get(&htl, NULL, (void *)&chl)) {
-    client = chl->client;
-    if (!client)
-      continue;
-
-    /* If client has router set it is not locally connected client and
-       we will route the message to the router set in the client. Though,
-       send locally connected server in all cases. */
-    if (server->server_type == SILC_ROUTER && client->router &&
-	((!route && client->router->router == server->id_entry) || route)) {
-
-      /* Check if we have sent the packet to this route already */
-      for (k = 0; k < routed_count; k++)
-	if (routed[k] == client->router)
-	  break;
-      if (k < routed_count)
-	continue;
+  if (!silc_server_channel_delivery(server, channel))
+    return;
 
-      /* Get data used in packet header encryption, keys and stuff. */
-      sock = client->router->connection;
-      idata = (SilcIDListData)client->router;
+  /* Send to locally connected clients */
+  for (i = 0; send_to_clients && i < channel->delivery_local; i++) {
+    client = channel->delivery[i].entry;
 
-      if (sender && sock == sender)
-	continue;
+    /* Get data used in packet header encryption, keys and stuff. */
+    sock = client->connection;
+    if (!sock || (sender && sock == sender))
+      continue;
 
-      /* Route only once to router. Protocol prohibits sending channel
-	 messages to more than one router. */
-      if (idata->conn_type == SILC_CONN_ROUTER) {
-	if (gone)
-	  continue;
-	gone = TRUE;
-      }
+    SILC_LOG_DEBUG(("Sending packet to client %s",
+		    client->nickname ? client->nickname :
+		    (unsigned char *)""));
 
-      SILC_LOG_DEBUG(("Sending packet to client %s",
-		      client->nickname ? client->nickname :
-		      (unsigned char *)""));
+    /* Send the packet */
+    silc_server_packet_send_dest(server, sock, type, 0, channel->id,
+				 SILC_ID_CHANNEL, data, data_len);
 
-      /* Send the packet */
-      silc_server_packet_send_dest(server, sock, type, 0, channel->id,
-				   SILC_ID_CHANNEL, data, data_len);
+    /* Stop if connection was closed and the list was invalidated */
+    if (channel->delivery_gen != server->delivery_gen)
+      return;
+  }
 
-      /* Mark this route routed already */
-      routed[routed_count++] = client->router;
-      continue;
-    }
+  if (server->server_type != SILC_ROUTER)
+    return;
 
-    if (client->router || !send_to_clients)
+  /* Route to the servers of the remote clients.  Send locally connected
+     server in all cases. */
+  for (i = channel->delivery_local; i < channel->delivery_count; i++) {
+    router = channel->delivery[i].entry;
+    if (!route && router->router != server->id_entry)
       continue;
 
-    /* Send to locally connected client */
-
     /* Get data used in packet header encryption, keys and stuff. */
-    sock = client->connection;
-    if (!sock || (sender && sock == sender))
+    sock = router->connection;
+    idata = (SilcIDListData)router;
+
+    if (sender && sock == sender)
       continue;
 
-    SILC_LOG_DEBUG(("Sending packet to client %s",
-		    client->nickname ? client->nickname :
-		    (unsigned char *)""));
+    /* Route only once to router. Protocol prohibits sending channel
+       messages to more than one router. */
+    if (idata->conn_type == SILC_CONN_ROUTER) {
+      if (gone)
+	continue;
+      gone = TRUE;
+    }
+
+    SILC_LOG_DEBUG(("Sending packet to server %s",
+		    router->server_name ? router->server_name : ""));
 
     /* Send the packet */
     silc_server_packet_send_dest(server, sock, type, 0, channel->id,
 				 SILC_ID_CHANNEL, data, data_len);
-  }
-  silc_hash_table_list_reset(&htl);
 
- out:
-  silc_free(routed);
+    /* Stop if connection was closed and the list was invalidated */
+    if (channel->delivery_gen != server->delivery_gen)
+      return;
+  }
 }
 
 /* This checks whether the relayed packet came from router. If it did
@@ -467,6 +609,37 @@ silc_server_packet_relay_to_channel_encrypt(SilcServer server,
   return TRUE;
 }
 
+/* Sends relayed channel message to `sock'.  The source and destination
+   IDs are already encoded by the caller, so that they are encoded only
+   once per relayed message, not once per recipient. */
+
+static inline SilcBool
+silc_server_packet_relay_send(SilcServer server,
+			      SilcPacketStream sock,
+			      SilcIdType sender_type,
+			      const unsigned char *sid,
+			      SilcUInt32 sid_len,
+			      const unsigned char *rid,
+			      SilcUInt32 rid_len,
+			      unsigned char *data,
+			      SilcUInt32 data_len)
+{
+  SilcIDListData idata = silc_packet_get_context(sock);
+
+  /* If entry is disabled do not sent anything. */
+  if ((idata && idata->status & SILC_IDLIST_STATUS_DISABLED) ||
+      ((SilcServerEntry)idata == server->id_entry)) {
+    SILC_LOG_DEBUG(("Connection is disabled"));
+    return FALSE;
+  }
+
+  return silc_packet_send_ext_str(sock, SILC_PACKET_CHANNEL_MESSAGE, 0,
+				  sender_type, sid, sid_len,
+				  SILC_ID_CHANNEL, rid, rid_len,
+				  (const unsigned char *)data, data_len,
+				  NULL, NULL);
+}
+
 /* This routine is explicitly used to relay messages to some channel.
    Packets sent with this function we have received earlier and are
    totally encrypted. This just sends the packet to all clients on
@@ -474,7 +647,11 @@ silc_server_packet_relay_to_channel_encrypt(SilcServer server,
    the message will not be sent to that client. The SILC Packet header
    is encrypted with the session key shared between us and the client.
    MAC is also computed before encrypting the header. Rest of the
-   packet will be untouched. */
+   packet will be untouched.  The source and destination IDs are encoded
+   only once and the channel message payload is shared by all recipients,
+   so that only the packet header is assembled for each link.  The writes
+   are batched per link by the corked packet streams: all packets relayed
+   to one link during a scheduler iteration are written at once. */
 
 void silc_server_packet_relay_to_channel(SilcServer server,
 					 SilcPacketStream sender_sock,
@@ -487,19 +664,23 @@ void silc_server_packet_relay_to_channel(SilcServer server,
 {
   SilcPacketStream sock = NULL;
   SilcClientEntry client = NULL;
-  SilcServerEntry *routed = NULL;
-  SilcChannelClientEntry chl, chl_sender;
-  SilcUInt32 routed_count = 0;
+  SilcServerEntry router;
+  SilcChannelClientEntry chl_sender;
+  SilcChannelDelivery d;
+  SilcUInt32 recipients = 0, deliver, i;
   SilcIDListData idata;
-  SilcHashTableList htl;
   SilcBool gone = FALSE;
-  int k;
+  unsigned char sid[32], rid[32];
+  SilcUInt32 sid_len, rid_len;
+  SilcInt64 start;
 
   if (!silc_server_client_on_channel(sender_entry, channel, &chl_sender))
     return;
 
   SILC_LOG_DEBUG(("Relaying packet to channel %s", channel->channel_name));
 
+  start = silc_time_usec();
+
   /* This encrypts the message, if needed. It will be encrypted if
      it came from the router thus it needs to be encrypted with the
      channel key. If the channel key does not exist, then we know we
@@ -510,171 +691,162 @@ void silc_server_packet_relay_to_channel(SilcServer server,
 						   data_len))
     return;
 
+  /* Encode the IDs once, they are same for all recipients */
+  if (!silc_id_id2str(sender_id, sender_type, sid, sizeof(sid), &sid_len))
+    return;
+  if (!silc_id_id2str(channel->id, SILC_ID_CHANNEL, rid, sizeof(rid),
+		      &rid_len))
+    return;
+
   /* If there are global users in the channel we will send the message
      first to our router for further routing. */
   if (server->server_type != SILC_ROUTER && !server->standalone &&
       channel->global_users) {
-    SilcServerEntry router = server->router;
+    router = server->router;
 
     /* Check that the sender is not our router. */
     if (sender_sock != router->connection) {
       SILC_LOG_DEBUG(("Sending message to router for routing"));
       sock = router->connection;
-      silc_server_packet_send_srcdest(server, sock,
-				      SILC_PACKET_CHANNEL_MESSAGE, 0,
-				      sender_id, sender_type,
-				      channel->id, SILC_ID_CHANNEL,
-				      data, data_len);
+      if (silc_server_packet_relay_send(server, sock, sender_type,
+					sid, sid_len, rid, rid_len,
+					data, data_len))
+	recipients++;
     }
   }
 
-  routed = silc_calloc(silc_hash_table_count(channel->user_list),
-		       sizeof(*routed));
+  if (!silc_server_channel_delivery(server, channel))
+    return;
 
-  /* Assure we won't route the message back to the sender's way. */
-  if (sender_entry->router)
-    routed[routed_count++] = sender_entry->router;
+  /* Message sending may be blocked by the recipients, depending on who
+     the sender is. */
+  deliver = silc_server_channel_deliver_sender(chl_sender, sender_entry);
 
-  /* Send the message to clients on the channel's client list. */
-  silc_hash_table_list(channel->user_list, &htl);
-  while (silc_hash_table_get(&htl, NULL, (void *)&chl)) {
-    client = chl->client;
-    if (!client || client == sender_entry)
+  /* Send the message to locally connected clients on the channel */
+  for (i = 0; i < channel->delivery_local; i++) {
+    d = &channel->delivery[i];
+    client = d->entry;
+    if (client == sender_entry || !(d->deliver & deliver))
       continue;
 
-    /* Check whether message sending is blocked */
-    if (chl->mode & SILC_CHANNEL_UMODE_BLOCK_MESSAGES)
-      continue;
-    if (chl->mode & SILC_CHANNEL_UMODE_BLOCK_MESSAGES_USERS &&
-	!(chl_sender->mode & SILC_CHANNEL_UMODE_CHANOP) &&
-	!(chl_sender->mode & SILC_CHANNEL_UMODE_CHANFO))
-      continue;
-    if (chl->mode & SILC_CHANNEL_UMODE_BLOCK_MESSAGES_ROBOTS &&
-	sender_entry->mode & SILC_UMODE_ROBOT)
+    /* Get data used in packet header encryption, keys and stuff. */
+    sock = client->connection;
+    if (!sock || (sender_sock && sock == sender_sock))
       continue;
 
-    /* If the client has set router it means that it is not locally
-       connected client and we will route the packet further. */
-    if (server->server_type == SILC_ROUTER && client->router) {
-
-      /* Check if we have sent the packet to this route already */
-      for (k = 0; k < routed_count; k++)
-	if (routed[k] == client->router)
-	  break;
-      if (k < routed_count)
-	continue;
-
-      /* Get data used in packet header encryption, keys and stuff. */
-      sock = client->router->connection;
-      idata = (SilcIDListData)client->router;
+    SILC_LOG_DEBUG(("Sending packet to client ID(%s)",
+		    silc_id_render(client->id, SILC_ID_CLIENT)));
 
-      /* Check if the sender socket is the same as this client's router
-	 socket. */
-      if (sender_sock && sock == sender_sock)
-	continue;
+    /* Send the packet */
+    if (silc_server_packet_relay_send(server, sock, sender_type,
+				      sid, sid_len, rid, rid_len,
+				      data, data_len))
+      recipients++;
+
+    /* Stop if connection was closed and the list was invalidated */
+    if (channel->delivery_gen != server->delivery_gen)
+      goto out;
+  }
 
-      SILC_LOG_DEBUG(("Relaying packet to client ID(%s)",
-		      silc_id_render(client->id, SILC_ID_CLIENT)));
+  if (server->server_type != SILC_ROUTER)
+    goto out;
 
-      /* Mark this route routed already. */
-      routed[routed_count++] = client->router;
+  /* Route the message to the servers of the remote clients */
+  for (i = channel->delivery_local; i < channel->delivery_count; i++) {
+    d = &channel->delivery[i];
+    router = d->entry;
 
-      if (idata->conn_type == SILC_CONN_ROUTER) {
-	/* The remote connection is router then we'll decrypt the
-	   channel message and re-encrypt it with the session key shared
-	   between us and the remote router. This is done because the
-	   channel keys are cell specific and we have different channel
-	   key than the remote router has. */
-
-	/* Route only once to router. Protocol prohibits sending channel
-	   messages to more than one router. */
-	if (gone)
-	  continue;
-	gone = TRUE;
+    /* Assure we won't route the message back to the sender's way. */
+    if (router == sender_entry->router || !(d->deliver & deliver))
+      continue;
 
-	/* If we are backup router and remote is our primary router and
-	   we are currently doing backup resuming protocol we must not
-	   re-encrypt message with session key. */
-	if (server->backup_router && idata->sconn->backup_resuming &&
-	    SILC_PRIMARY_ROUTE(server) == sock) {
-	  silc_server_packet_send_srcdest(server, sock,
-					  SILC_PACKET_CHANNEL_MESSAGE, 0,
-					  sender_id, sender_type,
-					  channel->id, SILC_ID_CHANNEL,
-					  data, data_len);
-	  continue;
-	}
-
-	SILC_LOG_DEBUG(("Remote is router, encrypt with session key"));
-
-	/* If private key mode is not set then decrypt the packet
-	   and re-encrypt it */
-	if (!(channel->mode & SILC_CHANNEL_MODE_PRIVKEY) &&
-	    channel->receive_key) {
-	  unsigned char tmp[SILC_PACKET_MAX_LEN], sid[32], rid[32];
-	  SilcUInt32 sid_len, rid_len;
-
-	  if (data_len > SILC_PACKET_MAX_LEN)
-	    data_len = SILC_PACKET_MAX_LEN;
-	  memcpy(tmp, data, data_len);
-
-	  /* Decrypt the channel message (we don't check the MAC) */
-	  silc_id_id2str(sender_id, sender_type, sid, sizeof(sid), &sid_len);
-	  silc_id_id2str(channel->id, SILC_ID_CHANNEL, rid, sizeof(rid),
-			 &rid_len);
-	  silc_message_payload_decrypt(tmp, data_len, FALSE, FALSE,
-				       channel->receive_key,
-				       channel->hmac, sid, sid_len,
-				       rid, rid_len, FALSE);
-
-	  /* Now re-encrypt and send it to the router */
-	  silc_server_packet_send_srcdest(server, sock,
-					  SILC_PACKET_CHANNEL_MESSAGE, 0,
-					  sender_id, sender_type,
-					  channel->id, SILC_ID_CHANNEL,
-					  tmp, data_len);
-	} else {
-	  /* Private key mode is set, we don't have the channel key, so
-	     just re-encrypt the entire packet and send it to the router. */
-	  silc_server_packet_send_srcdest(server, sock,
-					  SILC_PACKET_CHANNEL_MESSAGE, 0,
-					  sender_id, sender_type,
-					  channel->id, SILC_ID_CHANNEL,
-					  data, data_len);
-	}
-      } else {
-	/* Send the packet to normal server */
-	silc_server_packet_send_srcdest(server, sock,
-					SILC_PACKET_CHANNEL_MESSAGE, 0,
-					sender_id, sender_type,
-					channel->id, SILC_ID_CHANNEL,
-					data, data_len);
-      }
+    /* Get data used in packet header encryption, keys and stuff. */
+    sock = router->connection;
+    idata = (SilcIDListData)router;
 
+    /* Check if the sender socket is the same as this router's socket. */
+    if (sender_sock && sock == sender_sock)
       continue;
-    }
 
-    if (client->router)
-      continue;
+    SILC_LOG_DEBUG(("Relaying packet to server %s",
+		    router->server_name ? router->server_name : ""));
 
-    /* Get data used in packet header encryption, keys and stuff. */
-    sock = client->connection;
-    if (!sock || (sender_sock && sock == sender_sock))
-      continue;
+    if (idata->conn_type == SILC_CONN_ROUTER) {
+      /* The remote connection is router then we'll decrypt the
+	 channel message and re-encrypt it with the session key shared
+	 between us and the remote router. This is done because the
+	 channel keys are cell specific and we have different channel
+	 key than the remote router has. */
 
-    SILC_LOG_DEBUG(("Sending packet to client ID(%s)",
-		    silc_id_render(client->id, SILC_ID_CLIENT)));
+      /* Route only once to router. Protocol prohibits sending channel
+	 messages to more than one router. */
+      if (gone)
+	continue;
+      gone = TRUE;
+
+      /* If we are backup router and remote is our primary router and
+	 we are currently doing backup resuming protocol we must not
+	 re-encrypt message with session key. */
+      if (server->backup_router && idata->sconn->backup_resuming &&
+	  SILC_PRIMARY_ROUTE(server) == sock) {
+	if (silc_server_packet_relay_send(server, sock, sender_type,
+					  sid, sid_len, rid, rid_len,
+					  data, data_len))
+	  recipients++;
+	goto next;
+      }
 
-    /* Send the packet */
-    silc_server_packet_send_srcdest(server, sock,
-				    SILC_PACKET_CHANNEL_MESSAGE, 0,
-				    sender_id, sender_type,
-				    channel->id, SILC_ID_CHANNEL,
-				    data, data_len);
+      SILC_LOG_DEBUG(("Remote is router, encrypt with session key"));
+
+      /* If private key mode is not set then decrypt the packet
+	 and re-encrypt it */
+      if (!(channel->mode & SILC_CHANNEL_MODE_PRIVKEY) &&
+	  channel->receive_key) {
+	unsigned char tmp[SILC_PACKET_MAX_LEN];
+	SilcUInt32 tmp_len = data_len;
+
+	if (tmp_len > SILC_PACKET_MAX_LEN)
+	  tmp_len = SILC_PACKET_MAX_LEN;
+	memcpy(tmp, data, tmp_len);
+
+	/* Decrypt the channel message (we don't check the MAC) */
+	silc_message_payload_decrypt(tmp, tmp_len, FALSE, FALSE,
+				     channel->receive_key,
+				     channel->hmac, sid, sid_len,
+				     rid, rid_len, FALSE);
+
+	/* Now re-encrypt and send it to the router */
+	if (silc_server_packet_relay_send(server, sock, sender_type,
+					  sid, sid_len, rid, rid_len,
+					  tmp, tmp_len))
+	  recipients++;
+      } else {
+	/* Private key mode is set, we don't have the channel key, so
+	   just re-encrypt the entire packet and send it to the router. */
+	if (silc_server_packet_relay_send(server, sock, sender_type,
+					  sid, sid_len, rid, rid_len,
+					  data, data_len))
+	  recipients++;
+      }
+    } else {
+      /* Send the packet to normal server */
+      if (silc_server_packet_relay_send(server, sock, sender_type,
+					sid, sid_len, rid, rid_len,
+					data, data_len))
+	recipients++;
+    }
+
+  next:
+    /* Stop if connection was closed and the list was invalidated */
+    if (channel->delivery_gen != server->delivery_gen)
+      break;
   }
 
-  silc_hash_table_list_reset(&htl);
-  silc_free(routed);
+ out:
+  /* Update relay statistics */
+  server->stat.chmsgs_relayed++;
+  server->stat.chmsgs_recipients += recipients;
+  server->stat.chmsgs_relay_usec += silc_time_usec() - start;
 }
 
 /* This function is used to send packets strictly to all local clients
@@ -691,25 +863,31 @@ void silc_server_packet_send_local_channel(SilcServer server,
 					   unsigned char *data,
 					   SilcUInt32 data_len)
 {
-  SilcChannelClientEntry chl;
-  SilcHashTableList htl;
+  SilcClientEntry client;
   SilcPacketStream sock = NULL;
+  SilcUInt32 i;
 
   SILC_LOG_DEBUG(("Send packet to local clients on channel %s",
 		  channel->channel_name));
 
-  /* Send the message to clients on the channel's client list. */
-  silc_hash_table_list(channel->user_list, &htl);
-  while (silc_hash_table_get(&htl, NULL, (void *)&chl)) {
-    if (chl->client && SILC_IS_LOCAL(chl->client)) {
-      sock = chl->client->connection;
+  if (!silc_server_channel_delivery(server, channel))
+    return;
 
-      /* Send the packet to the client */
-      silc_server_packet_send_dest(server, sock, type, flags, chl->client->id,
-				   SILC_ID_CLIENT, data, data_len);
-    }
+  /* Send the message to locally connected clients on the channel */
+  for (i = 0; i < channel->delivery_local; i++) {
+    client = channel->delivery[i].entry;
+    if (!SILC_IS_LOCAL(client))
+      continue;
+    sock = client->connection;
+
+    /* Send the packet to the client */
+    silc_server_packet_send_dest(server, sock, type, flags, client->id,
+				 SILC_ID_CLIENT, data, data_len);
+
+    /* Stop if connection was closed and the list was invalidated */
+    if (channel->delivery_gen != server->delivery_gen)
+      return;
   }
-  silc_hash_table_list_reset(&htl);
 }
 
 /* Sends current motd to client */
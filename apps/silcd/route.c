@@ -17,91 +17,152 @@
   GNU General Public License for more details.
 
 */
-/* 
- * Route cache routines. Server uses these to route packets to specific
- * routes. If route entry doesn't exist for a specific destination, server
+/*
+ * Routing table routines.  Server uses these to route packets to specific
+ * routes.  If route entry doesn't exist for a specific destination, server
  * uses primary route (default route).
  */
-/* XXX Adding two ID's with same IP number replaces the old entry thus
-   gives wrong route. Thus, now disabled until figured out a better way
-   to do this or when removed the whole thing. This could be removed
-   because entry->router->connection gives always the most optimal route
-   for the ID anyway (unless new routes (faster perhaps) are established
-   after receiving this ID, this we don't know however). */
 /* $Id$ */
 
 #include "serverincludes.h"
 #include "server_internal.h"
 #include "route.h"
 
-/* Route cache hash table */
-SilcServerRouteTable silc_route_cache[SILC_SERVER_ROUTE_SIZE];
+/* Allocates the routing table */
+
+SilcHashTable silc_server_route_alloc(void)
+{
+  return silc_hash_table_alloc(0, silc_hash_id, SILC_32_TO_PTR(SILC_ID_SERVER),
+			       silc_hash_id_compare,
+			       SILC_32_TO_PTR(SILC_ID_SERVER), NULL, NULL, TRUE);
+}
+
+/* Frees the routing table.  The entries are not touched. */
+
+void silc_server_route_free(SilcHashTable routes)
+{
+  if (routes)
+    silc_hash_table_free(routes);
+}
 
-/* Adds new route to the route cache. The argument `index' is the
-   index value generated by silc_server_route_hash. */
+/* Adds route to the server `entry'.  The key is the entry's own Server ID
+   so the route must be deleted before the ID is changed or freed.  Replaces
+   any older route to the same ID. */
 
-void silc_server_route_add(SilcUInt32 index, unsigned int dest,
-			   SilcServerEntry router)
+void silc_server_route_add(SilcIDList id_list, SilcServerEntry entry)
 {
-  silc_route_cache[index].dest = dest;
-  silc_route_cache[index].router = router;
+  if (!id_list->routes || !entry->id)
+    return;
+
+  SILC_LOG_DEBUG(("Adding route to %s",
+		  silc_id_render(entry->id, SILC_ID_SERVER)));
+
+  silc_hash_table_replace(id_list->routes, entry->id, entry);
 }
 
-/* Checksk whether destination has a specific router. Returns the
-   router data if found, NULL otherwise. */
+/* Deletes route to the server `entry'.  Does nothing if the route to
+   the entry's ID has already been replaced by another entry. */
 
-SilcServerEntry silc_server_route_check(SilcUInt32 dest, 
-					SilcUInt16 port)
+void silc_server_route_del(SilcIDList id_list, SilcServerEntry entry)
 {
-  SilcUInt32 index;
+  if (!id_list->routes || !entry->id)
+    return;
 
-  index = silc_server_route_hash(dest, port);
+  silc_hash_table_del_by_context(id_list->routes, entry->id, entry);
+}
+
+/* Finds server entry by Server ID from the routing table.  Unlike
+   silc_idlist_find_server_by_id this finds both local and global servers
+   with one lookup. */
+
+SilcServerEntry silc_server_route_find(SilcServer server, SilcServerID *id)
+{
+  SilcServerEntry entry;
 
-  if (silc_route_cache[index].router != NULL &&
-      silc_route_cache[index].dest == dest)
-    return silc_route_cache[index].router;
+  if (!silc_hash_table_find(server->local_list->routes, id, NULL,
+			    (void *)&entry))
+    return NULL;
 
-  return NULL;
+  return entry;
+}
+
+/* Returns the next hop to the server `entry'.  It is the server itself if
+   it is directly connected to us, and otherwise the router connection the
+   server was announced through.  Returns the primary route if we don't
+   know better, and NULL if the entry is us. */
+
+SilcPacketStream silc_server_route_next_hop(SilcServer server,
+					    SilcServerEntry entry)
+{
+  if (!entry)
+    return SILC_PRIMARY_ROUTE(server);
+  if (entry == server->id_entry)
+    return NULL;
+
+  if (entry->connection)
+    return entry->connection;
+
+  if (entry->router && entry->router != server->id_entry &&
+      entry->router->connection)
+    return entry->router->connection;
+
+  return SILC_PRIMARY_ROUTE(server);
 }
 
 /* Returns the connection object for the fastest route for the given ID.
    If we are normal server then this just returns our primary route. If
-   we are router we will do route lookup. */
+   we are router we will do route lookup.  Client and channel IDs are
+   routed via the server that owns them. */
 
 SilcPacketStream silc_server_route_get(SilcServer server, void *id,
-					   SilcIdType id_type)
+				       SilcIdType id_type)
 {
-  if (server->server_type == SILC_ROUTER) {
-    SilcUInt32 dest = 0;
-    SilcUInt16 port = 0;
-    SilcServerEntry router = NULL;
-#if 0
+  SilcServerEntry router = NULL;
 
+  if (server->server_type == SILC_ROUTER) {
     switch(id_type) {
     case SILC_ID_CLIENT:
-      dest = ((SilcClientID *)id)->ip.s_addr;
-      port = server->id->port;
+      {
+	SilcClientEntry client;
+
+	client = silc_idlist_find_client_by_id(server->global_list, id,
+					       TRUE, NULL);
+	if (!client)
+	  client = silc_idlist_find_client_by_id(server->local_list, id,
+						 TRUE, NULL);
+	if (client) {
+	  if (client->connection)
+	    return client->connection;
+	  router = client->router;
+	}
+      }
       break;
+
     case SILC_ID_SERVER:
-      dest = ((SilcServerID *)id)->ip.s_addr;
-      port = ((SilcServerID *)id)->port;
+      router = silc_server_route_find(server, id);
       break;
+
     case SILC_ID_CHANNEL:
-      dest = ((SilcChannelID *)id)->ip.s_addr;
-      port = ((SilcChannelID *)id)->port;
+      {
+	SilcChannelEntry channel;
+
+	channel = silc_idlist_find_channel_by_id(server->global_list, id,
+						 NULL);
+	if (!channel)
+	  channel = silc_idlist_find_channel_by_id(server->local_list, id,
+						   NULL);
+	if (channel)
+	  router = channel->router;
+      }
       break;
+
     default:
       return NULL;
     }
 
-#endif
-
-    router = silc_server_route_check(dest, port);
     if (router)
-      return router->connection;
+      return silc_server_route_next_hop(server, router);
   }
 
-  return (server->id_entry->router) 
-       ? server->id_entry->router->connection
-       : NULL;
+  return SILC_PRIMARY_ROUTE(server);
 }
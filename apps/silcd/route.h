@@ -21,59 +21,33 @@
 #ifndef ROUTE_H
 #define ROUTE_H
 
-/* Definitions */
-
-/* Size of the route cache hash table */
-#define SILC_SERVER_ROUTE_SIZE 256
-
 /*
-   SILC Server Route table
-
-   Following short description of the fields.
-
-   SilcUInt32 dest
-
-       Destination IPv4 address.  Can be used to quickly check whether
-       the found route entry is what the caller wanted.
+   SILC Server routing table
 
-   SilcServerEntry router
+   The routing table maps Server IDs to server entries.  It is shared by
+   the local and global ID lists (SilcIDList routes) the same way the
+   slabs are, so one lookup finds the server regardless of which list it
+   is in.  The next hop to the server is its connection, that is the
+   directly connected server or the router link the server was announced
+   through.  Since the next hop is read from the entry it stays correct
+   when backup router switch updates the entries.
 
-       Pointer to the router specific data.
+   Client and channel IDs are routed via their owning server entry.  The
+   table is maintained by the ID list routines when server entries are
+   added, deleted or their ID changes, and by the code that removes
+   entries from the ID cache directly.
 
 */
-typedef struct {
-  SilcUInt32 dest;
-  SilcServerEntry router;
-} SilcServerRouteTable;
-
-/* Route cache hash table */
-extern SilcServerRouteTable silc_route_cache[SILC_SERVER_ROUTE_SIZE];
-
-/* Macros and super macros */
-
-/* Returns route cache hash table entry index. This is IPv4 specific.
-   `port' argument may be zero (0) if it doesn't exist.  This has been
-   taken from Linux kernel's route cache code. */
-static inline
-SilcUInt32 silc_server_route_hash(unsigned int addr, 
-				    SilcUInt16 port)
-{
-  SilcUInt32 hash;
-  
-  hash = ((addr & 0xf0f0f0f0) >> 4) | ((addr & 0x0f0f0f0f) << 4);
-  hash ^= port;
-  hash ^= (hash >> 16);
-  hash ^= (hash >> 8);
-  
-  return hash & 0xff;
-}
 
 /* Prototypes */
-void silc_server_route_add(SilcUInt32 index, unsigned int dest,
-			   SilcServerEntry router);
-SilcServerEntry silc_server_route_check(SilcUInt32 dest, 
-					SilcUInt16 port);
+SilcHashTable silc_server_route_alloc(void);
+void silc_server_route_free(SilcHashTable routes);
+void silc_server_route_add(SilcIDList id_list, SilcServerEntry entry);
+void silc_server_route_del(SilcIDList id_list, SilcServerEntry entry);
+SilcServerEntry silc_server_route_find(SilcServer server, SilcServerID *id);
+SilcPacketStream silc_server_route_next_hop(SilcServer server,
+					    SilcServerEntry entry);
 SilcPacketStream silc_server_route_get(SilcServer server, void *id,
-					   SilcIdType id_type);
+				       SilcIdType id_type);
 
 #endif
@@ -319,14 +319,20 @@ static void silc_server_packet_parse_type(SilcServer server,
 #ifdef SILC_DEBUG
   const char *ip;
   SilcUInt16 port;
+  SilcUInt32 num_malloc, bytes_malloc, num_malloc2, bytes_malloc2;
 
   silc_socket_stream_get_info(silc_packet_stream_get_stream(sock),
 			      NULL, NULL, &ip, &port);
+  silc_stack_stats(server->stack, &num_malloc, &bytes_malloc);
 #endif /* SILC_DEBUG */
 
   SILC_LOG_DEBUG(("Received %s packet [flags %d] from %s:%d",
 		  silc_get_packet_name(type), packet->flags, ip, port));
 
+  /* Payloads parsed while processing the packet are allocated from the
+     server's stack and freed all at once after the packet is processed. */
+  silc_stack_push(server->stack, NULL);
+
   /* Parse the packet type */
   switch (type) {
   case SILC_PACKET_NOTIFY:
@@ -574,6 +580,23 @@ static void silc_server_packet_parse_type(SilcServer server,
     SILC_LOG_ERROR(("Incorrect packet type %d, packet dropped", type));
     break;
   }
+
+#ifdef SILC_DEBUG
+  silc_stack_stats(server->stack, &num_malloc2, &bytes_malloc2);
+  if (num_malloc2 != num_malloc) {
+    num_malloc2 -= num_malloc;
+    bytes_malloc2 -= bytes_malloc;
+    SILC_LOG_DEBUG(("Packet used %d bytes of stack in %d allocations",
+		    bytes_malloc2, num_malloc2));
+    server->stat.stack_packets++;
+    server->stat.stack_allocs += num_malloc2;
+    server->stat.stack_bytes += bytes_malloc2;
+    if (bytes_malloc2 > server->stat.stack_peak)
+      server->stat.stack_peak = bytes_malloc2;
+  }
+#endif /* SILC_DEBUG */
+
+  silc_stack_pop(server->stack);
 }
 
 /****************************** Server API **********************************/
@@ -594,13 +617,24 @@ SilcBool silc_server_alloc(SilcServer *new_server)
     return FALSE;
   server->server_type = SILC_SERVER;
   server->standalone = TRUE;
+  server->delivery_gen = 1;
   server->local_list = silc_calloc(1, sizeof(*server->local_list));
   if (!server->local_list)
     return FALSE;
   server->global_list = silc_calloc(1, sizeof(*server->global_list));
   if (!server->global_list)
     return FALSE;
-  server->pending_commands = silc_dlist_init();
+  server->local_list->slabs = silc_idlist_slabs_alloc();
+  if (!server->local_list->slabs)
+    return FALSE;
+  server->global_list->slabs = server->local_list->slabs;
+  server->local_list->routes = silc_server_route_alloc();
+  if (!server->local_list->routes)
+    return FALSE;
+  server->global_list->routes = server->local_list->routes;
+  server->pending_commands =
+    silc_hash_table_alloc(0, silc_hash_uint, NULL, NULL, NULL,
+			  NULL, NULL, TRUE);
   if (!server->pending_commands)
     return FALSE;
   server->listeners = silc_dlist_init();
@@ -609,9 +643,16 @@ SilcBool silc_server_alloc(SilcServer *new_server)
   server->repository = silc_skr_alloc();
   if (!server->repository)
     return FALSE;
-  server->conns = silc_dlist_init();
+  server->conns = silc_hash_table_alloc(0, silc_hash_string, NULL,
+				       silc_hash_string_compare, NULL,
+				       NULL, NULL, TRUE);
   if (!server->conns)
     return FALSE;
+  server->conns_ip = silc_hash_table_alloc(0, silc_hash_string, NULL,
+					   silc_hash_string_compare, NULL,
+					   NULL, NULL, TRUE);
+  if (!server->conns_ip)
+    return FALSE;
   server->expired_clients = silc_dlist_init();
   if (!server->expired_clients)
     return FALSE;
@@ -639,12 +680,14 @@ void silc_server_free(SilcServer server)
   silc_server_config_unref(&server->config_ref);
   if (server->rng)
     silc_rng_free(server->rng);
+  silc_stack_free(server->stack);
   if (server->public_key)
     silc_pkcs_public_key_free(server->public_key);
   if (server->private_key)
     silc_pkcs_private_key_free(server->private_key);
   if (server->pending_commands)
-    silc_dlist_uninit(server->pending_commands);
+    silc_server_command_pending_free(server);
+  silc_free(server->list_cache.channels);
   if (server->id_entry) {
     if (server->id_entry->data.sconn)
       silc_schedule_task_del_by_context(server->schedule,
@@ -711,17 +754,22 @@ void silc_server_free(SilcServer server)
   silc_idcache_free(server->global_list->clients);
   silc_idcache_free(server->global_list->servers);
   silc_idcache_free(server->global_list->channels);
+  silc_idcache_directory_free(server->local_list->client_dir);
+  silc_idcache_directory_free(server->local_list->channel_dir);
   silc_hash_table_free(server->watcher_list);
   silc_hash_table_free(server->watcher_list_pk);
   silc_hash_free(server->md5hash);
   silc_hash_free(server->sha1hash);
 
   silc_dlist_uninit(server->listeners);
-  silc_dlist_uninit(server->conns);
+  silc_hash_table_free(server->conns);
+  silc_hash_table_free(server->conns_ip);
   silc_dlist_uninit(server->expired_clients);
   silc_skr_free(server->repository);
   silc_packet_engine_stop(server->packet_engine);
 
+  silc_idlist_slabs_free(server->local_list->slabs);
+  silc_server_route_free(server->local_list->routes);
   silc_free(server->local_list);
   silc_free(server->global_list);
   silc_free(server->server_name);
@@ -826,6 +874,15 @@ SilcBool silc_server_init(SilcServer server)
   silc_rng_init(server->rng);
   silc_rng_global_init(server->rng);
 
+  /* Stack for per-packet allocations */
+  server->stack = silc_stack_alloc(0);
+  if (!server->stack)
+    goto err;
+
+  /* Run key exchange crypto operations in worker threads */
+  silc_ske_set_crypto_workers(server->config->crypto_workers,
+			      server->config->crypto_queue);
+
   /* Initialize hash functions for server to use */
   silc_hash_alloc("md5", &server->md5hash);
   silc_hash_alloc("sha1", &server->sha1hash);
@@ -863,6 +920,22 @@ SilcBool silc_server_init(SilcServer server)
     silc_idcache_alloc(0, SILC_ID_CHANNEL, silc_idlist_channel_destructor,
 		       NULL);
 
+  /* Client and channel ID directories find entries from both lists */
+  server->local_list->client_dir =
+    silc_idcache_directory_alloc(0, SILC_ID_CLIENT);
+  server->local_list->channel_dir =
+    silc_idcache_directory_alloc(0, SILC_ID_CHANNEL);
+  server->global_list->client_dir = server->local_list->client_dir;
+  server->global_list->channel_dir = server->local_list->channel_dir;
+  silc_idcache_set_directory(server->local_list->clients,
+			     server->local_list->client_dir);
+  silc_idcache_set_directory(server->global_list->clients,
+			     server->local_list->client_dir);
+  silc_idcache_set_directory(server->local_list->channels,
+			     server->local_list->channel_dir);
+  silc_idcache_set_directory(server->global_list->channels,
+			     server->local_list->channel_dir);
+
   /* Init watcher lists */
   server->watcher_list =
     silc_hash_table_alloc(1, silc_hash_client_id_hash, NULL,
@@ -1194,6 +1267,9 @@ SilcBool silc_server_rehash(SilcServer server)
   server->config = newconfig;
   silc_server_config_ref(&server->config_ref, server->config, server->config);
 
+  silc_ske_set_crypto_workers(server->config->crypto_workers,
+			      server->config->crypto_queue);
+
 #ifdef SILC_DEBUG
   /* Set debugging on if configured */
   if (server->config->debug_string) {
@@ -1320,7 +1396,7 @@ void silc_server_connection_free(SilcServerConnection sconn)
   if (!sconn)
     return;
   SILC_LOG_DEBUG(("Free connection %p", sconn));
-  silc_dlist_del(sconn->server->conns, sconn);
+  silc_server_conns_del(sconn->server, sconn);
   silc_server_config_unref(&sconn->conn);
   silc_free(sconn->remote_host);
   silc_free(sconn->backup_replace_ip);
@@ -1388,7 +1464,7 @@ silc_server_ke_auth_compl(SilcConnAuth connauth, SilcBool success,
       silc_schedule_task_add_timeout(server->schedule,
 				     silc_server_connect_to_router_retry,
 			     	     sconn, 1, 0);
-      silc_dlist_del(server->conns, sconn);
+      silc_server_conns_del(server, sconn);
       return;
     }
 
@@ -1463,14 +1539,17 @@ silc_server_ke_auth_compl(SilcConnAuth connauth, SilcBool success,
 					     &remote_id.u.server_id,
 					     TRUE, NULL);
     if (id_entry) {
+      silc_server_route_del(server->local_list, id_entry);
       silc_idcache_del_by_context(server->local_list->servers, id_entry, NULL);
     } else {
       id_entry = silc_idlist_find_server_by_id(server->global_list,
 					       &remote_id.u.server_id,
 					       TRUE, NULL);
-      if (id_entry)
+      if (id_entry) {
+	silc_server_route_del(server->global_list, id_entry);
 	silc_idcache_del_by_context(server->global_list->servers, id_entry,
 				    NULL);
+      }
     }
 
     SILC_LOG_DEBUG(("New server id(%s)",
@@ -1490,7 +1569,7 @@ silc_server_ke_auth_compl(SilcConnAuth connauth, SilcBool success,
         silc_schedule_task_add_timeout(server->schedule,
 				       silc_server_connect_to_router_retry,
 			     	       sconn, 1, 0);
-        silc_dlist_del(server->conns, sconn);
+        silc_server_conns_del(server, sconn);
         return;
       }
 
@@ -1649,7 +1728,7 @@ static void silc_server_ke_completed(SilcSKE ske, SilcSKEStatus status,
       silc_schedule_task_add_timeout(server->schedule,
 				     silc_server_connect_to_router_retry,
 			     	     sconn, 1, 0);
-      silc_dlist_del(server->conns, sconn);
+      silc_server_conns_del(server, sconn);
       return;
     }
 
@@ -1673,7 +1752,7 @@ static void silc_server_ke_completed(SilcSKE ske, SilcSKEStatus status,
       silc_schedule_task_add_timeout(server->schedule,
 				     silc_server_connect_to_router_retry,
 			     	     sconn, 1, 0);
-      silc_dlist_del(server->conns, sconn);
+      silc_server_conns_del(server, sconn);
       return;
     }
 
@@ -1700,7 +1779,7 @@ static void silc_server_ke_completed(SilcSKE ske, SilcSKEStatus status,
       silc_schedule_task_add_timeout(server->schedule,
 				     silc_server_connect_to_router_retry,
 			     	     sconn, 1, 0);
-      silc_dlist_del(server->conns, sconn);
+      silc_server_conns_del(server, sconn);
       return;
     }
 
@@ -1758,6 +1837,7 @@ void silc_server_start_key_exchange(SilcServerConnection sconn)
   /* Create packet stream */
   sconn->sock = silc_packet_stream_create(server->packet_engine,
 					  server->schedule, sconn->stream);
+  silc_server_conns_set_ip(server, sconn);
   if (!sconn->sock) {
     SILC_LOG_ERROR(("Cannot connect: cannot create packet stream"));
     silc_stream_destroy(sconn->stream);
@@ -1767,7 +1847,7 @@ void silc_server_start_key_exchange(SilcServerConnection sconn)
       silc_schedule_task_add_timeout(server->schedule,
 				     silc_server_connect_to_router_retry,
 			     	     sconn, 1, 0);
-      silc_dlist_del(server->conns, sconn);
+      silc_server_conns_del(server, sconn);
       return;
     }
 
@@ -1778,6 +1858,9 @@ void silc_server_start_key_exchange(SilcServerConnection sconn)
   }
   server->stat.conn_num++;
 
+  /* Collect packets sent during one scheduler iteration to one write */
+  silc_packet_stream_set_cork(sconn->sock, TRUE);
+
   /* Set source ID to packet stream */
   if (!silc_packet_set_ids(sconn->sock, SILC_ID_SERVER, server->id,
 			   0, NULL)) {
@@ -1788,7 +1871,7 @@ void silc_server_start_key_exchange(SilcServerConnection sconn)
       silc_schedule_task_add_timeout(server->schedule,
 				     silc_server_connect_to_router_retry,
 			     	     sconn, 1, 0);
-      silc_dlist_del(server->conns, sconn);
+      silc_server_conns_del(server, sconn);
       return;
     }
 
@@ -1808,7 +1891,7 @@ void silc_server_start_key_exchange(SilcServerConnection sconn)
       silc_schedule_task_add_timeout(server->schedule,
 				     silc_server_connect_to_router_retry,
 			     	     sconn, 1, 0);
-      silc_dlist_del(server->conns, sconn);
+      silc_server_conns_del(server, sconn);
       return;
     }
 
@@ -1845,7 +1928,7 @@ void silc_server_start_key_exchange(SilcServerConnection sconn)
       silc_schedule_task_add_timeout(server->schedule,
 				     silc_server_connect_to_router_retry,
 			     	     sconn, 1, 0);
-      silc_dlist_del(server->conns, sconn);
+      silc_server_conns_del(server, sconn);
       return;
     }
 
@@ -1944,7 +2027,7 @@ static void silc_server_connection_established(SilcNetStatus status,
       silc_schedule_task_add_timeout(sconn->server->schedule,
 				     silc_server_connect_to_router_retry,
 				     sconn, 1, 0);
-      silc_dlist_del(server->conns, sconn);
+      silc_server_conns_del(server, sconn);
     } else {
       if (sconn->callback)
 	(*sconn->callback)(server, NULL, sconn->callback_context);
@@ -1960,7 +2043,7 @@ static void silc_server_connection_established(SilcNetStatus status,
       silc_schedule_task_add_timeout(sconn->server->schedule,
 				     silc_server_connect_to_router_retry,
 				     sconn, 1, 0);
-      silc_dlist_del(server->conns, sconn);
+      silc_server_conns_del(server, sconn);
     } else {
       if (sconn->callback)
 	(*sconn->callback)(server, NULL, sconn->callback_context);
@@ -2025,7 +2108,7 @@ SILC_TASK_CALLBACK(silc_server_connect_router)
   }
 
   /* Add to connection list */
-  silc_dlist_add(server->conns, sconn);
+  silc_server_conns_add(server, sconn);
 }
 
 /* This function connects to our primary router or if we are a router this
@@ -2631,7 +2714,8 @@ silc_server_accept_auth_compl(SilcConnAuth connauth, SilcBool success,
   sconn->sock = sock;
   sconn->remote_host = strdup(hostname);
   sconn->remote_port = port;
-  silc_dlist_add(server->conns, sconn);
+  silc_server_conns_add(server, sconn);
+  silc_server_conns_set_ip(server, sconn);
   idata->sconn = sconn;
   idata->sconn->callback = NULL;
   idata->last_receive = time(NULL);
@@ -2772,7 +2856,7 @@ static void silc_server_accept_new_connection(SilcNetStatus status,
 
   /* Check for maximum allowed connections */
   server->stat.conn_attempts++;
-  if (silc_dlist_count(server->conns) >
+  if (silc_hash_table_count(server->conns) >
       server->config->param.connections_max) {
     SILC_LOG_ERROR(("Refusing connection, server is full"));
     server->stat.conn_failures++;
@@ -2800,6 +2884,9 @@ static void silc_server_accept_new_connection(SilcNetStatus status,
   }
   server->stat.conn_num++;
 
+  /* Collect packets sent during one scheduler iteration to one write */
+  silc_packet_stream_set_cork(packet_stream, TRUE);
+
   SILC_LOG_DEBUG(("Created packet stream %p", packet_stream));
 
   /* Set source ID to packet stream */
@@ -3214,8 +3301,9 @@ void silc_server_free_client_data(SilcServer server,
   if (!server->server_shutdown) {
     client->data.status &= ~SILC_IDLIST_STATUS_REGISTERED;
     client->mode = 0;
-    client->router = NULL;
+    silc_idlist_client_set_router(client, NULL);
     client->connection = NULL;
+    silc_server_client_delivery_reset(client);
     client->data.created = silc_time();
     silc_dlist_del(server->expired_clients, client);
     silc_dlist_add(server->expired_clients, client);
@@ -3552,6 +3640,7 @@ void silc_server_remove_from_channels(SilcServer server,
     silc_hash_table_del(client->channels, channel);
     silc_hash_table_del(channel->user_list, client);
     channel->user_count--;
+    SILC_CHANNEL_DELIVERY_RESET(channel);
 
     /* If there is no global users on the channel anymore mark the channel
        as local channel. Do not check if the removed client is local client. */
@@ -3560,7 +3649,7 @@ void silc_server_remove_from_channels(SilcServer server,
       channel->global_users = FALSE;
 
     memset(chl, 'A', sizeof(*chl));
-    silc_free(chl);
+    silc_idlist_del_chl(server->local_list, chl);
 
     /* Update statistics */
     if (SILC_IS_LOCAL(client))
@@ -3606,7 +3695,8 @@ void silc_server_remove_from_channels(SilcServer server,
 	SilcArgumentPayload iargs;
 	ab = silc_argument_payload_encode_one(NULL, clidp->data,
 					      silc_buffer_len(clidp), 3);
-	iargs = silc_argument_payload_parse(ab->data, silc_buffer_len(ab), 1);
+	iargs = silc_argument_payload_parse(ab->data, silc_buffer_len(ab), 1,
+					    NULL);
 	silc_server_inviteban_process(server, channel->invite_list, 1, iargs);
 	silc_buffer_free(ab);
 	silc_argument_payload_free(iargs);
@@ -3670,6 +3760,7 @@ SilcBool silc_server_remove_from_one_channel(SilcServer server,
   silc_hash_table_del(client->channels, channel);
   silc_hash_table_del(channel->user_list, client);
   channel->user_count--;
+  SILC_CHANNEL_DELIVERY_RESET(channel);
 
   /* If there is no global users on the channel anymore mark the channel
      as local channel. Do not check if the client is local client. */
@@ -3678,7 +3769,7 @@ SilcBool silc_server_remove_from_one_channel(SilcServer server,
     channel->global_users = FALSE;
 
   memset(chl, 'O', sizeof(*chl));
-  silc_free(chl);
+  silc_idlist_del_chl(server->local_list, chl);
 
   /* Update statistics */
   if (SILC_IS_LOCAL(client))
@@ -4154,6 +4245,212 @@ SilcChannelEntry silc_server_save_channel_key(SilcServer server,
   return channel;
 }
 
+/* Maximum amount of announcement data sent in one list packet.  Leaves
+   room for the packet header, IDs, padding and MAC. */
+#define SILC_SERVER_ANNOUNCE_MAX (SILC_PACKET_MAX_LEN - 512)
+
+/* Reserves `len' bytes from the end of the announcement buffer `*buf' and
+   returns pointer to the reserved area.  The announced data is between
+   the head and data area of the buffer, and the reserved area is the
+   data area.  Caller must pull the buffer by `len' after writing to the
+   area.  The buffer is grown geometrically, so that assembling a list of
+   entries is linear in time. */
+
+static unsigned char *silc_server_announce_reserve(SilcBuffer *buf,
+						   SilcUInt32 len)
+{
+  SilcBuffer sb = *buf;
+  SilcUInt32 size;
+
+  if (!sb) {
+    sb = silc_buffer_alloc(len > 1024 ? len : 1024);
+    if (!sb)
+      return NULL;
+    *buf = sb;
+  }
+
+  if (silc_buffer_taillen(sb) < len) {
+    size = silc_buffer_truelen(sb) * 2;
+    if (size < silc_buffer_truelen(sb) + len)
+      size = silc_buffer_truelen(sb) + len;
+    if (!silc_buffer_realloc(sb, size))
+      return NULL;
+  }
+
+  silc_buffer_pull_tail(sb, len);
+  return sb->data;
+}
+
+/* Appends `data' to the announcement buffer `*buf'. */
+
+static SilcBool silc_server_announce_put(SilcBuffer *buf,
+					 const unsigned char *data,
+					 SilcUInt32 data_len)
+{
+  if (!silc_server_announce_reserve(buf, data_len))
+    return FALSE;
+  silc_buffer_put(*buf, data, data_len);
+  silc_buffer_pull(*buf, data_len);
+  return TRUE;
+}
+
+/* Encodes ID Payload of `id' into `idp' and returns its length. */
+
+static SilcUInt32 silc_server_announce_id(void *id, SilcIdType type,
+					  unsigned char *idp,
+					  SilcUInt32 idp_size)
+{
+  SilcUInt32 id_len;
+
+  if (!silc_id_id2str(id, type, idp + 4, idp_size - 4, &id_len))
+    return 0;
+  SILC_PUT16_MSB(type, idp);
+  SILC_PUT16_MSB(id_len, idp + 2);
+
+  return 4 + id_len;
+}
+
+/* Appends Notify Payload to the announcement buffer `*buf'.  The variable
+   arguments are pairs of data and data length, as with the function
+   silc_notify_payload_encode, but the payload is encoded directly to the
+   buffer without temporary allocations. */
+
+static SilcBool silc_server_announce_put_notify(SilcBuffer *buf,
+						SilcNotifyType notify,
+						SilcUInt32 argc, ...)
+{
+  va_list ap;
+  unsigned char *x, *p;
+  SilcUInt32 x_len, len = 5;
+  int i, k = 0;
+
+  va_start(ap, argc);
+  for (i = 0; i < argc; i++) {
+    x = va_arg(ap, unsigned char *);
+    x_len = va_arg(ap, SilcUInt32);
+    if (!x || !x_len)
+      continue;
+    len += 3 + (SilcUInt16)x_len;
+    k++;
+  }
+  va_end(ap);
+
+  p = silc_server_announce_reserve(buf, len);
+  if (!p)
+    return FALSE;
+
+  SILC_PUT16_MSB(notify, p);
+  SILC_PUT16_MSB(len, p + 2);
+  p[4] = k;
+  p += 5;
+
+  va_start(ap, argc);
+  for (i = 0; i < argc; i++) {
+    x = va_arg(ap, unsigned char *);
+    x_len = va_arg(ap, SilcUInt32);
+    if (!x || !x_len)
+      continue;
+    x_len = (SilcUInt16)x_len;
+    SILC_PUT16_MSB(x_len, p);
+    p[2] = i + 1;
+    memcpy(p + 3, x, x_len);
+    p += 3 + x_len;
+  }
+  va_end(ap);
+
+  silc_buffer_pull(*buf, len);
+  return TRUE;
+}
+
+/* Returns the length of the first entry in announcement list `data' of
+   packet type `type', or zero if it cannot be determined. */
+
+static SilcUInt32 silc_server_announce_entry_len(SilcPacketType type,
+						 const unsigned char *data,
+						 SilcUInt32 data_len)
+{
+  SilcUInt16 len1, len2;
+
+  switch (type) {
+  case SILC_PACKET_NOTIFY:
+    if (data_len < 5)
+      return 0;
+    SILC_GET16_MSB(len1, data + 2);
+    return len1;
+
+  case SILC_PACKET_NEW_ID:
+    if (data_len < 4)
+      return 0;
+    SILC_GET16_MSB(len1, data + 2);
+    return 4 + len1;
+
+  case SILC_PACKET_NEW_CHANNEL:
+    if (data_len < 4)
+      return 0;
+    SILC_GET16_MSB(len1, data);
+    if (data_len < 4 + len1)
+      return 0;
+    SILC_GET16_MSB(len2, data + 2 + len1);
+    return 8 + len1 + len2;
+
+  default:
+    break;
+  }
+
+  return 0;
+}
+
+/* Sends the announcement list `buffer' assembled with the announcement
+   routines to `remote' as list packets of type `type' and frees the
+   buffer.  The list is split to as many packets as needed so that each
+   packet fits SILC_PACKET_MAX_LEN.  If `channel_id' is non-NULL the
+   packets are destined to the channel. */
+
+void silc_server_announce_send(SilcServer server, SilcPacketStream remote,
+			       SilcPacketType type,
+			       SilcChannelID *channel_id,
+			       SilcBuffer buffer)
+{
+  unsigned char *data;
+  SilcUInt32 data_len, len, elen;
+
+  if (!buffer)
+    return;
+
+  silc_buffer_push(buffer, buffer->data - buffer->head);
+  data = buffer->data;
+  data_len = silc_buffer_len(buffer);
+
+  while (data_len) {
+    /* Take as many whole entries as fit in one packet */
+    len = 0;
+    while (len < data_len) {
+      elen = silc_server_announce_entry_len(type, data + len,
+					    data_len - len);
+      if (!elen || elen > data_len - len)
+	elen = data_len - len;
+      if (len && len + elen > SILC_SERVER_ANNOUNCE_MAX)
+	break;
+      len += elen;
+    }
+
+    SILC_LOG_HEXDUMP(("announce"), data, len);
+
+    if (channel_id)
+      silc_server_packet_send_dest(server, remote, type,
+				   SILC_PACKET_FLAG_LIST,
+				   channel_id, SILC_ID_CHANNEL, data, len);
+    else
+      silc_server_packet_send(server, remote, type,
+			      SILC_PACKET_FLAG_LIST, data, len);
+
+    data += len;
+    data_len -= len;
+  }
+
+  silc_buffer_free(buffer);
+}
+
 /* Returns assembled of all servers in the given ID list. The packet's
    form is dictated by the New ID payload. */
 
@@ -4166,8 +4463,8 @@ static void silc_server_announce_get_servers(SilcServer server,
   SilcList list;
   SilcIDCacheEntry id_cache;
   SilcServerEntry entry;
-  SilcBuffer idp;
-  void *tmp;
+  unsigned char idp[64];
+  SilcUInt32 idp_len;
 
   /* Go through all clients in the list */
   if (silc_idcache_get_all(id_list->servers, &list)) {
@@ -4182,20 +4479,10 @@ static void silc_server_announce_get_servers(SilcServer server,
 	  (creation_time && entry->data.created < creation_time))
 	continue;
 
-      idp = silc_id_payload_encode(entry->id, SILC_ID_SERVER);
-
-      tmp = silc_buffer_realloc(*servers,
-				(*servers ?
-				 silc_buffer_truelen((*servers)) +
-				 silc_buffer_len(idp) :
-				 silc_buffer_len(idp)));
-      if (!tmp)
+      idp_len = silc_server_announce_id(entry->id, SILC_ID_SERVER,
+					idp, sizeof(idp));
+      if (!idp_len || !silc_server_announce_put(servers, idp, idp_len))
 	return;
-      *servers = tmp;
-      silc_buffer_pull_tail(*servers, ((*servers)->end - (*servers)->data));
-      silc_buffer_put(*servers, idp->data, silc_buffer_len(idp));
-      silc_buffer_pull(*servers, silc_buffer_len(idp));
-      silc_buffer_free(idp);
     }
   }
 }
@@ -4237,17 +4524,9 @@ void silc_server_announce_servers(SilcServer server, SilcBool global,
 				     server->global_list, &servers,
 				     creation_time);
 
-  if (servers) {
-    silc_buffer_push(servers, servers->data - servers->head);
-    SILC_LOG_HEXDUMP(("servers"), servers->data, silc_buffer_len(servers));
-
-    /* Send the packet */
-    silc_server_packet_send(server, remote,
-			    SILC_PACKET_NEW_ID, SILC_PACKET_FLAG_LIST,
-			    servers->data, silc_buffer_len(servers));
-
-    silc_buffer_free(servers);
-  }
+  /* Send the packets */
+  silc_server_announce_send(server, remote, SILC_PACKET_NEW_ID, NULL,
+			    servers);
 }
 
 /* Returns assembled packet of all clients in the given ID list. The
@@ -4262,10 +4541,9 @@ static void silc_server_announce_get_clients(SilcServer server,
   SilcList list;
   SilcIDCacheEntry id_cache;
   SilcClientEntry client;
-  SilcBuffer idp;
-  SilcBuffer tmp;
+  unsigned char idp[64];
+  SilcUInt32 idp_len;
   unsigned char mode[4];
-  void *tmp2;
 
   /* Go through all clients in the list */
   if (silc_idcache_get_all(id_list->clients, &list)) {
@@ -4283,41 +4561,16 @@ static void silc_server_announce_get_clients(SilcServer server,
       SILC_LOG_DEBUG(("Announce Client ID %s",
 		      silc_id_render(client->id, SILC_ID_CLIENT)));
 
-      idp = silc_id_payload_encode(client->id, SILC_ID_CLIENT);
-      if (!idp)
+      idp_len = silc_server_announce_id(client->id, SILC_ID_CLIENT,
+					idp, sizeof(idp));
+      if (!idp_len || !silc_server_announce_put(clients, idp, idp_len))
 	return;
 
-      tmp2 = silc_buffer_realloc(*clients,
-				(*clients ?
-				 silc_buffer_truelen((*clients)) +
-				 silc_buffer_len(idp) :
-				 silc_buffer_len(idp)));
-      if (!tmp2)
-	return;
-      *clients = tmp2;
-      silc_buffer_pull_tail(*clients, ((*clients)->end - (*clients)->data));
-      silc_buffer_put(*clients, idp->data, silc_buffer_len(idp));
-      silc_buffer_pull(*clients, silc_buffer_len(idp));
-
       SILC_PUT32_MSB(client->mode, mode);
-      tmp =
-	silc_server_announce_encode_notify(SILC_NOTIFY_TYPE_UMODE_CHANGE,
-					   2, idp->data, silc_buffer_len(idp),
-					   mode, 4);
-      tmp2 = silc_buffer_realloc(*umodes,
-				 (*umodes ?
-				  silc_buffer_truelen((*umodes)) +
-				  silc_buffer_len(tmp) :
-				  silc_buffer_len(tmp)));
-      if (!tmp2)
+      if (!silc_server_announce_put_notify(umodes,
+					   SILC_NOTIFY_TYPE_UMODE_CHANGE,
+					   2, idp, idp_len, mode, 4))
 	return;
-      *umodes = tmp2;
-      silc_buffer_pull_tail(*umodes, ((*umodes)->end - (*umodes)->data));
-      silc_buffer_put(*umodes, tmp->data, silc_buffer_len(tmp));
-      silc_buffer_pull(*umodes, silc_buffer_len(tmp));
-      silc_buffer_free(tmp);
-
-      silc_buffer_free(idp);
     }
   }
 }
@@ -4345,29 +4598,11 @@ void silc_server_announce_clients(SilcServer server,
     silc_server_announce_get_clients(server, server->global_list,
 				     &clients, &umodes, creation_time);
 
-  if (clients) {
-    silc_buffer_push(clients, clients->data - clients->head);
-    SILC_LOG_HEXDUMP(("clients"), clients->data, silc_buffer_len(clients));
-
-    /* Send the packet */
-    silc_server_packet_send(server, remote,
-			    SILC_PACKET_NEW_ID, SILC_PACKET_FLAG_LIST,
-			    clients->data, silc_buffer_len(clients));
-
-    silc_buffer_free(clients);
-  }
-
-  if (umodes) {
-    silc_buffer_push(umodes, umodes->data - umodes->head);
-    SILC_LOG_HEXDUMP(("umodes"), umodes->data, silc_buffer_len(umodes));
-
-    /* Send the packet */
-    silc_server_packet_send(server, remote,
-			    SILC_PACKET_NOTIFY, SILC_PACKET_FLAG_LIST,
-			    umodes->data, silc_buffer_len(umodes));
-
-    silc_buffer_free(umodes);
-  }
+  /* Send the packets */
+  silc_server_announce_send(server, remote, SILC_PACKET_NEW_ID, NULL,
+			    clients);
+  silc_server_announce_send(server, remote, SILC_PACKET_NOTIFY, NULL,
+			    umodes);
 }
 
 /* Returns channel's topic for announcing it */
@@ -4462,17 +4697,21 @@ void silc_server_announce_get_channel_users(SilcServer server,
 {
   SilcChannelClientEntry chl;
   SilcHashTableList htl;
-  SilcBuffer chidp, clidp, csidp;
-  SilcBuffer tmp, fkey = NULL, chpklist;
-  int len;
+  unsigned char chidp[64], csidp[64], clidp[64];
+  SilcUInt32 chidp_len, csidp_len, clidp_len;
+  SilcBuffer fkey = NULL, chpklist;
   unsigned char mode[4], ulimit[4];
   char *hmac;
-  void *tmp2;
+  SilcBool founder;
 
   SILC_LOG_DEBUG(("Start"));
 
-  chidp = silc_id_payload_encode(channel->id, SILC_ID_CHANNEL);
-  csidp = silc_id_payload_encode(server->id, SILC_ID_SERVER);
+  chidp_len = silc_server_announce_id(channel->id, SILC_ID_CHANNEL,
+				      chidp, sizeof(chidp));
+  csidp_len = silc_server_announce_id(server->id, SILC_ID_SERVER,
+				      csidp, sizeof(csidp));
+  if (!chidp_len || !csidp_len)
+    return;
   chpklist = silc_server_get_channel_pk_list(server, channel, TRUE, FALSE);
 
   /* CMODE notify */
@@ -4482,109 +4721,66 @@ void silc_server_announce_get_channel_users(SilcServer server,
   hmac = channel->hmac ? (char *)silc_hmac_get_name(channel->hmac) : NULL;
   if (channel->founder_key)
     fkey = silc_public_key_payload_encode(channel->founder_key);
-  tmp =
-    silc_server_announce_encode_notify(SILC_NOTIFY_TYPE_CMODE_CHANGE,
-				       8, csidp->data,
-				       silc_buffer_len(csidp),
-				       mode, sizeof(mode),
-				       NULL, 0,
-				       hmac, hmac ? strlen(hmac) : 0,
-				       channel->passphrase,
-				       channel->passphrase ?
-				       strlen(channel->passphrase) : 0,
-				       fkey ? fkey->data : NULL,
-				       fkey ? silc_buffer_len(fkey) : 0,
-				       chpklist ? chpklist->data : NULL,
-				       chpklist ?
-				       silc_buffer_len(chpklist) : 0,
-				       (channel->mode &
-					SILC_CHANNEL_MODE_ULIMIT ?
-					ulimit : NULL),
-				       (channel->mode &
-					SILC_CHANNEL_MODE_ULIMIT ?
-					sizeof(ulimit) : 0));
-  len = silc_buffer_len(tmp);
-  tmp2 =
-    silc_buffer_realloc(*channel_modes,
-			(*channel_modes ?
-			 silc_buffer_truelen((*channel_modes)) + len : len));
-  if (!tmp2)
-    return;
-  *channel_modes = tmp2;
-  silc_buffer_pull_tail(*channel_modes,
-			((*channel_modes)->end -
-			 (*channel_modes)->data));
-  silc_buffer_put(*channel_modes, tmp->data, silc_buffer_len(tmp));
-  silc_buffer_pull(*channel_modes, len);
-  silc_buffer_free(tmp);
+  silc_server_announce_put_notify(channel_modes,
+				  SILC_NOTIFY_TYPE_CMODE_CHANGE,
+				  8, csidp, csidp_len,
+				  mode, sizeof(mode),
+				  NULL, 0,
+				  hmac, hmac ? strlen(hmac) : 0,
+				  channel->passphrase,
+				  channel->passphrase ?
+				  strlen(channel->passphrase) : 0,
+				  fkey ? fkey->data : NULL,
+				  fkey ? silc_buffer_len(fkey) : 0,
+				  chpklist ? chpklist->data : NULL,
+				  chpklist ?
+				  silc_buffer_len(chpklist) : 0,
+				  (channel->mode &
+				   SILC_CHANNEL_MODE_ULIMIT ?
+				   ulimit : NULL),
+				  (channel->mode &
+				   SILC_CHANNEL_MODE_ULIMIT ?
+				   sizeof(ulimit) : 0));
   silc_buffer_free(fkey);
+  silc_buffer_free(chpklist);
   fkey = NULL;
 
+  /* The founder key is same for all users */
+  if (channel->founder_key)
+    fkey = silc_public_key_payload_encode(channel->founder_key);
+
   /* Now find all users on the channel */
   silc_hash_table_list(channel->user_list, &htl);
   while (silc_hash_table_get(&htl, NULL, (void *)&chl)) {
-    clidp = silc_id_payload_encode(chl->client->id, SILC_ID_CLIENT);
+    clidp_len = silc_server_announce_id(chl->client->id, SILC_ID_CLIENT,
+					clidp, sizeof(clidp));
+    if (!clidp_len)
+      continue;
 
     SILC_LOG_DEBUG(("JOIN Client %s", silc_id_render(chl->client->id,
 						     SILC_ID_CLIENT)));
 
     /* JOIN Notify */
-    tmp = silc_server_announce_encode_notify(SILC_NOTIFY_TYPE_JOIN, 2,
-					     clidp->data,
-					     silc_buffer_len(clidp),
-					     chidp->data,
-					     silc_buffer_len(chidp));
-    len = silc_buffer_len(tmp);
-    tmp2 =
-      silc_buffer_realloc(*channel_users,
-			  (*channel_users ?
-			   silc_buffer_truelen((*channel_users)) + len : len));
-    if (!tmp2)
-      return;
-    *channel_users = tmp2;
-    silc_buffer_pull_tail(*channel_users,
-			  ((*channel_users)->end -
-			   (*channel_users)->data));
-
-    silc_buffer_put(*channel_users, tmp->data, silc_buffer_len(tmp));
-    silc_buffer_pull(*channel_users, len);
-    silc_buffer_free(tmp);
+    if (!silc_server_announce_put_notify(channel_users,
+					 SILC_NOTIFY_TYPE_JOIN, 2,
+					 clidp, clidp_len,
+					 chidp, chidp_len))
+      break;
 
     /* CUMODE notify for mode change on the channel */
     SILC_PUT32_MSB(chl->mode, mode);
-    if (chl->mode & SILC_CHANNEL_UMODE_CHANFO && channel->founder_key)
-      fkey = silc_public_key_payload_encode(channel->founder_key);
-    tmp = silc_server_announce_encode_notify(SILC_NOTIFY_TYPE_CUMODE_CHANGE,
-					     4, csidp->data,
-					     silc_buffer_len(csidp),
-					     mode, sizeof(mode),
-					     clidp->data,
-					     silc_buffer_len(clidp),
-					     fkey ? fkey->data : NULL,
-					     fkey ? silc_buffer_len(fkey) : 0);
-    len = silc_buffer_len(tmp);
-    tmp2 =
-      silc_buffer_realloc(*channel_users_modes,
-			  (*channel_users_modes ?
-			   silc_buffer_truelen((*channel_users_modes)) +
-			   len : len));
-    if (!tmp2)
-      return;
-    *channel_users_modes = tmp2;
-    silc_buffer_pull_tail(*channel_users_modes,
-			  ((*channel_users_modes)->end -
-			   (*channel_users_modes)->data));
-
-    silc_buffer_put(*channel_users_modes, tmp->data, silc_buffer_len(tmp));
-    silc_buffer_pull(*channel_users_modes, len);
-    silc_buffer_free(tmp);
-    silc_buffer_free(fkey);
-    fkey = NULL;
-    silc_buffer_free(clidp);
+    founder = (chl->mode & SILC_CHANNEL_UMODE_CHANFO) && fkey;
+    if (!silc_server_announce_put_notify(channel_users_modes,
+					 SILC_NOTIFY_TYPE_CUMODE_CHANGE,
+					 4, csidp, csidp_len,
+					 mode, sizeof(mode),
+					 clidp, clidp_len,
+					 founder ? fkey->data : NULL,
+					 founder ? silc_buffer_len(fkey) : 0))
+      break;
   }
   silc_hash_table_list_reset(&htl);
-  silc_buffer_free(chidp);
-  silc_buffer_free(csidp);
+  silc_buffer_free(fkey);
 }
 
 /* Returns assembled packets for all channels and users on those channels
@@ -4607,8 +4803,8 @@ void silc_server_announce_get_channels(SilcServer server,
   SilcList list;
   SilcIDCacheEntry id_cache;
   SilcChannelEntry channel;
-  unsigned char cid[32];
-  SilcUInt32 id_len;
+  unsigned char cid[32], *p;
+  SilcUInt32 id_len, count;
   SilcUInt16 name_len;
   int len;
   int i = *channel_users_modes_c;
@@ -4619,6 +4815,34 @@ void silc_server_announce_get_channels(SilcServer server,
 
   /* Go through all channels in the list */
   if (silc_idcache_get_all(id_list->channels, &list)) {
+    /* Allocate per channel lists for all channels at once */
+    count = i + silc_list_count(list);
+    tmp = silc_realloc(*channel_users_modes,
+		       sizeof(**channel_users_modes) * count);
+    if (!tmp)
+      return;
+    *channel_users_modes = tmp;
+    tmp = silc_realloc(*channel_modes, sizeof(**channel_modes) * count);
+    if (!tmp)
+      return;
+    *channel_modes = tmp;
+    tmp = silc_realloc(*channel_ids, sizeof(**channel_ids) * count);
+    if (!tmp)
+      return;
+    *channel_ids = tmp;
+    tmp = silc_realloc(*channel_topics, sizeof(**channel_topics) * count);
+    if (!tmp)
+      return;
+    *channel_topics = tmp;
+    tmp = silc_realloc(*channel_invites, sizeof(**channel_invites) * count);
+    if (!tmp)
+      return;
+    *channel_invites = tmp;
+    tmp = silc_realloc(*channel_bans, sizeof(**channel_bans) * count);
+    if (!tmp)
+      return;
+    *channel_bans = tmp;
+
     silc_list_start(list);
     while ((id_cache = silc_list_get(list))) {
       channel = (SilcChannelEntry)id_cache->context;
@@ -4636,17 +4860,9 @@ void silc_server_announce_get_channels(SilcServer server,
 
       if (announce) {
 	len = 4 + name_len + id_len + 4;
-	tmp =
-	  silc_buffer_realloc(*channels,
-			      (*channels ?
-			       silc_buffer_truelen((*channels)) +
-			       len : len));
-	if (!tmp)
+	p = silc_server_announce_reserve(channels, len);
+	if (!p)
 	  break;
-	*channels = tmp;
-
-	silc_buffer_pull_tail(*channels,
-			      ((*channels)->end - (*channels)->data));
 	silc_buffer_format(*channels,
 			   SILC_STR_UI_SHORT(name_len),
 			   SILC_STR_UI_XNSTRING(channel->channel_name,
@@ -4665,24 +4881,8 @@ void silc_server_announce_get_channels(SilcServer server,
 
       if (announce) {
 	/* Channel user modes */
-	tmp = silc_realloc(*channel_users_modes,
-			    sizeof(**channel_users_modes) * (i + 1));
-	if (!tmp)
-	  break;
-	*channel_users_modes = tmp;
 	(*channel_users_modes)[i] = NULL;
-	tmp = silc_realloc(*channel_modes,
-			   sizeof(**channel_modes) * (i + 1));
-	if (!tmp)
-	  break;
-	*channel_modes = tmp;
 	(*channel_modes)[i] = NULL;
-	tmp = silc_realloc(*channel_ids,
-			   sizeof(**channel_ids) * (i + 1));
-	if (!tmp)
-	  break;
-	*channel_ids = tmp;
-	(*channel_ids)[i] = NULL;
 	silc_server_announce_get_channel_users(server, channel,
 					       &(*channel_modes)[i],
 					       channel_users,
@@ -4690,27 +4890,12 @@ void silc_server_announce_get_channels(SilcServer server,
 	(*channel_ids)[i] = channel->id;
 
 	/* Channel's topic */
-	tmp = silc_realloc(*channel_topics,
-			   sizeof(**channel_topics) * (i + 1));
-	if (!tmp)
-	  break;
-	*channel_topics = tmp;
 	(*channel_topics)[i] = NULL;
 	silc_server_announce_get_channel_topic(server, channel,
 					       &(*channel_topics)[i]);
 
 	/* Channel's invite and ban list */
-	tmp = silc_realloc(*channel_invites,
-			   sizeof(**channel_invites) * (i + 1));
-	if (!tmp)
-	  break;
-	*channel_invites = tmp;
 	(*channel_invites)[i] = NULL;
-	tmp = silc_realloc(*channel_bans,
-			   sizeof(**channel_bans) * (i + 1));
-	if (!tmp)
-	  break;
-	*channel_bans = tmp;
 	(*channel_bans)[i] = NULL;
 	silc_server_announce_get_inviteban(server, channel,
 					   &(*channel_invites)[i],
@@ -4742,6 +4927,7 @@ void silc_server_announce_channels(SilcServer server,
   SilcBuffer *channel_bans = NULL;
   SilcUInt32 channel_users_modes_c = 0;
   SilcChannelID **channel_ids = NULL;
+  int i;
 
   SILC_LOG_DEBUG(("Announcing channels and channel users"));
 
@@ -4768,139 +4954,33 @@ void silc_server_announce_channels(SilcServer server,
 				      &channel_bans,
 				      &channel_ids, creation_time);
 
-  if (channels) {
-    silc_buffer_push(channels, channels->data - channels->head);
-    SILC_LOG_HEXDUMP(("channels"), channels->data, silc_buffer_len(channels));
-
-    /* Send the packet */
-    silc_server_packet_send(server, remote,
-			    SILC_PACKET_NEW_CHANNEL, SILC_PACKET_FLAG_LIST,
-			    channels->data, silc_buffer_len(channels));
-
-    silc_buffer_free(channels);
-  }
-
-  if (channel_users) {
-    silc_buffer_push(channel_users, channel_users->data - channel_users->head);
-    SILC_LOG_HEXDUMP(("channel users"), channel_users->data,
-		     silc_buffer_len(channel_users));
-
-    /* Send the packet */
-    silc_server_packet_send(server, remote,
-			    SILC_PACKET_NOTIFY, SILC_PACKET_FLAG_LIST,
-			    channel_users->data, silc_buffer_len(channel_users));
-
-    silc_buffer_free(channel_users);
-  }
-
-  if (channel_modes) {
-    int i;
-
-    for (i = 0; i < channel_users_modes_c; i++) {
-      if (!channel_modes[i])
-        continue;
-      silc_buffer_push(channel_modes[i],
-		       channel_modes[i]->data -
-		       channel_modes[i]->head);
-      SILC_LOG_HEXDUMP(("channel modes"), channel_modes[i]->data,
-		       silc_buffer_len(channel_modes[i]));
-      silc_server_packet_send_dest(server, remote,
-				   SILC_PACKET_NOTIFY, SILC_PACKET_FLAG_LIST,
-				   channel_ids[i], SILC_ID_CHANNEL,
-				   channel_modes[i]->data,
-				   silc_buffer_len(channel_modes[i]));
-      silc_buffer_free(channel_modes[i]);
-    }
-    silc_free(channel_modes);
-  }
-
-  if (channel_users_modes) {
-    int i;
-
-    for (i = 0; i < channel_users_modes_c; i++) {
-      if (!channel_users_modes[i])
-        continue;
-      silc_buffer_push(channel_users_modes[i],
-		       channel_users_modes[i]->data -
-		       channel_users_modes[i]->head);
-      SILC_LOG_HEXDUMP(("channel users modes"), channel_users_modes[i]->data,
-		       silc_buffer_len(channel_users_modes[i]));
-      silc_server_packet_send_dest(server, remote,
-				   SILC_PACKET_NOTIFY, SILC_PACKET_FLAG_LIST,
-				   channel_ids[i], SILC_ID_CHANNEL,
-				   channel_users_modes[i]->data,
-				   silc_buffer_len(channel_users_modes[i]));
-      silc_buffer_free(channel_users_modes[i]);
-    }
-    silc_free(channel_users_modes);
-  }
-
-  if (channel_topics) {
-    int i;
-
-    for (i = 0; i < channel_users_modes_c; i++) {
-      if (!channel_topics[i])
-	continue;
-
-      silc_buffer_push(channel_topics[i],
-		       channel_topics[i]->data -
-		       channel_topics[i]->head);
-      SILC_LOG_HEXDUMP(("channel topic"), channel_topics[i]->data,
-		       silc_buffer_len(channel_topics[i]));
-      silc_server_packet_send_dest(server, remote,
-				   SILC_PACKET_NOTIFY, SILC_PACKET_FLAG_LIST,
-				   channel_ids[i], SILC_ID_CHANNEL,
-				   channel_topics[i]->data,
-				   silc_buffer_len(channel_topics[i]));
-      silc_buffer_free(channel_topics[i]);
-    }
-    silc_free(channel_topics);
-  }
-
-  if (channel_invites) {
-    int i;
-
-    for (i = 0; i < channel_users_modes_c; i++) {
-      if (!channel_invites[i])
-	continue;
-
-      silc_buffer_push(channel_invites[i],
-		       channel_invites[i]->data -
-		       channel_invites[i]->head);
-      SILC_LOG_HEXDUMP(("channel invite list"), channel_invites[i]->data,
-		       silc_buffer_len(channel_invites[i]));
-      silc_server_packet_send_dest(server, remote,
-				   SILC_PACKET_NOTIFY, SILC_PACKET_FLAG_LIST,
-				   channel_ids[i], SILC_ID_CHANNEL,
-				   channel_invites[i]->data,
-				   silc_buffer_len(channel_invites[i]));
-      silc_buffer_free(channel_invites[i]);
-    }
-    silc_free(channel_invites);
-  }
-
-  if (channel_bans) {
-    int i;
-
-    for (i = 0; i < channel_users_modes_c; i++) {
-      if (!channel_bans[i])
-	continue;
-
-      silc_buffer_push(channel_bans[i],
-		       channel_bans[i]->data -
-		       channel_bans[i]->head);
-      SILC_LOG_HEXDUMP(("channel ban list"), channel_bans[i]->data,
-		       silc_buffer_len(channel_bans[i]));
-      silc_server_packet_send_dest(server, remote,
-				   SILC_PACKET_NOTIFY, SILC_PACKET_FLAG_LIST,
-				   channel_ids[i], SILC_ID_CHANNEL,
-				   channel_bans[i]->data,
-				   silc_buffer_len(channel_bans[i]));
-      silc_buffer_free(channel_bans[i]);
-    }
-    silc_free(channel_bans);
-  }
-
+  /* Send the packets */
+  silc_server_announce_send(server, remote, SILC_PACKET_NEW_CHANNEL, NULL,
+			    channels);
+  silc_server_announce_send(server, remote, SILC_PACKET_NOTIFY, NULL,
+			    channel_users);
+
+  for (i = 0; i < channel_users_modes_c; i++)
+    silc_server_announce_send(server, remote, SILC_PACKET_NOTIFY,
+			      channel_ids[i], channel_modes[i]);
+  for (i = 0; i < channel_users_modes_c; i++)
+    silc_server_announce_send(server, remote, SILC_PACKET_NOTIFY,
+			      channel_ids[i], channel_users_modes[i]);
+  for (i = 0; i < channel_users_modes_c; i++)
+    silc_server_announce_send(server, remote, SILC_PACKET_NOTIFY,
+			      channel_ids[i], channel_topics[i]);
+  for (i = 0; i < channel_users_modes_c; i++)
+    silc_server_announce_send(server, remote, SILC_PACKET_NOTIFY,
+			      channel_ids[i], channel_invites[i]);
+  for (i = 0; i < channel_users_modes_c; i++)
+    silc_server_announce_send(server, remote, SILC_PACKET_NOTIFY,
+			      channel_ids[i], channel_bans[i]);
+
+  silc_free(channel_modes);
+  silc_free(channel_users_modes);
+  silc_free(channel_topics);
+  silc_free(channel_invites);
+  silc_free(channel_bans);
   silc_free(channel_ids);
 }
 
@@ -4936,8 +5016,9 @@ void silc_server_announce_watches(SilcServer server,
     args = silc_argument_payload_encode_one(args, pkp->data,
 					    silc_buffer_len(pkp), 0x00);
     buffer = silc_command_payload_encode_va(SILC_COMMAND_WATCH,
-					    ++server->cmd_ident, 2,
-					    1, idp->data, silc_buffer_len(idp),
+					    silc_server_command_ident(server),
+					    2, 1, idp->data,
+					    silc_buffer_len(idp),
 					    4, args->data,
 					    silc_buffer_len(args));
 
@@ -5089,7 +5170,7 @@ void silc_server_save_users_on_channel(SilcServer server,
 
     if (!silc_server_client_on_channel(client, channel, &chl)) {
       /* Client was not on the channel, add it. */
-      chl = silc_calloc(1, sizeof(*chl));
+      chl = silc_idlist_add_chl(server->local_list);
       chl->client = client;
       chl->mode = mode;
       chl->channel = channel;
@@ -5100,6 +5181,7 @@ void silc_server_save_users_on_channel(SilcServer server,
       /* Update mode */
       chl->mode = mode;
     }
+    SILC_CHANNEL_DELIVERY_RESET(channel);
   }
 }
 
@@ -5167,7 +5249,7 @@ void silc_server_save_user_channels(SilcServer server,
 
       /* Add the client on the channel */
       if (!silc_server_client_on_channel(client, channel, &chl)) {
-	chl = silc_calloc(1, sizeof(*chl));
+	chl = silc_idlist_add_chl(server->local_list);
 	chl->client = client;
 	chl->mode = chumodes[i++];
 	chl->channel = channel;
@@ -5178,6 +5260,7 @@ void silc_server_save_user_channels(SilcServer server,
 	/* Update mode */
 	chl->mode = chumodes[i++];
       }
+      SILC_CHANNEL_DELIVERY_RESET(channel);
 
       silc_hash_table_add(ht, channel, channel);
     }
@@ -5192,9 +5275,10 @@ void silc_server_save_user_channels(SilcServer server,
     silc_hash_table_list(client->channels, &htl);
     while (silc_hash_table_get(&htl, NULL, (void *)&chl)) {
       if (!silc_hash_table_find(ht, chl->channel, NULL, NULL)) {
+	SILC_CHANNEL_DELIVERY_RESET(chl->channel);
 	silc_hash_table_del(chl->channel->user_list, chl->client);
 	silc_hash_table_del(chl->client->channels, chl->channel);
-	silc_free(chl);
+	silc_idlist_del_chl(server->local_list, chl);
       }
     }
     silc_hash_table_list_reset(&htl);
@@ -5202,9 +5286,10 @@ void silc_server_save_user_channels(SilcServer server,
   } else {
     silc_hash_table_list(client->channels, &htl);
     while (silc_hash_table_get(&htl, NULL, (void *)&chl)) {
+      SILC_CHANNEL_DELIVERY_RESET(chl->channel);
       silc_hash_table_del(chl->channel->user_list, chl->client);
       silc_hash_table_del(chl->client->channels, chl->channel);
-      silc_free(chl);
+      silc_idlist_del_chl(server->local_list, chl);
     }
     silc_hash_table_list_reset(&htl);
   }
@@ -5223,29 +5308,39 @@ silc_server_get_client_route(SilcServer server,
 			     SilcIDListData *idata,
 			     SilcClientEntry *client_entry)
 {
-  SilcClientID *id, clid;
   SilcClientEntry client;
+  SilcBool local = TRUE;
 
   SILC_LOG_DEBUG(("Start"));
 
   if (client_entry)
     *client_entry = NULL;
 
-  /* Decode destination Client ID */
+  /* Find the destination client from local and global list.  Encoded
+     Client ID is found without decoding it. */
   if (!client_id) {
-    if (!silc_id_str2id(id_data, id_len, SILC_ID_CLIENT, &clid, sizeof(clid)))
-      return NULL;
-    id = silc_id_dup(&clid, SILC_ID_CLIENT);
+    client = silc_idlist_find_client_by_id_str(server->local_list, id_data,
+					       id_len, TRUE, &local);
+    if (!client) {
+      /* Unknown ID, check that it is valid before routing it anywhere */
+      SilcClientID clid;
+      if (!silc_id_str2id(id_data, id_len, SILC_ID_CLIENT, &clid,
+			  sizeof(clid)))
+	return NULL;
+    }
   } else {
-    id = silc_id_dup(client_id, SILC_ID_CLIENT);
+    client = silc_idlist_find_client_by_id(server->local_list, client_id,
+					   TRUE, NULL);
+    if (!client) {
+      local = FALSE;
+      client = silc_idlist_find_client_by_id(server->global_list, client_id,
+					     TRUE, NULL);
+    }
   }
 
   /* If the destination belongs to our server we don't have to route
      the packet anywhere but to send it to the local destination. */
-  client = silc_idlist_find_client_by_id(server->local_list, id, TRUE, NULL);
-  if (client) {
-    silc_free(id);
-
+  if (client && local) {
     /* If we are router and the client has router then the client is in
        our cell but not directly connected to us. */
     if (server->server_type == SILC_ROUTER && client->router) {
@@ -5268,31 +5363,26 @@ silc_server_get_client_route(SilcServer server,
   /* Destination belongs to someone not in this server. If we are normal
      server our action is to send the packet to our router. */
   if (server->server_type != SILC_ROUTER && !server->standalone) {
-    silc_free(id);
     if (idata)
       *idata = (SilcIDListData)server->router;
     return SILC_PRIMARY_ROUTE(server);
   }
 
   /* We are router and we will perform route lookup for the destination
-     and send the packet to fastest route. */
+     and send the packet to fastest route.  The route to the client is
+     the route to the server that owns it. */
   if (server->server_type == SILC_ROUTER && !server->standalone) {
     /* Check first that the ID is valid */
-    client = silc_idlist_find_client_by_id(server->global_list, id,
-					   TRUE, NULL);
     if (client) {
       SilcPacketStream dst_sock;
 
-      dst_sock = silc_server_route_get(server, id, SILC_ID_CLIENT);
-
-      silc_free(id);
+      dst_sock = silc_server_route_next_hop(server, client->router);
       if (idata && dst_sock)
 	*idata = silc_packet_get_context(dst_sock);
       return dst_sock;
     }
   }
 
-  silc_free(id);
   return NULL;
 }
 
@@ -5379,8 +5469,8 @@ SILC_TASK_CALLBACK(silc_server_get_stats)
     idp = silc_id_payload_encode(server->router->id, SILC_ID_SERVER);
     if (idp) {
       packet = silc_command_payload_encode_va(SILC_COMMAND_STATS,
-					      ++server->cmd_ident, 1,
-					      1, idp->data,
+					      silc_server_command_ident(server),
+					      1, 1, idp->data,
 					      silc_buffer_len(idp));
       silc_server_packet_send(server, SILC_PRIMARY_ROUTE(server),
 			      SILC_PACKET_COMMAND, 0, packet->data,
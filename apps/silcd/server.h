@@ -45,6 +45,7 @@ typedef struct SilcServerConnectionStruct {
 
   char *remote_host;
   int remote_port;
+  char *remote_ip;			/* Key in server->conns_ip */
 
   char *backup_replace_ip;
   int backup_replace_port;
@@ -89,6 +90,9 @@ typedef struct SilcServerConnectionStruct {
 #define SILC_SERVER_REKEY              3600	 /* Session rekey interval */
 #define SILC_SERVER_SKE_TIMEOUT        60	 /* SKE timeout */
 #define SILC_SERVER_CONNAUTH_TIMEOUT   60	 /* CONN_AUTH timeout */
+#define SILC_SERVER_LIST_CACHE_TTL     60	 /* LIST cache lifetime */
+#define SILC_SERVER_CRYPTO_WORKERS     4	 /* SKE crypto worker threads */
+#define SILC_SERVER_CRYPTO_QUEUE       1000	 /* SKE crypto queue length */
 #define SILC_SERVER_MAX_CONNECTIONS    1000	 /* Max connections */
 #define SILC_SERVER_MAX_CONNECTIONS_SINGLE 1000  /* Max connections per host */
 #define SILC_SERVER_LOG_FLUSH_DELAY    300       /* Default log flush delay */
@@ -209,6 +213,10 @@ void silc_server_announce_get_channels(SilcServer server,
 				       SilcBuffer **channel_bans,
 				       SilcChannelID ***channel_ids,
 				       unsigned long creation_time);
+void silc_server_announce_send(SilcServer server, SilcPacketStream remote,
+			       SilcPacketType type,
+			       SilcChannelID *channel_id,
+			       SilcBuffer buffer);
 void silc_server_announce_servers(SilcServer server, SilcBool global,
 				  unsigned long creation_time,
 				  SilcPacketStream remote);
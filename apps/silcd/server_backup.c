@@ -631,8 +631,9 @@ void silc_server_backup_resume_router(SilcServer server,
     SILC_LOG_DEBUG(("Sending PING to detect status of primary router"));
     idp = silc_id_payload_encode(server->router->id, SILC_ID_SERVER);
     silc_server_send_command(server, SILC_PRIMARY_ROUTE(server),
-			     SILC_COMMAND_PING, ++server->cmd_ident, 1,
-			     1, idp->data, silc_buffer_len(idp));
+			     SILC_COMMAND_PING,
+			     silc_server_command_ident(server),
+			     1, 1, idp->data, silc_buffer_len(idp));
     silc_buffer_free(idp);
 
     /* Reprocess this packet after received reply from router */
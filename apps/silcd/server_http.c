@@ -49,6 +49,22 @@ do {								\
   silc_buffer_strformat(&page, buf, SILC_STRFMT_END);		\
 } while(0)
 
+#define STAT_OUTPUT64(fmt, stat)				\
+do {								\
+  silc_snprintf(buf, sizeof(buf), fmt "<br>",			\
+		(unsigned long long)stat);			\
+  silc_buffer_strformat(&page, buf, SILC_STRFMT_END);		\
+} while(0)
+
+#define SLAB_OUTPUT(name, slab)					\
+do {								\
+  SilcUInt32 _live, _free;					\
+  silc_slab_stats(slab, &_live, &_free);			\
+  silc_snprintf(buf, sizeof(buf), name " : %d/%d<br>",		\
+		(int)_live, (int)_free);			\
+  silc_buffer_strformat(&page, buf, SILC_STRFMT_END);		\
+} while(0)
+
 
 /****************************** HTTP access *********************************/
 
@@ -62,8 +78,11 @@ static void silc_server_http_callback(SilcHttpServer httpd,
 				      void *context)
 {
   SilcServer server = context;
+  SilcIDListSlabs slabs = server->local_list->slabs;
   SilcBufferStruct page;
+  SilcSKECryptoStatsStruct crypto;
   unsigned char buf[128];
+  int i;
 
   SILC_LOG_DEBUG(("HTTP callback: %s %s", method, uri));
 
@@ -127,6 +146,49 @@ static void silc_server_http_callback(SilcHttpServer httpd,
       STAT_OUTPUT("Commands sent : %d", server->stat.commands_sent);
       STAT_OUTPUT("Commands received : %d", server->stat.commands_received);
       STAT_OUTPUT("Connections   : %d", server->stat.conn_num);
+      STAT_OUTPUT("Channel messages relayed : %d",
+		  server->stat.chmsgs_relayed);
+      STAT_OUTPUT("Channel messages/sec : %d",
+		  (server->stat.chmsgs_relayed /
+		   (silc_time() - server->starttime ?
+		    silc_time() - server->starttime : 1)));
+      STAT_OUTPUT64("Channel message recipients : %llu",
+		    server->stat.chmsgs_recipients);
+      STAT_OUTPUT64("Usec per recipient : %llu",
+		    (server->stat.chmsgs_recipients ?
+		     server->stat.chmsgs_relay_usec /
+		     server->stat.chmsgs_recipients : 0));
+      STAT_OUTPUT("LIST cache hits : %d", server->stat.list_cache_hits);
+      STAT_OUTPUT("LIST cache misses : %d", server->stat.list_cache_misses);
+      STAT_OUTPUT("Transit packets : %d", server->stat.transit_packets);
+      STAT_OUTPUT64("Transit kilobytes : %llu",
+		    server->stat.transit_bytes / 1024);
+      silc_ske_get_crypto_stats(&crypto);
+      STAT_OUTPUT("SKE crypto workers busy : %d", crypto.workers);
+      STAT_OUTPUT("SKE crypto queue : %d", crypto.queued);
+      STAT_OUTPUT("SKE crypto queue peak : %d", crypto.queued_peak);
+      STAT_OUTPUT("SKE crypto operations : %d", crypto.completed);
+      STAT_OUTPUT("SKE rejected, queue full : %d", crypto.rejected);
+
+      silc_buffer_strformat(&page, "<p><b>Slabs (live/free):</b><p>",
+			    SILC_STRFMT_END);
+      SLAB_OUTPUT("Server entries", slabs->servers);
+      SLAB_OUTPUT("Client entries", slabs->clients);
+      SLAB_OUTPUT("Channel entries", slabs->channels);
+      SLAB_OUTPUT("Channel client entries", slabs->chl);
+      SLAB_OUTPUT("Hash table entries", slabs->hash);
+
+      silc_buffer_strformat(&page, "<p><b>SKE crypto latency "
+			    "(wait/run):</b><p>", SILC_STRFMT_END);
+      for (i = 0; i < SILC_SKE_CRYPTO_BUCKETS - 1; i++) {
+	silc_snprintf(buf, sizeof(buf), "&lt; %d ms : %d/%d<br>",
+		      1 << (2 * i), (int)crypto.wait[i], (int)crypto.run[i]);
+	silc_buffer_strformat(&page, buf, SILC_STRFMT_END);
+      }
+      silc_snprintf(buf, sizeof(buf), "&gt;= %d ms : %d/%d<br>",
+		    1 << (2 * (i - 1)), (int)crypto.wait[i],
+		    (int)crypto.run[i]);
+      silc_buffer_strformat(&page, buf, SILC_STRFMT_END);
 
       silc_buffer_strformat(&page, HTTP_END, SILC_STRFMT_END);
 
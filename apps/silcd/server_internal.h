@@ -63,8 +63,35 @@ typedef struct {
   SilcUInt32 conn_num;			  /* Number of connections */
   SilcUInt32 commands_sent;	          /* Commands/replies sent */
   SilcUInt32 commands_received;	          /* Commands/replies received */
+  SilcUInt32 chmsgs_relayed;		  /* Channel messages relayed */
+  SilcUInt64 chmsgs_recipients;		  /* Relayed channel msg recipients */
+  SilcUInt64 chmsgs_relay_usec;		  /* Time used relaying channel msgs */
+  SilcUInt32 list_cache_hits;		  /* LIST replied from cache */
+  SilcUInt32 list_cache_misses;		  /* LIST cache rebuilt or fetched */
+  SilcUInt32 transit_packets;		  /* Transit packets forwarded */
+  SilcUInt64 transit_bytes;		  /* Transit payload bytes forwarded */
+#ifdef SILC_DEBUG
+  SilcUInt32 stack_packets;		  /* Packets allocating from stack */
+  SilcUInt64 stack_allocs;		  /* Stack allocations by packets */
+  SilcUInt64 stack_bytes;		  /* Stack bytes used by packets */
+  SilcUInt32 stack_peak;		  /* Most stack bytes for one packet */
+#endif /* SILC_DEBUG */
 } SilcServerStatistics;
 
+/* Cached channel list for the LIST command.  The list is rebuilt when
+   channels are added to or deleted from the ID lists.  Normal server
+   lists the channels without asking router for `list_cache_ttl' seconds
+   after all channels were last received from the router. */
+typedef struct {
+  SilcChannelEntry *channels;		  /* Local, then global channels */
+  SilcUInt32 local_count;		  /* Number of local channels */
+  SilcUInt32 count;			  /* Number of all channels */
+  SilcUInt32 local_gen;			  /* Local list generation */
+  SilcUInt32 global_gen;		  /* Global list generation */
+  SilcInt64 updated;			  /* Time received from router */
+  SilcUInt16 ident;			  /* Ident of LIST sent to router */
+} SilcServerListCache;
+
 /*
    SILC Server Object.
 
@@ -73,7 +100,8 @@ struct SilcServerStruct {
   SilcSchedule schedule;	     /* Server scheduler */
   SilcDList listeners;		     /* TCP listeners */
   SilcPacketEngine packet_engine;    /* Packet engine */
-  SilcDList conns;		     /* Connections in server */
+  SilcHashTable conns;		     /* Connections by remote host */
+  SilcHashTable conns_ip;	     /* Connections by IP address */
   SilcSKR repository;		     /* Public key repository */
   SilcPublicKey public_key;	     /* Server public key */
   SilcPrivateKey private_key;	     /* Server private key */
@@ -96,6 +124,10 @@ struct SilcServerStruct {
   /* Current command identifier, 0 not used */
   SilcUInt16 cmd_ident;
 
+  /* Channel delivery list generation and build counter, 0 not used */
+  SilcUInt32 delivery_gen;
+  SilcUInt32 delivery_build;
+
   /* ID lists. */
   SilcIDList local_list;
   SilcIDList global_list;
@@ -114,11 +146,21 @@ struct SilcServerStruct {
   /* Random pool */
   SilcRng rng;
 
+  /* Stack for the allocations made while processing one received
+     packet.  The frame is popped after the packet is processed. */
+  SilcStack stack;
+
   /* Server statistics */
   SilcServerStatistics stat;
 
-  /* Pending command queue */
-  SilcDList pending_commands;
+  /* Pending commands hashed by command identifier, and the pool of
+     unused pending command contexts */
+  SilcHashTable pending_commands;
+  struct SilcServerCommandPendingStruct *pending_pool;
+  SilcUInt32 pending_pool_count;
+
+  /* Cached channel list for LIST command */
+  SilcServerListCache list_cache;
 
   unsigned int server_type    : 2;   /* Server type (server.h) */
   unsigned int standalone     : 1;   /* Set if server is standalone, and
@@ -166,6 +208,19 @@ typedef struct {
 #define SILC_IS_LOCAL(entry) \
   (((SilcIDListData)entry)->status & SILC_IDLIST_STATUS_LOCAL)
 
+/* Invalidates the precomputed delivery list of the channel.  The list
+   is rebuilt when packet is sent to the channel next time. */
+#define SILC_CHANNEL_DELIVERY_RESET(channel) ((channel)->delivery_gen = 0)
+
+/* Invalidates delivery lists of all channels.  This is called when the
+   routes of many clients change at once, as in netsplit or backup router
+   switch.  Single client uses silc_server_client_delivery_reset. */
+#define SILC_SERVER_DELIVERY_RESET(server)	\
+do {						\
+  if (++(server)->delivery_gen == 0)		\
+    (server)->delivery_gen = 1;			\
+} while(0)
+
 #define SILC_OPER_STATS_UPDATE(c, type, mod)	\
 do {						\
   if ((c)->mode & (mod)) {			\
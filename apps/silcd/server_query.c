@@ -354,7 +354,8 @@ void silc_server_query_send_router(SilcServer server, SilcServerQuery query)
 
   /* Send WHOIS command to our router */
   old_ident = silc_command_get_ident(query->cmd->payload);
-  silc_command_set_ident(query->cmd->payload, ++server->cmd_ident);
+  silc_command_set_ident(query->cmd->payload,
+			 silc_server_command_ident(server));
   tmpbuf = silc_command_payload_encode_payload(query->cmd->payload);
   silc_server_packet_send(server, query->router,
 			  SILC_PACKET_COMMAND, 0,
@@ -1339,7 +1340,7 @@ void silc_server_query_resolve(SilcServer server, SilcServerQuery query,
       query->queries_left++;
   } else {
     /* This entry will be resolved */
-    ident = ++server->cmd_ident;
+    ident = silc_server_command_ident(server);
 
     switch (query->querycmd) {
 
@@ -2181,7 +2182,7 @@ SilcClientEntry silc_server_query_client(SilcServer server,
     if (client) {
       client->data.status |= SILC_IDLIST_STATUS_RESOLVING;
       client->data.status &= ~SILC_IDLIST_STATUS_RESOLVED;
-      client->resolve_cmd_ident = ++server->cmd_ident;
+      client->resolve_cmd_ident = silc_server_command_ident(server);
     }
 
     idp = silc_id_payload_encode(client_id, SILC_ID_CLIENT);
@@ -69,6 +69,7 @@ silc_server_remove_clients_channels(SilcServer server,
     silc_hash_table_del(client->channels, channel);
     silc_hash_table_del(channel->user_list, chl->client);
     channel->user_count--;
+    SILC_CHANNEL_DELIVERY_RESET(channel);
 
     /* If there is no global users on the channel anymore mark the channel
        as local channel. Do not check if the removed client is local client. */
@@ -76,7 +77,7 @@ silc_server_remove_clients_channels(SilcServer server,
 	chl->client->router && !silc_server_channel_has_global(channel))
       channel->global_users = FALSE;
 
-    silc_free(chl);
+    silc_idlist_del_chl(server->local_list, chl);
 
     /* Update statistics */
     if (SILC_IS_LOCAL(client))
@@ -122,35 +123,49 @@ silc_server_remove_clients_channels(SilcServer server,
   SILC_VERIFY(!silc_hash_table_count(client->channels));
 }
 
-/* This function removes all client entries that are originated from
-   `router' and are owned by `entry'.  `router' and `entry' can be same
-   too.  If `server_signoff' is TRUE then SERVER_SIGNOFF notify is
-   distributed to our local clients. */
+/* Maximum length of encoded ID Payload */
+#define SILC_SERVER_ID_PAYLOAD_LEN (4 + SILC_PACKET_MAX_ID_LEN)
 
-SilcBool silc_server_remove_clients_by_server(SilcServer server,
-					      SilcServerEntry router,
-					      SilcServerEntry entry,
-					      SilcBool server_signoff)
+/* Encodes ID Payload of `id' to `data', which must have room for
+   SILC_SERVER_ID_PAYLOAD_LEN bytes.  Returns the length of the payload
+   or 0 on error. */
+
+static SilcUInt32 silc_server_encode_id_payload(unsigned char *data,
+						void *id, SilcIdType type)
 {
-  SilcList list;
-  SilcIDCacheEntry id_cache = NULL;
-  SilcClientEntry client = NULL;
-  SilcBuffer idp;
-  unsigned char **argv = NULL;
-  SilcUInt32 *argv_lens = NULL, *argv_types = NULL, argc = 0;
+  SilcUInt32 id_len;
+
+  if (!silc_id_id2str(id, type, data + 4, SILC_PACKET_MAX_ID_LEN, &id_len))
+    return 0;
+  SILC_PUT16_MSB(type, data);
+  SILC_PUT16_MSB(id_len, data + 2);
+
+  return id_len + 4;
+}
+
+/* Removes the clients owned by `entry' that are originated from `router'.
+   The clients are given in `list', or if it is NULL all clients in the
+   client list of the `router' are removed.  This is called only by the
+   functions silc_server_remove_clients_by_server and
+   silc_server_remove_servers_by_server. */
+
+static SilcBool silc_server_remove_clients(SilcServer server,
+					   SilcServerEntry router,
+					   SilcServerEntry entry,
+					   SilcDList list,
+					   SilcBool server_signoff)
+{
+  SilcClientEntry client, next;
+  unsigned char **argv = NULL, *ids = NULL;
+  SilcUInt32 *argv_lens = NULL, *argv_types = NULL, argc = 0, len, count;
   SilcHashTableList htl;
   SilcChannelEntry channel;
   SilcHashTable channels, clients;
-  int i;
-
-  if (!(entry->data.status & SILC_IDLIST_STATUS_REGISTERED))
-    return FALSE;
 
   SILC_LOG_DEBUG(("Removing clients by %s",
 		  entry->server_name ? entry->server_name : "server"));
 
-  if (!router)
-    router = entry;
+  count = list ? silc_dlist_count(list) : router->num_clients;
 
   /* Allocate the hash table that holds the channels that require
      channel key re-generation after we've removed this server's clients
@@ -161,149 +176,80 @@ SilcBool silc_server_remove_clients_by_server(SilcServer server,
 				  NULL, NULL, TRUE);
 
   if (server_signoff) {
-    idp = silc_id_payload_encode(entry->id, SILC_ID_SERVER);
-    argv = silc_realloc(argv, sizeof(*argv) * (argc + 1));
-    argv_lens = silc_realloc(argv_lens,  sizeof(*argv_lens) * (argc + 1));
-    argv_types = silc_realloc(argv_types, sizeof(*argv_types) * (argc + 1));
-    argv[argc] = silc_calloc(silc_buffer_len(idp), sizeof(*argv[0]));
-    memcpy(argv[argc], idp->data, silc_buffer_len(idp));
-    argv_lens[argc] = silc_buffer_len(idp);
+    /* The notify has the server ID and at most all the client IDs of the
+       removed clients.  The ID payloads are encoded to one buffer. */
+    argv = silc_calloc(count + 1, sizeof(*argv));
+    argv_lens = silc_calloc(count + 1, sizeof(*argv_lens));
+    argv_types = silc_calloc(count + 1, sizeof(*argv_types));
+    ids = silc_malloc((count + 1) * SILC_SERVER_ID_PAYLOAD_LEN);
+
+    len = silc_server_encode_id_payload(ids, entry->id, SILC_ID_SERVER);
+    argv[argc] = ids;
+    argv_lens[argc] = len;
     argv_types[argc] = argc + 1;
     argc++;
-    silc_buffer_free(idp);
   }
 
-  if (silc_idcache_get_all(server->local_list->clients, &list)) {
-    silc_list_start(list);
-    while ((id_cache = silc_list_get(list))) {
-      client = (SilcClientEntry)id_cache->context;
-
-      /* If client is not registered, is not originated from `router'
-	 and is not owned by `entry', skip it. */
-      if (!(client->data.status & SILC_IDLIST_STATUS_REGISTERED) ||
-	  client->router != router ||
-	  (router != entry && !SILC_ID_COMPARE(client->id, entry->id,
-					       client->id->ip.data_len))) {
-	continue;
-      }
-
-      if (server_signoff) {
-	idp = silc_id_payload_encode(client->id, SILC_ID_CLIENT);
-	if (idp) {
-	  argv = silc_realloc(argv, sizeof(*argv) * (argc + 1));
-	  argv_lens = silc_realloc(argv_lens, sizeof(*argv_lens) *
-				   (argc + 1));
-	  argv_types = silc_realloc(argv_types, sizeof(*argv_types) *
-				    (argc + 1));
-	  argv[argc] = silc_calloc(silc_buffer_len(idp), sizeof(*argv[0]));
-	  memcpy(argv[argc], idp->data, silc_buffer_len(idp));
-	  argv_lens[argc] = silc_buffer_len(idp);
-	  argv_types[argc] = argc + 1;
-	  argc++;
-	  silc_buffer_free(idp);
-	}
-      }
-
-      /* Update statistics */
-      SILC_LOG_DEBUG(("stat.clients %d->%d", server->stat.clients,
-		      server->stat.clients - 1));
-      SILC_VERIFY(server->stat.clients > 0);
-      server->stat.clients--;
-      if (server->stat.cell_clients)
-	server->stat.cell_clients--;
-      SILC_OPER_STATS_UPDATE(client, server, SILC_UMODE_SERVER_OPERATOR);
-      SILC_OPER_STATS_UPDATE(client, router, SILC_UMODE_ROUTER_OPERATOR);
-
-      /* Remove client's public key from repository, this will free it too. */
-      if (client->data.public_key) {
-	silc_skr_del_public_key(server->repository, client->data.public_key,
-				client);
-	client->data.public_key = NULL;
-      }
-
-      silc_server_remove_clients_channels(server, entry, clients,
-					  client, channels);
-      silc_server_del_from_watcher_list(server, client);
-
-      /* Remove the client entry */
-      if (!server_signoff) {
-	client->data.status &= ~SILC_IDLIST_STATUS_REGISTERED;
-	client->mode = 0;
-	client->router = NULL;
-	client->connection = NULL;
-	client->data.created = silc_time();
-	silc_dlist_del(server->expired_clients, client);
-	silc_dlist_add(server->expired_clients, client);
-      } else {
-	silc_idlist_del_data(client);
-	silc_idlist_del_client(server->local_list, client);
-      }
-    }
+  if (list) {
+    silc_dlist_start(list);
+    client = silc_dlist_get(list);
+  } else {
+    client = router->clients;
   }
 
-  if (silc_idcache_get_all(server->global_list->clients, &list)) {
-    silc_list_start(list);
-    while ((id_cache = silc_list_get(list))) {
-      client = (SilcClientEntry)id_cache->context;
+  for (; client; client = next) {
+    next = list ? silc_dlist_get(list) : client->router_next;
 
-      /* If client is not registered, is not originated from `router'
-	 and is not owned by `entry', skip it. */
-      if (!(client->data.status & SILC_IDLIST_STATUS_REGISTERED) ||
-	  client->router != router ||
-	  (router != entry && !SILC_ID_COMPARE(client->id, entry->id,
-					       client->id->ip.data_len))) {
-	continue;
-      }
+    /* If client is not registered, skip it. */
+    if (!(client->data.status & SILC_IDLIST_STATUS_REGISTERED))
+      continue;
 
-      if (server_signoff) {
-	idp = silc_id_payload_encode(client->id, SILC_ID_CLIENT);
-	argv = silc_realloc(argv, sizeof(*argv) * (argc + 1));
-	argv_lens = silc_realloc(argv_lens, sizeof(*argv_lens) *
-				 (argc + 1));
-	argv_types = silc_realloc(argv_types, sizeof(*argv_types) *
-				  (argc + 1));
-	argv[argc] = silc_calloc(silc_buffer_len(idp), sizeof(*argv[0]));
-	memcpy(argv[argc], idp->data, silc_buffer_len(idp));
-	argv_lens[argc] = silc_buffer_len(idp);
+    if (server_signoff) {
+      argv[argc] = ids + (argc * SILC_SERVER_ID_PAYLOAD_LEN);
+      len = silc_server_encode_id_payload(argv[argc], client->id,
+					  SILC_ID_CLIENT);
+      if (len) {
+	argv_lens[argc] = len;
 	argv_types[argc] = argc + 1;
 	argc++;
-	silc_buffer_free(idp);
       }
+    }
 
-      /* Update statistics */
-      SILC_LOG_DEBUG(("stat.clients %d->%d", server->stat.clients,
-		      server->stat.clients - 1));
-      SILC_VERIFY(server->stat.clients > 0);
-      server->stat.clients--;
-      if (server->stat.cell_clients)
-	server->stat.cell_clients--;
-      SILC_OPER_STATS_UPDATE(client, server, SILC_UMODE_SERVER_OPERATOR);
-      SILC_OPER_STATS_UPDATE(client, router, SILC_UMODE_ROUTER_OPERATOR);
-
-      /* Remove client's public key from repository, this will free it too. */
-      if (client->data.public_key) {
-	silc_skr_del_public_key(server->repository, client->data.public_key,
-				client);
-	client->data.public_key = NULL;
-      }
+    /* Update statistics */
+    SILC_LOG_DEBUG(("stat.clients %d->%d", server->stat.clients,
+		    server->stat.clients - 1));
+    SILC_VERIFY(server->stat.clients > 0);
+    server->stat.clients--;
+    if (server->stat.cell_clients)
+      server->stat.cell_clients--;
+    SILC_OPER_STATS_UPDATE(client, server, SILC_UMODE_SERVER_OPERATOR);
+    SILC_OPER_STATS_UPDATE(client, router, SILC_UMODE_ROUTER_OPERATOR);
 
-      silc_server_remove_clients_channels(server, entry, clients,
-					  client, channels);
-      silc_server_del_from_watcher_list(server, client);
-
-      /* Remove the client entry */
-      if (!server_signoff) {
-	client->data.status &= ~SILC_IDLIST_STATUS_REGISTERED;
-	client->mode = 0;
-	client->router = NULL;
-	client->connection = NULL;
-	client->data.created = silc_time();
-	silc_dlist_del(server->expired_clients, client);
-	silc_dlist_add(server->expired_clients, client);
-      } else {
-	silc_idlist_del_data(client);
+    /* Remove client's public key from repository, this will free it too. */
+    if (client->data.public_key) {
+      silc_skr_del_public_key(server->repository, client->data.public_key,
+			      client);
+      client->data.public_key = NULL;
+    }
+
+    silc_server_remove_clients_channels(server, entry, clients,
+					client, channels);
+    silc_server_del_from_watcher_list(server, client);
+
+    /* Remove the client entry */
+    if (!server_signoff) {
+      client->data.status &= ~SILC_IDLIST_STATUS_REGISTERED;
+      client->mode = 0;
+      silc_idlist_client_set_router(client, NULL);
+      client->connection = NULL;
+      silc_server_client_delivery_reset(client);
+      client->data.created = silc_time();
+      silc_dlist_del(server->expired_clients, client);
+      silc_dlist_add(server->expired_clients, client);
+    } else {
+      silc_idlist_del_data(client);
+      if (!silc_idlist_del_client(server->local_list, client))
 	silc_idlist_del_client(server->global_list, client);
-      }
     }
   }
 
@@ -312,8 +258,7 @@ SilcBool silc_server_remove_clients_by_server(SilcServer server,
     silc_hash_table_free(channels);
 
     if (server_signoff) {
-      for (i = 0; i < argc; i++)
-	silc_free(argv[i]);
+      silc_free(ids);
       silc_free(argv);
       silc_free(argv_lens);
       silc_free(argv_types);
@@ -356,8 +301,7 @@ SilcBool silc_server_remove_clients_by_server(SilcServer server,
 
     silc_buffer_free(args);
     silc_buffer_free(not);
-    for (i = 0; i < argc; i++)
-      silc_free(argv[i]);
+    silc_free(ids);
     silc_free(argv);
     silc_free(argv_lens);
     silc_free(argv_types);
@@ -389,105 +333,236 @@ SilcBool silc_server_remove_clients_by_server(SilcServer server,
   return TRUE;
 }
 
-static SilcServerEntry
-silc_server_update_clients_by_real_server(SilcServer server,
-					  SilcServerEntry from,
-					  SilcServerEntry to,
-					  SilcClientEntry client,
-					  SilcBool local,
-					  SilcIDCacheEntry client_cache)
+/* This function removes all client entries that are originated from
+   `router' and are owned by `entry'.  `router' and `entry' can be same
+   too.  If `server_signoff' is TRUE then SERVER_SIGNOFF notify is
+   distributed to our local clients.  The clients are found from the
+   client list of the `router'. */
+
+SilcBool silc_server_remove_clients_by_server(SilcServer server,
+					      SilcServerEntry router,
+					      SilcServerEntry entry,
+					      SilcBool server_signoff)
+{
+  SilcClientEntry client;
+  SilcDList list;
+  SilcBool ret;
+
+  if (!(entry->data.status & SILC_IDLIST_STATUS_REGISTERED))
+    return FALSE;
+
+  if (!router || router == entry)
+    return silc_server_remove_clients(server, entry, entry, NULL,
+				      server_signoff);
+
+  /* Find the clients owned by `entry' */
+  list = silc_dlist_init();
+  if (!list)
+    return FALSE;
+  for (client = router->clients; client; client = client->router_next)
+    if (SILC_ID_COMPARE(client->id, entry->id, client->id->ip.data_len))
+      silc_dlist_add(list, client);
+
+  ret = silc_server_remove_clients(server, router, entry, list,
+				   server_signoff);
+  silc_dlist_uninit(list);
+  return ret;
+}
+
+/* Hash and compare functions for the IP address of an ID.  Used to find
+   the server that owns a Client ID. */
+
+static SilcUInt32 silc_server_id_ip_hash(void *key, void *user_context)
+{
+  SilcIDIP *ip = key;
+  return silc_hash_data(ip->data, SILC_32_TO_PTR(ip->data_len));
+}
+
+static SilcBool silc_server_id_ip_compare(void *key1, void *key2,
+					  void *user_context)
 {
+  SilcIDIP *ip1 = key1, *ip2 = key2;
+  return (ip1->data_len == ip2->data_len &&
+	  !memcmp(ip1->data, ip2->data, ip1->data_len));
+}
+
+/* Returns hash table of the servers in `id_list' keyed by the IP address
+   of their Server ID, for silc_server_update_clients_by_real_server.
+   Servers that cannot be the real server of a client are left out. */
+
+static SilcHashTable
+silc_server_servers_by_ip(SilcServer server, SilcIDList id_list,
+			  SilcServerEntry from, SilcServerEntry to)
+{
+  SilcHashTable servers;
   SilcServerEntry server_entry;
   SilcIDCacheEntry id_cache = NULL;
   SilcList list;
   SilcBool tolocal = (to == server->id_entry);
 
-  SILC_LOG_DEBUG(("Start"));
-
-  if (!silc_idcache_get_all(server->local_list->servers, &list))
+  servers = silc_hash_table_alloc(0, silc_server_id_ip_hash, NULL,
+				  silc_server_id_ip_compare, NULL,
+				  NULL, NULL, TRUE);
+  if (!servers)
     return NULL;
 
+  if (!silc_idcache_get_all(id_list->servers, &list))
+    return servers;
+
   silc_list_start(list);
   while ((id_cache = silc_list_get(list))) {
     server_entry = (SilcServerEntry)id_cache->context;
-    if (server_entry != from &&
-	(tolocal || server_entry != server->id_entry) &&
-	SILC_ID_COMPARE(server_entry->id, client->id,
-			client->id->ip.data_len)) {
-      SILC_LOG_DEBUG(("Found (local) %s",
-		      silc_id_render(server_entry->id, SILC_ID_SERVER)));
-
-      if (!SILC_IS_LOCAL(server_entry) && server_entry->router) {
-	SILC_LOG_DEBUG(("Server not locally connected, use its router"));
-	/* If the client is not marked as local then move it to local list
-	   since the server is local. */
-	if (!local) {
-	  SILC_LOG_DEBUG(("Moving client to local list"));
-	  silc_idcache_move(server->global_list->clients,
-			    server->local_list->clients, client_cache);
-	}
-	server_entry = server_entry->router;
-      } else {
-	SILC_LOG_DEBUG(("Server locally connected"));
-	/* If the client is not marked as local then move it to local list
-	   since the server is local. */
-	if (server_entry->server_type != SILC_BACKUP_ROUTER && !local) {
-	  SILC_LOG_DEBUG(("Moving client to local list"));
-	  silc_idcache_move(server->global_list->clients,
-			    server->local_list->clients, client_cache);
-
-	} else if (server->server_type == SILC_BACKUP_ROUTER && local) {
-	  /* If we are backup router and this client is on local list, we
-	     must move it to global list, as it is not currently local to
-	     us (we are not primary). */
-	  SILC_LOG_DEBUG(("Moving client to global list"));
-	  silc_idcache_move(server->local_list->clients,
-			    server->global_list->clients, client_cache);
-	}
+    if (server_entry == from || !server_entry->id ||
+	(server_entry == server->id_entry &&
+	 (!tolocal || id_list == server->global_list)))
+      continue;
+
+    /* First server with the address is used */
+    if (!silc_hash_table_find(servers, &server_entry->id->ip, NULL, NULL))
+      silc_hash_table_add(servers, &server_entry->id->ip, server_entry);
+  }
+
+  return servers;
+}
+
+static SilcServerEntry
+silc_server_update_clients_by_real_server(SilcServer server,
+					  SilcServerEntry from,
+					  SilcServerEntry to,
+					  SilcClientEntry client,
+					  SilcBool local,
+					  SilcIDCacheEntry client_cache,
+					  SilcHashTable local_servers,
+					  SilcHashTable global_servers)
+{
+  SilcServerEntry server_entry;
+
+  SILC_LOG_DEBUG(("Start"));
+
+  if (local_servers &&
+      silc_hash_table_find(local_servers, &client->id->ip, NULL,
+			   (void *)&server_entry)) {
+    SILC_LOG_DEBUG(("Found (local) %s",
+		    silc_id_render(server_entry->id, SILC_ID_SERVER)));
+
+    if (!SILC_IS_LOCAL(server_entry) && server_entry->router) {
+      SILC_LOG_DEBUG(("Server not locally connected, use its router"));
+      /* If the client is not marked as local then move it to local list
+	 since the server is local. */
+      if (!local) {
+	SILC_LOG_DEBUG(("Moving client to local list"));
+	silc_idcache_move(server->global_list->clients,
+			  server->local_list->clients, client_cache);
+      }
+      server_entry = server_entry->router;
+    } else {
+      SILC_LOG_DEBUG(("Server locally connected"));
+      /* If the client is not marked as local then move it to local list
+	 since the server is local. */
+      if (server_entry->server_type != SILC_BACKUP_ROUTER && !local) {
+	SILC_LOG_DEBUG(("Moving client to local list"));
+	silc_idcache_move(server->global_list->clients,
+			  server->local_list->clients, client_cache);
+
+      } else if (server->server_type == SILC_BACKUP_ROUTER && local) {
+	/* If we are backup router and this client is on local list, we
+	   must move it to global list, as it is not currently local to
+	   us (we are not primary). */
+	SILC_LOG_DEBUG(("Moving client to global list"));
+	silc_idcache_move(server->local_list->clients,
+			  server->global_list->clients, client_cache);
       }
+    }
 
-      return server_entry;
+    return server_entry;
+  }
+
+  if (global_servers &&
+      silc_hash_table_find(global_servers, &client->id->ip, NULL,
+			   (void *)&server_entry)) {
+    SILC_LOG_DEBUG(("Found (global) %s",
+		    silc_id_render(server_entry->id, SILC_ID_SERVER)));
+
+    if (!SILC_IS_LOCAL(server_entry) && server_entry->router) {
+      SILC_LOG_DEBUG(("Server not locally connected, use its router"));
+      /* If the client is marked as local then move it to global list
+	 since the server is global. */
+      if (local) {
+	SILC_LOG_DEBUG(("Moving client to global list"));
+	silc_idcache_move(server->local_list->clients,
+			  server->global_list->clients, client_cache);
+      }
+      server_entry = server_entry->router;
+    } else {
+      SILC_LOG_DEBUG(("Server locally connected"));
+      /* If the client is marked as local then move it to global list
+	 since the server is global. */
+      if (server_entry->server_type != SILC_BACKUP_ROUTER && local) {
+	SILC_LOG_DEBUG(("Moving client to global list"));
+	silc_idcache_move(server->local_list->clients,
+			  server->global_list->clients, client_cache);
+      }
     }
+    return server_entry;
   }
 
-  if (!silc_idcache_get_all(server->global_list->servers, &list))
-    return NULL;
+  return NULL;
+}
 
-  silc_list_start(list);
-  while ((id_cache = silc_list_get(list))) {
-    server_entry = (SilcServerEntry)id_cache->context;
-    if (server_entry != from && server_entry != server->id_entry &&
-	(tolocal || server_entry != server->id_entry) &&
-	SILC_ID_COMPARE(server_entry->id, client->id,
-			client->id->ip.data_len)) {
-      SILC_LOG_DEBUG(("Found (global) %s",
-		      silc_id_render(server_entry->id, SILC_ID_SERVER)));
-
-      if (!SILC_IS_LOCAL(server_entry) && server_entry->router) {
-	SILC_LOG_DEBUG(("Server not locally connected, use its router"));
-	/* If the client is marked as local then move it to global list
-	   since the server is global. */
-	if (local) {
-	  SILC_LOG_DEBUG(("Moving client to global list"));
-	  silc_idcache_move(server->local_list->clients,
-			    server->global_list->clients, client_cache);
-	}
-	server_entry = server_entry->router;
-      } else {
-	SILC_LOG_DEBUG(("Server locally connected"));
-	/* If the client is marked as local then move it to global list
-	   since the server is global. */
-	if (server_entry->server_type != SILC_BACKUP_ROUTER && local) {
-	  SILC_LOG_DEBUG(("Moving client to global list"));
-	  silc_idcache_move(server->local_list->clients,
-			    server->global_list->clients, client_cache);
-	}
+/* Updates one client that is originated from the `from' to be originated
+   from the `to', or from its real server if `local_servers' and
+   `global_servers' are given.  See silc_server_update_clients_by_server. */
+
+static void silc_server_update_client_by_server(SilcServer server,
+						SilcServerEntry from,
+						SilcServerEntry to,
+						SilcClientEntry client,
+						SilcBool local,
+						SilcIDCacheEntry id_cache,
+						SilcHashTable local_servers,
+						SilcHashTable global_servers)
+{
+  SilcServerEntry router;
+
+  SILC_LOG_DEBUG(("Client %s", silc_id_render(client->id, SILC_ID_CLIENT)));
+  if (client->router && client->router->id)
+    SILC_LOG_DEBUG(("Client->router %s",
+		    silc_id_render(client->router->id, SILC_ID_SERVER)));
+
+  if (from) {
+    if (local_servers) {
+      router =
+	silc_server_update_clients_by_real_server(server, from, to,
+						  client, local, id_cache,
+						  local_servers,
+						  global_servers);
+      if (!router) {
+	if (local || server->server_type == SILC_ROUTER)
+	  router = from;
+	else
+	  router = to;
       }
-      return server_entry;
+    } else {
+      router = to;
     }
+  } else {
+    /* All are changed */
+    if (local_servers)
+      /* Call this so that the entry is moved to correct list if
+	 needed.  No resolving by real server is actually done. */
+      silc_server_update_clients_by_real_server(server, NULL, to,
+						client, local, id_cache,
+						local_servers,
+						global_servers);
+
+    router = to;
   }
 
-  return NULL;
+  silc_idlist_client_set_router(client, router);
+
+  if (client->router && client->router->id)
+    SILC_LOG_DEBUG(("Client changed to %s",
+		    silc_id_render(client->router->id, SILC_ID_SERVER)));
 }
 
 /* Updates the clients that are originated from the `from' to be originated
@@ -495,7 +570,8 @@ silc_server_update_clients_by_real_server(SilcServer server,
    attempt to figure out which clients really are originated from the
    `from' and which are originated from a server that we have connection
    to, when we've acting as backup router. If it is FALSE the `to' will
-   be the new source. */
+   be the new source.  The clients are found from the client list of the
+   `from', and all clients are gone through only if `from' is NULL. */
 
 void silc_server_update_clients_by_server(SilcServer server,
 					  SilcServerEntry from,
@@ -504,7 +580,8 @@ void silc_server_update_clients_by_server(SilcServer server,
 {
   SilcList list;
   SilcIDCacheEntry id_cache = NULL;
-  SilcClientEntry client = NULL;
+  SilcClientEntry client = NULL, next;
+  SilcHashTable local_servers = NULL, global_servers = NULL;
   SilcBool local;
 
   if (from && from->id) {
@@ -516,6 +593,43 @@ void silc_server_update_clients_by_server(SilcServer server,
 		    silc_id_render(to->id, SILC_ID_SERVER)));
   }
 
+  /* Routes of the clients change */
+  SILC_SERVER_DELIVERY_RESET(server);
+
+  /* Index the servers by address for finding the real servers */
+  if (resolve_real_server) {
+    local_servers = silc_server_servers_by_ip(server, server->local_list,
+					      from, to);
+    global_servers = silc_server_servers_by_ip(server, server->global_list,
+					       from, to);
+  }
+
+  if (from) {
+    for (client = from->clients; client; client = next) {
+      next = client->router_next;
+
+      /* If entry is disabled skip it.  If entry is local to us, do not
+	 switch it to anyone else, it is ours so skip it. */
+      if (!(client->data.status & SILC_IDLIST_STATUS_REGISTERED) ||
+	  SILC_IS_LOCAL(client))
+	continue;
+
+      local = TRUE;
+      if (!silc_idcache_find_by_context(server->local_list->clients,
+					client, &id_cache)) {
+	local = FALSE;
+	if (!silc_idcache_find_by_context(server->global_list->clients,
+					  client, &id_cache))
+	  continue;
+      }
+
+      silc_server_update_client_by_server(server, from, to, client, local,
+					  id_cache, local_servers,
+					  global_servers);
+    }
+    goto out;
+  }
+
   SILC_LOG_DEBUG(("global list"));
   local = FALSE;
   if (silc_idcache_get_all(server->global_list->clients, &list)) {
@@ -529,44 +643,9 @@ void silc_server_update_clients_by_server(SilcServer server,
 	  SILC_IS_LOCAL(client))
 	continue;
 
-      SILC_LOG_DEBUG(("Client %s",
-		      silc_id_render(client->id, SILC_ID_CLIENT)));
-      if (client->router && client->router->id)
-	SILC_LOG_DEBUG(("Client->router %s",
-			silc_id_render(client->router->id, SILC_ID_SERVER)));
-
-      if (from) {
-	if (client->router == from) {
-	  if (resolve_real_server) {
-	    client->router =
-	      silc_server_update_clients_by_real_server(server, from, to,
-							client, local,
-							id_cache);
-	    if (!client->router) {
-	      if (server->server_type == SILC_ROUTER)
-		client->router = from;
-	      else
-		client->router = to;
-	    }
-	  } else {
-	    client->router = to;
-	  }
-	}
-      } else {
-	/* All are changed */
-	if (resolve_real_server)
-	  /* Call this so that the entry is moved to correct list if
-	     needed.  No resolving by real server is actually done. */
-	  silc_server_update_clients_by_real_server(server, NULL, to,
-						    client, local,
-						    id_cache);
-
-	client->router = to;
-      }
-
-      if (client->router && client->router->id)
-	SILC_LOG_DEBUG(("Client changed to %s",
-			silc_id_render(client->router->id, SILC_ID_SERVER)));
+      silc_server_update_client_by_server(server, NULL, to, client, local,
+					  id_cache, local_servers,
+					  global_servers);
     }
   }
 
@@ -583,42 +662,17 @@ void silc_server_update_clients_by_server(SilcServer server,
 	  SILC_IS_LOCAL(client))
 	continue;
 
-      SILC_LOG_DEBUG(("Client %s",
-		      silc_id_render(client->id, SILC_ID_CLIENT)));
-      if (client->router && client->router->id)
-	SILC_LOG_DEBUG(("Client->router %s",
-			silc_id_render(client->router->id, SILC_ID_SERVER)));
-
-      if (from) {
-	if (client->router == from) {
-	  if (resolve_real_server) {
-	    client->router =
-	      silc_server_update_clients_by_real_server(server, from, to,
-							client, local,
-							id_cache);
-	    if (!client->router)
-	      client->router = from;
-	  } else {
-	    client->router = to;
-	  }
-	}
-      } else {
-	/* All are changed */
-	if (resolve_real_server)
-	  /* Call this so that the entry is moved to correct list if
-	     needed.  No resolving by real server is actually done. */
-	  silc_server_update_clients_by_real_server(server, NULL, to,
-						    client, local,
-						    id_cache);
-
-	client->router = to;
-      }
-
-      if (client->router && client->router->id)
-	SILC_LOG_DEBUG(("Client changed to %s",
-			silc_id_render(client->router->id, SILC_ID_SERVER)));
+      silc_server_update_client_by_server(server, NULL, to, client, local,
+					  id_cache, local_servers,
+					  global_servers);
     }
   }
+
+ out:
+  if (local_servers)
+    silc_hash_table_free(local_servers);
+  if (global_servers)
+    silc_hash_table_free(global_servers);
 }
 
 /* Updates servers that are from `from' to be originated from `to'.  This
@@ -770,6 +824,92 @@ void silc_server_local_servers_toggle_enabled(SilcServer server,
   }
 }
 
+/* Destructor for the client lists of silc_server_clients_by_owner. */
+
+static void silc_server_owner_destructor(void *key, void *context,
+					 void *user_context)
+{
+  silc_free(key);
+  silc_dlist_uninit(context);
+}
+
+/* Returns the client list of the server whose Server ID has the IP
+   address `ip' from the `owners' table, adding empty list if the server
+   has no clients yet.  Returns NULL on error. */
+
+static SilcDList silc_server_owner_clients(SilcHashTable owners,
+					   SilcIDIP *ip)
+{
+  SilcDList list;
+  SilcIDIP *key;
+
+  if (silc_hash_table_find(owners, ip, NULL, (void *)&list))
+    return list;
+
+  list = silc_dlist_init();
+  key = silc_memdup(ip, sizeof(*ip));
+  if (!list || !key) {
+    silc_dlist_uninit(list);
+    silc_free(key);
+    return NULL;
+  }
+  silc_hash_table_add(owners, key, list);
+
+  return list;
+}
+
+/* Returns hash table of the clients in the client list of `from' grouped
+   by the IP address of their Client ID, that is, by the server that owns
+   them.  This way the clients of all servers behind `from' are found with
+   one walk of the list. */
+
+static SilcHashTable silc_server_clients_by_owner(SilcServerEntry from)
+{
+  SilcHashTable owners;
+  SilcClientEntry client;
+  SilcDList list;
+
+  owners = silc_hash_table_alloc(0, silc_server_id_ip_hash, NULL,
+				 silc_server_id_ip_compare, NULL,
+				 silc_server_owner_destructor, NULL, TRUE);
+  if (!owners)
+    return NULL;
+
+  for (client = from->clients; client; client = client->router_next) {
+    list = silc_server_owner_clients(owners, &client->id->ip);
+    if (!list) {
+      silc_hash_table_free(owners);
+      return NULL;
+    }
+    silc_dlist_add(list, client);
+  }
+
+  return owners;
+}
+
+/* Removes clients owned by `server_entry' found from the `owners', or
+   from the client list of `from' if `owners' is NULL. */
+
+static void silc_server_remove_owned_clients(SilcServer server,
+					     SilcServerEntry from,
+					     SilcServerEntry server_entry,
+					     SilcHashTable owners)
+{
+  SilcDList list = NULL;
+
+  if (!(server_entry->data.status & SILC_IDLIST_STATUS_REGISTERED))
+    return;
+
+  if (owners && server_entry->id)
+    list = silc_server_owner_clients(owners, &server_entry->id->ip);
+  if (!list) {
+    silc_server_remove_clients_by_server(server, from, server_entry, TRUE);
+    return;
+  }
+
+  silc_server_remove_clients(server, from, server_entry, list, TRUE);
+}
+
 /* Removes servers that are originated from the `from'.  The server
    entry is deleted in this function.  If `remove_clients' is TRUE then
    all clients originated from the server are removed too, and server
@@ -783,10 +923,15 @@ void silc_server_remove_servers_by_server(SilcServer server,
   SilcList list;
   SilcIDCacheEntry id_cache = NULL;
   SilcServerEntry server_entry = NULL;
+  SilcHashTable owners = NULL;
 
   SILC_LOG_DEBUG(("Removing servers by %s",
 		  from->server_name ? from->server_name : "server"));
 
+  /* Group the clients of `from' by their server */
+  if (remove_clients)
+    owners = silc_server_clients_by_owner(from);
+
   if (silc_idcache_get_all(server->local_list->servers, &list)) {
     silc_list_start(list);
     while ((id_cache = silc_list_get(list))) {
@@ -797,8 +942,7 @@ void silc_server_remove_servers_by_server(SilcServer server,
 
       /* Remove clients owned by this server */
       if (remove_clients)
-	silc_server_remove_clients_by_server(server, from, server_entry,
-					     TRUE);
+	silc_server_remove_owned_clients(server, from, server_entry, owners);
 
       /* Remove the server */
       silc_server_backup_del(server, server_entry);
@@ -816,14 +960,16 @@ void silc_server_remove_servers_by_server(SilcServer server,
 
       /* Remove clients owned by this server */
       if (remove_clients)
-	silc_server_remove_clients_by_server(server, from, server_entry,
-					     TRUE);
+	silc_server_remove_owned_clients(server, from, server_entry, owners);
 
       /* Remove the server */
       silc_server_backup_del(server, server_entry);
       silc_idlist_del_server(server->global_list, server_entry);
     }
   }
+
+  if (owners)
+    silc_hash_table_free(owners);
 }
 
 /* Removes channels that are from `from. */
@@ -831,19 +977,17 @@ void silc_server_remove_servers_by_server(SilcServer server,
 void silc_server_remove_channels_by_server(SilcServer server,
 					   SilcServerEntry from)
 {
-  SilcList list;
-  SilcIDCacheEntry id_cache = NULL;
-  SilcChannelEntry channel = NULL;
+  SilcChannelEntry channel = NULL, next;
 
   SILC_LOG_DEBUG(("Removing channels by server"));
 
-  if (silc_idcache_get_all(server->global_list->channels, &list)) {
-    silc_list_start(list);
-    while ((id_cache = silc_list_get(list))) {
-      channel = (SilcChannelEntry)id_cache->context;
-      if (channel->router == from)
-	silc_idlist_del_channel(server->global_list, channel);
-    }
+  /* Only the channels in global list are removed */
+  for (channel = from->channels; channel; channel = next) {
+    next = channel->router_next;
+    if (!silc_idcache_find_by_context(server->global_list->channels,
+				      channel, NULL))
+      continue;
+    silc_idlist_del_channel(server->global_list, channel);
   }
 }
 
@@ -855,21 +999,28 @@ void silc_server_update_channels_by_server(SilcServer server,
 {
   SilcList list;
   SilcIDCacheEntry id_cache = NULL;
-  SilcChannelEntry channel = NULL;
+  SilcChannelEntry channel = NULL, next;
 
   SILC_LOG_DEBUG(("Updating channels by server"));
 
+  if (from) {
+    /* Only the channels in global list are updated */
+    for (channel = from->channels; channel; channel = next) {
+      next = channel->router_next;
+      if (silc_idcache_find_by_context(server->global_list->channels,
+				       channel, NULL))
+	silc_idlist_channel_set_router(channel, to);
+    }
+    return;
+  }
+
   if (silc_idcache_get_all(server->global_list->channels, &list)) {
     silc_list_start(list);
     while ((id_cache = silc_list_get(list))) {
       channel = (SilcChannelEntry)id_cache->context;
-      if (from) {
-	if (channel->router == from)
-	  channel->router = to;
-      } else {
-	/* Update all */
-	channel->router = to;
-      }
+
+      /* Update all */
+      silc_idlist_channel_set_router(channel, to);
     }
   }
 }
@@ -959,6 +1110,7 @@ SilcBool silc_server_channel_delete(SilcServer server,
     silc_hash_table_del(chl->client->channels, channel);
     silc_hash_table_del(channel->user_list, chl->client);
     channel->user_count--;
+    SILC_CHANNEL_DELIVERY_RESET(channel);
 
     /* Update statistics */
     if (SILC_IS_LOCAL(chl->client))
@@ -968,7 +1120,7 @@ SilcBool silc_server_channel_delete(SilcServer server,
       server->stat.chanclients--;
     }
 
-    silc_free(chl);
+    silc_idlist_del_chl(server->local_list, chl);
   }
   silc_hash_table_list_reset(&htl);
 
@@ -993,6 +1145,96 @@ SilcBool silc_server_client_on_channel(SilcClientEntry client,
 			      (void *)chl);
 }
 
+/* Invalidates the delivery lists of the channels the `client' is on.
+   This is called when the route (router or connection) of the client
+   changes, so that other channels keep their delivery lists. */
+
+void silc_server_client_delivery_reset(SilcClientEntry client)
+{
+  SilcChannelClientEntry chl;
+  SilcHashTableList htl;
+
+  if (!client->channels)
+    return;
+
+  silc_hash_table_list(client->channels, &htl);
+  while (silc_hash_table_get(&htl, NULL, (void *)&chl))
+    SILC_CHANNEL_DELIVERY_RESET(chl->channel);
+  silc_hash_table_list_reset(&htl);
+}
+
+/* Indexes the connection `sconn' by the IP address of its socket, or
+   removes it from the IP index if it doesn't have socket. */
+
+void silc_server_conns_set_ip(SilcServer server, SilcServerConnection sconn)
+{
+  const char *ip = NULL;
+
+  if (sconn->remote_ip) {
+    silc_hash_table_del_by_context(server->conns_ip, sconn->remote_ip, sconn);
+    silc_free(sconn->remote_ip);
+    sconn->remote_ip = NULL;
+  }
+
+  if (!sconn->sock || !silc_packet_stream_is_valid(sconn->sock))
+    return;
+  silc_socket_stream_get_info(silc_packet_stream_get_stream(sconn->sock),
+			      NULL, NULL, &ip, NULL);
+  if (!ip)
+    return;
+
+  sconn->remote_ip = strdup(ip);
+  if (sconn->remote_ip)
+    silc_hash_table_add(server->conns_ip, sconn->remote_ip, sconn);
+}
+
+/* Adds the connection `sconn' to the server's connections.  It is
+   indexed by IP address with silc_server_conns_set_ip after it has
+   socket. */
+
+void silc_server_conns_add(SilcServer server, SilcServerConnection sconn)
+{
+  if (sconn->remote_host)
+    silc_hash_table_add(server->conns, sconn->remote_host, sconn);
+}
+
+/* Removes the connection `sconn' from the server's connections.  Nothing
+   happens if it is not there. */
+
+void silc_server_conns_del(SilcServer server, SilcServerConnection sconn)
+{
+  if (sconn->remote_host)
+    silc_hash_table_del_by_context(server->conns, sconn->remote_host, sconn);
+  if (sconn->remote_ip) {
+    silc_hash_table_del_by_context(server->conns_ip, sconn->remote_ip, sconn);
+    silc_free(sconn->remote_ip);
+    sconn->remote_ip = NULL;
+  }
+}
+
+typedef struct {
+  SilcConnectionType type;
+  SilcUInt16 port;
+  SilcUInt32 count;
+  SilcPacketStream sock;
+} SilcServerConnsFind;
+
+/* Counts the valid connections of given type */
+
+static void silc_server_conns_count_ip(void *key, void *context,
+				       void *user_context)
+{
+  SilcServerConnection conn = context;
+  SilcServerConnsFind *f = user_context;
+  SilcIDListData idata;
+
+  if (!conn || !conn->sock || !silc_packet_stream_is_valid(conn->sock))
+    return;
+  idata = silc_packet_get_context(conn->sock);
+  if (idata && idata->conn_type == f->type)
+    f->count++;
+}
+
 /* Find number of sockets by IP address indicated by `ip'. Returns 0 if
    socket connections with the IP address does not exist.  Counts only
    fully established connections. */
@@ -1000,23 +1242,32 @@ SilcBool silc_server_client_on_channel(SilcClientEntry client,
 SilcUInt32 silc_server_num_sockets_by_ip(SilcServer server, const char *ip,
 					 SilcConnectionType type)
 {
-  SilcServerConnection conn;
-  SilcIDListData idata;
-  const char *ipaddr;
-  int count = 0;
+  SilcServerConnsFind f;
 
-  silc_dlist_start(server->conns);
-  while ((conn = silc_dlist_get(server->conns))) {
-    if (!conn->sock || !silc_packet_stream_is_valid(conn->sock))
-      continue;
-    silc_socket_stream_get_info(silc_packet_stream_get_stream(conn->sock),
-				NULL, NULL, &ipaddr, NULL);
-    idata = silc_packet_get_context(conn->sock);
-    if (!strcmp(ipaddr, ip) && idata && idata->conn_type == type)
-      count++;
-  }
+  memset(&f, 0, sizeof(f));
+  f.type = type;
+  silc_hash_table_find_foreach(server->conns_ip, (void *)ip,
+			       silc_server_conns_count_ip, &f);
+
+  return f.count;
+}
+
+/* Finds the valid connection of given type and port */
+
+static void silc_server_conns_find_ip(void *key, void *context,
+				      void *user_context)
+{
+  SilcServerConnection conn = context;
+  SilcServerConnsFind *f = user_context;
+  SilcIDListData idata;
 
-  return count;
+  if (!conn || f->sock || !conn->sock ||
+      !silc_packet_stream_is_valid(conn->sock))
+    return;
+  idata = silc_packet_get_context(conn->sock);
+  if (idata && idata->conn_type == f->type &&
+      (!f->port || conn->remote_port == f->port))
+    f->sock = conn->sock;
 }
 
 /* Find active socket connection by the IP address and port indicated by
@@ -1027,24 +1278,36 @@ silc_server_find_socket_by_host(SilcServer server,
 				SilcConnectionType type,
 				const char *ip, SilcUInt16 port)
 {
-  SilcServerConnection conn;
+  SilcServerConnsFind f;
+
+  memset(&f, 0, sizeof(f));
+  f.type = type;
+  f.port = port;
+  silc_hash_table_find_foreach(server->conns_ip, (void *)ip,
+			       silc_server_conns_find_ip, &f);
+
+  return f.sock;
+}
+
+/* Counts the connections of given type and port */
+
+static void silc_server_conns_count_remote(void *key, void *context,
+					   void *user_context)
+{
+  SilcServerConnection conn = context;
+  SilcServerConnsFind *f = user_context;
   SilcIDListData idata;
-  const char *ipaddr;
+  SilcConnectionType t = SILC_CONN_UNKNOWN;
 
-  silc_dlist_start(server->conns);
-  while ((conn = silc_dlist_get(server->conns))) {
-    if (!conn->sock || !silc_packet_stream_is_valid(conn->sock))
-      continue;
+  if (!conn)
+    return;
+  if (conn->sock) {
     idata = silc_packet_get_context(conn->sock);
-    silc_socket_stream_get_info(silc_packet_stream_get_stream(conn->sock),
-				NULL, NULL, &ipaddr, NULL);
-    if (!strcmp(ipaddr, ip) &&
-	(!port || conn->remote_port == port) &&
-	idata->conn_type == type)
-      return conn->sock;
+    if (idata)
+      t = idata->conn_type;
   }
-
-  return NULL;
+  if (conn->remote_port == f->port && t == f->type)
+    f->count++;
 }
 
 /* Find number of sockets by IP address indicated by remote host, indicatd
@@ -1057,30 +1320,25 @@ SilcUInt32 silc_server_num_sockets_by_remote(SilcServer server,
 					     SilcUInt16 port,
 					     SilcConnectionType type)
 {
-  SilcServerConnection conn;
-  SilcIDListData idata;
-  SilcConnectionType t = SILC_CONN_UNKNOWN;
-  int count = 0;
+  SilcServerConnsFind f;
 
   if (!ip && !hostname)
     return 0;
 
-  SILC_LOG_DEBUG(("Num connections %d", silc_dlist_count(server->conns)));
+  SILC_LOG_DEBUG(("Num connections %d",
+		  silc_hash_table_count(server->conns)));
 
-  silc_dlist_start(server->conns);
-  while ((conn = silc_dlist_get(server->conns))) {
-    if (conn->sock) {
-      idata = silc_packet_get_context(conn->sock);
-      if (idata)
-	t = idata->conn_type;
-    }
-    if (((ip && !strcmp(conn->remote_host, ip)) ||
-	 (hostname && !strcmp(conn->remote_host, hostname))) &&
-	conn->remote_port == port && t == type)
-      count++;
-  }
+  memset(&f, 0, sizeof(f));
+  f.type = type;
+  f.port = port;
+  if (ip)
+    silc_hash_table_find_foreach(server->conns, (void *)ip,
+				 silc_server_conns_count_remote, &f);
+  if (hostname && (!ip || strcasecmp(ip, hostname)))
+    silc_hash_table_find_foreach(server->conns, (void *)hostname,
+				 silc_server_conns_count_remote, &f);
 
-  return count;
+  return f.count;
 }
 
 /* SKR find callbcak */
@@ -2168,7 +2426,7 @@ SilcStatus silc_server_set_channel_pk_list(SilcServer server,
 
   /* Get the argument from the Argument List Payload */
   SILC_GET16_MSB(argc, pklist);
-  args = silc_argument_payload_parse(pklist + 2, pklist_len - 2, argc);
+  args = silc_argument_payload_parse(pklist + 2, pklist_len - 2, argc, NULL);
   if (!args)
     return SILC_STATUS_ERR_NOT_ENOUGH_PARAMS;
 
@@ -94,6 +94,23 @@ SilcBool silc_server_client_on_channel(SilcClientEntry client,
 				       SilcChannelEntry channel,
 				       SilcChannelClientEntry *chl);
 
+/* Invalidates the delivery lists of the channels the `client' is on.
+   Must be called when the router or connection of the client changes. */
+void silc_server_client_delivery_reset(SilcClientEntry client);
+
+/* Adds the connection `sconn' to the server's connections.  It is
+   indexed by IP address with silc_server_conns_set_ip after it has
+   socket. */
+void silc_server_conns_add(SilcServer server, SilcServerConnection sconn);
+
+/* Removes the connection `sconn' from the server's connections.  Nothing
+   happens if it is not there. */
+void silc_server_conns_del(SilcServer server, SilcServerConnection sconn);
+
+/* Indexes the connection `sconn' by the IP address of its socket, or
+   removes it from the IP index if it doesn't have socket. */
+void silc_server_conns_set_ip(SilcServer server, SilcServerConnection sconn);
+
 /* Find number of sockets by IP address indicated by `ip'. Returns 0 if
    socket connections with the IP address does not exist. */
 SilcUInt32 silc_server_num_sockets_by_ip(SilcServer server, const char *ip,
@@ -46,9 +46,13 @@
   if (!__list__) {							\
     __list__ = tmp;							\
   } else {								\
-    for (findtmp = __list__; findtmp->next; findtmp = findtmp->next);	\
+    findtmp = (config->tmp_list == (void *)&__list__ &&		\
+	       config->tmp_last ? config->tmp_last : __list__);		\
+    for (; findtmp->next; findtmp = findtmp->next);			\
     findtmp->next = tmp;						\
-  }
+  }									\
+  config->tmp_list = (void *)&__list__;					\
+  config->tmp_last = tmp;
 
 /* loops all elements in a list and provides a di struct pointer of the
  * specified type containing the current element */
@@ -64,6 +68,16 @@
     goto got_err;							\
   }
 
+/* Compile the wildcard pattern, bail out if necessary */
+#define CONFIG_MATCH_COMPILE(__x__, __match__)				\
+  if ((__x__)) {							\
+    __match__ = silc_string_match_compile((__x__));			\
+    if (!(__match__)) {							\
+      got_errno = SILC_CONFIG_EINTERNAL;				\
+      goto got_err;							\
+    }									\
+  }
+
 /* Free the authentication fields in the specified struct
  * Expands to two instructions */
 #define CONFIG_FREE_AUTH(__section__)			\
@@ -275,6 +289,15 @@ SILC_CONFIG_CALLBACK(fetch_generic)
   else if (!strcmp(name, "conn_auth_timeout")) {
     config->conn_auth_timeout = (SilcUInt32) *(int *)val;
   }
+  else if (!strcmp(name, "list_cache_ttl")) {
+    config->list_cache_ttl = (SilcUInt32) *(int *)val;
+  }
+  else if (!strcmp(name, "crypto_workers")) {
+    config->crypto_workers = (SilcUInt32) *(int *)val;
+  }
+  else if (!strcmp(name, "crypto_queue")) {
+    config->crypto_queue = (SilcUInt32) *(int *)val;
+  }
   else if (!strcmp(name, "version_protocol")) {
     CONFIG_IS_DOUBLE(config->param.version_protocol);
     config->param.version_protocol =
@@ -855,6 +878,7 @@ SILC_CONFIG_CALLBACK(fetch_client)
   if (!strcmp(name, "host")) {
     CONFIG_IS_DOUBLE(tmp->host);
     tmp->host = (*(char *)val ? strdup((char *) val) : NULL);
+    CONFIG_MATCH_COMPILE(tmp->host, tmp->host_match);
   }
   else if (!strcmp(name, "passphrase")) {
     CONFIG_IS_DOUBLE(tmp->passphrase);
@@ -899,6 +923,7 @@ SILC_CONFIG_CALLBACK(fetch_client)
 
  got_err:
   silc_free(tmp->host);
+  silc_string_match_free(tmp->host_match);
   CONFIG_FREE_AUTH(tmp);
   silc_free(tmp);
   config->tmp = NULL;
@@ -926,14 +951,17 @@ SILC_CONFIG_CALLBACK(fetch_admin)
   if (!strcmp(name, "host")) {
     CONFIG_IS_DOUBLE(tmp->host);
     tmp->host = (*(char *)val ? strdup((char *) val) : NULL);
+    CONFIG_MATCH_COMPILE(tmp->host, tmp->host_match);
   }
   else if (!strcmp(name, "user")) {
     CONFIG_IS_DOUBLE(tmp->user);
     tmp->user = (*(char *)val ? strdup((char *) val) : NULL);
+    CONFIG_MATCH_COMPILE(tmp->user, tmp->user_match);
   }
   else if (!strcmp(name, "nick")) {
     CONFIG_IS_DOUBLE(tmp->nick);
     tmp->nick = (*(char *)val ? strdup((char *) val) : NULL);
+    CONFIG_MATCH_COMPILE(tmp->nick, tmp->nick_match);
   }
   else if (!strcmp(name, "passphrase")) {
     CONFIG_IS_DOUBLE(tmp->passphrase);
@@ -959,8 +987,11 @@ SILC_CONFIG_CALLBACK(fetch_admin)
 
  got_err:
   silc_free(tmp->host);
+  silc_string_match_free(tmp->host_match);
   silc_free(tmp->user);
   silc_free(tmp->nick);
+  silc_string_match_free(tmp->user_match);
+  silc_string_match_free(tmp->nick_match);
   CONFIG_FREE_AUTH(tmp);
   silc_free(tmp);
   config->tmp = NULL;
@@ -992,6 +1023,7 @@ SILC_CONFIG_CALLBACK(fetch_deny)
   if (!strcmp(name, "host")) {
     CONFIG_IS_DOUBLE(tmp->host);
     tmp->host = (*(char *)val ? strdup((char *) val) : strdup("*"));
+    CONFIG_MATCH_COMPILE(tmp->host, tmp->host_match);
   }
   else if (!strcmp(name, "reason")) {
     CONFIG_IS_DOUBLE(tmp->reason);
@@ -1003,6 +1035,7 @@ SILC_CONFIG_CALLBACK(fetch_deny)
 
  got_err:
   silc_free(tmp->host);
+  silc_string_match_free(tmp->host_match);
   silc_free(tmp->reason);
   silc_free(tmp);
   config->tmp = NULL;
@@ -1035,6 +1068,7 @@ SILC_CONFIG_CALLBACK(fetch_server)
   if (!strcmp(name, "host")) {
     CONFIG_IS_DOUBLE(tmp->host);
     tmp->host = (*(char *)val ? strdup((char *) val) : strdup("*"));
+    CONFIG_MATCH_COMPILE(tmp->host, tmp->host_match);
   }
   else if (!strcmp(name, "passphrase")) {
     CONFIG_IS_DOUBLE(tmp->passphrase);
@@ -1074,6 +1108,7 @@ SILC_CONFIG_CALLBACK(fetch_server)
 
  got_err:
   silc_free(tmp->host);
+  silc_string_match_free(tmp->host_match);
   CONFIG_FREE_AUTH(tmp);
   silc_free(tmp);
   config->tmp = NULL;
@@ -1104,6 +1139,7 @@ SILC_CONFIG_CALLBACK(fetch_router)
   if (!strcmp(name, "host")) {
     CONFIG_IS_DOUBLE(tmp->host);
     tmp->host = strdup((char *) val);
+    CONFIG_MATCH_COMPILE(tmp->host, tmp->host_match);
   }
   else if (!strcmp(name, "port")) {
     int port = *(int *)val;
@@ -1175,6 +1211,7 @@ SILC_CONFIG_CALLBACK(fetch_router)
 
  got_err:
   silc_free(tmp->host);
+  silc_string_match_free(tmp->host_match);
   silc_free(tmp->backup_replace_ip);
   CONFIG_FREE_AUTH(tmp);
   silc_free(tmp);
@@ -1198,6 +1235,9 @@ static const SilcConfigTable table_general[] = {
   { "channel_rekey_secs",	SILC_CONFIG_ARG_INT,	fetch_generic,	NULL },
   { "key_exchange_timeout",   	SILC_CONFIG_ARG_INT,	fetch_generic,	NULL },
   { "conn_auth_timeout",   	SILC_CONFIG_ARG_INT,	fetch_generic,	NULL },
+  { "list_cache_ttl",   	SILC_CONFIG_ARG_INT,	fetch_generic,	NULL },
+  { "crypto_workers",   	SILC_CONFIG_ARG_INT,	fetch_generic,	NULL },
+  { "crypto_queue",   		SILC_CONFIG_ARG_INT,	fetch_generic,	NULL },
   { "version_protocol",	        SILC_CONFIG_ARG_STR,	fetch_generic,	NULL },
   { "version_software",		SILC_CONFIG_ARG_STR,	fetch_generic,	NULL },
   { "version_software_vendor",	SILC_CONFIG_ARG_STR,	fetch_generic,	NULL },
@@ -1391,6 +1431,341 @@ static void silc_server_config_set_defaults(SilcServerConfig config)
   config->conn_auth_timeout = (config->conn_auth_timeout ?
 			       config->conn_auth_timeout :
 			       SILC_SERVER_CONNAUTH_TIMEOUT);
+  config->list_cache_ttl = (config->list_cache_ttl ?
+			    config->list_cache_ttl :
+			    SILC_SERVER_LIST_CACHE_TTL);
+  config->crypto_workers = (config->crypto_workers ?
+			    config->crypto_workers :
+			    SILC_SERVER_CRYPTO_WORKERS);
+  config->crypto_queue = (config->crypto_queue ?
+			  config->crypto_queue :
+			  SILC_SERVER_CRYPTO_QUEUE);
+}
+
+/* Host pattern index.  The rules of a list are numbered in configuration
+   order and their host patterns are put to hash tables by the pattern's
+   literal part: patterns without wildcards, patterns with only trailing
+   '*' (IP address ranges, like 10.2.*) and patterns with only leading '*'
+   (domains, like *.example.com).  Other patterns are in the fallback list.
+   A lookup tries every prefix and suffix length that exists in the
+   tables, and returns the first rule in configuration order, so that
+   the result is same as with the linear walk of the list. */
+
+/* Longest literal part of indexed pattern */
+#define SILC_SERVER_CONFIG_INDEX_LEN 256
+
+/* Rules having the same literal part, in configuration order */
+typedef struct {
+  SilcUInt32 *rules;
+  SilcUInt32 count;
+} SilcServerConfigIndexKey;
+
+/* Rule in the fallback list */
+typedef struct {
+  SilcUInt32 rule;
+  SilcStringMatch match;
+} SilcServerConfigIndexFallback;
+
+struct SilcServerConfigIndexStruct {
+  void **rules;				/* Rules in configuration order */
+  SilcUInt32 rules_count;
+  SilcHashTable exact;			/* Patterns without wildcards */
+  SilcHashTable prefix;			/* Patterns with trailing '*' */
+  SilcHashTable suffix;			/* Patterns with leading '*' */
+  SilcServerConfigIndexFallback *fallback;
+  SilcUInt32 fallback_count;
+  unsigned char prefix_lens[SILC_SERVER_CONFIG_INDEX_LEN / 8 + 1];
+  unsigned char suffix_lens[SILC_SERVER_CONFIG_INDEX_LEN / 8 + 1];
+};
+
+#define SILC_INDEX_LEN_SET(lens, len) (lens)[(len) / 8] |= 1 << ((len) % 8)
+#define SILC_INDEX_LEN_IS(lens, len) ((lens)[(len) / 8] & (1 << ((len) % 8)))
+
+static SilcBool silc_server_config_index_compare(void *key1, void *key2,
+						 void *user_context)
+{
+  return !strcmp((char *)key1, (char *)key2);
+}
+
+static void silc_server_config_index_destructor(void *key, void *context,
+						void *user_context)
+{
+  SilcServerConfigIndexKey *k = context;
+  silc_free(key);
+  silc_free(k->rules);
+  silc_free(k);
+}
+
+/* Adds `rule' to the `table' with the key `literal' of `len' bytes */
+
+static SilcBool silc_server_config_index_key(SilcHashTable table,
+					     const char *literal,
+					     SilcUInt32 len, SilcUInt32 rule)
+{
+  SilcServerConfigIndexKey *k;
+  SilcUInt32 *rules;
+  char *key;
+
+  key = silc_memdup(literal, len);
+  if (!key)
+    return FALSE;
+
+  if (silc_hash_table_find(table, key, NULL, (void *)&k)) {
+    silc_free(key);
+    if (k->rules[k->count - 1] == rule)
+      return TRUE;
+  } else {
+    k = silc_calloc(1, sizeof(*k));
+    if (!k) {
+      silc_free(key);
+      return FALSE;
+    }
+    silc_hash_table_add(table, key, k);
+  }
+
+  /* Grow the array in powers of two */
+  if (!(k->count & (k->count - 1))) {
+    rules = silc_realloc(k->rules, (k->count ? k->count * 2 : 1) *
+			 sizeof(*k->rules));
+    if (!rules)
+      return FALSE;
+    k->rules = rules;
+  }
+  k->rules[k->count++] = rule;
+
+  return TRUE;
+}
+
+/* Adds next rule `entry' with host `pattern' compiled as `match' to the
+   index.  NULL `pattern' matches any host. */
+
+static SilcBool silc_server_config_index_add(SilcServerConfigIndex index,
+					     void *entry, const char *pattern,
+					     SilcStringMatch match)
+{
+  SilcUInt32 rule, len, stars;
+  const char *cp, *star;
+
+  rule = index->rules_count;
+  index->rules[index->rules_count++] = entry;
+
+  if (!pattern) {
+    SILC_INDEX_LEN_SET(index->prefix_lens, 0);
+    return silc_server_config_index_key(index->prefix, "", 0, rule);
+  }
+
+  /* Index each comma separated alternative */
+  while (*pattern) {
+    cp = strchr(pattern, ',');
+    len = cp ? cp - pattern : strlen(pattern);
+
+    for (star = NULL, stars = 0, cp = pattern; cp < pattern + len; cp++) {
+      if (*cp == '?')
+	break;
+      if (*cp == '*') {
+	star = cp;
+	stars++;
+      }
+    }
+
+    if (!len) {
+      /* Empty alternative matches nothing */
+    } else if (cp < pattern + len || stars > 1 ||
+	       len > SILC_SERVER_CONFIG_INDEX_LEN ||
+	       (star && star != pattern && star != pattern + len - 1)) {
+      /* Needs the full matcher */
+      if (!index->fallback_count ||
+	  index->fallback[index->fallback_count - 1].rule != rule) {
+	index->fallback[index->fallback_count].rule = rule;
+	index->fallback[index->fallback_count++].match = match;
+      }
+    } else if (!star) {
+      if (!silc_server_config_index_key(index->exact, pattern, len, rule))
+	return FALSE;
+    } else if (star == pattern + len - 1) {
+      SILC_INDEX_LEN_SET(index->prefix_lens, len - 1);
+      if (!silc_server_config_index_key(index->prefix, pattern, len - 1,
+					rule))
+	return FALSE;
+    } else {
+      SILC_INDEX_LEN_SET(index->suffix_lens, len - 1);
+      if (!silc_server_config_index_key(index->suffix, pattern + 1, len - 1,
+					rule))
+	return FALSE;
+    }
+
+    pattern += len;
+    if (*pattern)
+      pattern++;
+  }
+
+  return TRUE;
+}
+
+/* Frees index */
+
+static void silc_server_config_index_free(SilcServerConfigIndex index)
+{
+  if (!index)
+    return;
+  if (index->exact)
+    silc_hash_table_free(index->exact);
+  if (index->prefix)
+    silc_hash_table_free(index->prefix);
+  if (index->suffix)
+    silc_hash_table_free(index->suffix);
+  silc_free(index->rules);
+  silc_free(index->fallback);
+  silc_free(index);
+}
+
+/* Allocates empty index for `count' rules */
+
+static SilcServerConfigIndex silc_server_config_index_alloc(SilcUInt32 count)
+{
+  SilcServerConfigIndex index;
+
+  index = silc_calloc(1, sizeof(*index));
+  if (!index)
+    return NULL;
+
+  index->rules = silc_calloc(count + 1, sizeof(*index->rules));
+  index->fallback = silc_calloc(count + 1, sizeof(*index->fallback));
+
+  index->exact = silc_hash_table_alloc(0, silc_hash_string, NULL,
+				       silc_server_config_index_compare, NULL,
+				       silc_server_config_index_destructor,
+				       NULL, TRUE);
+  index->prefix = silc_hash_table_alloc(0, silc_hash_string, NULL,
+					silc_server_config_index_compare, NULL,
+					silc_server_config_index_destructor,
+					NULL, TRUE);
+  index->suffix = silc_hash_table_alloc(0, silc_hash_string, NULL,
+					silc_server_config_index_compare, NULL,
+					silc_server_config_index_destructor,
+					NULL, TRUE);
+  if (!index->rules || !index->fallback || !index->exact || !index->prefix ||
+      !index->suffix) {
+    silc_server_config_index_free(index);
+    return NULL;
+  }
+
+  return index;
+}
+
+/* Updates `best' to be the first rule in `key' table entry that is at
+   `start' or after it. */
+
+static void silc_server_config_index_lookup(SilcHashTable table,
+					    char *key, SilcUInt32 start,
+					    SilcUInt32 *best)
+{
+  SilcServerConfigIndexKey *k;
+  SilcUInt32 low, high, mid;
+
+  if (!silc_hash_table_find(table, key, NULL, (void *)&k))
+    return;
+
+  low = 0;
+  high = k->count;
+  while (low < high) {
+    mid = (low + high) / 2;
+    if (k->rules[mid] < start)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+
+  if (low < k->count && k->rules[low] < *best)
+    *best = k->rules[low];
+}
+
+/* Returns the first rule at position `start' or after it that matches
+   `host'.  The position of the rule is returned to `start'.  Returns NULL
+   if no rule matches. */
+
+static void *silc_server_config_index_find(SilcServerConfigIndex index,
+					   const char *host,
+					   SilcUInt32 *start)
+{
+  char buf[SILC_SERVER_CONFIG_INDEX_LEN + 1], c;
+  SilcUInt32 i, len, best = index->rules_count;
+
+  len = strlen(host);
+
+  /* Exact match */
+  silc_server_config_index_lookup(index->exact, (char *)host, *start, &best);
+
+  /* Every prefix and suffix length that has patterns */
+  memcpy(buf, host, len < sizeof(buf) - 1 ? len : sizeof(buf) - 1);
+  for (i = 0; i <= len && i <= SILC_SERVER_CONFIG_INDEX_LEN; i++) {
+    if (SILC_INDEX_LEN_IS(index->prefix_lens, i)) {
+      c = buf[i];
+      buf[i] = '\0';
+      silc_server_config_index_lookup(index->prefix, buf, *start, &best);
+      buf[i] = c;
+    }
+    if (SILC_INDEX_LEN_IS(index->suffix_lens, i))
+      silc_server_config_index_lookup(index->suffix, (char *)host + len - i,
+				      *start, &best);
+  }
+
+  /* Fallback rules before the best found so far */
+  for (i = 0; i < index->fallback_count; i++) {
+    if (index->fallback[i].rule < *start)
+      continue;
+    if (index->fallback[i].rule >= best)
+      break;
+    if (silc_string_match_compiled(index->fallback[i].match, host)) {
+      best = index->fallback[i].rule;
+      break;
+    }
+  }
+
+  if (best == index->rules_count)
+    return NULL;
+
+  *start = best;
+  return index->rules[best];
+}
+
+/* Builds the host pattern indexes of the configuration */
+
+static SilcBool silc_server_config_index_build(SilcServerConfig config)
+{
+  SilcServerConfigClient *client;
+  SilcServerConfigAdmin *admin;
+  SilcServerConfigDeny *deny;
+  SilcUInt32 clients = 0, admins = 0, denied = 0;
+
+  for (client = config->clients; client; client = client->next)
+    clients++;
+  for (admin = config->admins; admin; admin = admin->next)
+    admins++;
+  for (deny = config->denied; deny; deny = deny->next)
+    denied++;
+
+  config->clients_index = silc_server_config_index_alloc(clients);
+  config->admins_index = silc_server_config_index_alloc(admins);
+  config->denied_index = silc_server_config_index_alloc(denied);
+  if (!config->clients_index || !config->admins_index ||
+      !config->denied_index)
+    return FALSE;
+
+  for (client = config->clients; client; client = client->next)
+    if (!silc_server_config_index_add(config->clients_index, client,
+				      client->host, client->host_match))
+      return FALSE;
+  for (admin = config->admins; admin; admin = admin->next)
+    if (!silc_server_config_index_add(config->admins_index, admin,
+				      admin->host, admin->host_match))
+      return FALSE;
+  for (deny = config->denied; deny; deny = deny->next)
+    if (!silc_server_config_index_add(config->denied_index, deny,
+				      deny->host, deny->host_match))
+      return FALSE;
+
+  return TRUE;
 }
 
 /* Check for correctness of the configuration */
@@ -1564,6 +1939,13 @@ SilcServerConfig silc_server_config_alloc(const char *filename,
   /* Set default to configuration parameters */
   silc_server_config_set_defaults(config_new);
 
+  /* Index the connection rules */
+  if (!silc_server_config_index_build(config_new)) {
+    SILC_SERVER_LOG_ERROR(("\nError: can't index connection rules"));
+    silc_server_config_destroy(config_new);
+    return NULL;
+  }
+
   return config_new;
 }
 
@@ -1681,32 +2063,42 @@ void silc_server_config_destroy(SilcServerConfig config)
     silc_free(di->version_software_vendor);
     silc_free(di);
   }
+  silc_server_config_index_free(config->clients_index);
+  silc_server_config_index_free(config->admins_index);
+  silc_server_config_index_free(config->denied_index);
   SILC_SERVER_CONFIG_LIST_DESTROY(SilcServerConfigClient, config->clients)
     silc_free(di->host);
+    silc_string_match_free(di->host_match);
     CONFIG_FREE_AUTH(di);
     silc_free(di);
   }
   SILC_SERVER_CONFIG_LIST_DESTROY(SilcServerConfigAdmin, config->admins)
     silc_free(di->host);
+    silc_string_match_free(di->host_match);
     silc_free(di->user);
     silc_free(di->nick);
+    silc_string_match_free(di->user_match);
+    silc_string_match_free(di->nick_match);
     CONFIG_FREE_AUTH(di);
     silc_free(di);
   }
   SILC_SERVER_CONFIG_LIST_DESTROY(SilcServerConfigDeny, config->denied)
     silc_free(di->host);
+    silc_string_match_free(di->host_match);
     silc_free(di->reason);
     silc_free(di);
   }
   SILC_SERVER_CONFIG_LIST_DESTROY(SilcServerConfigServer,
 				  config->servers)
     silc_free(di->host);
+    silc_string_match_free(di->host_match);
     CONFIG_FREE_AUTH(di);
     silc_free(di);
   }
   SILC_SERVER_CONFIG_LIST_DESTROY(SilcServerConfigRouter,
 				  config->routers)
     silc_free(di->host);
+    silc_string_match_free(di->host_match);
     silc_free(di->backup_replace_ip);
     CONFIG_FREE_AUTH(di);
     silc_free(di);
@@ -1864,19 +2256,12 @@ SilcServerConfigClient *
 silc_server_config_find_client(SilcServer server, char *host)
 {
   SilcServerConfig config = server->config;
-  SilcServerConfigClient *client;
+  SilcUInt32 start = 0;
 
   if (!config || !host)
     return NULL;
 
-  for (client = config->clients; client; client = client->next) {
-    if (client->host && !silc_string_match(client->host, host))
-      continue;
-    break;
-  }
-
-  /* if none matched, then client is already NULL */
-  return client;
+  return silc_server_config_index_find(config->clients_index, host, &start);
 }
 
 /* Returns admin connection configuration by host, username and/or
@@ -1888,6 +2273,7 @@ silc_server_config_find_admin(SilcServer server, char *host, char *user,
 {
   SilcServerConfig config = server->config;
   SilcServerConfigAdmin *admin;
+  SilcUInt32 i;
 
   /* make sure we have a value for the matching parameters */
   if (!host)
@@ -1897,12 +2283,11 @@ silc_server_config_find_admin(SilcServer server, char *host, char *user,
   if (!nick)
     nick = "*";
 
-  for (admin = config->admins; admin; admin = admin->next) {
-    if (admin->host && !silc_string_match(admin->host, host))
-      continue;
-    if (admin->user && !silc_string_match(admin->user, user))
+  for (i = 0; (admin = silc_server_config_index_find(config->admins_index,
+							 host, &i)); i++) {
+    if (admin->user && !silc_string_match_compiled(admin->user_match, user))
       continue;
-    if (admin->nick && !silc_string_match(admin->nick, nick))
+    if (admin->nick && !silc_string_match_compiled(admin->nick_match, nick))
       continue;
     /* no checks failed -> this entry matches */
     break;
@@ -1918,20 +2303,13 @@ SilcServerConfigDeny *
 silc_server_config_find_denied(SilcServer server, char *host)
 {
   SilcServerConfig config = server->config;
-  SilcServerConfigDeny *deny;
+  SilcUInt32 start = 0;
 
   /* make sure we have a value for the matching parameters */
   if (!config || !host)
     return NULL;
 
-  for (deny = config->denied; deny; deny = deny->next) {
-    if (deny->host && !silc_string_match(deny->host, host))
-      continue;
-    break;
-  }
-
-  /* if none matched, then deny is already NULL */
-  return deny;
+  return silc_server_config_index_find(config->denied_index, host, &start);
 }
 
 /* Returns server connection info from server configuartion by host
@@ -1950,7 +2328,7 @@ silc_server_config_find_server_conn(SilcServer server, char *host)
     return NULL;
 
   for (serv = config->servers; serv; serv = serv->next) {
-    if (!silc_string_match(serv->host, host))
+    if (!silc_string_match_compiled(serv->host_match, host))
       continue;
     break;
   }
@@ -1974,7 +2352,7 @@ silc_server_config_find_router_conn(SilcServer server, char *host, int port)
     return NULL;
 
   for (serv = config->routers; serv; serv = serv->next) {
-    if (!silc_string_match(serv->host, host))
+    if (!silc_string_match_compiled(serv->host_match, host))
       continue;
     if (port && serv->port && serv->port != port)
       continue;
@@ -2001,7 +2379,7 @@ silc_server_config_find_backup_conn(SilcServer server, char *host)
   for (serv = config->routers; serv; serv = serv->next) {
     if (!serv->backup_router)
       continue;
-    if (!silc_string_match(serv->host, host))
+    if (!silc_string_match_compiled(serv->host_match, host))
       continue;
     break;
   }
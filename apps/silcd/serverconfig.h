@@ -104,6 +104,7 @@ typedef struct SilcServerConfigConnParams {
 /* Holds all client authentication data from config file */
 typedef struct SilcServerConfigClientStruct {
   char *host;
+  SilcStringMatch host_match;
   unsigned char *passphrase;
   SilcUInt32 passphrase_len;
   SilcBool publickeys;
@@ -116,6 +117,9 @@ typedef struct SilcServerConfigAdminStruct {
   char *host;
   char *user;
   char *nick;
+  SilcStringMatch host_match;
+  SilcStringMatch user_match;
+  SilcStringMatch nick_match;
   unsigned char *passphrase;
   SilcUInt32 passphrase_len;
   SilcBool publickeys;
@@ -125,6 +129,7 @@ typedef struct SilcServerConfigAdminStruct {
 /* Holds all configured denied connections from config file */
 typedef struct SilcServerConfigDenyStruct {
   char *host;
+  SilcStringMatch host_match;
   char *reason;
   struct SilcServerConfigDenyStruct *next;
 } SilcServerConfigDeny;
@@ -132,6 +137,7 @@ typedef struct SilcServerConfigDenyStruct {
 /* Holds all configured server connections from config file */
 typedef struct SilcServerConfigServerStruct {
   char *host;
+  SilcStringMatch host_match;
   unsigned char *passphrase;
   SilcUInt32 passphrase_len;
   SilcBool publickeys;
@@ -143,6 +149,7 @@ typedef struct SilcServerConfigServerStruct {
 /* Holds all configured router connections from config file */
 typedef struct SilcServerConfigRouterStruct {
   char *host;
+  SilcStringMatch host_match;
   unsigned char *passphrase;
   SilcUInt32 passphrase_len;
   SilcBool publickeys;
@@ -157,10 +164,15 @@ typedef struct SilcServerConfigRouterStruct {
   struct SilcServerConfigRouterStruct *next;
 } SilcServerConfigRouter;
 
+/* Index of host patterns of connection rules */
+typedef struct SilcServerConfigIndexStruct *SilcServerConfigIndex;
+
 /* define the SilcServerConfig object */
 typedef struct {
   SilcServer server;
   void *tmp;
+  void *tmp_list;		/* List where tmp_last was appended to */
+  void *tmp_last;
 
   /* Reference count (when this reaches zero, config object is destroyed) */
   SilcInt32 refcount;
@@ -172,6 +184,9 @@ typedef struct {
   SilcUInt32 channel_rekey_secs;
   SilcUInt32 key_exchange_timeout;
   SilcUInt32 conn_auth_timeout;
+  SilcUInt32 list_cache_ttl;
+  SilcUInt32 crypto_workers;
+  SilcUInt32 crypto_queue;
   SilcServerConfigConnParams param;
   SilcBool detach_disabled;
   SilcUInt32 detach_timeout;
@@ -201,6 +216,9 @@ typedef struct {
   SilcServerConfigDeny *denied;
   SilcServerConfigServer *servers;
   SilcServerConfigRouter *routers;
+  SilcServerConfigIndex clients_index;
+  SilcServerConfigIndex admins_index;
+  SilcServerConfigIndex denied_index;
 } *SilcServerConfig;
 
 typedef struct {
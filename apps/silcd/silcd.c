@@ -252,8 +252,9 @@ SILC_TASK_CALLBACK(stop_server)
 
 SILC_TASK_CALLBACK(dump_stats)
 {
+  SilcSKECryptoStatsStruct crypto;
   FILE *fdd;
-  int fild;
+  int fild, i;
   char filename[256];
 
   memset(filename, 0, sizeof(filename));
@@ -270,6 +271,8 @@ SILC_TASK_CALLBACK(dump_stats)
   }
 
 #define STAT_OUTPUT(fmt, stat) fprintf(fdd, fmt "\n", (int)stat);
+#define STAT_OUTPUT64(fmt, stat) \
+  fprintf(fdd, fmt "\n", (unsigned long long)stat);
 
   fprintf(fdd, "SILC Server %s Statistics\n\n", silcd->server_name);
   fprintf(fdd, "Local Stats:\n");
@@ -306,6 +309,43 @@ SILC_TASK_CALLBACK(dump_stats)
   STAT_OUTPUT("  Commands sent           : %d", silcd->stat.commands_sent);
   STAT_OUTPUT("  Commands received       : %d", silcd->stat.commands_received);
   STAT_OUTPUT("  Connections             : %d", silcd->stat.conn_num);
+  STAT_OUTPUT("  Channel msgs relayed    : %d", silcd->stat.chmsgs_relayed);
+  STAT_OUTPUT("  Channel messages/sec    : %d",
+	      (silcd->stat.chmsgs_relayed /
+	       (silc_time() - silcd->starttime ?
+	        silc_time() - silcd->starttime : 1)));
+  STAT_OUTPUT64("  Channel msg recipients  : %llu",
+		silcd->stat.chmsgs_recipients);
+  STAT_OUTPUT64("  Usec per recipient      : %llu",
+		(silcd->stat.chmsgs_recipients ?
+		 silcd->stat.chmsgs_relay_usec /
+		 silcd->stat.chmsgs_recipients : 0));
+  STAT_OUTPUT("  LIST cache hits         : %d", silcd->stat.list_cache_hits);
+  STAT_OUTPUT("  LIST cache misses       : %d", silcd->stat.list_cache_misses);
+  STAT_OUTPUT("  Transit packets         : %d", silcd->stat.transit_packets);
+  STAT_OUTPUT64("  Transit kilobytes       : %llu",
+		silcd->stat.transit_bytes / 1024);
+#ifdef SILC_DEBUG
+  STAT_OUTPUT("  Packets using stack     : %d", silcd->stat.stack_packets);
+  STAT_OUTPUT64("  Stack allocations       : %llu",
+		silcd->stat.stack_allocs);
+  STAT_OUTPUT64("  Stack bytes per packet  : %llu",
+		(silcd->stat.stack_packets ?
+		 silcd->stat.stack_bytes / silcd->stat.stack_packets : 0));
+  STAT_OUTPUT("  Stack bytes peak        : %d", silcd->stat.stack_peak);
+#endif /* SILC_DEBUG */
+  silc_ske_get_crypto_stats(&crypto);
+  STAT_OUTPUT("  SKE crypto workers busy : %d", crypto.workers);
+  STAT_OUTPUT("  SKE crypto queue        : %d", crypto.queued);
+  STAT_OUTPUT("  SKE crypto queue peak   : %d", crypto.queued_peak);
+  STAT_OUTPUT("  SKE crypto operations   : %d", crypto.completed);
+  STAT_OUTPUT("  SKE rejected, queue full: %d", crypto.rejected);
+  fprintf(fdd, "\nSKE crypto latency (wait/run):\n");
+  for (i = 0; i < SILC_SKE_CRYPTO_BUCKETS - 1; i++)
+    fprintf(fdd, "  < %-4d ms                : %d/%d\n", 1 << (2 * i),
+	    (int)crypto.wait[i], (int)crypto.run[i]);
+  fprintf(fdd, "  >= %-4d ms               : %d/%d\n", 1 << (2 * (i - 1)),
+	  (int)crypto.wait[i], (int)crypto.run[i]);
 
 #undef STAT_OUTPUT
 
@@ -324,6 +364,26 @@ SILC_TASK_CALLBACK(dump_stats)
     fprintf(fdd, "  primary router         : %s\n",
       silcd->router->server_name ? silcd->router->server_name : "");
 
+  /* Dump slabs */
+  {
+    SilcIDListSlabs slabs = silcd->local_list->slabs;
+    SilcUInt32 live, free_count;
+
+#define SLAB_OUTPUT(name, slab)						\
+    silc_slab_stats(slab, &live, &free_count);				\
+    fprintf(fdd, "  %-23s: %d live, %d free\n", name, (int)live,	\
+	    (int)free_count);
+
+    fprintf(fdd, "\nDumping slabs\n");
+    SLAB_OUTPUT("server entries", slabs->servers);
+    SLAB_OUTPUT("client entries", slabs->clients);
+    SLAB_OUTPUT("channel entries", slabs->channels);
+    SLAB_OUTPUT("channel client entries", slabs->chl);
+    SLAB_OUTPUT("hash table entries", slabs->hash);
+
+#undef SLAB_OUTPUT
+  }
+
   /* Dump connections */
   {
     SilcPacketStream s;
@@ -335,13 +395,23 @@ SILC_TASK_CALLBACK(dump_stats)
       const char *hostname, *ip;
       SilcUInt16 port;
       SilcSocket sock;
+      SilcUInt32 flushes;
+      SilcUInt64 packets, bytes;
       SilcIDListData idata = silc_packet_get_context(s);
       if (!silc_socket_stream_get_info(silc_packet_stream_get_stream(s),
 				       &sock, &hostname, &ip, &port))
 	continue;
+      silc_packet_stream_get_flush_stats(s, &flushes, &packets, &bytes);
       fprintf(fdd, "  %d: host %s ip %s port %d type %d idata %p\n",
 	      sock, hostname ? hostname : "N/A",
 	      ip ? ip : "N/A", port, idata ? idata->conn_type : 0, idata);
+      fprintf(fdd, "      flushes %u packets/flush %u bytes/flush %u\n",
+	      flushes, flushes ? (unsigned int)(packets / flushes) : 0,
+	      flushes ? (unsigned int)(bytes / flushes) : 0);
+      if (idata && idata->transit_packets)
+	fprintf(fdd, "      transit packets %u kilobytes %u\n",
+		idata->transit_packets,
+		(unsigned int)(idata->transit_bytes / 1024));
     }
     silc_dlist_uninit(conns);
   }
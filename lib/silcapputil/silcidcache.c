@@ -30,9 +30,24 @@ struct SilcIDCacheStruct {
   SilcHashTable context_table;	     /* Context hash table */
   SilcIDCacheDestructor destructor;  /* Entry destructor */
   void *context;		     /* Destructor context */
+  SilcIDDirectory dir;		     /* ID directory or NULL */
   SilcIdType id_type;		     /* Type of ID cache */
 };
 
+/* ID directory context.  The directory is keyed by the IDs of the entries
+   but the hash is computed from the encoded ID so that the entries can be
+   found with encoded IDs too. */
+struct SilcIDDirectoryStruct {
+  SilcHashTable id_table;	     /* ID hash table */
+  SilcIdType id_type;		     /* Type of IDs */
+};
+
+/* Encoded ID used as key when finding from ID directory */
+typedef struct {
+  const unsigned char *data;
+  SilcUInt32 data_len;
+} SilcIDDirectoryKey;
+
 
 /************************ Static utility functions **************************/
 
@@ -48,6 +63,111 @@ static void silc_idcache_get_all_foreach(void *key, void *context,
   silc_list_add(*list, context);
 }
 
+/* FNV-1a hash of encoded ID */
+
+static inline SilcUInt32 silc_idcache_dir_hash_data(const unsigned char *data,
+						    SilcUInt32 data_len)
+{
+  SilcUInt32 h = 2166136261UL;
+
+  while (data_len--) {
+    h ^= *data++;
+    h *= 16777619;
+  }
+
+  return h;
+}
+
+/* ID directory hash function for IDs.  The ID is hashed in the encoded
+   form.  The `user_context' is the ID type. */
+
+static SilcUInt32 silc_idcache_dir_hash(void *key, void *user_context)
+{
+  unsigned char id[SILC_PACKET_MAX_ID_LEN];
+  SilcUInt32 id_len;
+
+  if (!silc_id_id2str(key, SILC_PTR_TO_32(user_context), id, sizeof(id),
+		      &id_len))
+    return 0;
+
+  return silc_idcache_dir_hash_data(id, id_len);
+}
+
+/* ID directory hash function for encoded IDs */
+
+static SilcUInt32 silc_idcache_dir_hash_str(void *key, void *user_context)
+{
+  SilcIDDirectoryKey *k = key;
+  return silc_idcache_dir_hash_data(k->data, k->data_len);
+}
+
+/* Compares ID in the ID directory, `key1', to the encoded ID `key2'
+   field by field, without encoding the ID.  The `user_context' is the
+   ID type. */
+
+static SilcBool silc_idcache_dir_compare_str(void *key1, void *key2,
+					     void *user_context)
+{
+  SilcIDDirectoryKey *k = key2;
+  const unsigned char *data = k->data;
+  SilcUInt32 ip_len;
+  SilcUInt16 port, rnd;
+
+  switch (SILC_PTR_TO_32(user_context)) {
+  case SILC_ID_CLIENT:
+    {
+      SilcClientID *id = key1;
+      ip_len = id->ip.data_len;
+      return (k->data_len == ip_len + 12 &&
+	      !memcmp(id->ip.data, data, ip_len) &&
+	      id->rnd == data[ip_len] &&
+	      !memcmp(id->hash, data + ip_len + 1, CLIENTID_HASH_LEN));
+    }
+
+  case SILC_ID_SERVER:
+    {
+      SilcServerID *id = key1;
+      ip_len = id->ip.data_len;
+      if (k->data_len != ip_len + 4 || memcmp(id->ip.data, data, ip_len))
+	return FALSE;
+      SILC_GET16_MSB(port, data + ip_len);
+      SILC_GET16_MSB(rnd, data + ip_len + 2);
+      return id->port == port && id->rnd == rnd;
+    }
+
+  case SILC_ID_CHANNEL:
+    {
+      SilcChannelID *id = key1;
+      ip_len = id->ip.data_len;
+      if (k->data_len != ip_len + 4 || memcmp(id->ip.data, data, ip_len))
+	return FALSE;
+      SILC_GET16_MSB(port, data + ip_len);
+      SILC_GET16_MSB(rnd, data + ip_len + 2);
+      return id->port == port && id->rnd == rnd;
+    }
+  }
+
+  return FALSE;
+}
+
+/* Adds entry to the ID directory of the cache */
+
+static inline void silc_idcache_dir_add(SilcIDCache cache,
+					SilcIDCacheEntry entry)
+{
+  if (cache->dir && entry->id)
+    silc_hash_table_add(cache->dir->id_table, entry->id, entry);
+}
+
+/* Deletes entry from the ID directory of the cache */
+
+static inline void silc_idcache_dir_del(SilcIDCache cache,
+					SilcIDCacheEntry entry)
+{
+  if (cache->dir && entry->id)
+    silc_hash_table_del_by_context(cache->dir->id_table, entry->id, entry);
+}
+
 /* Cache entry destructor */
 
 static void silc_idcache_destructor(SilcIDCache cache,
@@ -78,16 +198,18 @@ SilcIDCache silc_idcache_alloc(SilcUInt32 count, SilcIdType id_type,
   if (!cache)
     return NULL;
 
-  cache->id_table = silc_hash_table_alloc(count, silc_hash_id,
-					  SILC_32_TO_PTR(id_type),
-					  silc_hash_id_compare,
-					  SILC_32_TO_PTR(id_type),
-					  NULL, NULL, TRUE);
-  cache->name_table = silc_hash_table_alloc(count, silc_hash_utf8_string, NULL,
-					    silc_hash_utf8_compare, NULL,
-					    NULL, NULL, TRUE);
-  cache->context_table = silc_hash_table_alloc(count, silc_hash_ptr, NULL,
-					       NULL, NULL, NULL, NULL, TRUE);
+  cache->id_table = silc_hash_table_alloc_open(count, silc_hash_id,
+					       SILC_32_TO_PTR(id_type),
+					       silc_hash_id_compare,
+					       SILC_32_TO_PTR(id_type),
+					       NULL, NULL, TRUE);
+  cache->name_table = silc_hash_table_alloc_open(count,
+						 silc_hash_utf8_string, NULL,
+						 silc_hash_utf8_compare, NULL,
+						 NULL, NULL, TRUE);
+  cache->context_table = silc_hash_table_alloc_open(count, silc_hash_ptr,
+						    NULL, NULL, NULL, NULL,
+						    NULL, TRUE);
   cache->destructor = destructor;
   cache->context = destructor_context;
   cache->id_type = id_type;
@@ -106,10 +228,24 @@ SilcIDCache silc_idcache_alloc(SilcUInt32 count, SilcIdType id_type,
   return cache;
 }
 
+/* Removes cache entries from the ID directory */
+
+static void silc_idcache_free_dir_foreach(void *key, void *context,
+					  void *user_context)
+{
+  SilcIDCache cache = user_context;
+  if (!context)
+    return;
+  silc_idcache_dir_del(cache, context);
+}
+
 /* Frees ID cache object and cache entries */
 
 void silc_idcache_free(SilcIDCache cache)
 {
+  if (cache->dir)
+    silc_hash_table_foreach(cache->id_table, silc_idcache_free_dir_foreach,
+			    cache);
   silc_hash_table_free(cache->id_table);
   silc_hash_table_free(cache->name_table);
   silc_hash_table_free(cache->context_table);
@@ -136,6 +272,7 @@ silc_idcache_add(SilcIDCache cache, char *name, void *id, void *context)
   c->id = id;
   c->name = name;
   c->context = context;
+  c->cache = cache;
 
   SILC_LOG_DEBUG(("Adding cache entry %p", c));
 
@@ -158,6 +295,7 @@ silc_idcache_add(SilcIDCache cache, char *name, void *id, void *context)
   if (context)
     if (!silc_hash_table_add(cache->context_table, context, c))
       goto err;
+  silc_idcache_dir_add(cache, c);
 
   return c;
 
@@ -195,8 +333,10 @@ SilcBool silc_idcache_del(SilcIDCache cache, SilcIDCacheEntry entry,
     ret = silc_hash_table_del_by_context(cache->id_table, entry->id,
 					 entry);
 
-  if (ret)
+  if (ret) {
+    silc_idcache_dir_del(cache, entry);
     silc_idcache_destructor(cache, entry, app_context);
+  }
 
   return ret;
 }
@@ -246,6 +386,7 @@ SilcBool silc_idcache_update(SilcIDCache cache, SilcIDCacheEntry entry,
     if (entry->id) {
       if (!silc_hash_table_del_by_context(cache->id_table, entry->id, entry))
 	return FALSE;
+      silc_idcache_dir_del(cache, entry);
 
       if (cache->id_type == SILC_ID_CLIENT)
 	*(SilcClientID *)entry->id = *(SilcClientID *)new_id;
@@ -259,6 +400,7 @@ SilcBool silc_idcache_update(SilcIDCache cache, SilcIDCacheEntry entry,
 
     if (!silc_hash_table_add(cache->id_table, entry->id, entry))
       return FALSE;
+    silc_idcache_dir_add(cache, entry);
   }
 
   if (new_name) {
@@ -355,6 +497,11 @@ SilcBool silc_idcache_move(SilcIDCache from_cache, SilcIDCache to_cache,
     silc_hash_table_add(to_cache->name_table, c->name, c);
   if (c->context)
     silc_hash_table_add(to_cache->context_table, c->context, c);
+  if (from_cache->dir != to_cache->dir) {
+    silc_idcache_dir_del(from_cache, c);
+    silc_idcache_dir_add(to_cache, c);
+  }
+  c->cache = to_cache;
 
   return TRUE;
 }
@@ -454,3 +601,84 @@ SilcBool silc_idcache_find_by_name_one(SilcIDCache cache, char *name,
     return FALSE;
   return silc_hash_table_find(cache->name_table, name, NULL, (void *)ret);
 }
+
+/* Allocates ID directory */
+
+SilcIDDirectory silc_idcache_directory_alloc(SilcUInt32 count,
+					     SilcIdType id_type)
+{
+  SilcIDDirectory dir;
+
+  dir = silc_calloc(1, sizeof(*dir));
+  if (!dir)
+    return NULL;
+
+  dir->id_type = id_type;
+  dir->id_table = silc_hash_table_alloc_open(count, silc_idcache_dir_hash,
+					     SILC_32_TO_PTR(id_type),
+					     silc_hash_id_compare_full,
+					     SILC_32_TO_PTR(id_type),
+					     NULL, NULL, TRUE);
+  if (!dir->id_table) {
+    silc_free(dir);
+    return NULL;
+  }
+
+  return dir;
+}
+
+/* Frees ID directory */
+
+void silc_idcache_directory_free(SilcIDDirectory dir)
+{
+  if (!dir)
+    return;
+  silc_hash_table_free(dir->id_table);
+  silc_free(dir);
+}
+
+/* Attaches ID directory to the cache and adds the existing entries to it */
+
+static void silc_idcache_set_directory_foreach(void *key, void *context,
+					       void *user_context)
+{
+  SilcIDCache cache = user_context;
+  if (!context)
+    return;
+  silc_idcache_dir_add(cache, context);
+}
+
+SilcBool silc_idcache_set_directory(SilcIDCache cache, SilcIDDirectory dir)
+{
+  if (!cache || !dir || cache->dir || cache->id_type != dir->id_type)
+    return FALSE;
+
+  cache->dir = dir;
+  silc_hash_table_foreach(cache->id_table,
+			  silc_idcache_set_directory_foreach, cache);
+
+  return TRUE;
+}
+
+/* Finds entry by encoded ID from ID directory */
+
+SilcIDCacheEntry silc_idcache_directory_find(SilcIDDirectory dir,
+					     const unsigned char *id,
+					     SilcUInt32 id_len)
+{
+  SilcIDDirectoryKey key;
+  SilcIDCacheEntry entry;
+
+  if (!dir || !id)
+    return NULL;
+
+  key.data = id;
+  key.data_len = id_len;
+
+  if (!silc_hash_table_find_ext(dir->id_table, &key, NULL, (void *)&entry,
+				silc_idcache_dir_hash_str, NULL,
+				silc_idcache_dir_compare_str, NULL))
+    return NULL;
+
+  return entry;
+}
@@ -52,6 +52,7 @@ typedef struct SilcIDCacheEntryStruct {
   void *id;			       /* Associated ID */
   char *name;			       /* Associated entry name */
   void *context;		       /* Associated context */
+  struct SilcIDCacheStruct *cache;     /* Cache the entry is in */
 } *SilcIDCacheEntry;
 /***/
 
@@ -71,6 +72,25 @@ typedef struct SilcIDCacheEntryStruct {
  ***/
 typedef struct SilcIDCacheStruct *SilcIDCache;
 
+/****s* silcapputil/SilcIDCacheAPI/SilcIDDirectory
+ *
+ * NAME
+ *
+ *    typedef struct SilcIDDirectoryStruct *SilcIDDirectory;
+ *
+ * DESCRIPTION
+ *
+ *    ID directory indexes the entries of one or more ID caches of the
+ *    same ID type by the ID.  The entries can be found from the directory
+ *    directly with the encoded ID, as it is in a packet, without decoding
+ *    it first.  The cache the found entry is in is in the entry's `cache'
+ *    field.  The directory is attached to ID caches with the function
+ *    silc_idcache_set_directory and the ID cache routines keep it up to
+ *    date.  It is allocated with silc_idcache_directory_alloc.
+ *
+ ***/
+typedef struct SilcIDDirectoryStruct *SilcIDDirectory;
+
 /****f* silcapputil/SilcIDCacheAPI/SilcIDCacheDestructor
  *
  * SYNOPSIS
@@ -369,4 +389,73 @@ SilcBool silc_idcache_find_by_name(SilcIDCache cache, char *name,
 SilcBool silc_idcache_find_by_name_one(SilcIDCache cache, char *name,
 				       SilcIDCacheEntry *ret);
 
+/****f* silcapputil/SilcIDCacheAPI/silc_idcache_directory_alloc
+ *
+ * SYNOPSIS
+ *
+ *    SilcIDDirectory silc_idcache_directory_alloc(SilcUInt32 count,
+ *                                                 SilcIdType id_type);
+ *
+ * DESCRIPTION
+ *
+ *    Allocates new ID directory for ID caches of `id_type'.  The `count'
+ *    is the initial size, and if it is 0 the system uses default value.
+ *
+ ***/
+SilcIDDirectory silc_idcache_directory_alloc(SilcUInt32 count,
+					     SilcIdType id_type);
+
+/****f* silcapputil/SilcIDCacheAPI/silc_idcache_directory_free
+ *
+ * SYNOPSIS
+ *
+ *    void silc_idcache_directory_free(SilcIDDirectory dir);
+ *
+ * DESCRIPTION
+ *
+ *    Frees the ID directory.  The ID caches using the directory must be
+ *    freed before the directory.  The cache entries are not freed.
+ *
+ ***/
+void silc_idcache_directory_free(SilcIDDirectory dir);
+
+/****f* silcapputil/SilcIDCacheAPI/silc_idcache_set_directory
+ *
+ * SYNOPSIS
+ *
+ *    SilcBool silc_idcache_set_directory(SilcIDCache cache,
+ *                                        SilcIDDirectory dir);
+ *
+ * DESCRIPTION
+ *
+ *    Attaches the ID directory `dir' to the `cache'.  After this all
+ *    entries in the cache, and added to the cache later, can be found
+ *    from the directory.  The same directory may be attached to several
+ *    caches.  Returns FALSE if the ID types of the cache and directory
+ *    differ or if the cache has directory already.
+ *
+ ***/
+SilcBool silc_idcache_set_directory(SilcIDCache cache, SilcIDDirectory dir);
+
+/****f* silcapputil/SilcIDCacheAPI/silc_idcache_directory_find
+ *
+ * SYNOPSIS
+ *
+ *    SilcIDCacheEntry
+ *    silc_idcache_directory_find(SilcIDDirectory dir,
+ *                                const unsigned char *id,
+ *                                SilcUInt32 id_len);
+ *
+ * DESCRIPTION
+ *
+ *    Finds cache entry by encoded ID `id' of `id_len' bytes from the ID
+ *    directory.  The ID is not decoded and the whole ID must match.
+ *    Returns NULL if the entry was not found.  The `cache' field of the
+ *    returned entry tells the cache the entry is in.
+ *
+ ***/
+SilcIDCacheEntry silc_idcache_directory_find(SilcIDDirectory dir,
+					     const unsigned char *id,
+					     SilcUInt32 id_len);
+
 #endif /* SILCIDCACHE_H */
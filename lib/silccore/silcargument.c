@@ -30,13 +30,15 @@ struct SilcArgumentPayloadStruct {
   SilcUInt32 *argv_lens;
   SilcUInt32 *argv_types;
   SilcUInt32 pos;
+  SilcStack stack;
 };
 
 /* Parses arguments and returns them into Argument Payload structure. */
 
 SilcArgumentPayload silc_argument_payload_parse(const unsigned char *payload,
 						SilcUInt32 payload_len,
-						SilcUInt32 argc)
+						SilcUInt32 argc,
+						SilcStack stack)
 {
   SilcBufferStruct buffer;
   SilcArgumentPayload newp;
@@ -47,16 +49,17 @@ SilcArgumentPayload silc_argument_payload_parse(const unsigned char *payload,
   int i = 0, ret;
 
   silc_buffer_set(&buffer, (unsigned char *)payload, payload_len);
-  newp = silc_calloc(1, sizeof(*newp));
+  newp = silc_scalloc(stack, 1, sizeof(*newp));
   if (!newp)
     return NULL;
-  newp->argv = silc_calloc(argc, sizeof(unsigned char *));
+  newp->stack = stack;
+  newp->argv = silc_scalloc(stack, argc, sizeof(unsigned char *));
   if (!newp->argv)
     goto err;
-  newp->argv_lens = silc_calloc(argc, sizeof(SilcUInt32));
+  newp->argv_lens = silc_scalloc(stack, argc, sizeof(SilcUInt32));
   if (!newp->argv_lens)
     goto err;
-  newp->argv_types = silc_calloc(argc, sizeof(SilcUInt32));
+  newp->argv_types = silc_scalloc(stack, argc, sizeof(SilcUInt32));
   if (!newp->argv_types)
     goto err;
 
@@ -77,10 +80,10 @@ SilcArgumentPayload silc_argument_payload_parse(const unsigned char *payload,
 
     /* Get argument data */
     silc_buffer_pull(&buffer, 3);
-    ret = silc_buffer_unformat(&buffer,
-			       SILC_STR_UI_XNSTRING_ALLOC(&newp->argv[i],
-							  p_len),
-			       SILC_STR_END);
+    ret = silc_buffer_sunformat(stack, &buffer,
+				SILC_STR_UI_XNSTRING_ALLOC(&newp->argv[i],
+							   p_len),
+				SILC_STR_END);
     if (ret == -1) {
       SILC_LOG_DEBUG(("Malformed argument payload"));
       goto err;
@@ -104,6 +107,11 @@ SilcArgumentPayload silc_argument_payload_parse(const unsigned char *payload,
 
  err:
   SILC_LOG_DEBUG(("Error parsing argument payload"));
+
+  /* Memory allocated from stack is freed when the stack is popped */
+  if (stack)
+    return NULL;
+
   if (i)
     for (ret = 0; ret < i; ret++)
       silc_free(newp->argv[ret]);
@@ -217,7 +225,7 @@ void silc_argument_payload_free(SilcArgumentPayload payload)
 {
   int i;
 
-  if (payload) {
+  if (payload && !payload->stack) {
     for (i = 0; i < payload->argc; i++)
       silc_free(payload->argv[i]);
 
@@ -415,7 +423,7 @@ silc_argument_list_parse(const unsigned char *payload,
 
   SILC_GET16_MSB(argc, payload);
 
-  arg = silc_argument_payload_parse(payload + 2, payload_len - 2, argc);
+  arg = silc_argument_payload_parse(payload + 2, payload_len - 2, argc, NULL);
 
   return arg;
 }
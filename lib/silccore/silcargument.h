@@ -52,7 +52,8 @@ typedef struct SilcArgumentPayloadStruct *SilcArgumentPayload;
  *    SilcArgumentPayload
  *    silc_argument_payload_parse(const unsigned char *payload,
  *                                SilcUInt32 payload_len,
- *                                SilcUInt32 argc);
+ *                                SilcUInt32 argc,
+ *                                SilcStack stack);
  *
  * DESCRIPTION
  *
@@ -63,10 +64,17 @@ typedef struct SilcArgumentPayloadStruct *SilcArgumentPayload;
  *    Argument payload is associated with other payloads which defines
  *    the number of the arguments.
  *
+ *    If the `stack' is non-NULL the payload and the arguments are
+ *    allocated from that stack.  They remain valid until the stack frame
+ *    is popped and silc_argument_payload_free does not free them.  This
+ *    is useful when the payload is parsed and processed inside one
+ *    stack frame, for example when processing a received packet.
+ *
  ***/
 SilcArgumentPayload silc_argument_payload_parse(const unsigned char *payload,
 						SilcUInt32 payload_len,
-						SilcUInt32 argc);
+						SilcUInt32 argc,
+						SilcStack stack);
 
 /****f* silccore/SilcArgumentAPI/silc_argument_payload_encode
  *
@@ -136,7 +144,9 @@ SilcBuffer silc_argument_payload_encode_payload(SilcArgumentPayload payload);
  *
  * DESCRIPTION
  *
- *    Frees the Argument Payload and all data in it.
+ *    Frees the Argument Payload and all data in it.  If the payload was
+ *    parsed with SilcStack this call has no effect and the memory is
+ *    freed when the stack frame is popped.
  *
  ***/
 void silc_argument_payload_free(SilcArgumentPayload payload);
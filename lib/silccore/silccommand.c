@@ -85,7 +85,7 @@ SilcCommandPayload silc_command_payload_parse(const unsigned char *payload,
   if (args_num) {
     newp->args = silc_argument_payload_parse(buffer.data,
 					     silc_buffer_len(&buffer),
-					     args_num);
+					     args_num, NULL);
     if (!newp->args) {
       silc_free(newp);
       return NULL;
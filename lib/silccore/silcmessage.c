@@ -588,7 +588,6 @@ SilcBuffer silc_message_payload_encode(SilcMessageFlags flags,
   unsigned char pad[16], iv[SILC_CIPHER_MAX_IV_SIZE];
   SilcBuffer buf = NULL;
   SilcMessageEncode e;
-  int i;
 
   SILC_LOG_DEBUG(("Encoding Message Payload"));
 
@@ -611,11 +610,10 @@ SilcBuffer silc_message_payload_encode(SilcMessageFlags flags,
   /* Generate IV */
   if (cipher && generate_iv) {
     iv_len = silc_cipher_get_block_len(cipher);
-    if (rng) {
-      for (i = 0; i < iv_len; i++) iv[i] = silc_rng_get_byte_fast(rng);
-    } else {
-      for (i = 0; i < iv_len; i++) iv[i] = silc_rng_global_get_byte_fast();
-    }
+    if (rng)
+      silc_rng_get_data_fast(rng, iv, iv_len);
+    else
+      silc_rng_global_get_data_fast(iv, iv_len);
   }
 
   if (hmac)
@@ -629,11 +627,10 @@ SilcBuffer silc_message_payload_encode(SilcMessageFlags flags,
 
   /* Generate padding */
   if (cipher) {
-    if (rng) {
-      for (i = 0; i < pad_len; i++) pad[i] = silc_rng_get_byte_fast(rng);
-    } else {
-      for (i = 0; i < pad_len; i++) pad[i] = silc_rng_global_get_byte_fast();
-    }
+    if (rng)
+      silc_rng_get_data_fast(rng, pad, pad_len);
+    else
+      silc_rng_global_get_data_fast(pad, pad_len);
   }
 
   e.flags = flags;
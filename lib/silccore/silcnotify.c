@@ -31,12 +31,14 @@ struct SilcNotifyPayloadStruct {
   SilcNotifyType type;
   unsigned char argc;
   SilcArgumentPayload args;
+  SilcStack stack;
 };
 
 /* Parse notify payload buffer and return data into payload structure */
 
 SilcNotifyPayload silc_notify_payload_parse(const unsigned char *payload,
-					    SilcUInt32 payload_len)
+					    SilcUInt32 payload_len,
+					    SilcStack stack)
 {
   SilcBufferStruct buffer;
   SilcNotifyPayload newp;
@@ -46,9 +48,10 @@ SilcNotifyPayload silc_notify_payload_parse(const unsigned char *payload,
   SILC_LOG_DEBUG(("Parsing Notify payload"));
 
   silc_buffer_set(&buffer, (unsigned char *)payload, payload_len);
-  newp = silc_calloc(1, sizeof(*newp));
+  newp = silc_scalloc(stack, 1, sizeof(*newp));
   if (!newp)
     return NULL;
+  newp->stack = stack;
 
   ret = silc_buffer_unformat(&buffer,
 			     SILC_STR_UI_SHORT(&newp->type),
@@ -65,7 +68,7 @@ SilcNotifyPayload silc_notify_payload_parse(const unsigned char *payload,
     silc_buffer_pull(&buffer, 5);
     newp->args = silc_argument_payload_parse(buffer.data,
 					     silc_buffer_len(&buffer),
-					     newp->argc);
+					     newp->argc, stack);
     if (!newp->args)
       goto err;
     silc_buffer_push(&buffer, 5);
@@ -74,7 +77,8 @@ SilcNotifyPayload silc_notify_payload_parse(const unsigned char *payload,
   return newp;
 
  err:
-  silc_free(newp);
+  if (!stack)
+    silc_free(newp);
   return NULL;
 }
 
@@ -187,7 +191,7 @@ SilcBuffer silc_notify_payload_encode_args(SilcNotifyType type,
 
 void silc_notify_payload_free(SilcNotifyPayload payload)
 {
-  if (payload) {
+  if (payload && !payload->stack) {
     silc_argument_payload_free(payload->args);
     silc_free(payload);
   }
@@ -90,16 +90,20 @@ typedef SilcUInt16 SilcNotifyType;
  *
  *    SilcNotifyPayload
  *    silc_notify_payload_parse(const unsigned char *payload,
- *                              SilcUInt32 payload_len);
+ *                              SilcUInt32 payload_len,
+ *                              SilcStack stack);
  *
  * DESCRIPTION
  *
  *    Parse notify payload buffer and return data into payload structure.
- *    The `buffer' is the raw payload data.
+ *    The `buffer' is the raw payload data.  If the `stack' is non-NULL
+ *    the payload and its arguments are allocated from that stack and
+ *    remain valid until the stack frame is popped.
  *
  ***/
 SilcNotifyPayload silc_notify_payload_parse(const unsigned char *payload,
-					    SilcUInt32 payload_len);
+					    SilcUInt32 payload_len,
+					    SilcStack stack);
 
 /****f* silccore/SilcNotifyAPI/silc_notify_payload_encode
  *
@@ -145,7 +149,8 @@ SilcBuffer silc_notify_payload_encode_args(SilcNotifyType type,
  *
  * DESCRIPTION
  *
- *    Frees the Notify Payload and all data in it.
+ *    Frees the Notify Payload and all data in it.  Has no effect if the
+ *    payload was parsed with SilcStack.
  *
  ***/
 void silc_notify_payload_free(SilcNotifyPayload payload);
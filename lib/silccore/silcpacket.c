@@ -82,6 +82,10 @@ struct SilcPacketStreamStruct {
   SilcUInt32 send_psn;			 /* Sending sequence */
   SilcUInt32 receive_psn;		 /* Receiving sequence */
   SilcAtomic32 refcnt;		         /* Reference counter */
+  SilcUInt32 out_packets;		 /* Packets in outbuf not flushed */
+  SilcUInt32 flushes;			 /* Number of flushes */
+  SilcUInt64 flush_packets;		 /* Packets flushed */
+  SilcUInt64 flush_bytes;		 /* Bytes flushed */
   SilcUInt8 sid;			 /* Security ID, set if IV included */
   unsigned int src_id_len  : 6;
   unsigned int src_id_type : 2;
@@ -91,11 +95,17 @@ struct SilcPacketStreamStruct {
   unsigned int destroyed   : 1;		 /* Set if destroyed */
   unsigned int iv_included : 1;          /* Set if IV included */
   unsigned int udp         : 1;          /* UDP remote stream */
+  unsigned int cork        : 1;          /* Set if writing is deferred */
+  unsigned int flush_pending : 1;	 /* Set if flush is scheduled */
 };
 
 /* Initial size of stream buffers */
 #define SILC_PACKET_DEFAULT_SIZE  1024
 
+/* Amount of corked data in stream buffer after which it is written
+   immediately without waiting for the scheduled flush. */
+#define SILC_PACKET_CORK_THRESHOLD 16384
+
 /* Header length without source and destination ID's. */
 #define SILC_PACKET_HEADER_LEN 10
 
@@ -212,6 +222,14 @@ static inline SilcBool silc_packet_stream_write(SilcPacketStream ps,
   else
     stream = ps->stream;
 
+  /* Update flush statistics */
+  if (ps->out_packets) {
+    ps->flushes++;
+    ps->flush_packets += ps->out_packets;
+    ps->flush_bytes += silc_buffer_len(&ps->outbuf);
+    ps->out_packets = 0;
+  }
+
   if (ps->udp && silc_socket_stream_is_udp(stream, &connected)) {
     if (!connected) {
       /* Connectionless UDP stream */
@@ -283,6 +301,52 @@ static inline SilcBool silc_packet_stream_write(SilcPacketStream ps,
   return TRUE;
 }
 
+/* Scheduled flush of corked stream.  Writes all data collected to the
+   stream buffer during the last scheduler iteration at once. */
+
+SILC_TASK_CALLBACK(silc_packet_stream_flush)
+{
+  SilcPacketStream ps = context;
+
+  silc_mutex_lock(ps->lock);
+  ps->flush_pending = FALSE;
+
+  if (ps->destroyed || !silc_buffer_len(&ps->outbuf)) {
+    silc_mutex_unlock(ps->lock);
+    silc_packet_stream_unref(ps);
+    return;
+  }
+
+  SILC_LOG_DEBUG(("Flushing %d packets, %d bytes to stream %p",
+		  ps->out_packets, silc_buffer_len(&ps->outbuf), ps));
+
+  silc_packet_stream_write(ps, FALSE);
+  silc_packet_stream_unref(ps);
+}
+
+/* Writes the assembled packet to the stream, or if the stream is corked
+   leaves it to the stream buffer and schedules flush.  Must be called
+   with ps->lock locked.  Unlocks the lock inside this function. */
+
+static inline SilcBool silc_packet_stream_send(SilcPacketStream ps)
+{
+  if (!ps->cork || ps->udp ||
+      silc_buffer_len(&ps->outbuf) >= SILC_PACKET_CORK_THRESHOLD)
+    return silc_packet_stream_write(ps, FALSE);
+
+  if (!ps->flush_pending) {
+    if (silc_unlikely(!silc_schedule_task_add_timeout(ps->sc->schedule,
+						      silc_packet_stream_flush,
+						      ps, 0, 0)))
+      return silc_packet_stream_write(ps, FALSE);
+    ps->flush_pending = TRUE;
+    silc_packet_stream_ref(ps);
+  }
+
+  silc_mutex_unlock(ps->lock);
+  return TRUE;
+}
+
 /* Reads data from stream.  Must be called with ps->lock locked.  If this
    returns FALSE the lock has been unlocked.  If this returns packet stream
    to `ret_ps' its lock has been acquired and `ps' lock has been unlocked.
@@ -897,6 +961,22 @@ void silc_packet_stream_destroy(SilcPacketStream stream)
 
     SILC_LOG_DEBUG(("Marking packet stream %p destroyed", stream));
 
+    /* Write corked data before closing the stream */
+    if (stream->flush_pending && !stream->udp && stream->stream) {
+      int i;
+
+      silc_mutex_lock(stream->lock);
+      while (silc_buffer_len(&stream->outbuf) > 0) {
+	i = silc_stream_write(stream->stream, stream->outbuf.data,
+			      silc_buffer_len(&stream->outbuf));
+	if (i <= 0)
+	  break;
+	silc_buffer_pull(&stream->outbuf, i);
+      }
+      silc_buffer_reset(&stream->outbuf);
+      silc_mutex_unlock(stream->lock);
+    }
+
     /* Close the underlaying stream */
     if (!stream->udp && stream->stream)
       silc_stream_close(stream->stream);
@@ -997,6 +1077,39 @@ void silc_packet_stream_set_router(SilcPacketStream stream)
   stream->is_router = TRUE;
 }
 
+/* Set or unset corking */
+
+void silc_packet_stream_set_cork(SilcPacketStream stream, SilcBool cork)
+{
+  silc_mutex_lock(stream->lock);
+  stream->cork = cork;
+
+  /* Write pending data now when uncorking */
+  if (!cork && silc_buffer_len(&stream->outbuf) > 0 && !stream->destroyed) {
+    silc_packet_stream_write(stream, FALSE);
+    return;
+  }
+
+  silc_mutex_unlock(stream->lock);
+}
+
+/* Return flush statistics */
+
+void silc_packet_stream_get_flush_stats(SilcPacketStream stream,
+					SilcUInt32 *flushes,
+					SilcUInt64 *packets,
+					SilcUInt64 *bytes)
+{
+  silc_mutex_lock(stream->lock);
+  if (flushes)
+    *flushes = stream->flushes;
+  if (packets)
+    *packets = stream->flush_packets;
+  if (bytes)
+    *bytes = stream->flush_bytes;
+  silc_mutex_unlock(stream->lock);
+}
+
 /* Mark to include IV in ciphertext */
 
 void silc_packet_stream_set_iv_included(SilcPacketStream stream)
@@ -1619,8 +1732,7 @@ static inline SilcBool silc_packet_send_raw(SilcPacketStream stream,
   flags &= ~(SILC_PACKET_FLAG_LONG_PAD);
 
   /* Get random padding */
-  for (i = 0; i < padlen; i++) tmppad[i] =
-    silc_rng_get_byte_fast(stream->sc->engine->rng);
+  silc_rng_get_data_fast(stream->sc->engine->rng, tmppad, padlen);
 
   silc_mutex_lock(stream->lock);
 
@@ -1687,6 +1799,8 @@ static inline SilcBool silc_packet_send_raw(SilcPacketStream stream,
     stream->send_psn++;
   }
 
+  stream->out_packets++;
+
   return TRUE;
 }
 
@@ -1710,7 +1824,7 @@ SilcBool silc_packet_send(SilcPacketStream stream,
 			     stream->send_hmac[0]);
 
   /* Write the packet to the stream */
-  return ret ? silc_packet_stream_write(stream, FALSE) : FALSE;
+  return ret ? silc_packet_stream_send(stream) : FALSE;
 }
 
 /* Sends a packet, extended routine */
@@ -1747,7 +1861,37 @@ SilcBool silc_packet_send_ext(SilcPacketStream stream,
 			     hmac ? hmac : stream->send_hmac[0]);
 
   /* Write the packet to the stream */
-  return ret ? silc_packet_stream_write(stream, FALSE) : FALSE;
+  return ret ? silc_packet_stream_send(stream) : FALSE;
+}
+
+/* Sends a packet with source and destination IDs already encoded */
+
+SilcBool silc_packet_send_ext_str(SilcPacketStream stream,
+				  SilcPacketType type, SilcPacketFlags flags,
+				  SilcIdType src_id_type,
+				  const unsigned char *src_id,
+				  SilcUInt32 src_id_len,
+				  SilcIdType dst_id_type,
+				  const unsigned char *dst_id,
+				  SilcUInt32 dst_id_len,
+				  const unsigned char *data, SilcUInt32 data_len,
+				  SilcCipher cipher, SilcHmac hmac)
+{
+  SilcBool ret;
+
+  ret = silc_packet_send_raw(stream, type, flags,
+			     src_id ? src_id_type : stream->src_id_type,
+			     src_id ? (unsigned char *)src_id : stream->src_id,
+			     src_id ? src_id_len : stream->src_id_len,
+			     dst_id ? dst_id_type : stream->dst_id_type,
+			     dst_id ? (unsigned char *)dst_id : stream->dst_id,
+			     dst_id ? dst_id_len : stream->dst_id_len,
+			     data, data_len,
+			     cipher ? cipher : stream->send_key[0],
+			     hmac ? hmac : stream->send_hmac[0]);
+
+  /* Write the packet to the stream */
+  return ret ? silc_packet_stream_send(stream) : FALSE;
 }
 
 /* Sends packet after formatting the arguments to buffer */
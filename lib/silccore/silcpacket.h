@@ -577,6 +577,50 @@ void silc_packet_stream_set_router(SilcPacketStream stream);
  ***/
 void silc_packet_stream_set_iv_included(SilcPacketStream stream);
 
+/****f* silccore/SilcPacketAPI/silc_packet_stream_set_cork
+ *
+ * SYNOPSIS
+ *
+ *    void silc_packet_stream_set_cork(SilcPacketStream stream,
+ *                                     SilcBool cork);
+ *
+ * DESCRIPTION
+ *
+ *    Sets or unsets corking for the stream indicated by `stream'.  When
+ *    stream is corked the sent packets are not written to the stream
+ *    immediately.  They are collected to the stream's outgoing buffer and
+ *    written at once when the scheduler runs next time, or immediately
+ *    if the amount of collected data grows large.  This reduces the number
+ *    of write system calls when many packets are sent to the same stream
+ *    during one scheduler iteration.  When corking is unset any collected
+ *    data is written immediately.  This has no effect for UDP streams.
+ *
+ ***/
+void silc_packet_stream_set_cork(SilcPacketStream stream, SilcBool cork);
+
+/****f* silccore/SilcPacketAPI/silc_packet_stream_get_flush_stats
+ *
+ * SYNOPSIS
+ *
+ *    void silc_packet_stream_get_flush_stats(SilcPacketStream stream,
+ *                                            SilcUInt32 *flushes,
+ *                                            SilcUInt64 *packets,
+ *                                            SilcUInt64 *bytes);
+ *
+ * DESCRIPTION
+ *
+ *    Returns the number of times the sent data has been flushed to the
+ *    underlaying stream in `flushes', and the total number of packets and
+ *    bytes flushed in `packets' and `bytes'.  The average number of packets
+ *    and bytes written per flush can be computed from these.  Any of the
+ *    pointers may be NULL.
+ *
+ ***/
+void silc_packet_stream_get_flush_stats(SilcPacketStream stream,
+					SilcUInt32 *flushes,
+					SilcUInt64 *packets,
+					SilcUInt64 *bytes);
+
 /****f* silccore/SilcPacketAPI/silc_packet_stream_set_stream
  *
  * SYNOPSIS
@@ -1031,6 +1075,42 @@ SilcBool silc_packet_send_ext(SilcPacketStream stream,
 			      const unsigned char *data, SilcUInt32 data_len,
 			      SilcCipher cipher, SilcHmac hmac);
 
+/****f* silccore/SilcPacketAPI/silc_packet_send_ext_str
+ *
+ * SYNOPSIS
+ *
+ *    SilcBool
+ *    silc_packet_send_ext_str(SilcPacketStream stream,
+ *                             SilcPacketType type, SilcPacketFlags flags,
+ *                             SilcIdType src_id_type,
+ *                             const unsigned char *src_id,
+ *                             SilcUInt32 src_id_len,
+ *                             SilcIdType dst_id_type,
+ *                             const unsigned char *dst_id,
+ *                             SilcUInt32 dst_id_len,
+ *                             const unsigned char *data, SilcUInt32 data_len,
+ *                             SilcCipher cipher, SilcHmac hmac);
+ *
+ * DESCRIPTION
+ *
+ *    Same as silc_packet_send_ext but the source and destination IDs are
+ *    given already encoded in their wire format, as returned by the
+ *    silc_id_id2str.  This can be used when same packet is sent to many
+ *    streams, as the IDs need to be encoded only once by the caller.  If
+ *    the `src_id' or `dst_id' is NULL, the ID set to the stream will apply.
+ *
+ ***/
+SilcBool silc_packet_send_ext_str(SilcPacketStream stream,
+				  SilcPacketType type, SilcPacketFlags flags,
+				  SilcIdType src_id_type,
+				  const unsigned char *src_id,
+				  SilcUInt32 src_id_len,
+				  SilcIdType dst_id_type,
+				  const unsigned char *dst_id,
+				  SilcUInt32 dst_id_len,
+				  const unsigned char *data, SilcUInt32 data_len,
+				  SilcCipher cipher, SilcHmac hmac);
+
 /****f* silccore/SilcPacketAPI/silc_packet_send_va
  *
  * SYNOPSIS
@@ -41,12 +41,263 @@
  * SILC Crypto API for AES
  */
 
+/* AES-NI */
+
+/* The AES instructions are used if the CPU supports them.  The key
+   schedule is computed in C and the encryption round keys are used as is,
+   since on little endian CPU the key schedule words are in same byte order
+   as the AES-NI round keys.  The decryption round keys are computed from
+   the encryption round keys.  Several blocks are processed in parallel in
+   CBC decryption and CTR mode. */
+
+#if defined(__GNUC__) && (__GNUC__ >= 5 || defined(__clang__)) &&	\
+  (defined(SILC_X86_64) || defined(SILC_I486))
+#define SILC_AES_NI
+
+#include <cpuid.h>
+#include <wmmintrin.h>
+
+#define SILC_AES_NI_TARGET __attribute__((target("aes,sse2")))
+
+/* -1 if not checked yet, 0 if AES-NI is not supported and 1 if it is. */
+static int silc_aes_ni = -1;
+
+/* Returns TRUE if the CPU supports AES-NI instructions. */
+
+static SilcBool silc_aes_ni_supported(void)
+{
+  unsigned int eax, ebx, ecx, edx;
+
+  if (silc_aes_ni < 0) {
+    silc_aes_ni = 0;
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_AES) &&
+	(edx & bit_SSE2))
+      silc_aes_ni = 1;
+    SILC_LOG_DEBUG(("AES-NI %s", silc_aes_ni ? "supported" :
+		    "not supported"));
+  }
+
+  return silc_aes_ni;
+}
+
+/* Number of rounds from the key schedule */
+#define SILC_AES_NI_ROUNDS(cx) ((cx)->inf.b[0] >> 4)
+
+/* Encrypts or decrypts block `x' with round keys `k' */
+#define SILC_AES_NI_BLOCK(x, k, rounds, op, oplast)			\
+do {									\
+  int r;								\
+  x = _mm_xor_si128(x, k[0]);						\
+  for (r = 1; r < rounds; r++)						\
+    x = op(x, k[r]);							\
+  x = oplast(x, k[rounds]);						\
+} while(0)
+
+/* Encrypts or decrypts four blocks in parallel */
+#define SILC_AES_NI_BLOCK4(x0, x1, x2, x3, k, rounds, op, oplast)	\
+do {									\
+  int r;								\
+  x0 = _mm_xor_si128(x0, k[0]);						\
+  x1 = _mm_xor_si128(x1, k[0]);						\
+  x2 = _mm_xor_si128(x2, k[0]);						\
+  x3 = _mm_xor_si128(x3, k[0]);						\
+  for (r = 1; r < rounds; r++) {					\
+    x0 = op(x0, k[r]);							\
+    x1 = op(x1, k[r]);							\
+    x2 = op(x2, k[r]);							\
+    x3 = op(x3, k[r]);							\
+  }									\
+  x0 = oplast(x0, k[rounds]);						\
+  x1 = oplast(x1, k[rounds]);						\
+  x2 = oplast(x2, k[rounds]);						\
+  x3 = oplast(x3, k[rounds]);						\
+} while(0)
+
+/* Loads the round keys */
+
+static inline SILC_AES_NI_TARGET
+int silc_aes_ni_load_key(const uint_32t *ks, int rounds, __m128i *k)
+{
+  int i;
+
+  for (i = 0; i <= rounds; i++)
+    k[i] = _mm_loadu_si128((const __m128i *)(ks + 4 * i));
+
+  return rounds;
+}
+
+/* Computes the decryption key schedule from the encryption key schedule
+   in `cx'.  The key schedule is replaced with the decryption key
+   schedule. */
+
+static SILC_AES_NI_TARGET void silc_aes_ni_decrypt_key(aes_encrypt_ctx *cx)
+{
+  __m128i k[15];
+  int i, rounds = SILC_AES_NI_ROUNDS(cx);
+
+  silc_aes_ni_load_key(cx->ks, rounds, k);
+
+  _mm_storeu_si128((__m128i *)cx->ks, k[rounds]);
+  for (i = 1; i < rounds; i++)
+    _mm_storeu_si128((__m128i *)(cx->ks + 4 * i),
+		     _mm_aesimc_si128(k[rounds - i]));
+  _mm_storeu_si128((__m128i *)(cx->ks + 4 * rounds), k[0]);
+
+  memset(k, 0, sizeof(k));
+}
+
+/* CBC encryption */
+
+static SILC_AES_NI_TARGET
+void silc_aes_ni_cbc_encrypt(aes_encrypt_ctx *cx, const unsigned char *src,
+			     unsigned char *dst, SilcUInt32 len,
+			     unsigned char *iv)
+{
+  __m128i k[15], x;
+  int rounds = silc_aes_ni_load_key(cx->ks, SILC_AES_NI_ROUNDS(cx), k);
+
+  x = _mm_loadu_si128((__m128i *)iv);
+  for (; len; len -= 16, src += 16, dst += 16) {
+    x = _mm_xor_si128(x, _mm_loadu_si128((const __m128i *)src));
+    SILC_AES_NI_BLOCK(x, k, rounds, _mm_aesenc_si128, _mm_aesenclast_si128);
+    _mm_storeu_si128((__m128i *)dst, x);
+  }
+  _mm_storeu_si128((__m128i *)iv, x);
+}
+
+/* CBC decryption, four blocks in parallel */
+
+static SILC_AES_NI_TARGET
+void silc_aes_ni_cbc_decrypt(aes_decrypt_ctx *cx, const unsigned char *src,
+			     unsigned char *dst, SilcUInt32 len,
+			     unsigned char *iv)
+{
+  __m128i k[15], prev, c0, c1, c2, c3, x0, x1, x2, x3;
+  int rounds = silc_aes_ni_load_key(cx->ks, SILC_AES_NI_ROUNDS(cx), k);
+
+  prev = _mm_loadu_si128((__m128i *)iv);
+
+  for (; len >= 64; len -= 64, src += 64, dst += 64) {
+    x0 = c0 = _mm_loadu_si128((const __m128i *)src);
+    x1 = c1 = _mm_loadu_si128((const __m128i *)(src + 16));
+    x2 = c2 = _mm_loadu_si128((const __m128i *)(src + 32));
+    x3 = c3 = _mm_loadu_si128((const __m128i *)(src + 48));
+    SILC_AES_NI_BLOCK4(x0, x1, x2, x3, k, rounds, _mm_aesdec_si128,
+		       _mm_aesdeclast_si128);
+    _mm_storeu_si128((__m128i *)dst, _mm_xor_si128(x0, prev));
+    _mm_storeu_si128((__m128i *)(dst + 16), _mm_xor_si128(x1, c0));
+    _mm_storeu_si128((__m128i *)(dst + 32), _mm_xor_si128(x2, c1));
+    _mm_storeu_si128((__m128i *)(dst + 48), _mm_xor_si128(x3, c2));
+    prev = c3;
+  }
+
+  for (; len; len -= 16, src += 16, dst += 16) {
+    x0 = c0 = _mm_loadu_si128((const __m128i *)src);
+    SILC_AES_NI_BLOCK(x0, k, rounds, _mm_aesdec_si128,
+		      _mm_aesdeclast_si128);
+    _mm_storeu_si128((__m128i *)dst, _mm_xor_si128(x0, prev));
+    prev = c0;
+  }
+
+  _mm_storeu_si128((__m128i *)iv, prev);
+}
+
+/* Increments MSB first ordered 128-bit counter */
+#define SILC_AES_CTR_INC(iv)			\
+do {						\
+  int k;					\
+  for (k = 15; k >= 0; k--)			\
+    if (++(iv)[k])				\
+      break;					\
+} while(0)
+
+/* CTR mode encryption, four blocks in parallel.  Full blocks are
+   encrypted in parallel and the last partial block is saved to the
+   context as in silc_aes_ctr_encrypt. */
+
+static SILC_AES_NI_TARGET
+void silc_aes_ni_ctr_encrypt(aes_encrypt_ctx *cx, const unsigned char *src,
+			     unsigned char *dst, SilcUInt32 len,
+			     unsigned char *iv)
+{
+  __m128i k[15], x0, x1, x2, x3;
+  int i, rounds;
+
+  i = cx->inf.b[2];
+  if (!i)
+    i = 16;
+
+  /* Use rest of the previous key stream block */
+  while (i < 16 && len) {
+    *dst++ = *src++ ^ cx->pad[i++];
+    len--;
+  }
+  if (!len) {
+    cx->inf.b[2] = i;
+    return;
+  }
+
+  rounds = silc_aes_ni_load_key(cx->ks, SILC_AES_NI_ROUNDS(cx), k);
+
+  for (; len >= 64; len -= 64, src += 64, dst += 64) {
+    SILC_AES_CTR_INC(iv);
+    x0 = _mm_loadu_si128((__m128i *)iv);
+    SILC_AES_CTR_INC(iv);
+    x1 = _mm_loadu_si128((__m128i *)iv);
+    SILC_AES_CTR_INC(iv);
+    x2 = _mm_loadu_si128((__m128i *)iv);
+    SILC_AES_CTR_INC(iv);
+    x3 = _mm_loadu_si128((__m128i *)iv);
+    SILC_AES_NI_BLOCK4(x0, x1, x2, x3, k, rounds, _mm_aesenc_si128,
+		       _mm_aesenclast_si128);
+    x0 = _mm_xor_si128(x0, _mm_loadu_si128((const __m128i *)src));
+    x1 = _mm_xor_si128(x1, _mm_loadu_si128((const __m128i *)(src + 16)));
+    x2 = _mm_xor_si128(x2, _mm_loadu_si128((const __m128i *)(src + 32)));
+    x3 = _mm_xor_si128(x3, _mm_loadu_si128((const __m128i *)(src + 48)));
+    _mm_storeu_si128((__m128i *)dst, x0);
+    _mm_storeu_si128((__m128i *)(dst + 16), x1);
+    _mm_storeu_si128((__m128i *)(dst + 32), x2);
+    _mm_storeu_si128((__m128i *)(dst + 48), x3);
+  }
+
+  for (; len >= 16; len -= 16, src += 16, dst += 16) {
+    SILC_AES_CTR_INC(iv);
+    x0 = _mm_loadu_si128((__m128i *)iv);
+    SILC_AES_NI_BLOCK(x0, k, rounds, _mm_aesenc_si128, _mm_aesenclast_si128);
+    x0 = _mm_xor_si128(x0, _mm_loadu_si128((const __m128i *)src));
+    _mm_storeu_si128((__m128i *)dst, x0);
+  }
+
+  /* Last partial block */
+  if (len) {
+    SILC_AES_CTR_INC(iv);
+    x0 = _mm_loadu_si128((__m128i *)iv);
+    SILC_AES_NI_BLOCK(x0, k, rounds, _mm_aesenc_si128, _mm_aesenclast_si128);
+    _mm_storeu_si128((__m128i *)cx->pad, x0);
+    for (i = 0; len; len--)
+      *dst++ = *src++ ^ cx->pad[i++];
+  }
+
+  cx->inf.b[2] = i;
+}
+
+#endif /* SILC_AES_NI */
+
 /* CBC mode */
 
 /* Sets the key for the cipher. */
 
 SILC_CIPHER_API_SET_KEY(aes_cbc)
 {
+#ifdef SILC_AES_NI
+  if (silc_aes_ni_supported()) {
+    aes_encrypt_key(key, keylen, &((AesContext *)context)->u.enc);
+    if (!encryption)
+      silc_aes_ni_decrypt_key(&((AesContext *)context)->u.enc);
+    return TRUE;
+  }
+#endif /* SILC_AES_NI */
+
   if (encryption)
     aes_encrypt_key(key, keylen, &((AesContext *)context)->u.enc);
   else
@@ -80,6 +331,14 @@ SILC_CIPHER_API_ENCRYPT(aes_cbc)
   if (len & (16 - 1))
     return FALSE;
 
+#ifdef SILC_AES_NI
+  if (silc_aes_ni > 0) {
+    silc_aes_ni_cbc_encrypt(&((AesContext *)context)->u.enc, src, dst,
+			    len, iv);
+    return TRUE;
+  }
+#endif /* SILC_AES_NI */
+
   while(nb--) {
     SILC_GET32_MSB(tmp[0], &iv[0]);
     SILC_GET32_MSB(tmp[1], &iv[4]);
@@ -123,6 +382,14 @@ SILC_CIPHER_API_DECRYPT(aes_cbc)
   if (len & (16 - 1))
     return FALSE;
 
+#ifdef SILC_AES_NI
+  if (silc_aes_ni > 0) {
+    silc_aes_ni_cbc_decrypt(&((AesContext *)context)->u.dec, src, dst,
+			    len, iv);
+    return TRUE;
+  }
+#endif /* SILC_AES_NI */
+
   while(nb--) {
     memcpy(tmp, src, 16);
     aes_decrypt(src, dst, &((AesContext *)context)->u.dec);
@@ -164,6 +431,9 @@ SILC_CIPHER_API_SET_KEY(aes_ctr)
   AesContext *aes = context;
   memset(&aes->u.enc, 0, sizeof(aes->u.enc));
   aes_encrypt_key(key, keylen, &aes->u.enc);
+#ifdef SILC_AES_NI
+  silc_aes_ni_supported();
+#endif /* SILC_AES_NI */
   return TRUE;
 }
 
@@ -192,6 +462,13 @@ SILC_CIPHER_API_ENCRYPT(aes_ctr)
   AesContext *aes = context;
   int i, k;
 
+#ifdef SILC_AES_NI
+  if (silc_aes_ni > 0) {
+    silc_aes_ni_ctr_encrypt(&aes->u.enc, src, dst, len, iv);
+    return TRUE;
+  }
+#endif /* SILC_AES_NI */
+
   i = aes->u.enc.inf.b[2];
   if (!i)
     i = 16;
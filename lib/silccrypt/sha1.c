@@ -49,6 +49,115 @@ void SHA1Init(SHA1_CTX* context)
   context->count[0] = context->count[1] = 0;
 }
 
+/* SHA-1 with Intel SHA extensions.  Used if the CPU supports them.  Other
+   CPUs use the portable code.  Unlike SHA-256, SHA-1 gains nothing from
+   computing the message schedule with SSSE3, because its rounds are bound
+   by the dependency chain through `a' and `e', and the scalar schedule
+   runs in parallel with it. */
+
+#if defined(__GNUC__) && (__GNUC__ >= 5 || defined(__clang__)) &&	\
+  (defined(SILC_X86_64) || defined(SILC_I486))
+#define SILC_SHA1_NI
+
+#include <cpuid.h>
+#include <immintrin.h>
+
+#define SILC_SHA_NI_TARGET __attribute__((target("sha,sse4.1,ssse3")))
+
+/* -1 if not checked yet, 0 if SHA extensions are not supported and 1 if
+   they are. */
+static int silc_sha1_ni = -1;
+
+static SilcBool silc_sha1_ni_supported(void)
+{
+  unsigned int eax, ebx, ecx, edx;
+
+  if (silc_sha1_ni < 0) {
+    silc_sha1_ni = 0;
+    if (__get_cpuid_max(0, NULL) >= 7 &&
+	__get_cpuid(1, &eax, &ebx, &ecx, &edx) &&
+	(ecx & bit_SSE4_1) && (ecx & bit_SSSE3)) {
+      __cpuid_count(7, 0, eax, ebx, ecx, edx);
+      if (ebx & bit_SHA)
+	silc_sha1_ni = 1;
+    }
+  }
+
+  return silc_sha1_ni;
+}
+
+/* Four rounds.  Computes also the message schedule for later rounds. */
+#define SHA1_NI_ROUNDS4(e, enext, cur, next, prev, prev2, f)	\
+  e = _mm_sha1nexte_epu32(e, cur);				\
+  enext = abcd;							\
+  next = _mm_sha1msg2_epu32(next, cur);				\
+  abcd = _mm_sha1rnds4_epu32(abcd, e, f);			\
+  prev = _mm_sha1msg1_epu32(prev, cur);				\
+  prev2 = _mm_xor_si128(prev2, cur);
+
+static SILC_SHA_NI_TARGET
+void silc_sha1_ni_transform(SilcUInt32 *state, const unsigned char *data)
+{
+  const __m128i mask = _mm_set_epi64x(0x0001020304050607ULL,
+				      0x08090a0b0c0d0e0fULL);
+  __m128i abcd, abcd_save, e0, e0_save, e1, m0, m1, m2, m3;
+
+  abcd = _mm_loadu_si128((const __m128i *)state);
+  abcd = _mm_shuffle_epi32(abcd, 0x1b);
+  e0 = _mm_set_epi32(state[4], 0, 0, 0);
+  abcd_save = abcd;
+  e0_save = e0;
+
+  /* Rounds 0-15 */
+  m0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)data), mask);
+  e0 = _mm_add_epi32(e0, m0);
+  e1 = abcd;
+  abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+
+  m1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 16)), mask);
+  e1 = _mm_sha1nexte_epu32(e1, m1);
+  e0 = abcd;
+  abcd = _mm_sha1rnds4_epu32(abcd, e1, 0);
+  m0 = _mm_sha1msg1_epu32(m0, m1);
+
+  m2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 32)), mask);
+  e0 = _mm_sha1nexte_epu32(e0, m2);
+  e1 = abcd;
+  abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+  m1 = _mm_sha1msg1_epu32(m1, m2);
+  m0 = _mm_xor_si128(m0, m2);
+
+  m3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 48)), mask);
+  SHA1_NI_ROUNDS4(e1, e0, m3, m0, m2, m1, 0);
+
+  /* Rounds 16-79 */
+  SHA1_NI_ROUNDS4(e0, e1, m0, m1, m3, m2, 0);
+  SHA1_NI_ROUNDS4(e1, e0, m1, m2, m0, m3, 1);
+  SHA1_NI_ROUNDS4(e0, e1, m2, m3, m1, m0, 1);
+  SHA1_NI_ROUNDS4(e1, e0, m3, m0, m2, m1, 1);
+  SHA1_NI_ROUNDS4(e0, e1, m0, m1, m3, m2, 1);
+  SHA1_NI_ROUNDS4(e1, e0, m1, m2, m0, m3, 1);
+  SHA1_NI_ROUNDS4(e0, e1, m2, m3, m1, m0, 2);
+  SHA1_NI_ROUNDS4(e1, e0, m3, m0, m2, m1, 2);
+  SHA1_NI_ROUNDS4(e0, e1, m0, m1, m3, m2, 2);
+  SHA1_NI_ROUNDS4(e1, e0, m1, m2, m0, m3, 2);
+  SHA1_NI_ROUNDS4(e0, e1, m2, m3, m1, m0, 2);
+  SHA1_NI_ROUNDS4(e1, e0, m3, m0, m2, m1, 3);
+  SHA1_NI_ROUNDS4(e0, e1, m0, m1, m3, m2, 3);
+  SHA1_NI_ROUNDS4(e1, e0, m1, m2, m0, m3, 3);
+  SHA1_NI_ROUNDS4(e0, e1, m2, m3, m1, m0, 3);
+  SHA1_NI_ROUNDS4(e1, e0, m3, m0, m2, m1, 3);
+
+  /* Add the working vars back into state */
+  e0 = _mm_sha1nexte_epu32(e0, e0_save);
+  abcd = _mm_add_epi32(abcd, abcd_save);
+  abcd = _mm_shuffle_epi32(abcd, 0x1b);
+  _mm_storeu_si128((__m128i *)state, abcd);
+  state[4] = _mm_extract_epi32(e0, 3);
+}
+
+#endif /* SILC_SHA1_NI */
+
 #define rol(x, nr) (((x) << ((SilcUInt32)(nr))) | ((x) >> (32 - (SilcUInt32)(nr))))
 
 #define GET_WORD(cp) ((SilcUInt32)(SilcUInt8)(cp)[0]) << 24	\
@@ -74,14 +183,22 @@ void SHA1Init(SHA1_CTX* context)
 void SHA1Transform(SilcUInt32 *state, const unsigned char *data)
 {
   SilcUInt32 W[16];
-  
+  SilcUInt32 a, b, c, d, e;
+
+#ifdef SILC_SHA1_NI
+  if (silc_sha1_ni_supported()) {
+    silc_sha1_ni_transform(state, data);
+    return;
+  }
+#endif /* SILC_SHA1_NI */
+
   /* Copy context->state[] to working vars */
-  SilcUInt32 a = state[0];
-  SilcUInt32 b = state[1];
-  SilcUInt32 c = state[2];
-  SilcUInt32 d = state[3];
-  SilcUInt32 e = state[4];
-  
+  a = state[0];
+  b = state[1];
+  c = state[2];
+  d = state[3];
+  e = state[4];
+
   /* 4 rounds of 20 operations each. Loop unrolled. */
   R0(a,b,c,d,e, 0); R0(e,a,b,c,d, 1); R0(d,e,a,b,c, 2); R0(c,d,e,a,b, 3);
   R0(b,c,d,e,a, 4); R0(a,b,c,d,e, 5); R0(e,a,b,c,d, 6); R0(d,e,a,b,c, 7);
@@ -141,6 +258,7 @@ void SHA1Update(SHA1_CTX* context, unsigned char* data, SilcUInt32 len)
 
 void SHA1Final(unsigned char digest[20], SHA1_CTX* context)
 {
+  static const unsigned char padding[64] = { 0x80 };
   SilcUInt32 i, j;
   unsigned char finalcount[8];
   
@@ -148,10 +266,10 @@ void SHA1Final(unsigned char digest[20], SHA1_CTX* context)
     finalcount[i] = (unsigned char)((context->count[(i >= 4 ? 0 : 1)] 
 				     >> ((3 - (i & 3)) * 8)) & 255);
   }
-  SHA1Update(context, (unsigned char *)"\200", 1);
-  while ((context->count[0] & 504) != 448) {
-    SHA1Update(context, (unsigned char *)"\0", 1);
-  }
+
+  /* Pad to 56 mod 64 bytes with one call */
+  j = (context->count[0] >> 3) & 63;
+  SHA1Update(context, (unsigned char *)padding, j < 56 ? 56 - j : 120 - j);
   
   SHA1Update(context, finalcount, 8);  /* Should cause a SHA1Transform() */
   for (i = 0; i < 20; i++) {
@@ -165,5 +283,4 @@ void SHA1Final(unsigned char digest[20], SHA1_CTX* context)
   memset(context->state, 0, 20);
   memset(context->count, 0, 8);
   memset(finalcount, 0, 8);
-  SHA1Transform(context->state, context->buffer);
 }
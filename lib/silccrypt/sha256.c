@@ -43,6 +43,136 @@ SILC_HASH_API_CONTEXT_LEN(sha256)
   return sizeof(sha256_state);
 }
 
+/* SHA-256 with Intel SHA extensions, or with SSSE3 message schedule on
+   CPUs that do not have SHA extensions.  The implementation is selected
+   on the first call. */
+
+#if defined(__GNUC__) && (__GNUC__ >= 5 || defined(__clang__)) &&	\
+  (defined(SILC_X86_64) || defined(SILC_I486))
+#define SILC_SHA256_NI
+
+#include <cpuid.h>
+#include <immintrin.h>
+
+#define SILC_SHA_NI_TARGET __attribute__((target("sha,sse4.1,ssse3")))
+#define SILC_SHA_SSSE3_TARGET __attribute__((target("ssse3")))
+
+/* SHA-256 implementations */
+#define SILC_SHA256_C      0	/* Portable C */
+#define SILC_SHA256_SSSE3  1	/* SSSE3 message schedule */
+#define SILC_SHA256_SHA    2	/* SHA extensions */
+
+/* Selected implementation, -1 if not checked yet */
+static int silc_sha256_impl = -1;
+
+static int silc_sha256_select(void)
+{
+  unsigned int eax, ebx, ecx, edx;
+
+  if (silc_sha256_impl < 0) {
+    silc_sha256_impl = SILC_SHA256_C;
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_SSSE3)) {
+      silc_sha256_impl = SILC_SHA256_SSSE3;
+      if (__get_cpuid_max(0, NULL) >= 7 && (ecx & bit_SSE4_1)) {
+	__cpuid_count(7, 0, eax, ebx, ecx, edx);
+	if (ebx & bit_SHA)
+	  silc_sha256_impl = SILC_SHA256_SHA;
+      }
+    }
+  }
+
+  return silc_sha256_impl;
+}
+
+static const SilcUInt32 silc_sha256_k[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+  0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+  0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+  0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+  0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+  0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+  0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+  0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+  0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+/* Four rounds with message words `cur' */
+#define SHA256_NI_ROUNDS4(cur, i)					\
+  msg = _mm_add_epi32(cur, _mm_loadu_si128((const __m128i *)		\
+					   &silc_sha256_k[4 * (i)]));	\
+  state1 = _mm_sha256rnds2_epu32(state1, state0, msg);			\
+  msg = _mm_shuffle_epi32(msg, 0x0e);					\
+  state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+
+/* Four rounds.  Computes also the message schedule for later rounds. */
+#define SHA256_NI_ROUNDS4_MSG(cur, next, prev, i)			\
+  SHA256_NI_ROUNDS4(cur, i);						\
+  next = _mm_add_epi32(next, _mm_alignr_epi8(cur, prev, 4));		\
+  next = _mm_sha256msg2_epu32(next, cur);				\
+  prev = _mm_sha256msg1_epu32(prev, cur);
+
+static SILC_SHA_NI_TARGET
+void silc_sha256_ni_compress(SilcUInt32 *state, const unsigned char *buf)
+{
+  const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL,
+				      0x0405060700010203ULL);
+  __m128i state0, state1, abef_save, cdgh_save, msg, tmp, m0, m1, m2, m3;
+
+  /* Reorder the state to ABEF and CDGH */
+  tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)state), 0xb1);
+  state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)(state + 4)),
+			     0x1b);
+  state0 = _mm_alignr_epi8(tmp, state1, 8);
+  state1 = _mm_blend_epi16(state1, tmp, 0xf0);
+  abef_save = state0;
+  cdgh_save = state1;
+
+  /* Rounds 0-15 */
+  m0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)buf), mask);
+  SHA256_NI_ROUNDS4(m0, 0);
+  m1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(buf + 16)), mask);
+  SHA256_NI_ROUNDS4(m1, 1);
+  m0 = _mm_sha256msg1_epu32(m0, m1);
+  m2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(buf + 32)), mask);
+  SHA256_NI_ROUNDS4(m2, 2);
+  m1 = _mm_sha256msg1_epu32(m1, m2);
+  m3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(buf + 48)), mask);
+  SHA256_NI_ROUNDS4_MSG(m3, m0, m2, 3);
+
+  /* Rounds 16-63 */
+  SHA256_NI_ROUNDS4_MSG(m0, m1, m3, 4);
+  SHA256_NI_ROUNDS4_MSG(m1, m2, m0, 5);
+  SHA256_NI_ROUNDS4_MSG(m2, m3, m1, 6);
+  SHA256_NI_ROUNDS4_MSG(m3, m0, m2, 7);
+  SHA256_NI_ROUNDS4_MSG(m0, m1, m3, 8);
+  SHA256_NI_ROUNDS4_MSG(m1, m2, m0, 9);
+  SHA256_NI_ROUNDS4_MSG(m2, m3, m1, 10);
+  SHA256_NI_ROUNDS4_MSG(m3, m0, m2, 11);
+  SHA256_NI_ROUNDS4_MSG(m0, m1, m3, 12);
+  SHA256_NI_ROUNDS4_MSG(m1, m2, m0, 13);
+  SHA256_NI_ROUNDS4_MSG(m2, m3, m1, 14);
+  SHA256_NI_ROUNDS4(m3, 15);
+
+  /* Add back to state and reorder to ABCD and EFGH */
+  state0 = _mm_add_epi32(state0, abef_save);
+  state1 = _mm_add_epi32(state1, cdgh_save);
+  tmp = _mm_shuffle_epi32(state0, 0x1b);
+  state1 = _mm_shuffle_epi32(state1, 0xb1);
+  state0 = _mm_blend_epi16(tmp, state1, 0xf0);
+  state1 = _mm_alignr_epi8(state1, tmp, 8);
+  _mm_storeu_si128((__m128i *)state, state0);
+  _mm_storeu_si128((__m128i *)(state + 4), state1);
+}
+
+#endif /* SILC_SHA256_NI */
+
 #if defined(_MSC_VER)
 #pragma intrinsic(_lrotr,_lrotl)
 #define RORc(x,n) _lrotr(x,n)
@@ -71,12 +201,123 @@ static inline unsigned RORc(unsigned word, int i)
 #define Gamma0(x)       (S(x, 7) ^ S(x, 18) ^ R(x, 3))
 #define Gamma1(x)       (S(x, 17) ^ S(x, 19) ^ R(x, 10))
 
+#ifdef SILC_SHA256_NI
+/* Round with W[i] + K[i] already computed to WK[i] */
+#define RW(a,b,c,d,e,f,g,h,i)                        \
+     t0 = h + Sigma1(e) + Ch(e, f, g) + WK[i];       \
+     t1 = Sigma0(a) + Maj(a, b, c);                  \
+     d += t0;                                        \
+     h  = t0 + t1;
+
+/* Rotate right all four words of `x' by `n' bits, and the SHA-256
+   Gamma functions on four words */
+#define SHA256_SSSE3_ROR(x, n)						\
+  _mm_or_si128(_mm_srli_epi32(x, n), _mm_slli_epi32(x, 32 - (n)))
+#define SHA256_SSSE3_GAMMA0(x)						\
+  _mm_xor_si128(_mm_xor_si128(SHA256_SSSE3_ROR(x, 7),			\
+			      SHA256_SSSE3_ROR(x, 18)),			\
+		_mm_srli_epi32(x, 3))
+#define SHA256_SSSE3_GAMMA1(x)						\
+  _mm_xor_si128(_mm_xor_si128(SHA256_SSSE3_ROR(x, 17),			\
+			      SHA256_SSSE3_ROR(x, 19)),			\
+		_mm_srli_epi32(x, 10))
+
+/* Store W[i..i + 3] + K[i..i + 3] from `x' to WK[i..i + 3] */
+#define SHA256_SSSE3_WK(i, x)						\
+  _mm_store_si128((__m128i *)&WK[i],					\
+		  _mm_add_epi32(x, _mm_loadu_si128((const __m128i *)	\
+						   &silc_sha256_k[i])))
+
+/* SHA-256 with the message schedule computed four words at a time with
+   SSSE3.  The rounds are the same as in the portable code. */
+
+static SILC_SHA_SSSE3_TARGET
+void silc_sha256_ssse3_compress(SilcUInt32 *state, const unsigned char *buf)
+{
+  const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL,
+				      0x0405060700010203ULL);
+  SilcUInt32 WK[64] __attribute__((aligned(16)));
+  SilcUInt32 a, b, c, d, e, f, g, h, t0, t1;
+  __m128i w0, w1, w2, w3, x;
+  int i;
+
+  /* W[0..15] */
+  w0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)buf), mask);
+  w1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(buf + 16)), mask);
+  w2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(buf + 32)), mask);
+  w3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(buf + 48)), mask);
+  SHA256_SSSE3_WK(0, w0);
+  SHA256_SSSE3_WK(4, w1);
+  SHA256_SSSE3_WK(8, w2);
+  SHA256_SSSE3_WK(12, w3);
+
+  /* W[16..63].  W[i + 2] and W[i + 3] need Gamma1 of W[i] and W[i + 1]
+     computed in the same step, so the upper half is finished after the
+     lower half. */
+  for (i = 16; i < 64; i += 4) {
+    x = _mm_add_epi32(_mm_add_epi32(w0, _mm_alignr_epi8(w3, w2, 4)),
+		      SHA256_SSSE3_GAMMA0(_mm_alignr_epi8(w1, w0, 4)));
+    x = _mm_add_epi32(x, SHA256_SSSE3_GAMMA1(_mm_srli_si128(w3, 8)));
+    x = _mm_add_epi32(x, _mm_unpacklo_epi64(_mm_setzero_si128(),
+					    SHA256_SSSE3_GAMMA1(x)));
+
+    w0 = w1;
+    w1 = w2;
+    w2 = w3;
+    w3 = x;
+    SHA256_SSSE3_WK(i, x);
+  }
+
+  a = state[0];
+  b = state[1];
+  c = state[2];
+  d = state[3];
+  e = state[4];
+  f = state[5];
+  g = state[6];
+  h = state[7];
+
+  for (i = 0; i < 64; i += 8) {
+    RW(a,b,c,d,e,f,g,h,i);
+    RW(h,a,b,c,d,e,f,g,i+1);
+    RW(g,h,a,b,c,d,e,f,i+2);
+    RW(f,g,h,a,b,c,d,e,i+3);
+    RW(e,f,g,h,a,b,c,d,i+4);
+    RW(d,e,f,g,h,a,b,c,i+5);
+    RW(c,d,e,f,g,h,a,b,i+6);
+    RW(b,c,d,e,f,g,h,a,i+7);
+  }
+
+  state[0] += a;
+  state[1] += b;
+  state[2] += c;
+  state[3] += d;
+  state[4] += e;
+  state[5] += f;
+  state[6] += g;
+  state[7] += h;
+}
+
+#undef RW
+#endif /* SILC_SHA256_NI */
+
 /* compress 512-bits */
 int  sha256_compress(SilcUInt32 *state, unsigned char *buf)
 {
     SilcUInt32 S[8], W[64], t0, t1;
     int i;
 
+#ifdef SILC_SHA256_NI
+    switch (silc_sha256_select()) {
+    case SILC_SHA256_SHA:
+	silc_sha256_ni_compress(state, buf);
+	return TRUE;
+    case SILC_SHA256_SSSE3:
+	silc_sha256_ssse3_compress(state, buf);
+	return TRUE;
+    }
+#endif /* SILC_SHA256_NI */
+
     /* copy state into S */
     for (i = 0; i < 8; i++) {
         S[i] = state[i];
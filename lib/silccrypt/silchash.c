@@ -396,6 +396,24 @@ void silc_hash_transform(SilcHash hash, SilcUInt32 *state,
   hash->hash->transform(state, data);
 }
 
+/* Returns the size of the hash context.  The hash contexts do not have
+   pointers so the state can be saved and restored by copying it. */
+
+SilcUInt32 silc_hash_state_len(SilcHash hash)
+{
+  return hash->hash->context_len();
+}
+
+void silc_hash_save_state(SilcHash hash, void *state)
+{
+  memcpy(state, hash->context, hash->hash->context_len());
+}
+
+void silc_hash_restore_state(SilcHash hash, const void *state)
+{
+  memcpy(hash->context, state, hash->hash->context_len());
+}
+
 /* Creates fingerprint of the data. If `hash' is NULL SHA1 is used as
    default hash function. The returned fingerprint must be freed by the
    caller. */
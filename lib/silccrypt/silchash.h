@@ -410,6 +410,62 @@ void silc_hash_final(SilcHash hash, unsigned char *return_hash);
 void silc_hash_transform(SilcHash hash, SilcUInt32 *state,
 			 const unsigned char *data);
 
+/****f* silccrypt/SilcHashAPI/silc_hash_state_len
+ *
+ * SYNOPSIS
+ *
+ *    SilcUInt32 silc_hash_state_len(SilcHash hash);
+ *
+ * DESCRIPTION
+ *
+ *    Returns the size of the hash function's context in bytes.  This is
+ *    the size of the buffer needed by silc_hash_save_state.
+ *
+ ***/
+SilcUInt32 silc_hash_state_len(SilcHash hash);
+
+/****f* silccrypt/SilcHashAPI/silc_hash_save_state
+ *
+ * SYNOPSIS
+ *
+ *    void silc_hash_save_state(SilcHash hash, void *state);
+ *
+ * DESCRIPTION
+ *
+ *    Saves the current state of the hash function context to `state',
+ *    which must be at least silc_hash_state_len bytes.  The state can
+ *    be restored to any hash context of same hash function with the
+ *    silc_hash_restore_state.  This can be used to compute the hash of
+ *    common prefix of data only once.
+ *
+ * EXAMPLE
+ *
+ *    silc_hash_init(hash);
+ *    silc_hash_update(hash, prefix, prefix_len);
+ *    silc_hash_save_state(hash, state);
+ *    ...
+ *    silc_hash_restore_state(hash, state);
+ *    silc_hash_update(hash, data, data_len);
+ *    silc_hash_final(hash, digest);
+ *
+ ***/
+void silc_hash_save_state(SilcHash hash, void *state);
+
+/****f* silccrypt/SilcHashAPI/silc_hash_restore_state
+ *
+ * SYNOPSIS
+ *
+ *    void silc_hash_restore_state(SilcHash hash, const void *state);
+ *
+ * DESCRIPTION
+ *
+ *    Restores the hash function context from the `state' saved earlier
+ *    with silc_hash_save_state.  This is used instead of silc_hash_init
+ *    to continue computing the hash from the saved state.
+ *
+ ***/
+void silc_hash_restore_state(SilcHash hash, const void *state);
+
 /****f* silccrypt/SilcHashAPI/silc_hash_fingerprint
  *
  * SYNOPSIS
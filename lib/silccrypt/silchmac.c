@@ -27,8 +27,11 @@ struct SilcHmacStruct {
   unsigned char inner_pad[64];
   unsigned char outer_pad[64];
   unsigned char *key;
-  unsigned int key_len        : 31;
+  unsigned char *state;		     /* Hash states after inner and outer pad */
+  SilcUInt32 state_len;
+  unsigned int key_len        : 30;
   unsigned int allocated_hash : 1;   /* TRUE if the hash was allocated */
+  unsigned int outer_state    : 1;   /* Use saved outer state in final */
 };
 
 #ifndef SILC_SYMBIAN
@@ -260,6 +263,11 @@ void silc_hmac_free(SilcHmac hmac)
       silc_free(hmac->key);
     }
 
+    if (hmac->state) {
+      memset(hmac->state, 0, hmac->state_len * 2);
+      silc_free(hmac->state);
+    }
+
     silc_free(hmac);
   }
 }
@@ -355,20 +363,42 @@ char *silc_hmac_get_supported()
   return list;
 }
 
-/* Sets the HMAC key used in the HMAC creation */
+/* Sets the HMAC key used in the HMAC creation.  The hash states after
+   the inner and outer pads are computed here and saved, so that they need
+   not be computed again for every MAC. */
 
 void silc_hmac_set_key(SilcHmac hmac, const unsigned char *key,
 		       SilcUInt32 key_len)
 {
+  SilcHash hash = hmac->hash;
+
   if (hmac->key) {
     memset(hmac->key, 0, hmac->key_len);
     silc_free(hmac->key);
   }
+  if (hmac->state) {
+    memset(hmac->state, 0, hmac->state_len * 2);
+    silc_free(hmac->state);
+    hmac->state = NULL;
+  }
   hmac->key = silc_malloc(key_len);
   if (!hmac->key)
     return;
   hmac->key_len = key_len;
   memcpy(hmac->key, key, key_len);
+
+  hmac->state_len = silc_hash_state_len(hash);
+  hmac->state = silc_malloc(hmac->state_len * 2);
+  if (!hmac->state)
+    return;
+
+  silc_hmac_init_internal(hmac, hmac->key, hmac->key_len);
+  silc_hash_init(hash);
+  silc_hash_update(hash, hmac->inner_pad, silc_hash_block_len(hash));
+  silc_hash_save_state(hash, hmac->state);
+  silc_hash_init(hash);
+  silc_hash_update(hash, hmac->outer_pad, silc_hash_block_len(hash));
+  silc_hash_save_state(hash, hmac->state + hmac->state_len);
 }
 
 /* Return HMAC key */
@@ -435,6 +465,13 @@ void silc_hmac_make_truncated(SilcHmac hmac, unsigned char *data,
 
 void silc_hmac_init(SilcHmac hmac)
 {
+  /* Continue from the saved inner pad state */
+  if (hmac->state) {
+    silc_hash_restore_state(hmac->hash, hmac->state);
+    hmac->outer_state = TRUE;
+    return;
+  }
+
   silc_hmac_init_with_key(hmac, hmac->key, hmac->key_len);
 }
 
@@ -444,6 +481,7 @@ void silc_hmac_init_with_key(SilcHmac hmac, const unsigned char *key,
 			     SilcUInt32 key_len)
 {
   SilcHash hash = hmac->hash;
+  hmac->outer_state = FALSE;
   silc_hmac_init_internal(hmac, (unsigned char *)key, key_len);
   silc_hash_init(hash);
   silc_hash_update(hash, hmac->inner_pad, silc_hash_block_len(hash));
@@ -467,8 +505,12 @@ void silc_hmac_final(SilcHmac hmac, unsigned char *return_hash,
   unsigned char mac[SILC_HASH_MAXLEN];
 
   silc_hash_final(hash, mac);
-  silc_hash_init(hash);
-  silc_hash_update(hash, hmac->outer_pad, silc_hash_block_len(hash));
+  if (hmac->outer_state) {
+    silc_hash_restore_state(hash, hmac->state + hmac->state_len);
+  } else {
+    silc_hash_init(hash);
+    silc_hash_update(hash, hmac->outer_pad, silc_hash_block_len(hash));
+  }
   silc_hash_update(hash, mac, silc_hash_len(hash));
   silc_hash_final(hash, mac);
   memcpy(return_hash, mac, hmac->hmac->len);
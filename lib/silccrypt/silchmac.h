@@ -262,6 +262,10 @@ const char *silc_hmac_get_name(SilcHmac hmac);
  *    calling the silc_hmac_make_with_key where you give the key as
  *    argument.  Usually application still wants to set the key.
  *
+ *    The hash function states after the inner and outer pads of the key
+ *    are computed when the key is set, which makes computing MACs with
+ *    the key set faster than with silc_hmac_make_with_key.
+ *
  ***/
 void silc_hmac_set_key(SilcHmac hmac, const unsigned char *key,
 		       SilcUInt32 key_len);
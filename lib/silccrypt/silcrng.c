@@ -21,7 +21,7 @@
  * Created: Sun Mar  9 00:09:18 1997
  *
  * The original RNG was based on Secure Shell's random number generator
- * by Tatu Ylnen and was used as reference when programming this RNG.
+ * by Tatu Yl�nen and was used as reference when programming this RNG.
  * This RNG has been rewritten twice since the creation.
  */
 
@@ -35,6 +35,10 @@ extern pid_t getsid (pid_t __pid);
 #ifdef HAVE_GETPGID
 extern pid_t getpgid (pid_t __pid);
 #endif
+
+#ifdef HAVE_GETRANDOM
+#include <sys/random.h>
+#endif
 #endif
 
 #undef SILC_RNG_DEBUG
@@ -46,6 +50,10 @@ extern pid_t getpgid (pid_t __pid);
 /* Byte size of the random data pool. */
 #define SILC_RNG_POOLSIZE (20 * 48)
 
+/* Byte size of the fast random data buffer.  The buffer is filled from
+   the operating system with one call. */
+#define SILC_RNG_FAST_SIZE 1024
+
 static SilcUInt32 silc_rng_get_position(SilcRng rng);
 static void silc_rng_stir_pool(SilcRng rng);
 static void silc_rng_xor(SilcRng rng, SilcUInt32 val, unsigned int pos);
@@ -117,6 +125,18 @@ typedef struct SilcRngStateContext {
        noise from the environment.  More soft noise is acquired after
        64 bits of output and hard noise every 160 bits of output.
 
+   unsigned char fast[]
+   SilcUInt32 fast_pos
+
+       Buffer for fast random data and the position of next unused
+       byte in it.  The buffer is filled from the operating system's
+       random number generator when all of it has been used.  Used
+       bytes are zeroed.
+
+   SilcMutex lock
+
+       Lock for the fast random data buffer.
+
 */
 struct SilcRngStruct {
   unsigned char pool[SILC_RNG_POOLSIZE];
@@ -126,6 +146,9 @@ struct SilcRngStruct {
   SilcUInt8 threshold;
   char *devrandom;
   int fd_devurandom;
+  SilcMutex lock;
+  SilcUInt32 fast_pos;
+  unsigned char fast[SILC_RNG_FAST_SIZE];
 };
 
 /* Allocates new RNG object. */
@@ -137,7 +160,11 @@ SilcRng silc_rng_alloc(void)
   SILC_LOG_DEBUG(("Allocating new RNG object"));
 
   new = silc_calloc(1, sizeof(*new));
+  if (!new)
+    return NULL;
   new->fd_devurandom = -1;
+  new->fast_pos = sizeof(new->fast);
+  silc_mutex_alloc(&new->lock);
 
   memset(new->pool, 0, sizeof(new->pool));
   memset(new->key, 0, sizeof(new->key));
@@ -162,7 +189,9 @@ void silc_rng_free(SilcRng rng)
 
     memset(rng->pool, 0, sizeof(rng->pool));
     memset(rng->key, 0, sizeof(rng->key));
+    memset(rng->fast, 0, sizeof(rng->fast));
     silc_hash_free(rng->sha1);
+    silc_mutex_free(rng->lock);
     silc_free(rng->devrandom);
 
     if (rng->fd_devurandom != -1)
@@ -552,28 +581,104 @@ SilcUInt8 silc_rng_get_byte(SilcRng rng)
   return byte;
 }
 
-/* Return random byte as fast as possible. Reads from /dev/urandom if
-   available. If not then return from normal RNG (not so fast). */
+/* Fills the fast random data buffer from the operating system.  Uses
+   getrandom if available, otherwise reads from /dev/urandom.  Returns
+   FALSE if neither is available. */
 
-SilcUInt8 silc_rng_get_byte_fast(SilcRng rng)
+static SilcBool silc_rng_fast_fill(SilcRng rng)
 {
 #if defined(SILC_UNIX)
-  unsigned char buf[1];
+  SilcUInt32 len = 0;
+  int ret;
+
+#ifdef HAVE_GETRANDOM
+  while (len < sizeof(rng->fast)) {
+    ret = getrandom(rng->fast + len, sizeof(rng->fast) - len, 0);
+    if (ret < 0) {
+      if (errno == EINTR)
+	continue;
+      break;
+    }
+    len += ret;
+  }
+#endif /* HAVE_GETRANDOM */
 
-  if (rng->fd_devurandom == -1) {
+  if (len < sizeof(rng->fast) && rng->fd_devurandom == -1) {
     rng->fd_devurandom = open("/dev/urandom", O_RDONLY);
     if (rng->fd_devurandom < 0)
-      return silc_rng_get_byte(rng);
+      return FALSE;
     fcntl(rng->fd_devurandom, F_SETFL, O_NONBLOCK);
   }
 
-  if (read(rng->fd_devurandom, buf, sizeof(buf)) < 0)
-    return silc_rng_get_byte(rng);
+  while (len < sizeof(rng->fast)) {
+    ret = read(rng->fd_devurandom, rng->fast + len, sizeof(rng->fast) - len);
+    if (ret <= 0) {
+      if (ret < 0 && errno == EINTR)
+	continue;
+      return FALSE;
+    }
+    len += ret;
+  }
 
-  return buf[0] != 0x00 ? buf[0] : silc_rng_get_byte(rng);
+  rng->fast_pos = 0;
+  return TRUE;
 #else
-  return silc_rng_get_byte(rng);
-#endif
+  return FALSE;
+#endif /* SILC_UNIX */
+}
+
+/* Copies `len' bytes from the fast random data buffer to `buf'.  Zero
+   bytes are skipped if `nonzero' is TRUE.  If the operating system
+   random number generator is not available the data is taken from the
+   normal RNG (not so fast). */
+
+static void silc_rng_fast_get(SilcRng rng, unsigned char *buf,
+			      SilcUInt32 len, SilcBool nonzero)
+{
+  SilcUInt32 i;
+
+  silc_mutex_lock(rng->lock);
+
+  while (len) {
+    if (rng->fast_pos >= sizeof(rng->fast) && !silc_rng_fast_fill(rng)) {
+      silc_mutex_unlock(rng->lock);
+      while (len--)
+	*buf++ = silc_rng_get_byte(rng);
+      return;
+    }
+
+    for (i = rng->fast_pos; i < sizeof(rng->fast) && len; i++) {
+      if (nonzero && rng->fast[i] == 0x00)
+	continue;
+      *buf++ = rng->fast[i];
+      len--;
+    }
+
+    memset(rng->fast + rng->fast_pos, 0, i - rng->fast_pos);
+    rng->fast_pos = i;
+  }
+
+  silc_mutex_unlock(rng->lock);
+}
+
+/* Return random byte as fast as possible. Takes the byte from operating
+   system's RNG if available. If not then return from normal RNG (not so
+   fast). */
+
+SilcUInt8 silc_rng_get_byte_fast(SilcRng rng)
+{
+  unsigned char byte;
+
+  silc_rng_fast_get(rng, &byte, 1, TRUE);
+
+  return byte;
+}
+
+/* Returns `len' bytes of random data to `buf' as fast as possible. */
+
+void silc_rng_get_data_fast(SilcRng rng, unsigned char *buf, SilcUInt32 len)
+{
+  silc_rng_fast_get(rng, buf, len, FALSE);
 }
 
 /* Returns 16 bit random number */
@@ -625,13 +730,13 @@ unsigned char *silc_rng_get_rn_string(SilcRng rng, SilcUInt32 len)
 
 unsigned char *silc_rng_get_rn_data(SilcRng rng, SilcUInt32 len)
 {
-  int i;
   unsigned char *data;
 
   data = silc_calloc(len + 1, sizeof(*data));
+  if (!data)
+    return NULL;
 
-  for (i = 0; i < len; i++)
-    data[i] = silc_rng_get_byte(rng);
+  silc_rng_fast_get(rng, data, len, TRUE);
 
   return data;
 }
@@ -678,14 +783,26 @@ SilcUInt8 silc_rng_global_get_byte(void)
   return global_rng ? silc_rng_get_byte(global_rng) : 0;
 }
 
-/* Return random byte as fast as possible. Reads from /dev/urandom if
-   available. If not then return from normal RNG (not so fast). */
+/* Return random byte as fast as possible. Takes the byte from operating
+   system's RNG if available. If not then return from normal RNG (not so
+   fast). */
 
 SilcUInt8 silc_rng_global_get_byte_fast(void)
 {
   return global_rng ? silc_rng_get_byte_fast(global_rng) : 0;
 }
 
+/* Fills `buf' with `len' random bytes as fast as possible, or with zeros
+   if the global RNG is not initialized. */
+
+void silc_rng_global_get_data_fast(unsigned char *buf, SilcUInt32 len)
+{
+  if (global_rng)
+    silc_rng_get_data_fast(global_rng, buf, len);
+  else
+    memset(buf, 0, len);
+}
+
 SilcUInt16 silc_rng_global_get_rn16(void)
 {
   return global_rng ? silc_rng_get_rn16(global_rng) : 0;
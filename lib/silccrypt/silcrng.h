@@ -131,14 +131,33 @@ SilcUInt8 silc_rng_get_byte(SilcRng rng);
  *
  * NOTES
  *
- *    This will read the data from /dev/urandom if it is available in the
- *    operating system, since this may be faster than retrieving a byte
- *    from the SILC RNG.  If /dev/urandom is not available this will take
- *    the byte from SILC RNG and is effectively same as silc_rng_get_byte.
+ *    This will take the byte from the operating system's random number
+ *    generator if it is available, since this is faster than retrieving
+ *    a byte from the SILC RNG.  The data is read from the operating
+ *    system in large blocks and buffered.  If the operating system's
+ *    RNG is not available this will take the byte from SILC RNG and is
+ *    effectively same as silc_rng_get_byte.
  *
  ***/
 SilcUInt8 silc_rng_get_byte_fast(SilcRng rng);
 
+/****f* silccrypt/SilcRNGAPI/silc_rng_get_data_fast
+ *
+ * SYNOPSIS
+ *
+ *    void silc_rng_get_data_fast(SilcRng rng, unsigned char *buf,
+ *                                SilcUInt32 len);
+ *
+ * DESCRIPTION
+ *
+ *    Fills the buffer `buf' of `len' bytes with random data as fast as
+ *    possible.  Unlike the other functions the data may include zero
+ *    (0x00) bytes.  The data is taken the same way as in the function
+ *    silc_rng_get_byte_fast.
+ *
+ ***/
+void silc_rng_get_data_fast(SilcRng rng, unsigned char *buf, SilcUInt32 len);
+
 /****f* silccrypt/SilcRNGAPI/silc_rng_get_rn16
  *
  * SYNOPSIS
@@ -190,7 +209,8 @@ unsigned char *silc_rng_get_rn_string(SilcRng rng, SilcUInt32 len);
  *
  *    Returns random binary data of the length of `len' bytes.  The
  *    caller must free returned data buffer.  It is guaranteed the data
- *    buffer does not include any zero (0x00) bytes.
+ *    buffer does not include any zero (0x00) bytes.  The data is taken
+ *    the same way as in the function silc_rng_get_byte_fast.
  *
  ***/
 unsigned char *silc_rng_get_rn_data(SilcRng rng, SilcUInt32 len);
@@ -276,14 +296,32 @@ SilcUInt8 silc_rng_global_get_byte(void);
  *
  * NOTES
  *
- *    This will read the data from /dev/urandom if it is available in the
- *    operating system, since this may be faster than retrieving a byte
- *    from the SILC RNG.  If /dev/urandom is not available this will take
- *    the byte from SILC RNG and is effectively same as silc_rng_get_byte.
+ *    This will take the byte from the operating system's random number
+ *    generator if it is available, since this is faster than retrieving
+ *    a byte from the SILC RNG.  The data is read from the operating
+ *    system in large blocks and buffered.  If the operating system's
+ *    RNG is not available this will take the byte from SILC RNG and is
+ *    effectively same as silc_rng_get_byte.
  *
  ***/
 SilcUInt8 silc_rng_global_get_byte_fast(void);
 
+/****f* silccrypt/SilcRNGAPI/silc_rng_global_get_data_fast
+ *
+ * SYNOPSIS
+ *
+ *    void silc_rng_global_get_data_fast(unsigned char *buf, SilcUInt32 len);
+ *
+ * DESCRIPTION
+ *
+ *    Fills the buffer `buf' of `len' bytes with random data as fast as
+ *    possible.  Unlike the other functions the data may include zero
+ *    (0x00) bytes.  If the global RNG is not initialized the buffer is
+ *    filled with zeros.
+ *
+ ***/
+void silc_rng_global_get_data_fast(unsigned char *buf, SilcUInt32 len);
+
 /****f* silccrypt/SilcRNGAPI/silc_rng_global_get_rn16
  *
  * SYNOPSIS
@@ -0,0 +1,357 @@
+/*
+
+  mpmont.c
+
+  Author: agent <agent@local>
+
+  Copyright (C) 2026 agent
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; version 2 of the License.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+*/
+
+#include "silc.h"
+
+/* Modular exponentiation with fixed modulus.  The numbers are kept in
+   Montgomery form in fixed size limb arrays, and the multiplication does
+   not depend on the values of the operands.  The tables are read with
+   masks so that the memory access pattern does not depend on the
+   exponent either.  This is independent of the MP library in use. */
+
+#if defined(__SIZEOF_INT128__)
+typedef SilcUInt64 SilcMPLimb;
+typedef unsigned __int128 SilcMPDLimb;
+#else
+typedef SilcUInt32 SilcMPLimb;
+typedef SilcUInt64 SilcMPDLimb;
+#endif /* __SIZEOF_INT128__ */
+
+#define SILC_MP_LIMB_BITS  (sizeof(SilcMPLimb) * 8)
+#define SILC_MP_MONT_LIMBS (SILC_MP_MONT_MAX_BITS / SILC_MP_LIMB_BITS)
+
+/* Fixed base comb has 2^SILC_MP_COMB_ROWS entries.  Variable base uses
+   table of 2^SILC_MP_WINDOW entries. */
+#define SILC_MP_COMB_ROWS  6
+#define SILC_MP_WINDOW     5
+
+struct SilcMPMontStruct {
+  SilcMPLimb *m;			/* Modulus */
+  SilcMPLimb *rr;			/* R^2 mod m */
+  SilcMPLimb *one;			/* R mod m, one in Montgomery form */
+  SilcMPLimb *comb;			/* Fixed base comb table or NULL */
+  SilcMPLimb minv;			/* -m^-1 mod 2^w */
+  SilcUInt32 n;				/* Number of limbs */
+  SilcUInt32 bits;			/* Bits in modulus */
+  SilcUInt32 comb_cols;			/* Columns in comb */
+};
+
+/* Converts `mp' to `n' limbs.  The `mp' must fit in. */
+
+static void silc_mp_mont_from_mp(SilcMPInt *mp, SilcMPLimb *r, SilcUInt32 n)
+{
+  unsigned char buf[SILC_MP_MONT_LIMBS * sizeof(SilcMPLimb)], *p;
+  SilcUInt32 i, k, len = n * sizeof(SilcMPLimb);
+
+  silc_mp_mp2bin_noalloc(mp, buf, len);
+
+  for (i = 0; i < n; i++) {
+    p = buf + len - (i + 1) * sizeof(SilcMPLimb);
+    r[i] = 0;
+    for (k = 0; k < sizeof(SilcMPLimb); k++)
+      r[i] = (r[i] << 8) | p[k];
+  }
+
+  memset(buf, 0, len);
+}
+
+/* Converts `n' limbs to `mp' */
+
+static void silc_mp_mont_to_mp(const SilcMPLimb *a, SilcUInt32 n,
+			       SilcMPInt *mp)
+{
+  unsigned char buf[SILC_MP_MONT_LIMBS * sizeof(SilcMPLimb)], *p;
+  SilcUInt32 i, k, len = n * sizeof(SilcMPLimb);
+  SilcMPLimb l;
+
+  for (i = 0; i < n; i++) {
+    p = buf + len - (i + 1) * sizeof(SilcMPLimb);
+    l = a[i];
+    for (k = sizeof(SilcMPLimb); k > 0; k--) {
+      p[k - 1] = (unsigned char)l;
+      l >>= 8;
+    }
+  }
+
+  silc_mp_bin2mp(buf, len, mp);
+  memset(buf, 0, len);
+}
+
+/* Montgomery multiplication, r = a * b / R mod m.  The `a' and `b' must
+   be less than m.  The `r' may be same as `a' or `b'. */
+
+static void silc_mp_mont_mul(SilcMPMont mont, SilcMPLimb *r,
+			     const SilcMPLimb *a, const SilcMPLimb *b)
+{
+  const SilcMPLimb *m = mont->m;
+  SilcMPLimb t[SILC_MP_MONT_LIMBS + 2], d[SILC_MP_MONT_LIMBS];
+  SilcMPLimb u, c, borrow, mask;
+  SilcMPDLimb p;
+  SilcUInt32 i, j, n = mont->n;
+
+  memset(t, 0, (n + 2) * sizeof(*t));
+
+  for (i = 0; i < n; i++) {
+    /* t += a * b[i] */
+    c = 0;
+    for (j = 0; j < n; j++) {
+      p = (SilcMPDLimb)a[j] * b[i] + t[j] + c;
+      t[j] = (SilcMPLimb)p;
+      c = (SilcMPLimb)(p >> SILC_MP_LIMB_BITS);
+    }
+    p = (SilcMPDLimb)t[n] + c;
+    t[n] = (SilcMPLimb)p;
+    t[n + 1] = (SilcMPLimb)(p >> SILC_MP_LIMB_BITS);
+
+    /* t = (t + u * m) / 2^w */
+    u = t[0] * mont->minv;
+    p = (SilcMPDLimb)u * m[0] + t[0];
+    c = (SilcMPLimb)(p >> SILC_MP_LIMB_BITS);
+    for (j = 1; j < n; j++) {
+      p = (SilcMPDLimb)u * m[j] + t[j] + c;
+      t[j - 1] = (SilcMPLimb)p;
+      c = (SilcMPLimb)(p >> SILC_MP_LIMB_BITS);
+    }
+    p = (SilcMPDLimb)t[n] + c;
+    t[n - 1] = (SilcMPLimb)p;
+    t[n] = t[n + 1] + (SilcMPLimb)(p >> SILC_MP_LIMB_BITS);
+  }
+
+  /* t < 2m.  Subtract m and take the difference unless it borrowed. */
+  borrow = 0;
+  for (j = 0; j < n; j++) {
+    p = (SilcMPDLimb)t[j] - m[j] - borrow;
+    d[j] = (SilcMPLimb)p;
+    borrow = (SilcMPLimb)(p >> SILC_MP_LIMB_BITS) & 1;
+  }
+  mask = (SilcMPLimb)0 - (borrow & (SilcMPLimb)(t[n] == 0));
+  for (j = 0; j < n; j++)
+    r[j] = (t[j] & mask) | (d[j] & ~mask);
+
+  memset(t, 0, (n + 2) * sizeof(*t));
+  memset(d, 0, n * sizeof(*d));
+}
+
+/* Copies entry `index' of `table' of `count' entries to `r'.  Reads all
+   entries. */
+
+static void silc_mp_mont_select(SilcMPMont mont, SilcMPLimb *r,
+				const SilcMPLimb *table, SilcUInt32 count,
+				SilcUInt32 index)
+{
+  SilcUInt32 i, j, n = mont->n;
+  SilcMPLimb mask;
+
+  memset(r, 0, n * sizeof(*r));
+  for (i = 0; i < count; i++, table += n) {
+    mask = (SilcMPLimb)0 - (SilcMPLimb)(i == index);
+    for (j = 0; j < n; j++)
+      r[j] |= table[j] & mask;
+  }
+}
+
+/* Returns bit `i' of `e' */
+#define SILC_MP_BIT(e, i) \
+  (SilcUInt32)(((e)[(i) / SILC_MP_LIMB_BITS] >> ((i) % SILC_MP_LIMB_BITS)) & 1)
+
+/* Converts `a' into Montgomery form to `r'.  Reduces `a' if needed. */
+
+static void silc_mp_mont_enter(SilcMPMont mont, SilcMPLimb *r, SilcMPInt *a,
+			       SilcMPInt *mod)
+{
+  SilcMPInt tmp;
+
+  silc_mp_init(&tmp);
+  silc_mp_mod(&tmp, a, mod);
+  silc_mp_mont_from_mp(&tmp, r, mont->n);
+  silc_mp_mont_mul(mont, r, r, mont->rr);
+  silc_mp_uninit(&tmp);
+}
+
+/* Builds the fixed base comb table for `base'.  Entry v is product of
+   base^(2^(k * cols)) for every bit k set in v. */
+
+static void silc_mp_mont_comb(SilcMPMont mont, SilcMPInt *base,
+			      SilcMPInt *mod)
+{
+  SilcMPLimb g[SILC_MP_COMB_ROWS][SILC_MP_MONT_LIMBS];
+  SilcUInt32 i, k, v, n = mont->n;
+
+  silc_mp_mont_enter(mont, g[0], base, mod);
+  for (k = 1; k < SILC_MP_COMB_ROWS; k++) {
+    memcpy(g[k], g[k - 1], n * sizeof(SilcMPLimb));
+    for (i = 0; i < mont->comb_cols; i++)
+      silc_mp_mont_mul(mont, g[k], g[k], g[k]);
+  }
+
+  memcpy(mont->comb, mont->one, n * sizeof(SilcMPLimb));
+  for (v = 1; v < (1 << SILC_MP_COMB_ROWS); v++) {
+    for (k = SILC_MP_COMB_ROWS - 1; !(v & (1 << k)); k--);
+    silc_mp_mont_mul(mont, mont->comb + v * n,
+		     mont->comb + (v ^ (1 << k)) * n, g[k]);
+  }
+}
+
+/* Allocates context for modulus `mod' and optional fixed `base' */
+
+SilcMPMont silc_mp_mont_alloc(SilcMPInt *mod, SilcMPInt *base)
+{
+  SilcMPMont mont;
+  SilcMPInt tmp;
+  SilcMPLimb x;
+  SilcUInt32 n, bits, size;
+  int i;
+
+  bits = silc_mp_sizeinbase(mod, 2);
+  if (bits < 2 || bits > SILC_MP_MONT_MAX_BITS)
+    return NULL;
+  if (!(silc_mp_get_ui(mod) & 1))
+    return NULL;
+
+  n = (bits + SILC_MP_LIMB_BITS - 1) / SILC_MP_LIMB_BITS;
+  size = 3 * n;
+  if (base)
+    size += (1 << SILC_MP_COMB_ROWS) * n;
+
+  mont = silc_calloc(1, sizeof(*mont) + size * sizeof(SilcMPLimb));
+  if (!mont)
+    return NULL;
+
+  mont->n = n;
+  mont->bits = bits;
+  mont->m = (SilcMPLimb *)(mont + 1);
+  mont->rr = mont->m + n;
+  mont->one = mont->rr + n;
+  silc_mp_mont_from_mp(mod, mont->m, n);
+
+  /* -m^-1 mod 2^w with Newton iteration, x is correct to 3 bits first */
+  x = mont->m[0];
+  for (i = 0; i < 5; i++)
+    x *= 2 - mont->m[0] * x;
+  mont->minv = (SilcMPLimb)0 - x;
+
+  /* R^2 mod m, and one which is R mod m */
+  silc_mp_init(&tmp);
+  silc_mp_set_ui(&tmp, 1);
+  silc_mp_mul_2exp(&tmp, &tmp, 2 * n * SILC_MP_LIMB_BITS);
+  silc_mp_mod(&tmp, &tmp, mod);
+  silc_mp_mont_from_mp(&tmp, mont->rr, n);
+  silc_mp_uninit(&tmp);
+
+  mont->one[0] = 1;
+  silc_mp_mont_mul(mont, mont->one, mont->one, mont->rr);
+
+  if (base) {
+    mont->comb = mont->one + n;
+    mont->comb_cols = (bits + SILC_MP_COMB_ROWS - 1) / SILC_MP_COMB_ROWS;
+    silc_mp_mont_comb(mont, base, mod);
+  }
+
+  return mont;
+}
+
+/* Free context */
+
+void silc_mp_mont_free(SilcMPMont mont)
+{
+  silc_free(mont);
+}
+
+/* Computes dst = base ^ exp mod m.  If `base' is NULL uses the fixed
+   base. */
+
+SilcBool silc_mp_mont_pow(SilcMPMont mont, SilcMPInt *dst, SilcMPInt *base,
+			  SilcMPInt *exp)
+{
+  SilcMPLimb r[SILC_MP_MONT_LIMBS], t[SILC_MP_MONT_LIMBS];
+  SilcMPLimb e[SILC_MP_MONT_LIMBS + 1], *table;
+  SilcUInt32 i, k, v, n = mont->n, ebits, cols;
+  SilcMPInt mod;
+
+  if (silc_mp_cmp_ui(exp, 0) < 0)
+    return FALSE;
+  ebits = silc_mp_sizeinbase(exp, 2);
+  if (ebits > SILC_MP_MONT_MAX_BITS)
+    return FALSE;
+  if (!base && (!mont->comb ||
+		ebits > mont->comb_cols * SILC_MP_COMB_ROWS))
+    return FALSE;
+
+  /* Exponent is processed at least to the size of the modulus, so that
+     its length does not show in the running time. */
+  if (ebits < mont->bits)
+    ebits = mont->bits;
+  memset(e, 0, sizeof(e));
+  silc_mp_mont_from_mp(exp, e, (ebits + SILC_MP_LIMB_BITS - 1) /
+		       SILC_MP_LIMB_BITS);
+
+  if (!base) {
+    /* Fixed base comb, one squaring and multiplication per column */
+    cols = mont->comb_cols;
+    memcpy(r, mont->one, n * sizeof(*r));
+    for (i = cols; i > 0; i--) {
+      silc_mp_mont_mul(mont, r, r, r);
+      v = 0;
+      for (k = 0; k < SILC_MP_COMB_ROWS; k++)
+	v |= SILC_MP_BIT(e, k * cols + i - 1) << k;
+      silc_mp_mont_select(mont, t, mont->comb, 1 << SILC_MP_COMB_ROWS, v);
+      silc_mp_mont_mul(mont, r, r, t);
+    }
+  } else {
+    /* Fixed window */
+    table = silc_malloc((1 << SILC_MP_WINDOW) * n * sizeof(*table));
+    if (!table)
+      return FALSE;
+
+    silc_mp_init(&mod);
+    silc_mp_mont_to_mp(mont->m, n, &mod);
+    memcpy(table, mont->one, n * sizeof(*table));
+    silc_mp_mont_enter(mont, table + n, base, &mod);
+    silc_mp_uninit(&mod);
+    for (v = 2; v < (1 << SILC_MP_WINDOW); v++)
+      silc_mp_mont_mul(mont, table + v * n, table + (v - 1) * n, table + n);
+
+    ebits = ((ebits + SILC_MP_WINDOW - 1) / SILC_MP_WINDOW) * SILC_MP_WINDOW;
+    memcpy(r, mont->one, n * sizeof(*r));
+    for (i = ebits; i > 0; i -= SILC_MP_WINDOW) {
+      for (k = 0; k < SILC_MP_WINDOW; k++)
+	silc_mp_mont_mul(mont, r, r, r);
+      v = 0;
+      for (k = 0; k < SILC_MP_WINDOW; k++)
+	v |= SILC_MP_BIT(e, i - SILC_MP_WINDOW + k) << k;
+      silc_mp_mont_select(mont, t, table, 1 << SILC_MP_WINDOW, v);
+      silc_mp_mont_mul(mont, r, r, t);
+    }
+
+    memset(table, 0, (1 << SILC_MP_WINDOW) * n * sizeof(*table));
+    silc_free(table);
+  }
+
+  /* Leave Montgomery form */
+  memset(t, 0, sizeof(t));
+  t[0] = 1;
+  silc_mp_mont_mul(mont, r, r, t);
+  silc_mp_mont_to_mp(r, n, dst);
+
+  memset(e, 0, sizeof(e));
+  memset(r, 0, sizeof(r));
+  memset(t, 0, sizeof(t));
+
+  return TRUE;
+}
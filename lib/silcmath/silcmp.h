@@ -721,4 +721,89 @@ void silc_mp_or(SilcMPInt *dst, SilcMPInt *mp1, SilcMPInt *mp2);
  ***/
 void silc_mp_xor(SilcMPInt *dst, SilcMPInt *mp1, SilcMPInt *mp2);
 
+
+/****s* silcmath/SilcMPAPI/SilcMPMont
+ *
+ * NAME
+ *
+ *    typedef struct SilcMPMontStruct *SilcMPMont;
+ *
+ * DESCRIPTION
+ *
+ *    Context for modular exponentiation with a fixed odd modulus, and
+ *    optionally with a fixed base.  The numbers are kept in Montgomery
+ *    form and the exponentiation runs in time and memory access pattern
+ *    that do not depend on the exponent.  Allocated with
+ *    silc_mp_mont_alloc and freed with silc_mp_mont_free.  The context
+ *    is not modified after allocation and can be used by many threads
+ *    at once.
+ *
+ ***/
+typedef struct SilcMPMontStruct *SilcMPMont;
+
+/****d* silcmath/SilcMPAPI/SILC_MP_MONT_MAX_BITS
+ *
+ * NAME
+ *
+ *    #define SILC_MP_MONT_MAX_BITS 8192
+ *
+ * DESCRIPTION
+ *
+ *    Maximum size of the modulus and exponent in bits for SilcMPMont.
+ *
+ * SOURCE
+ */
+#define SILC_MP_MONT_MAX_BITS 8192
+/***/
+
+/****f* silcmath/SilcMPAPI/silc_mp_mont_alloc
+ *
+ * SYNOPSIS
+ *
+ *    SilcMPMont silc_mp_mont_alloc(SilcMPInt *mod, SilcMPInt *base);
+ *
+ * DESCRIPTION
+ *
+ *    Allocates exponentiation context for the odd modulus `mod'.  If
+ *    `base' is non-NULL a precomputed table for the fixed base `base'
+ *    is built, which makes silc_mp_mont_pow with NULL base several
+ *    times faster.  Returns NULL if `mod' is even or larger than
+ *    SILC_MP_MONT_MAX_BITS.
+ *
+ ***/
+SilcMPMont silc_mp_mont_alloc(SilcMPInt *mod, SilcMPInt *base);
+
+/****f* silcmath/SilcMPAPI/silc_mp_mont_free
+ *
+ * SYNOPSIS
+ *
+ *    void silc_mp_mont_free(SilcMPMont mont);
+ *
+ * DESCRIPTION
+ *
+ *    Frees the context allocated with silc_mp_mont_alloc.
+ *
+ ***/
+void silc_mp_mont_free(SilcMPMont mont);
+
+/****f* silcmath/SilcMPAPI/silc_mp_mont_pow
+ *
+ * SYNOPSIS
+ *
+ *    SilcBool silc_mp_mont_pow(SilcMPMont mont, SilcMPInt *dst,
+ *                              SilcMPInt *base, SilcMPInt *exp);
+ *
+ * DESCRIPTION
+ *
+ *    Computes `base' to the power of `exp' modulo the modulus of `mont'
+ *    and saves the result to `dst'.  If `base' is NULL the fixed base
+ *    given to silc_mp_mont_alloc is used.  Returns FALSE if the `exp'
+ *    is negative or too large, or if fixed base was requested and the
+ *    `exp' is larger than the modulus.  Caller then should use
+ *    silc_mp_pow_mod.
+ *
+ ***/
+SilcBool silc_mp_mont_pow(SilcMPMont mont, SilcMPInt *dst, SilcMPInt *base,
+			  SilcMPInt *exp);
+
 #endif
@@ -69,6 +69,38 @@ const struct SilcSKEDiffieHellmanGroupDefStruct silc_ske_groups[] =
   { 0, NULL, NULL, NULL }
 };
 
+/* Precomputed exponentiation contexts for the groups, indexed as the
+   silc_ske_groups.  Built when the group is used first time and never
+   freed.  They are shared by all threads. */
+static SilcAtomicPointer silc_ske_groups_mont[sizeof(silc_ske_groups) /
+					      sizeof(silc_ske_groups[0])];
+
+/* Returns the exponentiation context for the group, building it if it
+   doesn't exist yet.  Returns NULL if it cannot be built. */
+
+static SilcMPMont silc_ske_group_mont(int i, SilcSKEDiffieHellmanGroup group)
+{
+  SilcMPMont mont;
+
+  mont = silc_atomic_get_pointer(&silc_ske_groups_mont[i]);
+  if (mont)
+    return mont;
+
+  SILC_LOG_DEBUG(("Precomputing Diffie-Hellman group %s", group->name));
+
+  mont = silc_mp_mont_alloc(&group->group, &group->generator);
+  if (!mont)
+    return NULL;
+
+  /* If some other thread built it at the same time, use that one */
+  if (!silc_atomic_cas_pointer(&silc_ske_groups_mont[i], NULL, mont)) {
+    silc_mp_mont_free(mont);
+    mont = silc_atomic_get_pointer(&silc_ske_groups_mont[i]);
+  }
+
+  return mont;
+}
+
 /* Returns Diffie Hellman group by group number */
 
 SilcSKEStatus silc_ske_group_get_by_number(int number,
@@ -98,6 +130,7 @@ SilcSKEStatus silc_ske_group_get_by_number(int number,
     silc_mp_set_str(&group->group, silc_ske_groups[i].group, 16);
     silc_mp_set_str(&group->group_order, silc_ske_groups[i].group_order, 16);
     silc_mp_set_str(&group->generator, silc_ske_groups[i].generator, 16);
+    group->mont = silc_ske_group_mont(i, group);
 
     *ret = group;
   }
@@ -134,6 +167,7 @@ SilcSKEStatus silc_ske_group_get_by_name(const char *name,
     silc_mp_set_str(&group->group, silc_ske_groups[i].group, 16);
     silc_mp_set_str(&group->group_order, silc_ske_groups[i].group_order, 16);
     silc_mp_set_str(&group->generator, silc_ske_groups[i].generator, 16);
+    group->mont = silc_ske_group_mont(i, group);
 
     *ret = group;
   }
@@ -151,6 +185,26 @@ void silc_ske_group_free(SilcSKEDiffieHellmanGroup group)
   silc_free(group);
 }
 
+/* Computes dst = g ^ x mod p with the group's generator g */
+
+void silc_ske_group_pow_generator(SilcSKEDiffieHellmanGroup group,
+				  SilcMPInt *dst, SilcMPInt *x)
+{
+  if (group->mont && silc_mp_mont_pow(group->mont, dst, NULL, x))
+    return;
+  silc_mp_pow_mod(dst, &group->generator, x, &group->group);
+}
+
+/* Computes dst = base ^ x mod p */
+
+void silc_ske_group_pow(SilcSKEDiffieHellmanGroup group, SilcMPInt *dst,
+			SilcMPInt *base, SilcMPInt *x)
+{
+  if (group->mont && silc_mp_mont_pow(group->mont, dst, base, x))
+    return;
+  silc_mp_pow_mod(dst, base, x, &group->group);
+}
+
 /* Returns comma separated list of supported groups */
 
 char *silc_ske_get_supported_groups()
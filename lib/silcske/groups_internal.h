@@ -36,9 +36,16 @@ struct SilcSKEDiffieHellmanGroupStruct {
   SilcMPInt group;
   SilcMPInt group_order;
   SilcMPInt generator;
+  SilcMPMont mont;		/* Shared, precomputed for generator */
 };
 
 /* List of defined groups. */
 extern const struct SilcSKEDiffieHellmanGroupDefStruct silc_ske_groups[];
 
+/* Diffie Hellman computations with the group's modulus */
+void silc_ske_group_pow_generator(SilcSKEDiffieHellmanGroup group,
+				  SilcMPInt *dst, SilcMPInt *x);
+void silc_ske_group_pow(SilcSKEDiffieHellmanGroup group, SilcMPInt *dst,
+			SilcMPInt *base, SilcMPInt *x);
+
 #endif
@@ -59,6 +59,7 @@ SILC_FSM_STATE(silc_ske_st_rekey_responder_wait);
 SILC_FSM_STATE(silc_ske_st_rekey_responder_start);
 SILC_FSM_STATE(silc_ske_st_rekey_responder_done);
 SILC_FSM_STATE(silc_ske_st_rekey_responder_end);
+SILC_FSM_STATE(silc_ske_st_crypto);
 SILC_TASK_CALLBACK(silc_ske_packet_send_retry);
 
 SilcSKEKeyMaterial
@@ -854,7 +855,6 @@ silc_ske_assemble_security_properties(SilcSKE ske,
 				      const char *version)
 {
   SilcSKEStartPayload rp;
-  int i;
 
   SILC_LOG_DEBUG(("Assembling KE Start Payload"));
 
@@ -865,8 +865,7 @@ silc_ske_assemble_security_properties(SilcSKE ske,
 
   /* Set random cookie */
   rp->cookie = silc_calloc(SILC_SKE_COOKIE_LEN, sizeof(*rp->cookie));
-  for (i = 0; i < SILC_SKE_COOKIE_LEN; i++)
-    rp->cookie[i] = silc_rng_get_byte_fast(ske->rng);
+  silc_rng_get_data_fast(ske->rng, rp->cookie, SILC_SKE_COOKIE_LEN);
   rp->cookie_len = SILC_SKE_COOKIE_LEN;
 
   /* In case IV included flag and session port is set the first 16-bits of
@@ -1019,6 +1018,239 @@ SILC_TASK_CALLBACK(silc_ske_timeout)
   silc_fsm_continue_sync(&ske->fsm);
 }
 
+/**************************** Crypto worker pool ****************************/
+
+/* The Diffie-Hellman and public key operations may be run in real FSM
+   threads so that the scheduler is not blocked by them during key exchange
+   floods.  The machine waits while the operation runs and it is continued
+   from the thread destructor, which is called in the scheduler.  The
+   session holds a reference to the SKE until the operation has completed.
+   At most `max_workers' threads run at a time and the rest of the sessions
+   wait in FIFO queue. */
+
+typedef struct {
+  SilcMutex lock;
+  SilcList queue;			/* Sessions waiting for worker */
+  SilcUInt32 max_workers;
+  SilcUInt32 max_queue;
+  SilcSKECryptoStatsStruct stats;
+} SilcSKECryptoPool;
+
+static SilcSKECryptoPool silc_ske_crypto;
+
+static void silc_ske_crypto_done(SilcFSMThread thread, void *thread_context,
+				 void *destructor_context);
+
+/* The state must wait if crypto operation is running in worker.  Packets
+   received meanwhile are not processed. */
+#define SILC_SKE_CRYPTO_WAIT(ske)			\
+do {							\
+  if (silc_unlikely((ske)->crypto_running)) {		\
+    if ((ske)->packet) {				\
+      silc_packet_free((ske)->packet);			\
+      (ske)->packet = NULL;				\
+    }							\
+    return SILC_FSM_WAIT;				\
+  }							\
+} while(0)
+
+/* Returns histogram bucket for `usec' */
+
+static int silc_ske_crypto_bucket(SilcInt64 usec)
+{
+  SilcInt64 limit = 1000;
+  int i;
+
+  for (i = 0; i < SILC_SKE_CRYPTO_BUCKETS - 1; i++, limit <<= 2)
+    if (usec < limit)
+      break;
+
+  return i;
+}
+
+/* Worker thread.  Runs the crypto operation. */
+
+SILC_FSM_STATE(silc_ske_st_crypto)
+{
+  SilcSKE ske = fsm_context;
+  SilcInt64 start = silc_time_usec();
+
+  ske->crypto_wait = start - ske->crypto_queued;
+
+  /* Don't waste time on aborted session */
+  if (ske->aborted)
+    ske->crypto_status = SILC_SKE_STATUS_ERROR;
+  else
+    ske->crypto_status = ske->crypto(ske);
+
+  ske->crypto_run = silc_time_usec() - start;
+
+  return SILC_FSM_FINISH;
+}
+
+/* Starts the worker thread */
+
+static void silc_ske_crypto_start(SilcSKE ske)
+{
+  silc_fsm_thread_init(&ske->crypto_thread, &ske->fsm, ske,
+		       silc_ske_crypto_done, NULL, TRUE);
+  silc_fsm_start(&ske->crypto_thread, silc_ske_st_crypto);
+}
+
+/* Starts queued operations while there are free workers.  If the pool was
+   disabled while there are queued operations they are run one at a time. */
+
+static void silc_ske_crypto_schedule(void)
+{
+  SilcSKECryptoPool *pool = &silc_ske_crypto;
+  SilcSKE ske;
+
+  while (1) {
+    silc_mutex_lock(pool->lock);
+    if (pool->stats.workers &&
+	pool->stats.workers >= pool->max_workers) {
+      silc_mutex_unlock(pool->lock);
+      return;
+    }
+
+    silc_list_start(pool->queue);
+    ske = silc_list_get(pool->queue);
+    if (!ske) {
+      silc_mutex_unlock(pool->lock);
+      return;
+    }
+    silc_list_del(pool->queue, ske);
+    pool->stats.queued--;
+    pool->stats.workers++;
+    silc_mutex_unlock(pool->lock);
+
+    silc_ske_crypto_start(ske);
+  }
+}
+
+/* Worker thread destructor.  Called in the scheduler after the operation
+   has completed.  Continues the machine and releases the reference. */
+
+static void silc_ske_crypto_done(SilcFSMThread thread, void *thread_context,
+				 void *destructor_context)
+{
+  SilcSKECryptoPool *pool = &silc_ske_crypto;
+  SilcSKE ske = thread_context;
+
+  SILC_LOG_DEBUG(("Crypto operation done for SKE %p, wait %d usec, "
+		  "run %d usec", ske, (int)ske->crypto_wait,
+		  (int)ske->crypto_run));
+
+  silc_mutex_lock(pool->lock);
+  pool->stats.workers--;
+  pool->stats.completed++;
+  pool->stats.wait[silc_ske_crypto_bucket(ske->crypto_wait)]++;
+  pool->stats.run[silc_ske_crypto_bucket(ske->crypto_run)]++;
+  silc_mutex_unlock(pool->lock);
+
+  /* Start next queued operation */
+  silc_ske_crypto_schedule();
+
+  ske->crypto_running = FALSE;
+  silc_fsm_continue_sync(&ske->fsm);
+  silc_ske_free(ske);
+}
+
+/* Runs the `crypto' operation for `ske'.  Returns TRUE if the operation
+   was given to worker pool, in which case the machine must wait and it is
+   continued after the operation has completed.  Returns FALSE if the
+   operation was run synchronously or was rejected because the queue is
+   full.  The result of the operation is in ske->crypto_status. */
+
+static SilcBool silc_ske_crypto_dispatch(SilcSKE ske,
+					 SilcSKEStatus (*crypto)(SilcSKE ske))
+{
+  SilcSKECryptoPool *pool = &silc_ske_crypto;
+  SilcBool start;
+
+  ske->crypto = crypto;
+
+  silc_mutex_lock(pool->lock);
+
+  /* Rekey is run synchronously so that new keys are taken into use
+     in order with the packet stream. */
+  if (!pool->max_workers || ske->rekeying) {
+    pool->stats.synchronous++;
+    silc_mutex_unlock(pool->lock);
+    ske->crypto_status = crypto(ske);
+    return FALSE;
+  }
+
+  start = (pool->stats.workers < pool->max_workers &&
+	   !silc_list_count(pool->queue));
+  if (!start) {
+    if (pool->max_queue && pool->stats.queued >= pool->max_queue) {
+      /* Admission control, reject new key exchange */
+      pool->stats.rejected++;
+      silc_mutex_unlock(pool->lock);
+      SILC_LOG_DEBUG(("Crypto queue is full, rejecting SKE %p", ske));
+      ske->crypto_status = SILC_SKE_STATUS_BUSY;
+      return FALSE;
+    }
+
+    silc_list_add(pool->queue, ske);
+    pool->stats.queued++;
+    if (pool->stats.queued > pool->stats.queued_peak)
+      pool->stats.queued_peak = pool->stats.queued;
+  } else {
+    pool->stats.workers++;
+  }
+
+  silc_mutex_unlock(pool->lock);
+
+  /* Hold reference until the operation has completed */
+  ske->refcnt++;
+  ske->crypto_running = TRUE;
+  ske->crypto_queued = silc_time_usec();
+
+  if (start)
+    silc_ske_crypto_start(ske);
+
+  return TRUE;
+}
+
+/* Sets the worker pool size */
+
+void silc_ske_set_crypto_workers(SilcUInt32 max_workers,
+				 SilcUInt32 max_queue)
+{
+  SilcSKECryptoPool *pool = &silc_ske_crypto;
+
+#ifdef SILC_THREADS
+  if (!pool->lock) {
+    if (!max_workers || !silc_mutex_alloc(&pool->lock))
+      return;
+    silc_list_init(pool->queue, struct SilcSKEStruct, crypto_next);
+  }
+
+  SILC_LOG_DEBUG(("Crypto workers %d, queue %d", max_workers, max_queue));
+
+  silc_mutex_lock(pool->lock);
+  pool->max_workers = max_workers;
+  pool->max_queue = max_queue;
+  silc_mutex_unlock(pool->lock);
+
+  /* Start queued operations if the limit grew */
+  silc_ske_crypto_schedule();
+#endif /* SILC_THREADS */
+}
+
+/* Returns worker pool statistics */
+
+void silc_ske_get_crypto_stats(SilcSKECryptoStats stats)
+{
+  SilcSKECryptoPool *pool = &silc_ske_crypto;
+
+  silc_mutex_lock(pool->lock);
+  *stats = pool->stats;
+  silc_mutex_unlock(pool->lock);
+}
+
 /******************************* Protocol API *******************************/
 
 /* Allocates new SKE object. */
@@ -1407,8 +1639,7 @@ SILC_FSM_STATE(silc_ske_st_initiator_phase2)
 
   /* Do the Diffie Hellman computation, e = g ^ x mod p */
   silc_mp_init(&payload->x);
-  silc_mp_pow_mod(&payload->x, &ske->prop->group->generator, x,
-		  &ske->prop->group->group);
+  silc_ske_group_pow_generator(ske->prop->group, &payload->x, x);
 
   /* Get public key */
   payload->pk_data = silc_pkcs_public_key_encode(ske->public_key, &pk_len);
@@ -1543,7 +1774,7 @@ SILC_FSM_STATE(silc_ske_st_initiator_phase3)
   /* Compute the shared secret key */
   KEY = silc_calloc(1, sizeof(*KEY));
   silc_mp_init(KEY);
-  silc_mp_pow_mod(KEY, &payload->x, ske->x, &ske->prop->group->group);
+  silc_ske_group_pow(ske->prop->group, KEY, &payload->x, ske->x);
   ske->KEY = KEY;
 
   /* Decode the remote's public key */
@@ -2112,66 +2343,108 @@ SILC_FSM_STATE(silc_ske_st_responder_phase2)
   return SILC_FSM_CONTINUE;
 }
 
-/* Phase-4. Generate KE2 payload */
+/* Computes the KE2 payload.  Verifies initiator's signature if doing
+   mutual authentication, does the Diffie-Hellman computations and signs
+   the HASH.  This may be run in crypto worker thread, and must not touch
+   anything else than the key exchange data. */
 
-SILC_FSM_STATE(silc_ske_st_responder_phase4)
+static SilcSKEStatus silc_ske_responder_ke2(SilcSKE ske)
 {
-  SilcSKE ske = fsm_context;
   SilcSKEStatus status;
-  SilcSKEKEPayload recv_payload, send_payload;
-  SilcMPInt *x, *KEY;
-
-  if (ske->aborted) {
-    /** Aborted */
-    silc_fsm_next(fsm, silc_ske_st_responder_aborted);
-    return SILC_FSM_CONTINUE;
-  }
-
-  /* Check result of public key verification */
-  if (ske->status != SILC_SKE_STATUS_OK) {
-    /** Public key not verified */
-    SILC_LOG_DEBUG(("Public key verification failed"));
-    silc_fsm_next(fsm, silc_ske_st_initiator_error);
-    return SILC_FSM_CONTINUE;
-  }
-
-  recv_payload = ske->ke1_payload;
+  SilcSKEKEPayload recv_payload = ske->ke1_payload;
+  SilcSKEKEPayload send_payload = ske->ke2_payload;
+  unsigned char hash[SILC_HASH_MAXLEN], sign[2048 + 1];
+  SilcUInt32 hash_len, sign_len;
+  SilcMPInt *KEY;
 
   /* The public key verification was performed only if the Mutual
      Authentication flag is set. */
   if (ske->start_payload &&
       ske->start_payload->flags & SILC_SKE_SP_FLAG_MUTUAL) {
-    unsigned char hash[SILC_HASH_MAXLEN];
-    SilcUInt32 hash_len;
-
     SILC_LOG_DEBUG(("We are doing mutual authentication"));
 
     /* Compute the hash value */
     status = silc_ske_make_hash(ske, hash, &hash_len, TRUE);
-    if (status != SILC_SKE_STATUS_OK) {
-      /** Error computing hash */
-      ske->status = status;
-      silc_fsm_next(fsm, silc_ske_st_responder_error);
-      return SILC_FSM_CONTINUE;
-    }
+    if (status != SILC_SKE_STATUS_OK)
+      return status;
 
     SILC_LOG_DEBUG(("Verifying signature (HASH_i)"));
 
     /* Verify signature */
     if (!silc_pkcs_verify(ske->prop->public_key, recv_payload->sign_data,
-			  recv_payload->sign_len, hash, hash_len, NULL)) {
-      /** Incorrect signature */
-      SILC_LOG_ERROR(("Signature verification failed, incorrect signature"));
-      ske->status = SILC_SKE_STATUS_INCORRECT_SIGNATURE;
-      silc_fsm_next(fsm, silc_ske_st_responder_error);
-      return SILC_FSM_CONTINUE;
-    }
+			  recv_payload->sign_len, hash, hash_len, NULL))
+      return SILC_SKE_STATUS_INCORRECT_SIGNATURE;
 
     SILC_LOG_DEBUG(("Signature is Ok"));
 
     memset(hash, 'F', hash_len);
   }
 
+  SILC_LOG_DEBUG(("Computing f = g ^ x mod p"));
+
+  /* Do the Diffie Hellman computation, f = g ^ x mod p */
+  silc_ske_group_pow_generator(ske->prop->group, &send_payload->x, ske->x);
+
+  SILC_LOG_DEBUG(("Computing KEY = e ^ x mod p"));
+
+  /* Compute the shared secret key */
+  KEY = silc_calloc(1, sizeof(*KEY));
+  if (!KEY)
+    return SILC_SKE_STATUS_OUT_OF_MEMORY;
+  silc_mp_init(KEY);
+  silc_ske_group_pow(ske->prop->group, KEY, &recv_payload->x, ske->x);
+  ske->KEY = KEY;
+
+  SILC_LOG_DEBUG(("Computing HASH value"));
+
+  /* Compute the hash value */
+  memset(hash, 0, sizeof(hash));
+  status = silc_ske_make_hash(ske, hash, &hash_len, FALSE);
+  if (status != SILC_SKE_STATUS_OK)
+    return status;
+  ske->hash = silc_memdup(hash, hash_len);
+  ske->hash_len = hash_len;
+
+  if (ske->public_key && ske->private_key) {
+    SILC_LOG_DEBUG(("Signing HASH value"));
+
+    /* Sign the hash value */
+    if (!silc_pkcs_sign(ske->private_key, hash, hash_len, sign,
+			sizeof(sign) - 1, &sign_len, FALSE, ske->prop->hash))
+      return SILC_SKE_STATUS_SIGNATURE_ERROR;
+    send_payload->sign_data = silc_memdup(sign, sign_len);
+    send_payload->sign_len = sign_len;
+    memset(sign, 0, sizeof(sign));
+  }
+
+  return SILC_SKE_STATUS_OK;
+}
+
+/* Phase-4. Generate KE2 payload */
+
+SILC_FSM_STATE(silc_ske_st_responder_phase4)
+{
+  SilcSKE ske = fsm_context;
+  SilcSKEStatus status;
+  SilcSKEKEPayload send_payload;
+  SilcMPInt *x;
+  unsigned char *pk;
+  SilcUInt32 pk_len;
+
+  if (ske->aborted) {
+    /** Aborted */
+    silc_fsm_next(fsm, silc_ske_st_responder_aborted);
+    return SILC_FSM_CONTINUE;
+  }
+
+  /* Check result of public key verification */
+  if (ske->status != SILC_SKE_STATUS_OK) {
+    /** Public key not verified */
+    SILC_LOG_DEBUG(("Public key verification failed"));
+    silc_fsm_next(fsm, silc_ske_st_initiator_error);
+    return SILC_FSM_CONTINUE;
+  }
+
   /* Create the random number x, 1 < x < q. */
   x = silc_calloc(1, sizeof(*x));
   silc_mp_init(x);
@@ -2192,25 +2465,28 @@ SILC_FSM_STATE(silc_ske_st_responder_phase4)
   send_payload = silc_calloc(1, sizeof(*send_payload));
   ske->x = x;
   ske->ke2_payload = send_payload;
-
-  SILC_LOG_DEBUG(("Computing f = g ^ x mod p"));
-
-  /* Do the Diffie Hellman computation, f = g ^ x mod p */
   silc_mp_init(&send_payload->x);
-  silc_mp_pow_mod(&send_payload->x, &ske->prop->group->generator, x,
-		  &ske->prop->group->group);
 
-  SILC_LOG_DEBUG(("Computing KEY = e ^ x mod p"));
+  if (ske->public_key && ske->private_key) {
+    SILC_LOG_DEBUG(("Getting public key"));
 
-  /* Compute the shared secret key */
-  KEY = silc_calloc(1, sizeof(*KEY));
-  silc_mp_init(KEY);
-  silc_mp_pow_mod(KEY, &ske->ke1_payload->x, ske->x,
-		  &ske->prop->group->group);
-  ske->KEY = KEY;
+    /* Get the public key */
+    pk = silc_pkcs_public_key_encode(ske->public_key, &pk_len);
+    if (!pk) {
+      /** Error encoding public key */
+      ske->status = SILC_SKE_STATUS_OUT_OF_MEMORY;
+      silc_fsm_next(fsm, silc_ske_st_responder_error);
+      return SILC_FSM_CONTINUE;
+    }
+    send_payload->pk_data = pk;
+    send_payload->pk_len = pk_len;
+  }
+  send_payload->pk_type = silc_pkcs_get_type(ske->public_key);
 
-  /** Send KE2 payload */
+  /** Compute KE2 payload, then send it */
   silc_fsm_next(fsm, silc_ske_st_responder_phase5);
+  if (silc_ske_crypto_dispatch(ske, silc_ske_responder_ke2))
+    return SILC_FSM_WAIT;
   return SILC_FSM_CONTINUE;
 }
 
@@ -2221,56 +2497,25 @@ SILC_FSM_STATE(silc_ske_st_responder_phase5)
   SilcSKE ske = fsm_context;
   SilcSKEStatus status;
   SilcBuffer payload_buf;
-  unsigned char hash[SILC_HASH_MAXLEN], sign[2048 + 1], *pk;
-  SilcUInt32 hash_len, sign_len, pk_len;
 
-  SILC_LOG_DEBUG(("Start"));
+  SILC_SKE_CRYPTO_WAIT(ske);
 
-  if (ske->public_key && ske->private_key) {
-    SILC_LOG_DEBUG(("Getting public key"));
+  SILC_LOG_DEBUG(("Start"));
 
-    /* Get the public key */
-    pk = silc_pkcs_public_key_encode(ske->public_key, &pk_len);
-    if (!pk) {
-      /** Error encoding public key */
-      status = SILC_SKE_STATUS_OUT_OF_MEMORY;
-      silc_fsm_next(fsm, silc_ske_st_responder_error);
-      return SILC_FSM_CONTINUE;
-    }
-    ske->ke2_payload->pk_data = pk;
-    ske->ke2_payload->pk_len = pk_len;
+  if (ske->aborted) {
+    /** Aborted */
+    silc_fsm_next(fsm, silc_ske_st_responder_aborted);
+    return SILC_FSM_CONTINUE;
   }
 
-  SILC_LOG_DEBUG(("Computing HASH value"));
-
-  /* Compute the hash value */
-  memset(hash, 0, sizeof(hash));
-  status = silc_ske_make_hash(ske, hash, &hash_len, FALSE);
-  if (status != SILC_SKE_STATUS_OK) {
-    /** Error computing hash */
-    ske->status = status;
+  if (ske->crypto_status != SILC_SKE_STATUS_OK) {
+    /** Error computing KE2 payload */
+    if (ske->crypto_status == SILC_SKE_STATUS_INCORRECT_SIGNATURE)
+      SILC_LOG_ERROR(("Signature verification failed, incorrect signature"));
+    ske->status = ske->crypto_status;
     silc_fsm_next(fsm, silc_ske_st_responder_error);
     return SILC_FSM_CONTINUE;
   }
-  ske->hash = silc_memdup(hash, hash_len);
-  ske->hash_len = hash_len;
-
-  if (ske->public_key && ske->private_key) {
-    SILC_LOG_DEBUG(("Signing HASH value"));
-
-    /* Sign the hash value */
-    if (!silc_pkcs_sign(ske->private_key, hash, hash_len, sign,
-			sizeof(sign) - 1, &sign_len, FALSE, ske->prop->hash)) {
-      /** Error computing signature */
-      status = SILC_SKE_STATUS_SIGNATURE_ERROR;
-      silc_fsm_next(fsm, silc_ske_st_responder_error);
-      return SILC_FSM_CONTINUE;
-    }
-    ske->ke2_payload->sign_data = silc_memdup(sign, sign_len);
-    ske->ke2_payload->sign_len = sign_len;
-    memset(sign, 0, sizeof(sign));
-  }
-  ske->ke2_payload->pk_type = silc_pkcs_get_type(ske->public_key);
 
   /* Encode the Key Exchange Payload */
   status = silc_ske_payload_ke_encode(ske, ske->ke2_payload,
@@ -2357,6 +2602,8 @@ SILC_FSM_STATE(silc_ske_st_responder_aborted)
   SilcSKE ske = fsm_context;
   unsigned char tmp[4];
 
+  SILC_SKE_CRYPTO_WAIT(ske);
+
   SILC_LOG_DEBUG(("Key exchange protocol aborted"));
 
   /* Send FAILURE packet */
@@ -2379,6 +2626,8 @@ SILC_FSM_STATE(silc_ske_st_responder_failure)
   SilcSKE ske = fsm_context;
   SilcUInt32 error = SILC_SKE_STATUS_ERROR;
 
+  SILC_SKE_CRYPTO_WAIT(ske);
+
   SILC_LOG_DEBUG(("Key exchange protocol failed"));
 
   if (ske->packet && silc_buffer_len(&ske->packet->buffer) == 4) {
@@ -2407,10 +2656,15 @@ SILC_FSM_STATE(silc_ske_st_responder_error)
   SILC_LOG_DEBUG(("Error %d (%s) during key exchange protocol",
 		  ske->status, silc_ske_map_status(ske->status)));
 
-  /* Send FAILURE packet */
-  if (ske->status > SILC_SKE_STATUS_INVALID_COOKIE)
-    ske->status = SILC_SKE_STATUS_BAD_PAYLOAD;
-  SILC_PUT32_MSB(ske->status, tmp);
+  /* Send FAILURE packet.  Rejected key exchange is reported to caller
+     as is, and to remote as generic error. */
+  if (ske->status == SILC_SKE_STATUS_BUSY)
+    SILC_PUT32_MSB(SILC_SKE_STATUS_ERROR, tmp);
+  else {
+    if (ske->status > SILC_SKE_STATUS_INVALID_COOKIE)
+      ske->status = SILC_SKE_STATUS_BAD_PAYLOAD;
+    SILC_PUT32_MSB(ske->status, tmp);
+  }
   silc_ske_packet_send(ske, SILC_PACKET_FAILURE, 0, tmp, 4);
 
   silc_packet_stream_unlink(ske->stream, &silc_ske_stream_cbs, ske);
@@ -3482,6 +3736,7 @@ const char *silc_ske_status_string[] =
   "Error computing signature",
   "System out of memory",
   "Key exchange timeout",
+  "Too many key exchanges in progress",
 
   NULL
 };
@@ -75,6 +75,7 @@ typedef enum {
   SILC_SKE_STATUS_SIGNATURE_ERROR,	       /* Error computing signature */
   SILC_SKE_STATUS_OUT_OF_MEMORY,	       /* System out of memory */
   SILC_SKE_STATUS_TIMEOUT,	               /* Timeout */
+  SILC_SKE_STATUS_BUSY,		               /* Too many key exchanges */
 } SilcSKEStatus;
 /***/
 
@@ -215,6 +216,36 @@ typedef struct SilcSKEParamsObject {
 } *SilcSKEParams, SilcSKEParamsStruct;
 /***/
 
+/****s* silcske/SilcSKEAPI/SilcSKECryptoStats
+ *
+ * NAME
+ *
+ *    typedef struct { ... } *SilcSKECryptoStats, SilcSKECryptoStatsStruct;
+ *
+ * DESCRIPTION
+ *
+ *    Statistics of the crypto worker pool, returned by the function
+ *    silc_ske_get_crypto_stats.  The `wait' and `run' are histograms of
+ *    the time operations spent in the queue and in the worker thread.
+ *    Bucket `i' counts operations that took less than 4^i milliseconds,
+ *    except the last bucket which counts all the rest.
+ *
+ * SOURCE
+ */
+#define SILC_SKE_CRYPTO_BUCKETS 8
+
+typedef struct SilcSKECryptoStatsObject {
+  SilcUInt32 workers;		/* Operations running in worker threads */
+  SilcUInt32 queued;		/* Operations waiting for a worker */
+  SilcUInt32 queued_peak;	/* Longest queue seen */
+  SilcUInt32 completed;		/* Operations completed in worker threads */
+  SilcUInt32 synchronous;	/* Operations run in the caller's thread */
+  SilcUInt32 rejected;		/* Key exchanges rejected, queue was full */
+  SilcUInt32 wait[SILC_SKE_CRYPTO_BUCKETS];  /* Queue wait histogram */
+  SilcUInt32 run[SILC_SKE_CRYPTO_BUCKETS];   /* Run time histogram */
+} *SilcSKECryptoStats, SilcSKECryptoStatsStruct;
+/***/
+
 /****d* silcske/SilcSKEAPI/SilcSKEPKType
  *
  * NAME
@@ -710,6 +741,47 @@ void silc_ske_free_rekey_material(SilcSKERekeyMaterial rekey);
  ***/
 const char *silc_ske_map_status(SilcSKEStatus status);
 
+/****f* silcske/SilcSKEAPI/silc_ske_set_crypto_workers
+ *
+ * SYNOPSIS
+ *
+ *    void silc_ske_set_crypto_workers(SilcUInt32 max_workers,
+ *                                     SilcUInt32 max_queue);
+ *
+ * DESCRIPTION
+ *
+ *    Sets the size of the crypto worker pool shared by all SKE sessions.
+ *    When set, the Diffie-Hellman computation and the signature operations
+ *    of the responder are run in at most `max_workers' real threads, and
+ *    the calling scheduler is not blocked by them.  Sessions beyond that
+ *    wait in a queue of at most `max_queue' sessions.  When the queue is
+ *    full new key exchanges fail with SILC_SKE_STATUS_BUSY.  If `max_queue'
+ *    is zero the queue is not limited.
+ *
+ *    By default the pool is disabled and the operations are run
+ *    synchronously in the scheduler.  Giving zero `max_workers' disables
+ *    the pool again.  This may be called again to change the limits.
+ *    The pool is not used when the library is compiled without threads
+ *    support.
+ *
+ ***/
+void silc_ske_set_crypto_workers(SilcUInt32 max_workers,
+				 SilcUInt32 max_queue);
+
+/****f* silcske/SilcSKEAPI/silc_ske_get_crypto_stats
+ *
+ * SYNOPSIS
+ *
+ *    void silc_ske_get_crypto_stats(SilcSKECryptoStats stats);
+ *
+ * DESCRIPTION
+ *
+ *    Returns the statistics of the crypto worker pool to `stats'.  See
+ *    silc_ske_set_crypto_workers.
+ *
+ ***/
+void silc_ske_get_crypto_stats(SilcSKECryptoStats stats);
+
 #include "silcske_i.h"
 
 #endif	/* !SILCSKE_H */
@@ -87,6 +87,16 @@ struct SilcSKEStruct {
     SilcUInt32 data_len;
   } retrans;
 
+  /* Crypto worker pool.  The `crypto_thread' runs `crypto' operation
+     while the machine waits. */
+  SilcFSMThreadStruct crypto_thread;
+  SilcSKEStatus (*crypto)(SilcSKE ske);
+  struct SilcSKEStruct *crypto_next;  /* Next in worker queue */
+  SilcInt64 crypto_queued;	      /* Time when queued */
+  SilcInt64 crypto_wait;	      /* Queue wait, microseconds */
+  SilcInt64 crypto_run;		      /* Run time, microseconds */
+  SilcSKEStatus crypto_status;	      /* Result of `crypto' */
+
   SilcUInt16 timeout;		      /* SKE timeout */
   SilcUInt16 refcnt;		      /* Reference counter */
 
@@ -95,6 +105,7 @@ struct SilcSKEStruct {
   unsigned int rekeying         : 1;  /* Set when rekeying */
   unsigned int failure_notified : 1;  /* Set to indicate that we already called
 					 the failure notify routine */
+  unsigned int crypto_running   : 1;  /* Set when `crypto' is in progress */
 };
 
 #endif /* SILCSKE_I_H */
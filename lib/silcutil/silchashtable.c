@@ -22,7 +22,12 @@
    keys are a lot in the hash table the lookup gets slower of course.
    However, this is reliable and no data is lost at any point. If you know
    that you never have duplicate keys then this is as fast as any simple
-   hash table. */
+   hash table.
+
+   The table may also be allocated as open addressing hash table with
+   silc_hash_table_alloc_open.  It has the same semantics, including
+   duplicate keys, but saves the entries inline in one array, which is
+   faster with large tables and tables with many lookups. */
 /* $Id$ */
 
 #include "silc.h"
@@ -51,6 +56,18 @@
   (ht->auto_rehash && (ht->entry_count * 2) < primesize[ht->table_size] && \
    ht->entry_count > primesize[SILC_HASH_TABLE_SIZE])
 
+/* Allocate and free hash table entry */
+#define SILC_HASH_ENTRY_ALLOC(ht)					\
+  ((ht)->slab ? silc_slab_get((ht)->slab) :				\
+   silc_calloc(1, sizeof(struct SilcHashTableEntryStruct)))
+#define SILC_HASH_ENTRY_FREE(ht, e)					\
+do {									\
+  if ((ht)->slab)							\
+    silc_slab_put((ht)->slab, (e));					\
+  else									\
+    silc_free((e));							\
+} while(0)
+
 /* One entry in the hash table. Includes the key and the associated
    context. The `next' pointer is non-NULL if two (or more) different
    keys hashed to same value.  The pointer is the pointer to the next
@@ -61,18 +78,36 @@ typedef struct SilcHashTableEntryStruct {
   struct SilcHashTableEntryStruct *next;
 } *SilcHashTableEntry;
 
+/* One slot in the open addressing hash table.  The key and context are
+   saved inline. */
+typedef struct {
+  SilcUInt32 hash;
+  void *key;
+  void *context;
+} SilcHashTableSlot;
+
 /* Hash table. */
 struct SilcHashTableStruct {
   SilcHashTableEntry *table;
+  SilcHashTableSlot *slots;		/* Open addressing table */
   SilcUInt32 table_size;
+  SilcUInt32 mask;			/* Open addressing table size - 1 */
   SilcUInt32 entry_count;
+  SilcUInt32 deleted_count;		/* Deleted open addressing slots */
+  SilcHashTableSlot *old_slots;		/* Old table while rehashing */
+  SilcUInt32 old_mask;			/* Old table size - 1 */
+  SilcUInt32 old_count;			/* Entries in old table */
+  SilcUInt32 move_pos;			/* Next old slot to move */
+  SilcUInt32 move_left;			/* Old slots left to move */
   SilcHashFunction hash;
   SilcHashCompare compare;
   SilcHashDestructor destructor;
   void *hash_user_context;
   void *compare_user_context;
   void *destructor_user_context;
+  SilcSlab slab;
   unsigned int auto_rehash : 1;
+  unsigned int open        : 1;
 };
 
 /* Prime sizes for the hash table. The size of the table will always
@@ -104,6 +139,508 @@ static SilcUInt32 silc_hash_table_primesize(SilcUInt32 size, SilcUInt32 *index)
   return primesize[i - 1];
 }
 
+/* Open addressing hash table.  The entries are saved inline in one
+   array of power of two size and collisions are resolved with linear
+   probing.  The hash of each entry is saved in the slot and compared
+   before the key.  Deleted slots are marked deleted until the table is
+   rehashed.  Duplicate keys are kept in the order they were added by
+   never adding a key before an existing entry with same key.
+
+   When table with auto rehashing grows, the old array is kept and the
+   entries are moved to the new array few slots at a time when entries
+   are added or deleted.  New entries are added to the new array.  The
+   old array is searched first, and before a key is added to the new
+   array all entries with same key are moved from the old array, so the
+   entries with same key remain in the order they were added. */
+
+/* Slot states.  Used slot has the highest bit set in the saved hash. */
+#define SILC_HASH_SLOT_EMPTY   0
+#define SILC_HASH_SLOT_DELETED 1
+#define SILC_HASH_SLOT_USED    0x80000000
+#define SILC_HASH_SLOT_IS_USED(s) ((s)->hash & SILC_HASH_SLOT_USED)
+
+/* Minimum size of open addressing table */
+#define SILC_HASH_OPEN_MIN_SIZE 8
+
+/* Number of old slots moved to new array in one operation while
+   rehashing.  The new array is twice the size of the old array and
+   the old array is at most half full, so this guarantees all entries
+   have been moved well before the new array needs rehashing. */
+#define SILC_HASH_OPEN_MOVE 32
+
+/* Number of used and deleted slots in the new array */
+#define SILC_HASH_OPEN_USED(ht) \
+  ((ht)->entry_count - (ht)->old_count + (ht)->deleted_count)
+
+/* Check whether need to rehash.  Table is grown when half full, counting
+   deleted slots too, or when 7/8 full if auto rehashing is disabled,
+   since there must always be empty slots in the table.  Adding probes
+   until empty slot, so the load is kept low. */
+#define SILC_HASH_OPEN_REHASH_INC					\
+  (ht->auto_rehash ?							\
+   (SILC_HASH_OPEN_USED(ht) + 1) * 2 > (ht->mask + 1) :			\
+   (SILC_HASH_OPEN_USED(ht) + 1) * 8 > (ht->mask + 1) * 7)
+#define SILC_HASH_OPEN_REHASH_DEC					\
+  (ht->auto_rehash && !ht->old_slots &&					\
+   ht->mask + 1 > SILC_HASH_OPEN_MIN_SIZE &&				\
+   ht->entry_count * 8 < ht->mask + 1)
+
+/* Mixes the hash value so that the lowest bits used as index depend on
+   all bits of the hash.  Pointer and integer hashes are not random in
+   the lowest bits. */
+
+static inline SilcUInt32 silc_hash_table_open_hash(SilcUInt32 h)
+{
+  h ^= h >> 16;
+  h *= 0x85ebca6b;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35;
+  h ^= h >> 16;
+  return h | SILC_HASH_SLOT_USED;
+}
+
+/* Returns size for open addressing table for `count' entries */
+
+static SilcUInt32 silc_hash_table_open_size(SilcUInt32 count)
+{
+  SilcUInt32 size = SILC_HASH_OPEN_MIN_SIZE;
+
+  while (size <= count * 2 && size < 0x80000000)
+    size <<= 1;
+
+  return size;
+}
+
+/* Returns the index of the first slot after an empty slot.  Entries with
+   same key are never on both sides of an empty slot. */
+
+static SilcUInt32 silc_hash_table_open_start(SilcHashTableSlot *slots,
+					     SilcUInt32 mask)
+{
+  SilcUInt32 i;
+
+  for (i = 0; i < mask; i++)
+    if (slots[i].hash == SILC_HASH_SLOT_EMPTY)
+      break;
+
+  return (i + 1) & mask;
+}
+
+/* Puts entry to the new array.  The entry is put after all entries with
+   same key, otherwise to first deleted or empty slot. */
+
+static void silc_hash_table_open_put(SilcHashTable ht, SilcUInt32 h,
+				     void *key, void *context)
+{
+  SilcHashTableSlot *s, *reuse = NULL;
+  SilcUInt32 i;
+
+  for (i = h & ht->mask; ; i = (i + 1) & ht->mask) {
+    s = &ht->slots[i];
+    if (s->hash == SILC_HASH_SLOT_EMPTY)
+      break;
+    if (s->hash == SILC_HASH_SLOT_DELETED) {
+      if (!reuse)
+	reuse = s;
+      continue;
+    }
+    if (s->hash == h &&
+	(ht->compare ? ht->compare(s->key, key, ht->compare_user_context) :
+	 s->key == key))
+      reuse = NULL;
+  }
+
+  if (reuse) {
+    s = reuse;
+    ht->deleted_count--;
+  }
+
+  s->hash = h;
+  s->key = key;
+  s->context = context;
+}
+
+/* Moves entry in old array slot `s' to the new array */
+
+static inline void silc_hash_table_open_move_slot(SilcHashTable ht,
+						  SilcHashTableSlot *s)
+{
+  silc_hash_table_open_put(ht, s->hash, s->key, s->context);
+  s->hash = SILC_HASH_SLOT_DELETED;
+  s->key = s->context = NULL;
+  ht->old_count--;
+}
+
+/* Frees the old array after all entries have been moved */
+
+static inline void silc_hash_table_open_move_done(SilcHashTable ht)
+{
+  SILC_HT_DEBUG(("Rehashing done"));
+  silc_free(ht->old_slots);
+  ht->old_slots = NULL;
+  ht->old_mask = 0;
+  ht->old_count = 0;
+  ht->move_left = 0;
+}
+
+/* Moves all entries with key `key' to the new array */
+
+static void silc_hash_table_open_move_key(SilcHashTable ht, SilcUInt32 h,
+					  void *key)
+{
+  SilcHashTableSlot *s;
+  SilcUInt32 i;
+
+  for (i = h & ht->old_mask; ; i = (i + 1) & ht->old_mask) {
+    s = &ht->old_slots[i];
+    if (s->hash == SILC_HASH_SLOT_EMPTY)
+      break;
+    if (s->hash == h &&
+	(ht->compare ? ht->compare(s->key, key, ht->compare_user_context) :
+	 s->key == key))
+      silc_hash_table_open_move_slot(ht, s);
+  }
+}
+
+/* Moves at most `count' old slots to the new array, or all of them if
+   `count' is zero.  All entries with same key are moved at once, so that
+   same key is never in both arrays. */
+
+static void silc_hash_table_open_move(SilcHashTable ht, SilcUInt32 count)
+{
+  SilcHashTableSlot *s;
+
+  if (!count)
+    count = ht->move_left;
+
+  while (count-- && ht->move_left && ht->old_count) {
+    s = &ht->old_slots[ht->move_pos];
+    ht->move_pos = (ht->move_pos + 1) & ht->old_mask;
+    ht->move_left--;
+    if (SILC_HASH_SLOT_IS_USED(s))
+      silc_hash_table_open_move_key(ht, s->hash, s->key);
+  }
+
+  if (!ht->move_left || !ht->old_count)
+    silc_hash_table_open_move_done(ht);
+}
+
+/* Rehashes open addressing table to `size' slots.  If `hash' is non-NULL
+   the hashes are computed again with it.  If `incremental' is TRUE the
+   entries are moved to the new array later. */
+
+static SilcBool silc_hash_table_open_resize(SilcHashTable ht, SilcUInt32 size,
+					    SilcHashFunction hash,
+					    void *hash_user_context,
+					    SilcBool incremental)
+{
+  SilcHashTableSlot *slots, *s, *n;
+  SilcUInt32 old_size, start, i, k, h;
+
+  /* Finish previous rehashing first */
+  if (ht->old_slots)
+    silc_hash_table_open_move(ht, 0);
+
+  SILC_HT_DEBUG(("Rehashing to %d slots", size));
+
+  slots = silc_calloc(size, sizeof(*ht->slots));
+  if (!slots)
+    return FALSE;
+
+  if (incremental && !hash && ht->entry_count) {
+    ht->old_slots = ht->slots;
+    ht->old_mask = ht->mask;
+    ht->old_count = ht->entry_count;
+    ht->move_pos = silc_hash_table_open_start(ht->slots, ht->mask);
+    ht->move_left = ht->mask + 1;
+    ht->slots = slots;
+    ht->mask = size - 1;
+    ht->deleted_count = 0;
+    return TRUE;
+  }
+
+  old_size = ht->mask + 1;
+  start = silc_hash_table_open_start(ht->slots, ht->mask);
+  s = ht->slots;
+  ht->slots = slots;
+  slots = s;
+  ht->mask = size - 1;
+  ht->deleted_count = 0;
+
+  /* Move the entries in order starting after an empty slot */
+  for (k = 0; k < old_size; k++) {
+    s = &slots[(start + k) & (old_size - 1)];
+    if (!SILC_HASH_SLOT_IS_USED(s))
+      continue;
+
+    h = s->hash;
+    if (hash)
+      h = silc_hash_table_open_hash(hash(s->key, hash_user_context));
+
+    for (i = h & ht->mask; ; i = (i + 1) & ht->mask) {
+      n = &ht->slots[i];
+      if (n->hash == SILC_HASH_SLOT_EMPTY)
+	break;
+    }
+    n->hash = h;
+    n->key = s->key;
+    n->context = s->context;
+  }
+
+  silc_free(slots);
+  return TRUE;
+}
+
+/* Finds the first slot by `key', and `context' if `use_context' is TRUE,
+   from the array `slots'. */
+
+static inline SilcHashTableSlot *
+silc_hash_table_open_find_slot(SilcHashTableSlot *slots, SilcUInt32 mask,
+			       SilcUInt32 h, void *key, void *context,
+			       SilcBool use_context, SilcHashCompare compare,
+			       void *compare_user_context)
+{
+  SilcHashTableSlot *s;
+  SilcUInt32 i;
+
+  for (i = h & mask; ; i = (i + 1) & mask) {
+    s = &slots[i];
+    if (s->hash == SILC_HASH_SLOT_EMPTY)
+      return NULL;
+    if (s->hash != h)
+      continue;
+    if (compare ? !compare(s->key, key, compare_user_context) :
+	s->key != key)
+      continue;
+    if (use_context && s->context != context)
+      continue;
+    return s;
+  }
+}
+
+/* Finds the first slot by `key', and `context' if `use_context' is TRUE. */
+
+static inline SilcHashTableSlot *
+silc_hash_table_open_find(SilcHashTable ht, void *key, void *context,
+			  SilcBool use_context, SilcHashFunction hash,
+			  void *hash_user_context, SilcHashCompare compare,
+			  void *compare_user_context)
+{
+  SilcHashTableSlot *s;
+  SilcUInt32 h;
+
+  h = silc_hash_table_open_hash(hash(key, hash_user_context));
+
+  SILC_HT_DEBUG(("index %d key %p", h & ht->mask, key));
+
+  if (ht->old_slots) {
+    s = silc_hash_table_open_find_slot(ht->old_slots, ht->old_mask, h, key,
+				       context, use_context, compare,
+				       compare_user_context);
+    if (s)
+      return s;
+  }
+
+  return silc_hash_table_open_find_slot(ht->slots, ht->mask, h, key,
+					context, use_context, compare,
+					compare_user_context);
+}
+
+/* Calls `foreach' for all entries by `key' in the array `slots' */
+
+static SilcBool
+silc_hash_table_open_find_all_slots(SilcHashTable ht,
+				    SilcHashTableSlot *slots,
+				    SilcUInt32 mask, SilcUInt32 h, void *key,
+				    SilcHashCompare compare,
+				    void *compare_user_context,
+				    SilcHashForeach foreach,
+				    void *foreach_user_context)
+{
+  SilcHashTableSlot *s;
+  SilcBool found = FALSE;
+  SilcUInt32 i;
+
+  for (i = h & mask; ; i = (i + 1) & mask) {
+    s = &slots[i];
+    if (s->hash == SILC_HASH_SLOT_EMPTY)
+      break;
+    if (s->hash != h)
+      continue;
+    if (compare ? !compare(s->key, key, compare_user_context) :
+	s->key != key)
+      continue;
+    found = TRUE;
+    foreach(s->key, s->context, foreach_user_context);
+  }
+
+  return found;
+}
+
+/* Calls `foreach' for all entries by `key' */
+
+static void
+silc_hash_table_open_find_all(SilcHashTable ht, void *key,
+			      SilcHashFunction hash,
+			      void *hash_user_context,
+			      SilcHashCompare compare,
+			      void *compare_user_context,
+			      SilcHashForeach foreach,
+			      void *foreach_user_context)
+{
+  SilcBool auto_rehash, found = FALSE;
+  SilcUInt32 h;
+
+  h = silc_hash_table_open_hash(hash(key, hash_user_context));
+
+  /* Disallow auto rehashing while going through the table since we call
+     the `foreach' function which could alter the table. */
+  auto_rehash = ht->auto_rehash;
+  ht->auto_rehash = FALSE;
+
+  if (ht->old_slots)
+    found = silc_hash_table_open_find_all_slots(ht, ht->old_slots,
+						ht->old_mask, h, key,
+						compare, compare_user_context,
+						foreach, foreach_user_context);
+  if (silc_hash_table_open_find_all_slots(ht, ht->slots, ht->mask, h, key,
+					  compare, compare_user_context,
+					  foreach, foreach_user_context))
+    found = TRUE;
+
+  /* If nothing was found call with NULL context the callback */
+  if (!found)
+    foreach(key, NULL, foreach_user_context);
+
+  ht->auto_rehash = auto_rehash;
+}
+
+/* Adds new entry to open addressing table */
+
+static SilcBool
+silc_hash_table_open_add(SilcHashTable ht, void *key, void *context,
+			 SilcHashFunction hash, void *hash_user_context)
+{
+  SilcUInt32 h;
+
+  if (SILC_HASH_OPEN_REHASH_INC) {
+    if (!silc_hash_table_open_resize(ht,
+				     silc_hash_table_open_size(ht->entry_count
+							       + 1),
+				     NULL, NULL, ht->auto_rehash) &&
+	SILC_HASH_OPEN_USED(ht) + 1 > ht->mask)
+      return FALSE;
+  }
+
+  h = silc_hash_table_open_hash(hash(key, hash_user_context));
+
+  SILC_HT_DEBUG(("index %d key %p", h & ht->mask, key));
+
+  if (ht->old_slots) {
+    /* Entries with same key are moved first to keep them in order */
+    silc_hash_table_open_move_key(ht, h, key);
+    if (ht->auto_rehash)
+      silc_hash_table_open_move(ht, SILC_HASH_OPEN_MOVE);
+  }
+
+  silc_hash_table_open_put(ht, h, key, context);
+  ht->entry_count++;
+
+  return TRUE;
+}
+
+/* Deletes the entry in slot `s' */
+
+static void silc_hash_table_open_del(SilcHashTable ht, SilcHashTableSlot *s,
+				     SilcHashDestructor destructor,
+				     void *destructor_user_context)
+{
+  void *key = s->key, *context = s->context;
+
+  if (ht->old_slots && s >= ht->old_slots &&
+      s <= ht->old_slots + ht->old_mask)
+    ht->old_count--;
+  else
+    ht->deleted_count++;
+
+  s->hash = SILC_HASH_SLOT_DELETED;
+  s->key = s->context = NULL;
+  ht->entry_count--;
+
+  if (ht->old_slots && ht->auto_rehash)
+    silc_hash_table_open_move(ht, SILC_HASH_OPEN_MOVE);
+
+  if (destructor)
+    destructor(key, context, destructor_user_context);
+
+  if (SILC_HASH_OPEN_REHASH_DEC)
+    silc_hash_table_open_resize(ht, silc_hash_table_open_size(ht->entry_count),
+				NULL, NULL, FALSE);
+}
+
+/* Finds and deletes entry by `key', and `context' if `use_context' is
+   TRUE, from open addressing table. */
+
+static SilcBool
+silc_hash_table_open_del_key(SilcHashTable ht, void *key, void *context,
+			     SilcBool use_context,
+			     SilcHashFunction hash,
+			     void *hash_user_context,
+			     SilcHashCompare compare,
+			     void *compare_user_context,
+			     SilcHashDestructor destructor,
+			     void *destructor_user_context)
+{
+  SilcHashTableSlot *s;
+
+  s = silc_hash_table_open_find(ht, key, context, use_context,
+				hash, hash_user_context,
+				compare, compare_user_context);
+  if (!s)
+    return FALSE;
+
+  silc_hash_table_open_del(ht, s, destructor, destructor_user_context);
+  return TRUE;
+}
+
+/* Replaces entry in open addressing table, or adds new one */
+
+static SilcBool
+silc_hash_table_open_replace(SilcHashTable ht, void *key, void *context,
+			     SilcHashFunction hash, void *hash_user_context)
+{
+  SilcHashTableSlot *s;
+
+  s = silc_hash_table_open_find(ht, key, NULL, FALSE, hash,
+				hash_user_context, ht->compare,
+				ht->compare_user_context);
+  if (!s)
+    return silc_hash_table_open_add(ht, key, context, hash,
+				    hash_user_context);
+
+  if (ht->destructor)
+    ht->destructor(s->key, s->context, ht->destructor_user_context);
+  s->key = key;
+  s->context = context;
+
+  return TRUE;
+}
+
+/* Returns slot by index, counting old array slots first */
+
+static inline SilcHashTableSlot *
+silc_hash_table_open_slot(SilcHashTable ht, SilcUInt32 index)
+{
+  if (ht->old_slots) {
+    if (index <= ht->old_mask)
+      return &ht->old_slots[index];
+    index -= ht->old_mask + 1;
+  }
+  if (index > ht->mask)
+    return NULL;
+  return &ht->slots[index];
+}
+
 /* Internal routine to find entry in the hash table by `key'. Returns
    the previous entry (if exists) as well. */
 
@@ -217,7 +754,16 @@ silc_hash_table_find_internal_all(SilcHashTable ht, void *key,
 {
   SilcHashTableEntry e, tmp;
   SilcBool auto_rehash, found = FALSE;
-  SilcUInt32 i = SILC_HASH_TABLE_HASH(hash, hash_user_context);
+  SilcUInt32 i;
+
+  if (ht->open) {
+    silc_hash_table_open_find_all(ht, key, hash, hash_user_context,
+				  compare, compare_user_context,
+				  foreach, foreach_user_context);
+    return;
+  }
+
+  i = SILC_HASH_TABLE_HASH(hash, hash_user_context);
 
   SILC_HT_DEBUG(("index %d key %p", i, key));
 
@@ -281,7 +827,7 @@ silc_hash_table_add_internal(SilcHashTable ht, void *key, void *context,
 
     SILC_HT_DEBUG(("Collision; adding new key to list"));
 
-    e->next = silc_calloc(1, sizeof(*e->next));
+    e->next = SILC_HASH_ENTRY_ALLOC(ht);
     if (!e->next)
       return FALSE;
     e->next->key = key;
@@ -290,7 +836,7 @@ silc_hash_table_add_internal(SilcHashTable ht, void *key, void *context,
   } else {
     /* New key */
     SILC_HT_DEBUG(("New key"));
-    *entry = silc_calloc(1, sizeof(**entry));
+    *entry = SILC_HASH_ENTRY_ALLOC(ht);
     if (!(*entry))
       return FALSE;
     (*entry)->key = key;
@@ -325,7 +871,7 @@ silc_hash_table_replace_internal(SilcHashTable ht, void *key, void *context,
 		     ht->destructor_user_context);
   } else {
     /* New key */
-    *entry = silc_calloc(1, sizeof(**entry));
+    *entry = SILC_HASH_ENTRY_ALLOC(ht);
     if (!(*entry))
       return FALSE;
     ht->entry_count++;
@@ -348,17 +894,19 @@ silc_hash_table_replace_internal(SilcHashTable ht, void *key, void *context,
    destructor function, respectively. The `hash' is mandatory, the others
    are optional. */
 
-SilcHashTable silc_hash_table_alloc(SilcUInt32 table_size,
-				    SilcHashFunction hash,
-				    void *hash_user_context,
-				    SilcHashCompare compare,
-				    void *compare_user_context,
-				    SilcHashDestructor destructor,
-				    void *destructor_user_context,
-				    SilcBool auto_rehash)
+static SilcHashTable
+silc_hash_table_alloc_internal(SilcUInt32 table_size,
+			       SilcHashFunction hash,
+			       void *hash_user_context,
+			       SilcHashCompare compare,
+			       void *compare_user_context,
+			       SilcHashDestructor destructor,
+			       void *destructor_user_context,
+			       SilcBool auto_rehash,
+			       SilcBool open)
 {
   SilcHashTable ht;
-  SilcUInt32 size_index = SILC_HASH_TABLE_SIZE;
+  SilcUInt32 size_index = SILC_HASH_TABLE_SIZE, size;
 
   if (!hash)
     return NULL;
@@ -366,15 +914,28 @@ SilcHashTable silc_hash_table_alloc(SilcUInt32 table_size,
   ht = silc_calloc(1, sizeof(*ht));
   if (!ht)
     return NULL;
-  ht->table = silc_calloc(table_size ? silc_hash_table_primesize(table_size,
-								 &size_index) :
-			  primesize[SILC_HASH_TABLE_SIZE],
-			  sizeof(*ht->table));
-  if (!ht->table) {
-    silc_free(ht);
-    return NULL;
+
+  if (open) {
+    size = silc_hash_table_open_size(table_size);
+    ht->slots = silc_calloc(size, sizeof(*ht->slots));
+    if (!ht->slots) {
+      silc_free(ht);
+      return NULL;
+    }
+    ht->mask = size - 1;
+    ht->open = TRUE;
+  } else {
+    ht->table = silc_calloc(table_size ?
+			    silc_hash_table_primesize(table_size,
+						      &size_index) :
+			    primesize[SILC_HASH_TABLE_SIZE],
+			    sizeof(*ht->table));
+    if (!ht->table) {
+      silc_free(ht);
+      return NULL;
+    }
+    ht->table_size = size_index;
   }
-  ht->table_size = size_index;
   ht->hash = hash;
   ht->compare = compare;
   ht->destructor = destructor;
@@ -386,6 +947,39 @@ SilcHashTable silc_hash_table_alloc(SilcUInt32 table_size,
   return ht;
 }
 
+SilcHashTable silc_hash_table_alloc(SilcUInt32 table_size,
+				    SilcHashFunction hash,
+				    void *hash_user_context,
+				    SilcHashCompare compare,
+				    void *compare_user_context,
+				    SilcHashDestructor destructor,
+				    void *destructor_user_context,
+				    SilcBool auto_rehash)
+{
+  return silc_hash_table_alloc_internal(table_size, hash, hash_user_context,
+					compare, compare_user_context,
+					destructor, destructor_user_context,
+					auto_rehash, FALSE);
+}
+
+/* Allocates new open addressing hash table.  The `table_size' is the
+   number of entries the table should hold without rehashing. */
+
+SilcHashTable silc_hash_table_alloc_open(SilcUInt32 table_size,
+					 SilcHashFunction hash,
+					 void *hash_user_context,
+					 SilcHashCompare compare,
+					 void *compare_user_context,
+					 SilcHashDestructor destructor,
+					 void *destructor_user_context,
+					 SilcBool auto_rehash)
+{
+  return silc_hash_table_alloc_internal(table_size, hash, hash_user_context,
+					compare, compare_user_context,
+					destructor, destructor_user_context,
+					auto_rehash, TRUE);
+}
+
 /* Frees the hash table. The destructor function provided in the
    silc_hash_table_alloc will be called for all keys in the hash table. */
 
@@ -394,6 +988,18 @@ void silc_hash_table_free(SilcHashTable ht)
   SilcHashTableEntry e, tmp;
   int i;
 
+  if (ht->open) {
+    SilcHashTableSlot *s;
+
+    for (i = 0; (s = silc_hash_table_open_slot(ht, i)); i++)
+      if (SILC_HASH_SLOT_IS_USED(s) && ht->destructor)
+	ht->destructor(s->key, s->context, ht->destructor_user_context);
+    silc_free(ht->old_slots);
+    silc_free(ht->slots);
+    silc_free(ht);
+    return;
+  }
+
   for (i = 0; i < primesize[ht->table_size]; i++) {
     e = ht->table[i];
     while (e) {
@@ -401,7 +1007,7 @@ void silc_hash_table_free(SilcHashTable ht)
 	ht->destructor(e->key, e->context, ht->destructor_user_context);
       tmp = e;
       e = e->next;
-      silc_free(tmp);
+      SILC_HASH_ENTRY_FREE(ht, tmp);
     }
   }
 
@@ -409,10 +1015,28 @@ void silc_hash_table_free(SilcHashTable ht)
   silc_free(ht);
 }
 
+/* Allocates slab for hash table entries */
+
+SilcSlab silc_hash_table_slab_alloc(SilcUInt32 count)
+{
+  return silc_slab_alloc(sizeof(struct SilcHashTableEntryStruct), count);
+}
+
+/* Sets slab for the hash table entries */
+
+void silc_hash_table_set_slab(SilcHashTable ht, SilcSlab slab)
+{
+  if (ht->open)
+    return;
+  ht->slab = slab;
+}
+
 /* Returns the size of the hash table */
 
 SilcUInt32 silc_hash_table_size(SilcHashTable ht)
 {
+  if (ht->open)
+    return ht->mask + 1;
   return primesize[ht->table_size];
 }
 
@@ -432,6 +1056,9 @@ SilcUInt32 silc_hash_table_count(SilcHashTable ht)
 
 SilcBool silc_hash_table_add(SilcHashTable ht, void *key, void *context)
 {
+  if (ht->open)
+    return silc_hash_table_open_add(ht, key, context, ht->hash,
+				    ht->hash_user_context);
   return silc_hash_table_add_internal(ht, key, context, ht->hash,
 				      ht->hash_user_context);
 }
@@ -442,6 +1069,9 @@ SilcBool silc_hash_table_add_ext(SilcHashTable ht, void *key, void *context,
 				 SilcHashFunction hash,
 				 void *hash_user_context)
 {
+  if (ht->open)
+    return silc_hash_table_open_add(ht, key, context, hash,
+				    hash_user_context);
   return silc_hash_table_add_internal(ht, key, context,
 				      hash, hash_user_context);
 }
@@ -453,6 +1083,9 @@ SilcBool silc_hash_table_add_ext(SilcHashTable ht, void *key, void *context,
 
 SilcBool silc_hash_table_replace(SilcHashTable ht, void *key, void *context)
 {
+  if (ht->open)
+    return silc_hash_table_open_replace(ht, key, context, ht->hash,
+					ht->hash_user_context);
   return silc_hash_table_replace_internal(ht, key, context, ht->hash,
 					  ht->hash_user_context);
 }
@@ -464,6 +1097,9 @@ SilcBool silc_hash_table_replace_ext(SilcHashTable ht, void *key,
 				     SilcHashFunction hash,
 				     void *hash_user_context)
 {
+  if (ht->open)
+    return silc_hash_table_open_replace(ht, key, context, hash,
+					hash_user_context);
   return silc_hash_table_replace_internal(ht, key, context,
 					  hash, hash_user_context);
 }
@@ -476,6 +1112,13 @@ SilcBool silc_hash_table_del(SilcHashTable ht, void *key)
 {
   SilcHashTableEntry *entry, prev, e;
 
+  if (ht->open)
+    return silc_hash_table_open_del_key(ht, key, NULL, FALSE,
+					ht->hash, ht->hash_user_context,
+					ht->compare, ht->compare_user_context,
+					ht->destructor,
+					ht->destructor_user_context);
+
   entry = silc_hash_table_find_internal(ht, key, &prev,
 					ht->hash, ht->hash_user_context,
 					ht->compare, ht->compare_user_context);
@@ -495,7 +1138,7 @@ SilcBool silc_hash_table_del(SilcHashTable ht, void *key)
 
   if (ht->destructor)
     ht->destructor(e->key, e->context, ht->destructor_user_context);
-  silc_free(e);
+  SILC_HASH_ENTRY_FREE(ht, e);
 
   ht->entry_count--;
 
@@ -517,6 +1160,20 @@ SilcBool silc_hash_table_del_ext(SilcHashTable ht, void *key,
 {
   SilcHashTableEntry *entry, prev, e;
 
+  if (ht->open)
+    return silc_hash_table_open_del_key(ht, key, NULL, FALSE,
+					hash ? hash : ht->hash,
+					hash_user_context ? hash_user_context :
+					ht->hash_user_context,
+					compare ? compare : ht->compare,
+					compare_user_context ?
+					compare_user_context :
+					ht->compare_user_context,
+					destructor ? destructor :
+					ht->destructor,
+					destructor ? destructor_user_context :
+					ht->destructor_user_context);
+
   entry = silc_hash_table_find_internal(ht, key, &prev,
 					hash ? hash : ht->hash,
 					hash_user_context ? hash_user_context :
@@ -545,7 +1202,7 @@ SilcBool silc_hash_table_del_ext(SilcHashTable ht, void *key,
     if (ht->destructor)
       ht->destructor(e->key, e->context, ht->destructor_user_context);
   }
-  silc_free(e);
+  SILC_HASH_ENTRY_FREE(ht, e);
 
   ht->entry_count--;
 
@@ -565,6 +1222,13 @@ SilcBool silc_hash_table_del_by_context(SilcHashTable ht, void *key,
 {
   SilcHashTableEntry *entry, prev, e;
 
+  if (ht->open)
+    return silc_hash_table_open_del_key(ht, key, context, TRUE,
+					ht->hash, ht->hash_user_context,
+					ht->compare, ht->compare_user_context,
+					ht->destructor,
+					ht->destructor_user_context);
+
   entry = silc_hash_table_find_internal_context(ht, key, context, &prev,
 						ht->hash,
 						ht->hash_user_context,
@@ -586,7 +1250,7 @@ SilcBool silc_hash_table_del_by_context(SilcHashTable ht, void *key,
 
   if (ht->destructor)
     ht->destructor(e->key, e->context, ht->destructor_user_context);
-  silc_free(e);
+  SILC_HASH_ENTRY_FREE(ht, e);
 
   ht->entry_count--;
 
@@ -609,6 +1273,20 @@ SilcBool silc_hash_table_del_by_context_ext(SilcHashTable ht, void *key,
 {
   SilcHashTableEntry *entry, prev, e;
 
+  if (ht->open)
+    return silc_hash_table_open_del_key(ht, key, context, TRUE,
+					hash ? hash : ht->hash,
+					hash_user_context ? hash_user_context :
+					ht->hash_user_context,
+					compare ? compare : ht->compare,
+					compare_user_context ?
+					compare_user_context :
+					ht->compare_user_context,
+					destructor ? destructor :
+					ht->destructor,
+					destructor ? destructor_user_context :
+					ht->destructor_user_context);
+
   entry = silc_hash_table_find_internal_context(ht, key, context, &prev,
 						hash ? hash : ht->hash,
 						hash_user_context ?
@@ -639,7 +1317,7 @@ SilcBool silc_hash_table_del_by_context_ext(SilcHashTable ht, void *key,
     if (ht->destructor)
       ht->destructor(e->key, e->context, ht->destructor_user_context);
   }
-  silc_free(e);
+  SILC_HASH_ENTRY_FREE(ht, e);
 
   ht->entry_count--;
 
@@ -673,6 +1351,25 @@ SilcBool silc_hash_table_find_ext(SilcHashTable ht, void *key,
 {
   SilcHashTableEntry *entry;
 
+  if (ht->open) {
+    SilcHashTableSlot *s;
+
+    s = silc_hash_table_open_find(ht, key, NULL, FALSE,
+				  hash ? hash : ht->hash,
+				  hash_user_context ? hash_user_context :
+				  ht->hash_user_context,
+				  compare ? compare : ht->compare,
+				  compare_user_context ? compare_user_context :
+				  ht->compare_user_context);
+    if (!s)
+      return FALSE;
+    if (ret_key)
+      *ret_key = s->key;
+    if (ret_context)
+      *ret_context = s->context;
+    return TRUE;
+  }
+
   entry = silc_hash_table_find_internal_simple(ht, key,
 					       hash ? hash : ht->hash,
 					       hash_user_context ?
@@ -714,6 +1411,23 @@ SilcBool silc_hash_table_find_by_context_ext(SilcHashTable ht, void *key,
 {
   SilcHashTableEntry *entry;
 
+  if (ht->open) {
+    SilcHashTableSlot *s;
+
+    s = silc_hash_table_open_find(ht, key, context, TRUE,
+				  hash ? hash : ht->hash,
+				  hash_user_context ? hash_user_context :
+				  ht->hash_user_context,
+				  compare ? compare : ht->compare,
+				  compare_user_context ? compare_user_context :
+				  ht->compare_user_context);
+    if (!s)
+      return FALSE;
+    if (ret_key)
+      *ret_key = s->key;
+    return TRUE;
+  }
+
   entry = silc_hash_table_find_internal_context(ht, key, context, NULL,
 						hash ? hash : ht->hash,
 						hash_user_context ?
@@ -784,6 +1498,18 @@ void silc_hash_table_foreach(SilcHashTable ht, SilcHashForeach foreach,
 
   auto_rehash = ht->auto_rehash;
   ht->auto_rehash = FALSE;
+
+  if (ht->open) {
+    SilcHashTableSlot *s;
+
+    /* Table may be rehashed inside the `foreach' if it adds entries */
+    for (i = 0; (s = silc_hash_table_open_slot(ht, i)); i++)
+      if (SILC_HASH_SLOT_IS_USED(s))
+	foreach(s->key, s->context, user_context);
+    ht->auto_rehash = auto_rehash;
+    return;
+  }
+
   for (i = 0; i < primesize[ht->table_size]; i++) {
     e = ht->table[i];
     while (e) {
@@ -810,6 +1536,14 @@ void silc_hash_table_rehash(SilcHashTable ht, SilcUInt32 new_size)
 
   SILC_HT_DEBUG(("Start"));
 
+  if (ht->open) {
+    if (new_size < ht->entry_count)
+      new_size = ht->entry_count;
+    silc_hash_table_open_resize(ht, silc_hash_table_open_size(new_size),
+				NULL, NULL, FALSE);
+    return;
+  }
+
   if (new_size)
     silc_hash_table_primesize(new_size, &size_index);
   else
@@ -842,7 +1576,7 @@ void silc_hash_table_rehash(SilcHashTable ht, SilcUInt32 new_size)
       e = e->next;
 
       /* Remove old entry */
-      silc_free(tmp);
+      SILC_HASH_ENTRY_FREE(ht, tmp);
     }
   }
 
@@ -865,6 +1599,14 @@ void silc_hash_table_rehash_ext(SilcHashTable ht, SilcUInt32 new_size,
 
   SILC_HT_DEBUG(("Start"));
 
+  if (ht->open) {
+    if (new_size < ht->entry_count)
+      new_size = ht->entry_count;
+    silc_hash_table_open_resize(ht, silc_hash_table_open_size(new_size),
+				hash, hash_user_context, FALSE);
+    return;
+  }
+
   if (new_size)
     silc_hash_table_primesize(new_size, &size_index);
   else
@@ -898,7 +1640,7 @@ void silc_hash_table_rehash_ext(SilcHashTable ht, SilcUInt32 new_size,
       e = e->next;
 
       /* Remove old entry */
-      silc_free(tmp);
+      SILC_HASH_ENTRY_FREE(ht, tmp);
     }
   }
 
@@ -943,6 +1685,22 @@ SilcBool silc_hash_table_get(SilcHashTableList *htl, void **key,
   if (!htl->ht->entry_count)
     return FALSE;
 
+  if (htl->ht->open) {
+    SilcHashTableSlot *s;
+
+    while ((s = silc_hash_table_open_slot(htl->ht, htl->index))) {
+      htl->index++;
+      if (!SILC_HASH_SLOT_IS_USED(s))
+	continue;
+      if (key)
+	*key = s->key;
+      if (context)
+	*context = s->context;
+      return TRUE;
+    }
+    return FALSE;
+  }
+
   while (!entry && htl->index < primesize[htl->ht->table_size]) {
     entry = htl->ht->table[htl->index];
     htl->index++;
@@ -201,6 +201,51 @@ SilcHashTable silc_hash_table_alloc(SilcUInt32 table_size,
 				    void *destructor_user_context,
 				    SilcBool auto_rehash);
 
+/****f* silcutil/SilcHashTableAPI/silc_hash_table_alloc_open
+ *
+ * SYNOPSIS
+ *
+ *    SilcHashTable silc_hash_table_alloc_open(SilcUInt32 table_size,
+ *                                             SilcHashFunction hash,
+ *                                             void *hash_user_context,
+ *                                             SilcHashCompare compare,
+ *                                             void *compare_user_context,
+ *                                             SilcHashDestructor destructor,
+ *                                             void *destructor_user_context,
+ *                                             SilcBool auto_rehash);
+ *
+ * DESCRIPTION
+ *
+ *    Same as silc_hash_table_alloc but allocates open addressing hash
+ *    table.  The entries are saved inline in one array instead of
+ *    allocating memory for each entry, and the hash of each entry is
+ *    saved to avoid calling `compare' for different keys.  The table
+ *    is used with the same silc_hash_table_* functions and it may have
+ *    duplicate keys.  The `table_size' is the number of entries the
+ *    table can hold before it is rehashed, or zero to use the default.
+ *
+ *    If `auto_rehash' is TRUE the table is rehashed incrementally.  When
+ *    the table grows the entries are moved to the new table few at a
+ *    time when entries are added or deleted, so that adding an entry to
+ *    a large table does not stop to move all entries at once.
+ *
+ * NOTES
+ *
+ *    Even if `auto_rehash' is FALSE the table is rehashed when it is
+ *    nearly full, since entries cannot be chained.  Adding entries while
+ *    traversing the table may cause the traversing to miss or return
+ *    some entries twice.  Deleting entries while traversing is safe.
+ *
+ ***/
+SilcHashTable silc_hash_table_alloc_open(SilcUInt32 table_size,
+					 SilcHashFunction hash,
+					 void *hash_user_context,
+					 SilcHashCompare compare,
+					 void *compare_user_context,
+					 SilcHashDestructor destructor,
+					 void *destructor_user_context,
+					 SilcBool auto_rehash);
+
 /****f* silcutil/SilcHashTableAPI/silc_hash_table_free
  *
  * SYNOPSIS
@@ -215,6 +260,40 @@ SilcHashTable silc_hash_table_alloc(SilcUInt32 table_size,
  ***/
 void silc_hash_table_free(SilcHashTable ht);
 
+/****f* silcutil/SilcHashTableAPI/silc_hash_table_slab_alloc
+ *
+ * SYNOPSIS
+ *
+ *    SilcSlab silc_hash_table_slab_alloc(SilcUInt32 count);
+ *
+ * DESCRIPTION
+ *
+ *    Allocates slab for hash table entries.  The slab can be set to one
+ *    or more hash tables with silc_hash_table_set_slab.  The entries are
+ *    allocated from the slab in chunks of `count' entries, or default
+ *    count if it is zero.  Free the slab with silc_slab_free after all
+ *    hash tables using it have been freed.
+ *
+ ***/
+SilcSlab silc_hash_table_slab_alloc(SilcUInt32 count);
+
+/****f* silcutil/SilcHashTableAPI/silc_hash_table_set_slab
+ *
+ * SYNOPSIS
+ *
+ *    void silc_hash_table_set_slab(SilcHashTable ht, SilcSlab slab);
+ *
+ * DESCRIPTION
+ *
+ *    Sets the slab `slab' allocated with silc_hash_table_slab_alloc to be
+ *    used to allocate the entries of the hash table `ht'.  This must be
+ *    called before adding any entries to the hash table.  This is useful
+ *    when application has lot of small hash tables.  This has no effect
+ *    for open addressing hash table.
+ *
+ ***/
+void silc_hash_table_set_slab(SilcHashTable ht, SilcSlab slab);
+
 /****f* silcutil/SilcHashTableAPI/silc_hash_table_size
  *
  * SYNOPSIS
@@ -25,6 +25,9 @@ typedef struct {
   SilcUInt32 flushdelay;
 
   char debug_string[128];
+  regex_t debug_regex;		/* Compiled debug_string */
+  SilcMutex debug_lock;		/* Protects debug_regex */
+  SilcUInt32 generation;	/* Debug call site cache generation */
   SilcLogDebugCb debug_cb;
   void *debug_context;
   SilcLogHexdumpCb hexdump_cb;
@@ -37,6 +40,7 @@ typedef struct {
   unsigned int scheduled       : 1;
   unsigned int no_init         : 1;
   unsigned int starting        : 1;
+  unsigned int debug_regex_set : 1;
 } *SilcLogSettings, SilcLogSettingsStruct;
 
 /* SilcLog context */
@@ -57,6 +61,9 @@ static SilcLogSettingsStruct silclog =
 {
   300,
   { 0 },
+  { 0 },
+  NULL,
+  1,
   NULL, NULL,
   NULL, NULL,
   TRUE,
@@ -66,8 +73,23 @@ static SilcLogSettingsStruct silclog =
   FALSE,
   FALSE,
   TRUE,
+  FALSE,
 };
 
+/* Debug call site generations, see silclog_i.h */
+volatile SilcUInt32 silc_log_debug_generation = 0;
+volatile SilcUInt32 silc_log_hexdump_generation = 0;
+
+/* Publishes the current generation to the call sites.  Called whenever
+   debugging is enabled or disabled or the debug string changes. */
+
+static void silc_log_debug_publish(void)
+{
+  silc_log_debug_generation = silclog.debug ? silclog.generation : 0;
+  silc_log_hexdump_generation =
+    silclog.debug_hexdump ? silclog.generation : 0;
+}
+
 #endif /* !SILC_SYMBIAN */
 
 /* Default log contexts */
@@ -430,9 +452,31 @@ void silc_log_set_debug_string(const char *debug_string)
   len = strlen(string);
   if (len >= sizeof(silclog.debug_string))
     len = sizeof(silclog.debug_string) - 1;
+
+  if (!silclog.debug_lock)
+    silc_mutex_alloc(&silclog.debug_lock);
+  silc_mutex_lock(silclog.debug_lock);
+
   memset(silclog.debug_string, 0, sizeof(silclog.debug_string));
   strncpy(silclog.debug_string, string, len);
   silc_free(string);
+
+  /* Compile the debug string once here instead of for every message.  If
+     it does not compile nothing matches, as before. */
+  if (silclog.debug_regex_set)
+    regfree(&silclog.debug_regex);
+  silclog.debug_regex_set =
+    regcomp(&silclog.debug_regex, silclog.debug_string,
+	    REG_NOSUB | REG_EXTENDED) == 0;
+
+  /* Invalidate all call sites.  Generation must fit to 31 bits and
+     never be zero. */
+  silclog.generation = (silclog.generation + 1) & 0x7fffffff;
+  if (!silclog.generation)
+    silclog.generation = 1;
+  silc_log_debug_publish();
+
+  silc_mutex_unlock(silclog.debug_lock);
 #endif /* !SILC_SYMBIAN */
 }
 
@@ -469,6 +513,7 @@ void silc_log_debug(SilcBool enable)
 {
 #ifndef SILC_SYMBIAN
   silclog.debug = enable;
+  silc_log_debug_publish();
 #endif /* !SILC_SYMBIAN */
 }
 
@@ -478,10 +523,37 @@ void silc_log_debug_hexdump(SilcBool enable)
 {
 #ifndef SILC_SYMBIAN
   silclog.debug_hexdump = enable;
+  silc_log_debug_publish();
 #endif /* !SILC_SYMBIAN */
 }
 
-/* Outputs the debug message to stderr. */
+#ifndef SILC_SYMBIAN
+/* Matches debug call site against the debug string and caches the result
+   for the `generation'.  Called from silc_log_debug_site when the cached
+   result is stale. */
+
+SilcBool silc_log_debug_site_update(SilcLogSite *site, SilcUInt32 generation,
+				    const char *file, const char *function)
+{
+  SilcBool match;
+
+  silc_mutex_lock(silclog.debug_lock);
+  if (!silclog.debug_string[0])
+    match = TRUE;
+  else if (!silclog.debug_regex_set)
+    match = FALSE;
+  else
+    match = (regexec(&silclog.debug_regex, file, 0, NULL, 0) == 0 ||
+	     regexec(&silclog.debug_regex, function, 0, NULL, 0) == 0);
+  silc_mutex_unlock(silclog.debug_lock);
+
+  *site = (generation << 1) | match;
+  return match;
+}
+#endif /* !SILC_SYMBIAN */
+
+/* Outputs the debug message to stderr.  The debug string has already been
+   matched at the call site by SILC_LOG_DEBUG. */
 
 void silc_log_output_debug(char *file, const char *function,
 			   int line, char *string)
@@ -492,10 +564,6 @@ void silc_log_output_debug(char *file, const char *function,
   if (!silclog.debug)
     goto end;
 
-  if (!silc_string_regex_match(silclog.debug_string, file) &&
-      !silc_string_regex_match(silclog.debug_string, function))
-    goto end;
-
   if (silclog.debug_cb) {
     if ((*silclog.debug_cb)(file, (char *)function, line, string,
 			    silclog.debug_context))
@@ -537,10 +605,6 @@ void silc_log_output_hexdump(char *file, const char *function,
   if (!silclog.debug_hexdump)
     goto end;
 
-  if (!silc_string_regex_match(silclog.debug_string, file) &&
-      !silc_string_regex_match(silclog.debug_string, function))
-    goto end;
-
   if (silclog.hexdump_cb) {
     if ((*silclog.hexdump_cb)(file, (char *)function, line,
 			      data_in, len, string, silclog.hexdump_context))
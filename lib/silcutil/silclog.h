@@ -235,9 +235,28 @@ typedef SilcBool (*SilcLogHexdumpCb)(char *file, char *function, int line,
  *    value, thus removing all debug logging calls from the compiled
  *    application.
  *
+ *    When SILC_DEBUG is defined but debugging is not enabled with
+ *    silc_log_debug the macro costs a single branch and its arguments are
+ *    not evaluated.  When it is enabled, each call site matches its file
+ *    and function against the debug string only once and caches the
+ *    result until the debug string or the debug setting changes.
+ *
  * SOURCE
  */
-#if defined(SILC_DEBUG)
+#if defined(SILC_DEBUG) && !defined(SILC_SYMBIAN)
+#define SILC_LOG_DEBUG(fmt)						\
+do {									\
+  static SilcLogSite __silc_log_site = 0;				\
+  SilcUInt32 __silc_log_gen = silc_log_debug_generation;		\
+  if (silc_unlikely(__silc_log_gen) &&					\
+      silc_log_debug_site(&__silc_log_site, __silc_log_gen,		\
+			  __FILE__, __FUNCTION__))			\
+    silc_log_output_debug(__FILE__, __FUNCTION__, __LINE__,		\
+			  silc_format fmt);				\
+} while(0)
+#define SILC_NOT_IMPLEMENTED(string)					\
+  SILC_LOG_INFO(("*********** %s: NOT IMPLEMENTED YET", string));
+#elif defined(SILC_DEBUG)
 #define SILC_LOG_DEBUG(fmt) silc_log_output_debug(__FILE__,	\
 				__FUNCTION__,			\
 				__LINE__,			\
@@ -269,6 +288,8 @@ typedef SilcBool (*SilcLogHexdumpCb)(char *file, char *function, int line,
  *    defined to an empty value, thus removing all debug logging calls from
  *    the compiled application.
  *    This macro is also affected by the global variable silc_debug_hexdump.
+ *    Like SILC_LOG_DEBUG, the arguments are evaluated only when hexdump
+ *    debugging is enabled and the call site matches the debug string.
  *
  * EXAMPLE
  *
@@ -277,7 +298,18 @@ typedef SilcBool (*SilcLogHexdumpCb)(char *file, char *function, int line,
  *
  * SOURCE
  */
-#if defined(SILC_DEBUG)
+#if defined(SILC_DEBUG) && !defined(SILC_SYMBIAN)
+#define SILC_LOG_HEXDUMP(fmt, data, len)				\
+do {									\
+  static SilcLogSite __silc_log_site = 0;				\
+  SilcUInt32 __silc_log_gen = silc_log_hexdump_generation;		\
+  if (silc_unlikely(__silc_log_gen) &&					\
+      silc_log_debug_site(&__silc_log_site, __silc_log_gen,		\
+			  __FILE__, __FUNCTION__))			\
+    silc_log_output_hexdump(__FILE__, __FUNCTION__, __LINE__,		\
+			    (void *)(data), (len), silc_format fmt);	\
+} while(0)
+#elif defined(SILC_DEBUG)
 #define SILC_LOG_HEXDUMP(fmt, data, len) silc_log_output_hexdump(__FILE__, \
 				__FUNCTION__,				   \
 				__LINE__,				   \
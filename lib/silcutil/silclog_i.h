@@ -30,6 +30,38 @@
 #endif
 #endif
 
+#ifndef SILC_SYMBIAN
+/* Debug call site state.  Every SILC_LOG_DEBUG and SILC_LOG_HEXDUMP call
+   site has one of these as a static variable.  It caches the result of
+   matching the site's file and function against the debug string as
+   (generation << 1) | match, where generation is the value of
+   silc_log_debug_generation when the match was done.  Zero means the
+   site has not been evaluated yet. */
+typedef SilcUInt32 SilcLogSite;
+
+/* Current debug filter generation when debugging is enabled, and zero
+   when debugging is disabled.  This is the only thing disabled debug
+   call sites look at. */
+extern volatile SilcUInt32 silc_log_debug_generation;
+extern volatile SilcUInt32 silc_log_hexdump_generation;
+
+SilcBool silc_log_debug_site_update(SilcLogSite *site, SilcUInt32 generation,
+				    const char *file, const char *function);
+
+/* Returns TRUE if the call site matches the current debug string.  Only
+   the first call after the debug string changes does the actual match. */
+
+static inline
+SilcBool silc_log_debug_site(SilcLogSite *site, SilcUInt32 generation,
+			     const char *file, const char *function)
+{
+  SilcLogSite cached = *site;
+  if (silc_likely((cached >> 1) == generation))
+    return cached & 1;
+  return silc_log_debug_site_update(site, generation, file, function);
+}
+#endif /* !SILC_SYMBIAN */
+
 void silc_log_output(SilcLogType type, char *string);
 void silc_log_output_debug(char *file, const char *function,
 			   int line, char *string);
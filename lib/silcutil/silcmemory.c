@@ -153,3 +153,106 @@ char *silc_sstrdup(SilcStack stack, const char *str)
   addr[size] = '\0';
   return addr;
 }
+
+/* Slab routines */
+
+#define SILC_SLAB_DEFAULT_COUNT 256
+#define SILC_SLAB_ALIGN(bytes) \
+  (((bytes) + (sizeof(unsigned long) - 1)) & ~(sizeof(unsigned long) - 1))
+#define SILC_SLAB_HDR SILC_SLAB_ALIGN(sizeof(void *))
+
+/* Slab context.  The chunks are linked through their first pointer and
+   the free objects through their first pointer. */
+struct SilcSlabStruct {
+  void *chunks;			/* Allocated memory chunks */
+  void *free_list;		/* Free objects */
+  SilcUInt32 obj_size;		/* Aligned object size */
+  SilcUInt32 obj_count;		/* Objects per chunk */
+  SilcUInt32 live;		/* Objects in use */
+  SilcUInt32 free_count;	/* Objects in free list */
+};
+
+SilcSlab silc_slab_alloc(SilcUInt32 obj_size, SilcUInt32 obj_count)
+{
+  SilcSlab slab;
+
+  if (!obj_size)
+    return NULL;
+
+  slab = silc_calloc(1, sizeof(*slab));
+  if (silc_unlikely(!slab))
+    return NULL;
+
+  slab->obj_size = SILC_SLAB_ALIGN(obj_size < sizeof(void *) ?
+				   sizeof(void *) : obj_size);
+  slab->obj_count = obj_count ? obj_count : SILC_SLAB_DEFAULT_COUNT;
+
+  return slab;
+}
+
+void silc_slab_free(SilcSlab slab)
+{
+  void *chunk;
+
+  if (!slab)
+    return;
+
+  while (slab->chunks) {
+    chunk = slab->chunks;
+    slab->chunks = *(void **)chunk;
+    silc_free(chunk);
+  }
+
+  silc_free(slab);
+}
+
+void *silc_slab_get(SilcSlab slab)
+{
+  unsigned char *chunk;
+  void *obj;
+  int i;
+
+  if (silc_unlikely(!slab->free_list)) {
+    /* Allocate new chunk and put its objects to the free list */
+    chunk = silc_malloc(SILC_SLAB_HDR + (slab->obj_size * slab->obj_count));
+    if (silc_unlikely(!chunk))
+      return NULL;
+    *(void **)chunk = slab->chunks;
+    slab->chunks = chunk;
+
+    chunk += SILC_SLAB_HDR;
+    for (i = slab->obj_count - 1; i >= 0; i--) {
+      obj = chunk + (i * slab->obj_size);
+      *(void **)obj = slab->free_list;
+      slab->free_list = obj;
+    }
+    slab->free_count += slab->obj_count;
+  }
+
+  obj = slab->free_list;
+  slab->free_list = *(void **)obj;
+  slab->free_count--;
+  slab->live++;
+
+  memset(obj, 0, slab->obj_size);
+  return obj;
+}
+
+void silc_slab_put(SilcSlab slab, void *ptr)
+{
+  if (!ptr)
+    return;
+
+  *(void **)ptr = slab->free_list;
+  slab->free_list = ptr;
+  slab->free_count++;
+  slab->live--;
+}
+
+void silc_slab_stats(SilcSlab slab, SilcUInt32 *live, SilcUInt32 *free_count)
+{
+  if (live)
+    *live = slab ? slab->live : 0;
+  if (free_count)
+    *free_count = slab ? slab->free_count : 0;
+}
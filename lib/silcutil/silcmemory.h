@@ -304,4 +304,96 @@ void *silc_smemdup(SilcStack stack, const void *ptr, SilcUInt32 size);
  ***/
 char *silc_sstrdup(SilcStack stack, const char *str);
 
+/* Following functions allocate fixed size objects from a slab. */
+
+/****s* silcutil/SilcMemoryAPI/SilcSlab
+ *
+ * NAME
+ *
+ *    typedef struct SilcSlabStruct *SilcSlab;
+ *
+ * DESCRIPTION
+ *
+ *    The slab context allocated with silc_slab_alloc.  Slab allocates
+ *    fixed size objects from larger memory chunks and keeps the freed
+ *    objects in a free list for reuse.  Slab is useful when lot of
+ *    objects of same size are allocated and freed repeatedly.  The slab
+ *    is not thread-safe.
+ *
+ ***/
+typedef struct SilcSlabStruct *SilcSlab;
+
+/****f* silcutil/SilcMemoryAPI/silc_slab_alloc
+ *
+ * SYNOPSIS
+ *
+ *    SilcSlab silc_slab_alloc(SilcUInt32 obj_size, SilcUInt32 obj_count);
+ *
+ * DESCRIPTION
+ *
+ *    Allocates slab for objects of size of `obj_size' bytes.  The memory
+ *    is allocated in chunks of `obj_count' objects.  If `obj_count' is
+ *    zero a default count is used.  Returns NULL on error.
+ *
+ ***/
+SilcSlab silc_slab_alloc(SilcUInt32 obj_size, SilcUInt32 obj_count);
+
+/****f* silcutil/SilcMemoryAPI/silc_slab_free
+ *
+ * SYNOPSIS
+ *
+ *    void silc_slab_free(SilcSlab slab);
+ *
+ * DESCRIPTION
+ *
+ *    Frees the slab and all memory allocated from it.  Objects allocated
+ *    from the slab must not be used after calling this.
+ *
+ ***/
+void silc_slab_free(SilcSlab slab);
+
+/****f* silcutil/SilcMemoryAPI/silc_slab_get
+ *
+ * SYNOPSIS
+ *
+ *    void *silc_slab_get(SilcSlab slab);
+ *
+ * DESCRIPTION
+ *
+ *    Allocates one object from the slab and returns pointer to it.  The
+ *    object is zeroed.  Returns NULL on error.  Free the object by
+ *    calling silc_slab_put.
+ *
+ ***/
+void *silc_slab_get(SilcSlab slab);
+
+/****f* silcutil/SilcMemoryAPI/silc_slab_put
+ *
+ * SYNOPSIS
+ *
+ *    void silc_slab_put(SilcSlab slab, void *ptr);
+ *
+ * DESCRIPTION
+ *
+ *    Returns the object `ptr' allocated with silc_slab_get back to the
+ *    slab.  If `ptr' is NULL no operation is performed.
+ *
+ ***/
+void silc_slab_put(SilcSlab slab, void *ptr);
+
+/****f* silcutil/SilcMemoryAPI/silc_slab_stats
+ *
+ * SYNOPSIS
+ *
+ *    void silc_slab_stats(SilcSlab slab, SilcUInt32 *live,
+ *                         SilcUInt32 *free_count);
+ *
+ * DESCRIPTION
+ *
+ *    Returns the number of objects currently allocated from the slab to
+ *    `live' and the number of free objects in the slab to `free_count'.
+ *
+ ***/
+void silc_slab_stats(SilcSlab slab, SilcUInt32 *live, SilcUInt32 *free_count);
+
 #endif /* SILCMEMORY_H */
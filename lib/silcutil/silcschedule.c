@@ -41,6 +41,209 @@ static void silc_schedule_fd_destructor(void *key, void *context,
   silc_free(context);
 }
 
+/* Timeout queue.  The timeout tasks are kept in a binary min-heap ordered
+   by the expiry time, so the first task in the heap has always the
+   earliest timeout.  Tasks with equal expiry time are ordered by the
+   order they were added in.  Deleting a task only invalidates it; invalid
+   tasks are removed when they reach the top of the heap, or all at once
+   when the heap has more invalid tasks than valid ones.  The tasks are
+   also hashed by their context, so that deleting by context does not need
+   to go through the whole queue. */
+
+/* Returns negative if `t1' expires before `t2', positive otherwise. */
+
+static inline int silc_schedule_timeout_cmp(SilcTaskTimeout t1,
+					    SilcTaskTimeout t2)
+{
+  if (t1->timeout.tv_sec != t2->timeout.tv_sec)
+    return t1->timeout.tv_sec < t2->timeout.tv_sec ? -1 : 1;
+  if (t1->timeout.tv_usec != t2->timeout.tv_usec)
+    return t1->timeout.tv_usec < t2->timeout.tv_usec ? -1 : 1;
+  return (SilcInt32)(t1->seq - t2->seq);
+}
+
+/* Moves task at `i' towards the top of the heap */
+
+static void silc_schedule_heap_up(SilcSchedule schedule, SilcUInt32 i)
+{
+  SilcTaskTimeout *heap = schedule->timeout_heap, task = heap[i];
+  SilcUInt32 parent;
+
+  while (i > 0) {
+    parent = (i - 1) / 2;
+    if (silc_schedule_timeout_cmp(task, heap[parent]) >= 0)
+      break;
+    heap[i] = heap[parent];
+    heap[i]->index = i;
+    i = parent;
+  }
+  heap[i] = task;
+  task->index = i;
+}
+
+/* Moves task at `i' towards the bottom of the heap */
+
+static void silc_schedule_heap_down(SilcSchedule schedule, SilcUInt32 i)
+{
+  SilcTaskTimeout *heap = schedule->timeout_heap, task = heap[i];
+  SilcUInt32 child, count = schedule->timeout_count;
+
+  while ((child = (2 * i) + 1) < count) {
+    if (child + 1 < count &&
+	silc_schedule_timeout_cmp(heap[child + 1], heap[child]) < 0)
+      child++;
+    if (silc_schedule_timeout_cmp(task, heap[child]) <= 0)
+      break;
+    heap[i] = heap[child];
+    heap[i]->index = i;
+    i = child;
+  }
+  heap[i] = task;
+  task->index = i;
+}
+
+/* Returns context index bucket for `context' */
+
+static inline SilcTaskTimeout *
+silc_schedule_ctx_bucket(SilcSchedule schedule, void *context)
+{
+  SilcUInt32 h = SILC_PTR_TO_32(context) * 0x9e3779b1;
+  return &schedule->timeout_ctx[(h ^ (h >> 16)) &
+				(schedule->timeout_ctx_size - 1)];
+}
+
+static inline void silc_schedule_ctx_link(SilcSchedule schedule,
+					  SilcTaskTimeout task)
+{
+  SilcTaskTimeout *bucket = silc_schedule_ctx_bucket(schedule,
+						     task->header.context);
+  task->ctx_next = *bucket;
+  if (task->ctx_next)
+    task->ctx_next->ctx_prev = &task->ctx_next;
+  task->ctx_prev = bucket;
+  *bucket = task;
+}
+
+static inline void silc_schedule_ctx_unlink(SilcTaskTimeout task)
+{
+  *task->ctx_prev = task->ctx_next;
+  if (task->ctx_next)
+    task->ctx_next->ctx_prev = task->ctx_prev;
+  task->ctx_next = NULL;
+  task->ctx_prev = NULL;
+}
+
+/* Removes all invalid tasks from the timeout queue and rebuilds the heap.
+   This is done when most of the tasks in the queue are invalid, which
+   happens when long timeouts are added and deleted before they expire. */
+
+static void silc_schedule_timeout_compact(SilcSchedule schedule)
+{
+  SilcTaskTimeout *heap = schedule->timeout_heap, task;
+  SilcUInt32 i, count = 0;
+
+  SILC_LOG_DEBUG(("Removing %d invalid timeout tasks",
+		  schedule->timeout_invalid));
+
+  for (i = 0; i < schedule->timeout_count; i++) {
+    task = heap[i];
+    if (!task->header.valid) {
+      task->index = SILC_TASK_NO_INDEX;
+      silc_schedule_ctx_unlink(task);
+      silc_list_add(schedule->free_tasks, task);
+      continue;
+    }
+    task->index = count;
+    heap[count++] = task;
+  }
+  schedule->timeout_count = count;
+  schedule->timeout_invalid = 0;
+
+  for (i = count / 2; i > 0; i--)
+    silc_schedule_heap_down(schedule, i - 1);
+}
+
+/* Adds timeout task to the timeout queue */
+
+static SilcBool silc_schedule_timeout_add(SilcSchedule schedule,
+					  SilcTaskTimeout task)
+{
+  SilcUInt32 i;
+
+  /* Rather than growing the heap get rid of invalid tasks if there are
+     lots of them */
+  if (silc_unlikely(schedule->timeout_count == schedule->timeout_size &&
+		    schedule->timeout_invalid > schedule->timeout_count / 2))
+    silc_schedule_timeout_compact(schedule);
+
+  if (silc_unlikely(schedule->timeout_count == schedule->timeout_size)) {
+    SilcTaskTimeout *heap;
+    SilcUInt32 size = schedule->timeout_size ?
+      schedule->timeout_size * 2 : 64;
+
+    heap = silc_realloc(schedule->timeout_heap, size * sizeof(*heap));
+    if (silc_unlikely(!heap))
+      return FALSE;
+    schedule->timeout_heap = heap;
+    schedule->timeout_size = size;
+  }
+
+  /* Keep the context index at most two tasks per bucket on average */
+  if (silc_unlikely(schedule->timeout_count >=
+		    schedule->timeout_ctx_size * 2)) {
+    SilcTaskTimeout *ctx;
+    SilcUInt32 size = schedule->timeout_ctx_size ?
+      schedule->timeout_ctx_size * 2 : 64;
+
+    ctx = silc_calloc(size, sizeof(*ctx));
+    if (silc_unlikely(!ctx))
+      return FALSE;
+    silc_free(schedule->timeout_ctx);
+    schedule->timeout_ctx = ctx;
+    schedule->timeout_ctx_size = size;
+    for (i = 0; i < schedule->timeout_count; i++)
+      silc_schedule_ctx_link(schedule, schedule->timeout_heap[i]);
+  }
+
+  task->seq = schedule->timeout_seq++;
+  schedule->timeout_heap[schedule->timeout_count++] = task;
+  silc_schedule_heap_up(schedule, schedule->timeout_count - 1);
+  silc_schedule_ctx_link(schedule, task);
+
+  return TRUE;
+}
+
+/* Removes the first task from the timeout queue */
+
+static void silc_schedule_timeout_pop(SilcSchedule schedule)
+{
+  SilcTaskTimeout task = schedule->timeout_heap[0];
+
+  if (!task->header.valid)
+    schedule->timeout_invalid--;
+  task->index = SILC_TASK_NO_INDEX;
+  silc_schedule_ctx_unlink(task);
+
+  if (--schedule->timeout_count > 0) {
+    schedule->timeout_heap[0] =
+      schedule->timeout_heap[schedule->timeout_count];
+    silc_schedule_heap_down(schedule, 0);
+  }
+}
+
+/* Invalidates timeout task.  Returns FALSE if it was invalid already. */
+
+static inline SilcBool silc_schedule_timeout_invalidate(SilcSchedule schedule,
+							SilcTask task)
+{
+  if (!task->valid)
+    return FALSE;
+  task->valid = FALSE;
+  if (((SilcTaskTimeout)task)->index != SILC_TASK_NO_INDEX)
+    schedule->timeout_invalid++;
+  return TRUE;
+}
+
 /* Executes file descriptor tasks. Invalid tasks are removed here. */
 
 static void silc_schedule_dispatch_fd(SilcSchedule schedule)
@@ -92,11 +295,8 @@ static void silc_schedule_dispatch_timeout(SilcSchedule schedule,
   silc_gettimeofday(&curtime);
 
   /* First task in the task queue has always the earliest timeout. */
-  silc_list_start(schedule->timeout_queue);
-  task = silc_list_get(schedule->timeout_queue);
-  if (silc_unlikely(!task))
-    return;
-  do {
+  while (silc_likely(schedule->timeout_count)) {
+    task = schedule->timeout_heap[0];
     t = (SilcTask)task;
 
     /* Remove invalid task */
@@ -109,19 +309,22 @@ static void silc_schedule_dispatch_timeout(SilcSchedule schedule,
     if (silc_compare_timeval(&task->timeout, &curtime) > 0 && !dispatch_all)
       break;
 
+    /* Take the task out of the queue for the duration of the callback */
+    silc_schedule_timeout_pop(schedule);
     t->valid = FALSE;
+
     SILC_SCHEDULE_UNLOCK(schedule);
     t->callback(schedule, schedule->app_context, SILC_TASK_EXPIRE, 0,
 		t->context);
     SILC_SCHEDULE_LOCK(schedule);
 
-    /* Remove the expired task */
-    silc_schedule_task_remove(schedule, t);
+    /* Put the expired task to free list */
+    silc_list_add(schedule->free_tasks, task);
 
     /* Balance when we have lots of small timeouts */
     if (silc_unlikely((++count) > 40))
       break;
-  } while (silc_likely((task = silc_list_get(schedule->timeout_queue))));
+  }
 }
 
 /* Calculates next timeout. This is the timeout value when at earliest some
@@ -139,17 +342,21 @@ static void silc_schedule_select_timeout(SilcSchedule schedule)
   silc_gettimeofday(&curtime);
   schedule->has_timeout = FALSE;
 
+  /* Get rid of invalid tasks if there are lots of them */
+  if (silc_unlikely(schedule->timeout_invalid > 64 &&
+		    schedule->timeout_invalid > schedule->timeout_count / 2))
+    silc_schedule_timeout_compact(schedule);
+
   /* First task in the task queue has always the earliest timeout. */
-  silc_list_start(schedule->timeout_queue);
-  task = silc_list_get(schedule->timeout_queue);
-  if (silc_unlikely(!task))
-    return;
-  do {
+  task = NULL;
+  while (schedule->timeout_count) {
+    task = schedule->timeout_heap[0];
     t = (SilcTask)task;
 
     /* Remove invalid task */
     if (silc_unlikely(!t->valid)) {
       silc_schedule_task_remove(schedule, t);
+      task = NULL;
       continue;
     }
 
@@ -161,7 +368,7 @@ static void silc_schedule_select_timeout(SilcSchedule schedule)
 	return;
 
       /* Start selecting new timeout again after dispatch */
-      silc_list_start(schedule->timeout_queue);
+      task = NULL;
       dispatch = FALSE;
       continue;
     }
@@ -180,7 +387,7 @@ static void silc_schedule_select_timeout(SilcSchedule schedule)
       curtime.tv_usec += 1000000L;
     }
     break;
-  } while ((task = silc_list_get(schedule->timeout_queue)));
+  }
 
   /* Save the timeout */
   if (task) {
@@ -210,9 +417,9 @@ static void silc_schedule_task_remove(SilcSchedule schedule, SilcTask task)
     silc_hash_table_list_reset(&htl);
 
     /* Delete from timeout queue */
-    silc_list_start(schedule->timeout_queue);
-    while ((task = silc_list_get(schedule->timeout_queue))) {
-      silc_list_del(schedule->timeout_queue, task);
+    while (schedule->timeout_count) {
+      task = (SilcTask)schedule->timeout_heap[0];
+      silc_schedule_timeout_pop(schedule);
       silc_free(task);
     }
 
@@ -220,8 +427,9 @@ static void silc_schedule_task_remove(SilcSchedule schedule, SilcTask task)
   }
 
   if (silc_likely(task->type == 1)) {
-    /* Delete from timeout queue */
-    silc_list_del(schedule->timeout_queue, task);
+    /* Invalid tasks are removed only from the top of the timeout queue */
+    SILC_ASSERT(((SilcTaskTimeout)task)->index == 0);
+    silc_schedule_timeout_pop(schedule);
 
     /* Put to free list */
     silc_list_add(schedule->free_tasks, task);
@@ -252,7 +460,7 @@ SILC_TASK_CALLBACK(silc_schedule_timeout_gc)
 				   schedule, 3600, 0);
     return;
   }
-  if (silc_list_count(schedule->timeout_queue) >
+  if (schedule->timeout_count >
       silc_list_count(schedule->free_tasks)) {
     SILC_SCHEDULE_UNLOCK(schedule);
     silc_schedule_task_add_timeout(schedule, silc_schedule_timeout_gc,
@@ -261,9 +469,9 @@ SILC_TASK_CALLBACK(silc_schedule_timeout_gc)
   }
 
   c = silc_list_count(schedule->free_tasks) / 2;
-  if (c > silc_list_count(schedule->timeout_queue))
+  if (c > schedule->timeout_count)
     c = (silc_list_count(schedule->free_tasks) -
-	 silc_list_count(schedule->timeout_queue));
+	 schedule->timeout_count);
   if (silc_list_count(schedule->free_tasks) - c < 10)
     c -= (10 - (silc_list_count(schedule->free_tasks) - c));
 
@@ -303,14 +511,13 @@ SilcSchedule silc_schedule_init(int max_tasks, void *app_context)
     return NULL;
 
   schedule->fd_queue =
-    silc_hash_table_alloc(0, silc_hash_uint, NULL, NULL, NULL,
-			  silc_schedule_fd_destructor, NULL, TRUE);
+    silc_hash_table_alloc_open(0, silc_hash_uint, NULL, NULL, NULL,
+			       silc_schedule_fd_destructor, NULL, TRUE);
   if (!schedule->fd_queue) {
     silc_free(schedule);
     return NULL;
   }
 
-  silc_list_init(schedule->timeout_queue, struct SilcTaskStruct, next);
   silc_list_init(schedule->free_tasks, struct SilcTaskStruct, next);
 
   schedule->app_context = app_context;
@@ -372,6 +579,8 @@ SilcBool silc_schedule_uninit(SilcSchedule schedule)
 
   /* Unregister all task queues */
   silc_hash_table_free(schedule->fd_queue);
+  silc_free(schedule->timeout_heap);
+  silc_free(schedule->timeout_ctx);
 
   /* Uninit the platform specific scheduler. */
   schedule_ops.uninit(schedule, schedule->internal);
@@ -445,7 +654,7 @@ static SilcBool silc_schedule_iterate(SilcSchedule schedule, int timeout_usecs)
     if (silc_likely(ret == 0)) {
       /* Timeout */
       SILC_LOG_DEBUG(("Running timeout tasks"));
-      if (silc_likely(silc_list_count(schedule->timeout_queue)))
+      if (silc_likely(schedule->timeout_count))
 	silc_schedule_dispatch_timeout(schedule, FALSE);
       continue;
 
@@ -552,8 +761,7 @@ SilcTask silc_schedule_task_add(SilcSchedule schedule, SilcUInt32 fd,
   SILC_SCHEDULE_LOCK(schedule);
 
   if (silc_likely(type == SILC_TASK_TIMEOUT)) {
-    SilcTaskTimeout tmp, prev, ttask;
-    SilcList list;
+    SilcTaskTimeout ttask;
 
     silc_list_start(schedule->free_tasks);
     ttask = silc_list_get(schedule->free_tasks);
@@ -583,21 +791,11 @@ SilcTask silc_schedule_task_add(SilcSchedule schedule, SilcUInt32 fd,
     SILC_LOG_DEBUG(("New timeout task %p: sec=%ld, usec=%ld", ttask,
 		    seconds, useconds));
 
-    /* Add task to correct spot so that the first task in the list has
-       the earliest timeout. */
-    list = schedule->timeout_queue;
-    silc_list_start(list);
-    prev = NULL;
-    while ((tmp = silc_list_get(list)) != SILC_LIST_END) {
-      /* If we have shorter timeout, we have found our spot */
-      if (silc_compare_timeval(&ttask->timeout, &tmp->timeout) < 0) {
-	silc_list_insert(schedule->timeout_queue, prev, ttask);
-	break;
-      }
-      prev = tmp;
+    /* Add task to the timeout queue */
+    if (silc_unlikely(!silc_schedule_timeout_add(schedule, ttask))) {
+      silc_list_add(schedule->free_tasks, ttask);
+      goto out;
     }
-    if (!tmp)
-      silc_list_add(schedule->timeout_queue, ttask);
 
     task = (SilcTask)ttask;
 
@@ -691,6 +889,7 @@ SilcBool silc_schedule_task_del(SilcSchedule schedule, SilcTask task)
 {
   if (silc_unlikely(task == SILC_ALL_TASKS)) {
     SilcHashTableList htl;
+    SilcUInt32 i;
 
     SILC_LOG_DEBUG(("Unregister all tasks"));
 
@@ -710,9 +909,9 @@ SilcBool silc_schedule_task_del(SilcSchedule schedule, SilcTask task)
     silc_hash_table_list_reset(&htl);
 
     /* Delete from timeout queue */
-    silc_list_start(schedule->timeout_queue);
-    while ((task = (SilcTask)silc_list_get(schedule->timeout_queue))) {
-      task->valid = FALSE;
+    for (i = 0; i < schedule->timeout_count; i++) {
+      task = (SilcTask)schedule->timeout_heap[i];
+      silc_schedule_timeout_invalidate(schedule, task);
 
       /* Call notify callback */
       if (schedule->notify)
@@ -726,7 +925,10 @@ SilcBool silc_schedule_task_del(SilcSchedule schedule, SilcTask task)
 
   SILC_LOG_DEBUG(("Unregistering task %p", task));
   SILC_SCHEDULE_LOCK(schedule);
-  task->valid = FALSE;
+  if (task->type == 1)
+    silc_schedule_timeout_invalidate(schedule, task);
+  else
+    task->valid = FALSE;
 
   /* Call notify callback */
   if (schedule->notify)
@@ -780,7 +982,7 @@ SilcBool silc_schedule_task_del_by_callback(SilcSchedule schedule,
 {
   SilcTask task;
   SilcHashTableList htl;
-  SilcList list;
+  SilcUInt32 i;
   SilcBool ret = FALSE;
 
   SILC_LOG_DEBUG(("Unregister task by callback"));
@@ -804,11 +1006,10 @@ SilcBool silc_schedule_task_del_by_callback(SilcSchedule schedule,
   silc_hash_table_list_reset(&htl);
 
   /* Delete from timeout queue */
-  list = schedule->timeout_queue;
-  silc_list_start(list);
-  while ((task = (SilcTask)silc_list_get(list))) {
+  for (i = 0; i < schedule->timeout_count; i++) {
+    task = (SilcTask)schedule->timeout_heap[i];
     if (task->callback == callback) {
-      task->valid = FALSE;
+      silc_schedule_timeout_invalidate(schedule, task);
 
       /* Call notify callback */
       if (schedule->notify)
@@ -829,8 +1030,8 @@ SilcBool silc_schedule_task_del_by_context(SilcSchedule schedule,
 					   void *context)
 {
   SilcTask task;
+  SilcTaskTimeout ttask;
   SilcHashTableList htl;
-  SilcList list;
   SilcBool ret = FALSE;
 
   SILC_LOG_DEBUG(("Unregister task by context"));
@@ -854,11 +1055,12 @@ SilcBool silc_schedule_task_del_by_context(SilcSchedule schedule,
   silc_hash_table_list_reset(&htl);
 
   /* Delete from timeout queue */
-  list = schedule->timeout_queue;
-  silc_list_start(list);
-  while ((task = (SilcTask)silc_list_get(list))) {
+  ttask = schedule->timeout_count ?
+    *silc_schedule_ctx_bucket(schedule, context) : NULL;
+  for (; ttask; ttask = ttask->ctx_next) {
+    task = (SilcTask)ttask;
     if (task->context == context) {
-      task->valid = FALSE;
+      silc_schedule_timeout_invalidate(schedule, task);
 
       /* Call notify callback */
       if (schedule->notify)
@@ -880,7 +1082,7 @@ SilcBool silc_schedule_task_del_by_all(SilcSchedule schedule, int fd,
 				       void *context)
 {
   SilcTask task;
-  SilcList list;
+  SilcTaskTimeout ttask;
   SilcBool ret = FALSE;
 
   SILC_LOG_DEBUG(("Unregister task by fd, callback and context"));
@@ -892,11 +1094,12 @@ SilcBool silc_schedule_task_del_by_all(SilcSchedule schedule, int fd,
   SILC_SCHEDULE_LOCK(schedule);
 
   /* Delete from timeout queue */
-  list = schedule->timeout_queue;
-  silc_list_start(list);
-  while ((task = (SilcTask)silc_list_get(list))) {
+  ttask = schedule->timeout_count ?
+    *silc_schedule_ctx_bucket(schedule, context) : NULL;
+  for (; ttask; ttask = ttask->ctx_next) {
+    task = (SilcTask)ttask;
     if (task->callback == callback && task->context == context) {
-      task->valid = FALSE;
+      silc_schedule_timeout_invalidate(schedule, task);
 
       /* Call notify callback */
       if (schedule->notify)
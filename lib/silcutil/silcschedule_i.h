@@ -59,8 +59,15 @@ struct SilcTaskStruct {
 typedef struct SilcTaskTimeoutStruct {
   struct SilcTaskStruct header;
   struct timeval timeout;
+  struct SilcTaskTimeoutStruct *ctx_next;   /* Context index chain */
+  struct SilcTaskTimeoutStruct **ctx_prev;  /* Previous next pointer */
+  SilcUInt32 index;			    /* Index in timeout heap */
+  SilcUInt32 seq;			    /* Insertion order */
 } *SilcTaskTimeout;
 
+/* Timeout task that is not in the timeout heap has this index */
+#define SILC_TASK_NO_INDEX 0xffffffff
+
 /* Fd task */
 typedef struct SilcTaskFdStruct {
   struct SilcTaskStruct header;
@@ -78,7 +85,13 @@ struct SilcScheduleStruct {
   void *notify_context;		   /* Notify context */
   SilcHashTable fd_queue;	   /* FD task queue */
   SilcList fd_dispatch;		   /* Dispatched FDs */
-  SilcList timeout_queue;	   /* Timeout queue */
+  SilcTaskTimeout *timeout_heap;   /* Timeout queue, binary min-heap */
+  SilcUInt32 timeout_count;	   /* Number of tasks in timeout heap */
+  SilcUInt32 timeout_size;	   /* Allocated size of timeout heap */
+  SilcUInt32 timeout_invalid;	   /* Invalidated tasks in timeout heap */
+  SilcUInt32 timeout_seq;	   /* Next timeout task sequence number */
+  SilcTaskTimeout *timeout_ctx;	   /* Timeout tasks indexed by context */
+  SilcUInt32 timeout_ctx_size;	   /* Number of context index buckets */
   SilcList free_tasks;		   /* Timeout task freelist */
   SilcMutex lock;		   /* Scheduler lock */
   struct timeval timeout;	   /* Current timeout */
@@ -144,6 +144,22 @@ SilcUInt32 silc_stack_pop(SilcStack stack)
   return stack->frame->sp + 1;
 }
 
+/* Returns allocation statistics */
+
+void silc_stack_stats(SilcStack stack, SilcUInt32 *num_malloc,
+		      SilcUInt32 *bytes_malloc)
+{
+#ifdef SILC_DEBUG
+  if (stack) {
+    *num_malloc = stack->num_malloc;
+    *bytes_malloc = stack->bytes_malloc;
+    return;
+  }
+#endif /* SILC_DEBUG */
+  *num_malloc = 0;
+  *bytes_malloc = 0;
+}
+
 /* Allocate memory.  If the `aligned' is FALSE this allocates unaligned
    memory, otherwise memory is aligned.  Returns pointer to the memory
    or NULL on error. */
@@ -223,6 +223,27 @@ SilcUInt32 silc_stack_push(SilcStack stack, SilcStackFrame *frame);
  ***/
 SilcUInt32 silc_stack_pop(SilcStack stack);
 
+/****f* silcutil/SilcStackAPI/silc_stack_stats
+ *
+ * SYNOPSIS
+ *
+ *    void silc_stack_stats(SilcStack stack, SilcUInt32 *num_malloc,
+ *                          SilcUInt32 *bytes_malloc);
+ *
+ * DESCRIPTION
+ *
+ *    Returns the number of allocations made from the `stack' to
+ *    `num_malloc' and the number of bytes allocated to `bytes_malloc'.
+ *    The counters are never reset, so the caller computes the usage of
+ *    a stack frame as difference of the values taken before
+ *    silc_stack_push and before silc_stack_pop.  The statistics are
+ *    collected only when the library is compiled with SILC_DEBUG,
+ *    otherwise both values are always zero (0).
+ *
+ ***/
+void silc_stack_stats(SilcStack stack, SilcUInt32 *num_malloc,
+		      SilcUInt32 *bytes_malloc);
+
 #include "silcstack_i.h"
 
 #endif /* SILCSTACK_H */
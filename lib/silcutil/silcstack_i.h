@@ -58,6 +58,11 @@ struct SilcStackStruct {
   SilcStackFrame *frames;		      /* Allocated stack frames */
   SilcStackFrame *frame;		      /* Current stack frame */
   SilcUInt32 stack_size;		      /* Default stack size */
+#ifdef SILC_DEBUG
+  SilcUInt32 num_malloc;		      /* Number of allocations */
+  SilcUInt32 num_errors;		      /* Number of failed allocations */
+  SilcUInt32 bytes_malloc;		      /* Bytes allocated */
+#endif /* SILC_DEBUG */
 };
 
 /* Align the requested amount bytes.  The `align' defines the requested
@@ -75,7 +80,11 @@ struct SilcStackStruct {
    SILC_STACK_ALIGN(sizeof(**(stack)->stack), SILC_STACK_DEFAULT_ALIGN) + \
    ((bsize) - (stack)->stack[si]->bytes_left))
 
+#ifdef SILC_DEBUG
+#define SILC_STACK_STAT(stack, stat, val) ((stack)->stat += (val))
+#else
 #define SILC_STACK_STAT(stack, stat, val)
+#endif /* SILC_DEBUG */
 #define SILC_ST_DEBUG(fmt)
 
 /* Allocate memory.  If the `aligned' is FALSE this allocates unaligned
@@ -406,20 +406,175 @@ int silc_string_regex_match(const char *regex, const char *string)
   return ret;
 }
 
-/* Do regex match to the two strings `string1' and `string2'. If the
-   `string2' matches the `string1' this returns TRUE. */
+/* Compares `len' characters of `pattern' to `string'.  The '?' in
+   `pattern' matches any character. */
+
+static inline SilcBool silc_string_glob_eq(const char *pattern,
+					   const char *string,
+					   SilcUInt32 len)
+{
+  SilcUInt32 i;
+
+  for (i = 0; i < len; i++)
+    if (pattern[i] != string[i] && pattern[i] != '?')
+      return FALSE;
+
+  return TRUE;
+}
+
+/* Matches `string' to single wildcard `pattern'.  The pattern is split to
+   segments by '*'.  The first segment must match at the start and the last
+   at the end of the `string', and segments between them are matched
+   leftmost in order.  No backtracking is needed so this is linear to the
+   length of the `string' times the length of the longest segment. */
+
+static SilcBool silc_string_glob(const char *pattern, SilcUInt32 plen,
+				 const char *string, SilcUInt32 slen)
+{
+  SilcUInt32 n, tail, pos, end, i;
+
+  /* Leading segment */
+  for (n = 0; n < plen && pattern[n] != '*'; n++);
+  if (n == plen)
+    return n == slen && silc_string_glob_eq(pattern, string, n);
+  if (n > slen || !silc_string_glob_eq(pattern, string, n))
+    return FALSE;
+  pos = n;
+
+  /* Trailing segment */
+  for (i = plen; pattern[i - 1] != '*'; i--);
+  tail = plen - i;
+  if (slen - pos < tail ||
+      !silc_string_glob_eq(pattern + i, string + slen - tail, tail))
+    return FALSE;
+  end = slen - tail;
+
+  /* Segments between the first and last '*' */
+  for (plen = i - 1, i = n + 1; i < plen; i += n + 1) {
+    for (n = 0; pattern[i + n] != '*'; n++);
+    if (!n)
+      continue;
+    while (pos + n <= end && !silc_string_glob_eq(pattern + i, string + pos,
+						  n))
+      pos++;
+    if (pos + n > end)
+      return FALSE;
+    pos += n;
+  }
+
+  return TRUE;
+}
+
+/* Matches the wildcard pattern `string1' to `string2'.  The '*' matches
+   any number of characters and '?' matches one character.  A comma (`,')
+   in `string1' separates alternative patterns.  Returns TRUE if the
+   `string2' matches the `string1'. */
 
 int silc_string_match(const char *string1, const char *string2)
 {
-  char *s1;
-  int ret = FALSE;
+  const char *cp;
+  SilcUInt32 slen;
 
   if (!string1 || !string2)
-    return ret;
+    return FALSE;
 
-  s1 = silc_string_regexify(string1);
-  ret = silc_string_regex_match(s1, string2);
-  silc_free(s1);
+  slen = strlen(string2);
+  while (*string1) {
+    cp = strchr(string1, ',');
+    if (!cp)
+      cp = string1 + strlen(string1);
+    if (cp > string1 &&
+	silc_string_glob(string1, cp - string1, string2, slen))
+      return TRUE;
+    string1 = *cp ? cp + 1 : cp;
+  }
 
-  return ret;
+  return FALSE;
+}
+
+/* Compiled wildcard pattern alternative */
+typedef struct {
+  const char *pattern;
+  SilcUInt32 len;
+  SilcUInt32 min_len;			/* Characters other than '*' */
+} SilcStringMatchAlt;
+
+/* Compiled wildcard pattern.  The alternatives and the pattern are in
+   the same allocation. */
+struct SilcStringMatchStruct {
+  SilcUInt32 count;
+  SilcStringMatchAlt alt[1];
+};
+
+/* Compiles the wildcard pattern */
+
+SilcStringMatch silc_string_match_compile(const char *pattern)
+{
+  SilcStringMatch match;
+  SilcStringMatchAlt *alt;
+  SilcUInt32 i, len, count;
+  char *data;
+
+  if (!pattern)
+    return NULL;
+
+  len = strlen(pattern);
+  for (i = 0, count = 1; i < len; i++)
+    if (pattern[i] == ',')
+      count++;
+
+  match = silc_calloc(1, sizeof(*match) + count * sizeof(*match->alt) +
+		      len + 1);
+  if (!match)
+    return NULL;
+
+  data = (char *)(match->alt + count);
+  memcpy(data, pattern, len);
+
+  /* Split to alternatives, ignoring empty ones */
+  alt = match->alt;
+  for (i = 0; i <= len; i++) {
+    if (i < len && data[i] != ',') {
+      if (!alt->pattern)
+	alt->pattern = data + i;
+      alt->len++;
+      if (data[i] != '*')
+	alt->min_len++;
+      continue;
+    }
+    if (alt->pattern) {
+      match->count++;
+      alt++;
+    }
+  }
+
+  return match;
+}
+
+/* Matches `string' to compiled pattern */
+
+SilcBool silc_string_match_compiled(SilcStringMatch match, const char *string)
+{
+  SilcStringMatchAlt *alt;
+  SilcUInt32 i, slen;
+
+  if (!match || !string)
+    return FALSE;
+
+  slen = strlen(string);
+  for (i = 0, alt = match->alt; i < match->count; i++, alt++) {
+    if (slen < alt->min_len)
+      continue;
+    if (silc_string_glob(alt->pattern, alt->len, string, slen))
+      return TRUE;
+  }
+
+  return FALSE;
+}
+
+/* Frees compiled pattern */
+
+void silc_string_match_free(SilcStringMatch match)
+{
+  silc_free(match);
 }
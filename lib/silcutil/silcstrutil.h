@@ -165,12 +165,72 @@ int silc_string_regex_match(const char *regex, const char *string);
  *
  * DESCRIPTION
  *
- *    Do regex match to the two strings `string1' and `string2'. If the
- *    `string2' matches the `string1' this returns TRUE.
+ *    Matches the wildcard pattern `string1' to `string2'.  The '*' matches
+ *    any number of characters and '?' matches exactly one character.  A
+ *    comma (`,') in `string1' separates alternative patterns.  Returns
+ *    TRUE if the `string2' matches the `string1'.  If the same pattern is
+ *    matched many times use silc_string_match_compile.
  *
  ***/
 int silc_string_match(const char *string1, const char *string2);
 
+/****s* silcutil/SilcStrUtilAPI/SilcStringMatch
+ *
+ * NAME
+ *
+ *    typedef struct SilcStringMatchStruct *SilcStringMatch;
+ *
+ * DESCRIPTION
+ *
+ *    Compiled wildcard pattern, allocated with silc_string_match_compile
+ *    and freed with silc_string_match_free.
+ *
+ ***/
+typedef struct SilcStringMatchStruct *SilcStringMatch;
+
+/****f* silcutil/SilcStrUtilAPI/silc_string_match_compile
+ *
+ * SYNOPSIS
+ *
+ *    SilcStringMatch silc_string_match_compile(const char *pattern);
+ *
+ * DESCRIPTION
+ *
+ *    Compiles the wildcard `pattern', which has the same format as in
+ *    silc_string_match.  The compiled pattern is matched with
+ *    silc_string_match_compiled, which does not allocate memory.
+ *    Returns NULL on error.
+ *
+ ***/
+SilcStringMatch silc_string_match_compile(const char *pattern);
+
+/****f* silcutil/SilcStrUtilAPI/silc_string_match_compiled
+ *
+ * SYNOPSIS
+ *
+ *    SilcBool silc_string_match_compiled(SilcStringMatch match,
+ *                                        const char *string);
+ *
+ * DESCRIPTION
+ *
+ *    Returns TRUE if `string' matches the compiled pattern `match'.
+ *
+ ***/
+SilcBool silc_string_match_compiled(SilcStringMatch match, const char *string);
+
+/****f* silcutil/SilcStrUtilAPI/silc_string_match_free
+ *
+ * SYNOPSIS
+ *
+ *    void silc_string_match_free(SilcStringMatch match);
+ *
+ * DESCRIPTION
+ *
+ *    Frees the compiled pattern.
+ *
+ ***/
+void silc_string_match_free(SilcStringMatch match);
+
 /****f* silcutil/SilcStrUtilAPI/silc_string_compare
  *
  * SYNOPSIS
@@ -56,6 +56,7 @@ typedef struct {
 
 #define SIGNAL_COUNT 32
 SilcUnixSignal signal_call[SIGNAL_COUNT];
+static SilcBool signal_call_init = FALSE;
 
 #if defined(HAVE_EPOLL_WAIT)
 
@@ -405,10 +406,16 @@ void *silc_schedule_internal_init(SilcSchedule schedule,
 
   internal->app_context = app_context;
 
-  for (i = 0; i < SIGNAL_COUNT; i++) {
-    signal_call[i].sig = 0;
-    signal_call[i].call = FALSE;
-    signal_call[i].schedule = schedule;
+  /* Signals are process wide.  Initialize them only with the first
+     scheduler so that schedulers created later, for example for real
+     FSM threads, do not lose the signals registered by application. */
+  if (!signal_call_init) {
+    for (i = 0; i < SIGNAL_COUNT; i++) {
+      signal_call[i].sig = 0;
+      signal_call[i].call = FALSE;
+      signal_call[i].schedule = schedule;
+    }
+    signal_call_init = TRUE;
   }
 
   return (void *)internal;